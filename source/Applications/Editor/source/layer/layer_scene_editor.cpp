@@ -36,7 +36,6 @@ void SceneEditorLayer::on_attach()
     add_widget(peek_widget = new RTPeekWidget(application_.get_event_bus()));
     peek_widget->register_framebuffer("GBuffer");
     peek_widget->register_framebuffer("SpriteBuffer");
-    peek_widget->register_framebuffer("BloomCombine");
     peek_widget->register_framebuffer("LBuffer");
 }
 
@@ -1,4 +1,5 @@
 #include "layer/layer_scene_view.h"
+#include "asset/asset_manager.h"
 #include "entity/component/PBR_material.h"
 #include "entity/component/dirlight_material.h"
 #include "entity/component/light.h"
@@ -72,7 +73,7 @@ void SceneViewLayer::on_update(GameClock& clock)
     ComponentCamera3D& camera = scene.get_component<ComponentCamera3D>(e_camera);
     ComponentTransform3D& transform = scene.get_component<ComponentTransform3D>(e_camera);
     camera_controller_.update(clock, camera, transform);
-    Renderer3D::update_camera(camera, transform.global);
+    Renderer3D::update_camera(camera, transform.global, "scene_view"_h ^ uint64_t(e_camera));
 
     if(scene.has_named("Sun"_h))
     {
@@ -92,14 +93,35 @@ void SceneViewLayer::on_render()
     {
         Renderer3D::begin_deferred_pass();
         auto view = scene.view<ComponentTransform3D, ComponentPBRMaterial, ComponentMesh>();
+        // Occluders first, so that they can hide the meshes behind them
+        for(const entt::entity e : view)
+        {
+            const ComponentMesh& cmesh = view.get<ComponentMesh>(e);
+            if(!cmesh.occluder)
+                continue;
+            if(const MeshGeometry* geometry = AssetManager::get_occluder_geometry(cmesh.mesh))
+                Renderer3D::add_occluder(*geometry, view.get<ComponentTransform3D>(e).global.get_model_matrix());
+        }
+        draw_records_.clear();
         for(const entt::entity e : view)
         {
             const ComponentTransform3D& ctransform = view.get<ComponentTransform3D>(e);
             const ComponentPBRMaterial& cmaterial = view.get<ComponentPBRMaterial>(e);
             const ComponentMesh& cmesh = view.get<ComponentMesh>(e);
-            Renderer3D::draw_mesh_PBR_opaque(cmesh.mesh, ctransform.global.get_model_matrix(), cmaterial.material.texture_group,
-                                             &cmaterial.material_data);
+            draw_records_.push_back({&cmesh.mesh, &cmaterial, ctransform.global.get_model_matrix(), uint64_t(e)});
         }
+        Renderer3D::draw_mesh_batch_PBR_opaque(draw_records_);
+
+        // Punctual lights are clustered by the lighting pass
+        scene.view<ComponentTransform3D, ComponentPointLight>().each(
+            [](auto, const ComponentTransform3D& ctransform, const ComponentPointLight& light) {
+                Renderer3D::add_point_light(light, ctransform.global.position);
+            });
+        scene.view<ComponentTransform3D, ComponentSpotLight>().each(
+            [](auto, const ComponentTransform3D& ctransform, const ComponentSpotLight& light) {
+                Renderer3D::add_spot_light(light, ctransform.global.position,
+                                           ctransform.global.rotation * glm::vec3(0.f, 0.f, -1.f));
+            });
         Renderer3D::end_deferred_pass();
     }
 
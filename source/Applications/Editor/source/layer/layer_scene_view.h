@@ -3,6 +3,9 @@
 #include "core/layer.h"
 #include "entity/system/transform_hierarchy_system.h"
 #include "input/freefly_camera_system.h"
+#include "render/renderer_3d.h"
+
+#include <vector>
 
 namespace erwin
 {
@@ -40,6 +43,7 @@ private:
     erwin::FreeflyCameraSystem camera_controller_;
     erwin::TransformSystem transform_system_;
     bool freefly_mode_ = false;
+    std::vector<erwin::PBRDrawRecord> draw_records_; // Reused every frame
 };
 
 } // namespace editor
\ No newline at end of file
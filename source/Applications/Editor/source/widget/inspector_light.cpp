@@ -21,5 +21,23 @@ void inspector_GUI<ComponentDirectionalLight>(ComponentDirectionalLight& cmp, En
     ImGui::ColorEdit3("Amb. color", &cmp.ambient_color[0]);
 }
 
+template <>
+void inspector_GUI<ComponentPointLight>(ComponentPointLight& cmp, EntityID, Scene&)
+{
+    ImGui::SliderFloat("Brightness", &cmp.brightness, 0.0f, 30.0f);
+    ImGui::SliderFloat("Radius", &cmp.radius, 0.1f, 100.0f);
+    ImGui::ColorEdit3("Color", &cmp.color[0]);
+}
+
+template <>
+void inspector_GUI<ComponentSpotLight>(ComponentSpotLight& cmp, EntityID, Scene&)
+{
+    ImGui::SliderFloat("Brightness", &cmp.brightness, 0.0f, 30.0f);
+    ImGui::SliderFloat("Radius", &cmp.radius, 0.1f, 100.0f);
+    ImGui::SliderFloat("Outer angle", &cmp.outer_angle, 1.0f, 89.0f);
+    ImGui::SliderFloat("Inner angle", &cmp.inner_angle, 0.0f, cmp.outer_angle);
+    ImGui::ColorEdit3("Color", &cmp.color[0]);
+}
+
 
 } // namespace erwin
\ No newline at end of file
@@ -46,6 +46,8 @@ template <> void inspector_GUI<ComponentMesh>(ComponentMesh& cmp, EntityID e, Sc
             ImGui::EndPopup();
         }
     }
+
+    ImGui::Checkbox("Occluder", &cmp.occluder);
 }
 
 } // namespace erwin
\ No newline at end of file
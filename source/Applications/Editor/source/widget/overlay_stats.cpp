@@ -1,5 +1,6 @@
 #include "widget/overlay_stats.h"
 #include "erwin.h"
+#include "core/intern_string.h"
 #include "imgui.h"
 #include "imgui/imgui_utils.h"
 #include "level/scene.h"
@@ -27,11 +28,61 @@ void RenderStatsOverlay::on_imgui_render()
 #ifdef W_DEBUG
     const auto& r_stats = Renderer::get_stats();
 
-    ImGui::Text("Draw calls: %d", r_stats.draw_call_count);
+    ImGui::Text("Draw calls: %d (%d merged)", r_stats.draw_call_count, r_stats.merged_draw_call_count);
+    ImGui::Text("Uploads: %d (%d skipped)", r_stats.dependency_upload_misses, r_stats.dependency_upload_hits);
+    ImGui::Text("Meshes: %d visible (%d culled, %d occluded)", r_stats.visible_count, r_stats.culled_count,
+                r_stats.occluded_count);
+    // State cache: binds performed (binds skipped)
+    const auto& counters = r_stats.state_counters;
+    ImGui::Text("States: %d (%d cached), targets: %d", counters.state_changes, counters.state_hits,
+                counters.render_target_switches);
+    ImGui::Text("Shaders: %d (%d)  VAOs: %d (%d)", counters.shader_binds, counters.shader_hits, counters.VAO_binds,
+                counters.VAO_hits);
+    ImGui::Text("Textures: %d (%d)  Cubemaps: %d (%d)", counters.texture_binds, counters.texture_hits,
+                counters.cubemap_binds, counters.cubemap_hits);
+    if(counters.pending_shader_draws)
+        ImGui::Text("Draws waiting for shaders: %d", counters.pending_shader_draws);
     ImGui::Separator();
     ImGui::PlotVar("GPU Draw (µs)", r_stats.GPU_render_time, 0.0f, 7000.f);
     ImGui::PlotVar("CPU Flush (µs)", r_stats.CPU_flush_time, 0.0f, 7000.f);
     ImGui::PlotVarFlushOldEntries();
+
+    // Per-pass breakdown, GPU times lag a few frames behind
+    ImGui::Separator();
+    ImGui::Text("Sort: %.1f µs", r_stats.CPU_sort_time);
+    ImGui::Columns(6, "Passes");
+    ImGui::Text("Pass");
+    ImGui::NextColumn();
+    ImGui::Text("Draws");
+    ImGui::NextColumn();
+    ImGui::Text("Sort (µs)");
+    ImGui::NextColumn();
+    ImGui::Text("CPU (µs)");
+    ImGui::NextColumn();
+    ImGui::Text("Deps (µs)");
+    ImGui::NextColumn();
+    ImGui::Text("GPU (µs)");
+    ImGui::NextColumn();
+    ImGui::Separator();
+    for(const auto& pass : r_stats.passes)
+    {
+        if(pass.name != 0)
+            ImGui::Text("%s", istr::resolve(pass.name).c_str());
+        else
+            ImGui::Text("#%d", int(pass.layer_id));
+        ImGui::NextColumn();
+        ImGui::Text("%d", pass.draw_call_count);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f", pass.CPU_sort_time);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f", pass.CPU_dispatch_time);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f", pass.CPU_dependency_time);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f", pass.GPU_time);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
 #endif
 }
 
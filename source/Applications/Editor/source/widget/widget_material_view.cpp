@@ -67,9 +67,9 @@ void MaterialViewWidget::on_update(const GameClock& clock)
 {
     auto& scene = SceneManager::get("material_editor_scene"_h);
 
-    scene.view<ComponentTransform3D, ComponentCamera3D>().each([this, &clock](auto, auto& trans, auto& cam) {
+    scene.view<ComponentTransform3D, ComponentCamera3D>().each([this, &clock](auto e, auto& trans, auto& cam) {
         camera_controller_.update(clock, cam, trans);
-        Renderer3D::update_camera(cam, trans.local);
+        Renderer3D::update_camera(cam, trans.local, "material_editor_scene"_h ^ uint64_t(e));
     });
 
     scene.view<ComponentDirectionalLight>().each(
@@ -108,8 +108,8 @@ void MaterialViewWidget::on_layer_render()
     auto& scene = SceneManager::get("material_editor_scene"_h);
     Renderer3D::begin_deferred_pass();
     scene.view<ComponentTransform3D, ComponentMesh, ComponentPBRMaterial>().each(
-        [](auto, const auto& trans, const auto& mesh, const auto& mat) {
-            Renderer3D::draw_mesh_PBR_opaque(mesh.mesh, trans.local.get_model_matrix(), mat.material.texture_group, &mat.material_data);
+        [](auto e, const auto& trans, const auto& mesh, const auto& mat) {
+            Renderer3D::draw_mesh_PBR_opaque(mesh.mesh, trans.local.get_model_matrix(), mat.material.texture_group, &mat.material_data, uint64_t(e));
         });
     Renderer3D::end_deferred_pass();
 
@@ -111,6 +111,8 @@ void RTPeekWidget::register_texture(size_t pane_index, TextureHandle texture, co
 void RTPeekWidget::register_framebuffer(const std::string& framebuffer_name)
 {
     hash_t hframebuffer = H_(framebuffer_name.c_str());
+    // Transient framebuffers have no storage of their own to peek at
+    K_ASSERT(!FramebufferPool::is_transient(hframebuffer), "Cannot peek at a transient framebuffer.");
     FramebufferHandle fb = FramebufferPool::get_framebuffer(hframebuffer);
     bool has_depth = FramebufferPool::has_depth(hframebuffer);
     uint32_t ntex = Renderer::get_framebuffer_texture_count(fb);
@@ -29,6 +29,8 @@ template <> void erwin::inspector_GUI<ComponentMesh>(ComponentMesh&, EntityID, S
 template <> void erwin::inspector_GUI<ComponentPBRMaterial>(ComponentPBRMaterial&, EntityID, Scene&) {}
 template <> void erwin::inspector_GUI<ComponentDirectionalLightMaterial>(ComponentDirectionalLightMaterial&, EntityID, Scene&) {}
 template <> void erwin::inspector_GUI<ComponentDirectionalLight>(ComponentDirectionalLight&, EntityID, Scene&) {}
+template <> void erwin::inspector_GUI<ComponentPointLight>(ComponentPointLight&, EntityID, Scene&) {}
+template <> void erwin::inspector_GUI<ComponentSpotLight>(ComponentSpotLight&, EntityID, Scene&) {}
 template <> void erwin::inspector_GUI<ComponentScript>(ComponentScript&, EntityID, Scene&) {}
 
 
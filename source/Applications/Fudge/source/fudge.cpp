@@ -11,6 +11,7 @@
 
 #include "asset_registry.h"
 #include "atlas_packer.h"
+#include "mesh_simplifier.h"
 #include "texture_packer.h"
 #include "shader_packer.h"
 #include <kibble/logger/logger.h>
@@ -29,6 +30,7 @@ static bool     s_force_tom_rebuild = false; // If set to true, all TOM files wi
 static bool     s_force_cat_rebuild = false; // If set to true, all CAT files will be rebuilt, disregarding the asset registry content
 static bool     s_force_font_rebuild = false; // If set to true, all font files will be rebuilt, disregarding the asset registry content
 static bool     s_force_shader_rebuild = false; // If set to true, all shader files will be rebuilt, disregarding the asset registry content
+static bool     s_force_mesh_rebuild = false; // If set to true, all mesh LOD chains will be rebuilt, disregarding the asset registry content
 
 // Get path to executable
 static fs::path get_selfpath()
@@ -88,6 +90,7 @@ static void init_logger()
 {
     KLOGGER(create_channel("fudge", 3));
     KLOGGER(create_channel("shader", 3));
+    KLOGGER(create_channel("asset", 1));
     KLOGGER(attach_all("ConsoleSink", std::make_unique<kb::klog::ConsoleSink>()));
     KLOGGER(attach_all("MainFileSink", std::make_unique<kb::klog::LogFileSink>("fudge.log")));
     KLOGGER(set_single_threaded(true));
@@ -148,6 +151,7 @@ int main(int argc, char const *argv[])
     s_force_cat_rebuild    = s_force_rebuild || cmd_option_exists(argv, argv + argc, "--fcat");
     s_force_font_rebuild   = s_force_rebuild || cmd_option_exists(argv, argv + argc, "--ffont");
     s_force_shader_rebuild = s_force_rebuild || cmd_option_exists(argv, argv + argc, "--fshader");
+    s_force_mesh_rebuild   = s_force_rebuild || cmd_option_exists(argv, argv + argc, "--fmesh");
 
     // * Locate executable path, root directory, config directory, asset and fonts directories
     KLOGN("fudge") << "Locating unpacked assets." << std::endl;
@@ -295,6 +299,53 @@ int main(int argc, char const *argv[])
         KLOGW("fudge") << "Cannot find \"texmap\" node. Skipping texture maps packing." << std::endl;
     }
 
+    // ---------------- MESHES ----------------
+    rapidxml::xml_node<>* mesh_node = cfg.root->first_node("mesh");
+    if(mesh_node)
+    {
+        for(rapidxml::xml_node<>* batch=mesh_node->first_node("batch");
+            batch; batch=batch->next_sibling("batch"))
+        {
+            // Configure batch
+            std::string input_path, output_path;
+            if(!xml::parse_attribute(batch, "input", input_path)) continue;
+            if(!xml::parse_attribute(batch, "output", output_path)) continue;
+
+            std::vector<fudge::mesh::LODSpec> specs;
+            for(rapidxml::xml_node<>* lod_node=batch->first_node("lod");
+                lod_node; lod_node=lod_node->next_sibling("lod"))
+            {
+                fudge::mesh::LODSpec spec;
+                if(!xml::parse_attribute(lod_node, "ratio", spec.ratio)) continue;
+                if(!xml::parse_attribute(lod_node, "screen_size", spec.screen_size)) continue;
+                specs.push_back(spec);
+            }
+            if(specs.empty())
+            {
+                KLOGW("fudge") << "No LOD specified for mesh batch, skipping:" << std::endl;
+                KLOGI << kb::KS_PATH_ << input_path << std::endl;
+                continue;
+            }
+
+            KLOGN("fudge") << "Iterating meshes directory:" << std::endl;
+            KLOGI << kb::KS_PATH_ << input_path << kb::KC_ << std::endl;
+            for(auto& entry: fs::directory_iterator(s_root_path / input_path))
+            {
+                if(entry.is_regular_file() &&
+                   !entry.path().extension().string().compare(".wesh") &&
+                   (fudge::far::need_create(entry) || s_force_mesh_rebuild))
+                {
+                    KLOG("fudge",1) << "Processing mesh: " << kb::KS_NAME_ << entry.path().filename() << kb::KC_ << std::endl;
+                    fudge::mesh::make_lods(entry.path(), s_root_path / output_path, specs);
+                    KLOGR("fudge") << std::endl;
+                }
+            }
+        }
+
+        KLOGR("fudge") << "--------------------------------------------------------------------------------" << std::endl;
+        KLOGR("fudge") << std::endl;
+    }
+
     // ---------------- SHADERS ----------------
     if(fudge::spv::check_toolchain())
     {
@@ -0,0 +1,321 @@
+#include "mesh_simplifier.h"
+#include "filesystem/wesh_file.h"
+#include "core/core.h"
+#include <kibble/logger/logger.h>
+
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+using namespace erwin;
+
+namespace fudge
+{
+namespace mesh
+{
+
+// Symmetric 4x4 error quadric, only the upper triangle is stored
+struct Quadric
+{
+    std::array<double, 10> q = {};
+
+    static Quadric from_plane(const glm::dvec4& plane, double weight)
+    {
+        const double a = plane.x, b = plane.y, c = plane.z, d = plane.w;
+        Quadric Q;
+        Q.q = {a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+        for(auto& coeff : Q.q)
+            coeff *= weight;
+        return Q;
+    }
+
+    inline Quadric& operator+=(const Quadric& other)
+    {
+        for(size_t ii = 0; ii < q.size(); ++ii)
+            q[ii] += other.q[ii];
+        return *this;
+    }
+
+    inline Quadric operator+(const Quadric& other) const
+    {
+        Quadric Q(*this);
+        Q += other;
+        return Q;
+    }
+
+    // Squared distance of a point to the planes accumulated in this quadric
+    inline double error(const glm::vec3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x + q[4] * y * y +
+               2.0 * q[5] * y * z + 2.0 * q[6] * y + q[7] * z * z + 2.0 * q[8] * z + q[9];
+    }
+};
+
+// Candidate collapse of vertex 'from' onto vertex 'to'. The stamps detect stale candidates: a candidate is
+// only valid while neither vertex has been modified since it was pushed.
+struct Collapse
+{
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t from_stamp;
+    uint32_t to_stamp;
+
+    inline bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+class Simplifier
+{
+public:
+    Simplifier(const std::vector<float>& vertex_data, uint32_t vertex_size, const std::vector<uint32_t>& index_data)
+    {
+        // Position is the first attribute of a vertex
+        uint32_t vertex_count = uint32_t(vertex_data.size()) / vertex_size;
+        positions_.resize(vertex_count);
+        for(uint32_t ii = 0; ii < vertex_count; ++ii)
+            positions_[ii] = {vertex_data[ii * vertex_size + 0], vertex_data[ii * vertex_size + 1],
+                              vertex_data[ii * vertex_size + 2]};
+
+        quadrics_.resize(vertex_count);
+        locked_.resize(vertex_count, false);
+        removed_.resize(vertex_count, false);
+        stamps_.resize(vertex_count, 0);
+        vertex_triangles_.resize(vertex_count);
+
+        // Degenerate triangles are dropped
+        std::unordered_map<uint64_t, uint32_t> edge_uses;
+        for(size_t ii = 0; ii + 2 < index_data.size(); ii += 3)
+        {
+            std::array<uint32_t, 3> tri = {index_data[ii], index_data[ii + 1], index_data[ii + 2]};
+            if(tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+                continue;
+
+            uint32_t tri_index = uint32_t(triangles_.size());
+            triangles_.push_back(tri);
+            alive_.push_back(true);
+            for(uint32_t kk = 0; kk < 3; ++kk)
+            {
+                vertex_triangles_[tri[kk]].push_back(tri_index);
+                ++edge_uses[edge_key(tri[kk], tri[(kk + 1) % 3])];
+            }
+
+            // Area weighted plane quadric
+            glm::dvec3 p0(positions_[tri[0]]), p1(positions_[tri[1]]), p2(positions_[tri[2]]);
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(normal);
+            if(length == 0.0)
+                continue;
+            normal /= length;
+            Quadric Q = Quadric::from_plane(glm::dvec4(normal, -glm::dot(normal, p0)), 0.5 * length);
+            for(uint32_t kk = 0; kk < 3; ++kk)
+                quadrics_[tri[kk]] += Q;
+        }
+        live_count_ = uint32_t(triangles_.size());
+
+        // Edges that are not shared by exactly two triangles lie on a border, a UV seam or a non-manifold
+        // feature. Their vertices cannot move without tearing the mesh apart.
+        for(auto&& [key, uses] : edge_uses)
+        {
+            if(uses != 2)
+            {
+                locked_[uint32_t(key >> 32)] = true;
+                locked_[uint32_t(key & 0xffffffff)] = true;
+            }
+        }
+
+        for(uint32_t vv = 0; vv < vertex_count; ++vv)
+            push_candidates(vv);
+    }
+
+    // Collapse edges by increasing cost until the triangle count reaches the target, or no valid collapse
+    // remains
+    void reduce(uint32_t target_triangle_count)
+    {
+        while(live_count_ > target_triangle_count && !candidates_.empty())
+        {
+            Collapse collapse = candidates_.top();
+            candidates_.pop();
+            if(removed_[collapse.from] || removed_[collapse.to] || stamps_[collapse.from] != collapse.from_stamp ||
+               stamps_[collapse.to] != collapse.to_stamp)
+                continue;
+            if(try_collapse(collapse.from, collapse.to))
+                push_candidates(collapse.to);
+        }
+    }
+
+    std::vector<uint32_t> get_indices() const
+    {
+        std::vector<uint32_t> indices;
+        indices.reserve(live_count_ * 3);
+        for(size_t ii = 0; ii < triangles_.size(); ++ii)
+            if(alive_[ii])
+                indices.insert(indices.end(), triangles_[ii].begin(), triangles_[ii].end());
+        return indices;
+    }
+
+private:
+    static inline uint64_t edge_key(uint32_t a, uint32_t b)
+    {
+        return (uint64_t(std::min(a, b)) << 32) | uint64_t(std::max(a, b));
+    }
+
+    inline glm::vec3 triangle_normal(const std::array<uint32_t, 3>& tri) const
+    {
+        return glm::cross(positions_[tri[1]] - positions_[tri[0]], positions_[tri[2]] - positions_[tri[0]]);
+    }
+
+    void push_candidate(uint32_t from, uint32_t to)
+    {
+        if(locked_[from])
+            return;
+        double cost = (quadrics_[from] + quadrics_[to]).error(positions_[to]);
+        candidates_.push({cost, from, to, stamps_[from], stamps_[to]});
+    }
+
+    // Push the collapses of all edges around a vertex, in both directions
+    void push_candidates(uint32_t vertex)
+    {
+        auto& tris = vertex_triangles_[vertex];
+        tris.erase(std::remove_if(tris.begin(), tris.end(), [this](uint32_t tt) { return !alive_[tt]; }), tris.end());
+        for(uint32_t tt : tris)
+        {
+            for(uint32_t other : triangles_[tt])
+            {
+                if(other == vertex)
+                    continue;
+                push_candidate(vertex, other);
+                push_candidate(other, vertex);
+            }
+        }
+    }
+
+    bool try_collapse(uint32_t from, uint32_t to)
+    {
+        // Reject collapses that would flip a triangle that survives them
+        for(uint32_t tt : vertex_triangles_[from])
+        {
+            const auto& tri = triangles_[tt];
+            if(!alive_[tt] || std::find(tri.begin(), tri.end(), to) != tri.end())
+                continue;
+            auto moved = tri;
+            std::replace(moved.begin(), moved.end(), from, to);
+            if(glm::dot(triangle_normal(tri), triangle_normal(moved)) <= 0.f)
+                return false;
+        }
+
+        // Triangles sharing the edge vanish, the others are reattached to the target vertex
+        for(uint32_t tt : vertex_triangles_[from])
+        {
+            if(!alive_[tt])
+                continue;
+            auto& tri = triangles_[tt];
+            if(std::find(tri.begin(), tri.end(), to) != tri.end())
+            {
+                alive_[tt] = false;
+                --live_count_;
+                continue;
+            }
+            std::replace(tri.begin(), tri.end(), from, to);
+            vertex_triangles_[to].push_back(tt);
+        }
+
+        quadrics_[to] += quadrics_[from];
+        removed_[from] = true;
+        vertex_triangles_[from].clear();
+        ++stamps_[to];
+        return true;
+    }
+
+private:
+    std::vector<glm::vec3> positions_;
+    std::vector<Quadric> quadrics_;
+    std::vector<bool> locked_;
+    std::vector<bool> removed_;
+    std::vector<uint32_t> stamps_;
+    std::vector<std::vector<uint32_t>> vertex_triangles_;
+    std::vector<std::array<uint32_t, 3>> triangles_;
+    std::vector<bool> alive_;
+    uint32_t live_count_ = 0;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> candidates_;
+};
+
+std::vector<std::vector<uint32_t>> simplify(const std::vector<float>& vertex_data, uint32_t vertex_size,
+                                            const std::vector<uint32_t>& index_data,
+                                            const std::vector<uint32_t>& target_triangle_counts)
+{
+    // Each level continues the reduction of the previous one, so the quadrics keep the error accumulated
+    // with respect to the full resolution mesh
+    Simplifier simplifier(vertex_data, vertex_size, index_data);
+    std::vector<std::vector<uint32_t>> levels;
+    for(uint32_t target : target_triangle_counts)
+    {
+        simplifier.reduce(target);
+        levels.push_back(simplifier.get_indices());
+    }
+    return levels;
+}
+
+void make_lods(const fs::path& wesh_path, const fs::path& output_dir, const std::vector<LODSpec>& specs)
+{
+    std::ifstream ifs(wesh_path, std::ios::binary);
+    if(!ifs.is_open())
+    {
+        KLOGE("fudge") << "Cannot open WESH file:" << std::endl;
+        KLOGI << kb::KS_PATH_ << wesh_path << std::endl;
+        return;
+    }
+    wesh::WeshDescriptor descriptor = wesh::read(ifs);
+    ifs.close();
+
+    // Existing levels of detail are regenerated from the full resolution level
+    const auto& full = descriptor.lods[0];
+    std::vector<uint32_t> indices(descriptor.index_data.begin() + full.first_index,
+                                  descriptor.index_data.begin() + full.first_index + full.index_count);
+    uint32_t triangle_count = full.index_count / 3;
+
+    auto sorted_specs = specs;
+    std::sort(sorted_specs.begin(), sorted_specs.end(),
+              [](const LODSpec& a, const LODSpec& b) { return a.ratio > b.ratio; });
+    std::vector<uint32_t> targets;
+    for(const auto& spec : sorted_specs)
+        targets.push_back(uint32_t(float(triangle_count) * spec.ratio));
+    auto levels = simplify(descriptor.vertex_data, descriptor.vertex_size, indices, targets);
+
+    wesh::WeshDescriptor output;
+    output.extent = descriptor.extent;
+    output.vertex_size = descriptor.vertex_size;
+    output.vertex_data = std::move(descriptor.vertex_data);
+    output.index_data = std::move(indices);
+    output.lods.push_back({0, full.index_count, 1.f});
+
+    KLOG("fudge", 1) << "LOD 0: " << kb::KS_VALU_ << triangle_count << kb::KC_ << " triangles" << std::endl;
+    for(size_t ii = 0; ii < levels.size(); ++ii)
+    {
+        // Stop as soon as a level fails to reduce the previous one, the coarser ones would not either
+        uint32_t index_count = uint32_t(levels[ii].size());
+        if(index_count >= output.lods.back().index_count)
+        {
+            KLOGW("fudge") << "Mesh cannot be simplified further, dropping the coarser levels of detail." << std::endl;
+            break;
+        }
+        output.lods.push_back({uint32_t(output.index_data.size()), index_count, sorted_specs[ii].screen_size});
+        output.index_data.insert(output.index_data.end(), levels[ii].begin(), levels[ii].end());
+        KLOG("fudge", 1) << "LOD " << ii + 1 << ": " << kb::KS_VALU_ << index_count / 3 << kb::KC_ << " triangles"
+                         << std::endl;
+    }
+
+    fs::path output_path = output_dir / wesh_path.filename();
+    if(!wesh::write(output_path, output))
+    {
+        KLOGE("fudge") << "Cannot write WESH file:" << std::endl;
+        KLOGI << kb::KS_PATH_ << output_path << std::endl;
+    }
+}
+
+} // namespace mesh
+} // namespace fudge
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace fudge
+{
+namespace mesh
+{
+
+struct LODSpec
+{
+    float ratio;       // Triangle count of the level, relative to the full resolution mesh
+    float screen_size; // Projected size (fraction of the viewport height) under which the level is used
+};
+
+// Quadric error simplification of an indexed triangle list. Edges are collapsed onto one of their
+// vertices, so the vertex data is left untouched and only new index lists are produced. Vertices on a
+// border edge (mesh borders and attribute seams alike) are locked. One index list is returned per target
+// triangle count, targets must be in decreasing order.
+extern std::vector<std::vector<uint32_t>> simplify(const std::vector<float>& vertex_data, uint32_t vertex_size,
+                                                   const std::vector<uint32_t>& index_data,
+                                                   const std::vector<uint32_t>& target_triangle_counts);
+// Generate the LOD chain of a WESH file and export it to the output directory
+extern void make_lods(const fs::path& wesh_path, const fs::path& output_dir, const std::vector<LODSpec>& specs);
+
+} // namespace mesh
+} // namespace fudge
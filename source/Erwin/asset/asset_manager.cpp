@@ -1,6 +1,7 @@
 #include "asset/asset_manager.h"
 #include "asset/atlas_loader.h"
 #include "asset/environment_loader.h"
+#include "asset/ibl_cache.h"
 #include "asset/material_loader.h"
 #include "asset/mesh_loader.h"
 #include "asset/resource_cache.hpp"
@@ -9,6 +10,7 @@
 #include "core/application.h"
 #include "core/intern_string.h"
 #include "entity/component/PBR_material.h"
+#include "render/common_geometry.h"
 #include "render/renderer.h"
 #include "utils/future.hpp"
 
@@ -54,6 +56,7 @@ static struct
     std::array<AssetRegistry, k_max_asset_registries> registry;
 
     std::map<hash_t, TextureHandle> special_textures_cache_;
+    std::map<hash_t, std::shared_ptr<const MeshGeometry>> occluder_geometry_cache_;
 
 } s_storage;
 
@@ -74,6 +77,36 @@ template <typename ManagerT> static void release_if_not_shared(size_t reg, hash_
         manager.release(handle);
 }
 
+// CPU geometry of a mesh is dropped along with the mesh
+static void release_mesh(size_t reg, hash_t hname)
+{
+    release_if_not_shared(reg, hname, s_storage.mesh_cache);
+    if(!s_storage.mesh_cache.has(hname))
+        s_storage.occluder_geometry_cache_.erase(hname);
+}
+
+const MeshGeometry* AssetManager::get_occluder_geometry(const Mesh& mesh)
+{
+    auto it = s_storage.occluder_geometry_cache_.find(mesh.resource_id);
+    if(it != s_storage.occluder_geometry_cache_.end())
+        return it->second.get();
+
+    W_PROFILE_FUNCTION()
+
+    // Failures are cached as well, so that files are not read again every frame
+    std::shared_ptr<const MeshGeometry> geometry;
+    if(mesh.procedural)
+        geometry = CommonGeometry::make_occluder_geometry(mesh.resource_id);
+    else if(s_storage.mesh_cache.has(mesh.resource_id))
+    {
+        auto descriptor = wesh::read(s_storage.mesh_cache.get_meta_data(mesh.resource_id).file_path);
+        const auto& lod = descriptor.lods[std::min(descriptor.lods.size(), size_t(k_max_mesh_lods)) - 1];
+        geometry = MeshGeometry::make(descriptor.vertex_data, descriptor.vertex_size,
+                                      descriptor.index_data.data() + lod.first_index, lod.index_count);
+    }
+    return s_storage.occluder_geometry_cache_.emplace(mesh.resource_id, geometry).first->second.get();
+}
+
 TextureHandle AssetManager::create_debug_texture(hash_t type, uint32_t size_px)
 {
     W_PROFILE_FUNCTION()
@@ -183,7 +216,7 @@ template <> void AssetManager::release<ComponentPBRMaterial>(size_t reg, hash_t
 
 template <> void AssetManager::release<Mesh>(size_t reg, hash_t hname)
 {
-    release_if_not_shared(reg, hname, s_storage.mesh_cache);
+    release_mesh(reg, hname);
     s_storage.registry[reg].erase(hname);
 }
 
@@ -324,6 +357,7 @@ void AssetManager::launch_async_tasks()
 
 void AssetManager::update()
 {
+    IBLCache::update();
     s_storage.environment_cache.sync_work();
     s_storage.mesh_cache.sync_work();
     s_storage.material_cache.sync_work();
@@ -362,7 +396,7 @@ static void release_by_type(size_t reg, hash_t hname, AssetMetaData::AssetType t
         release_if_not_shared(reg, hname, s_storage.font_atlas_cache);
         break;
     case AssetMetaData::AssetType::MeshWESH:
-        release_if_not_shared(reg, hname, s_storage.mesh_cache);
+        release_mesh(reg, hname);
         break;
     default:
         break;
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <future>
 #include <map>
+#include <memory>
 #include <optional>
 
 namespace erwin
@@ -15,6 +16,7 @@ namespace erwin
 
 struct ComponentPBRMaterial;
 struct Mesh;
+struct MeshGeometry;
 struct TextureAtlas;
 struct FontAtlas;
 struct Environment;
@@ -46,6 +48,18 @@ public:
      */
     static TextureHandle create_debug_texture(hash_t type, uint32_t size_px);
 
+    /**
+     * @brief      Get the CPU geometry used to rasterize a mesh as an occluder,
+     *             made of its coarsest level of detail. It is loaded on first
+     *             request, and kept until the mesh is released.
+     *
+     * @param[in]  mesh  A mesh loaded by the asset manager, or a common
+     *                   geometry mesh.
+     *
+     * @return     The geometry, or null if the mesh is not made of triangles.
+     */
+    static const MeshGeometry* get_occluder_geometry(const Mesh& mesh);
+
     /**
      * @brief      Load any resource synchronously or get it from cache.
      *
@@ -17,12 +17,21 @@ AssetMetaData EnvironmentLoader::build_meta_data(const std::string& file_path)
     return {file_path, AssetMetaData::AssetType::EnvironmentHDR};
 }
 
-Texture2DDescriptor EnvironmentLoader::load_from_file(const AssetMetaData& meta_data)
+EnvironmentDescriptor EnvironmentLoader::load_from_file(const AssetMetaData& meta_data)
 {
     KLOG("asset", 1) << "Loading environment:" << std::endl;
     KLOGI << kb::KS_PATH_ << meta_data.file_path << std::endl;
 
-    Texture2DDescriptor descriptor;
+    EnvironmentDescriptor descriptor;
+
+    // Skip the HDR file and the precompute if the generated cubemaps were cached
+    descriptor.cache_key = IBLCache::make_key(meta_data.file_path);
+    if(IBLCache::load(descriptor.cache_key, descriptor.maps))
+    {
+        KLOGI << "Cubemaps found in IBL cache" << std::endl;
+        descriptor.cached = true;
+        return descriptor;
+    }
 
     // Load HDR file
     img::HDRDescriptor hdrfile{meta_data.file_path};
@@ -37,26 +46,36 @@ Texture2DDescriptor EnvironmentLoader::load_from_file(const AssetMetaData& meta_
         KLOGW("asset") << "HDR file must be in 2:1 format (width = 2 * height) for optimal results." << std::endl;
     }
 
-    descriptor.width = hdrfile.width;
-    descriptor.height = hdrfile.height;
-    descriptor.mips = 0;
-    descriptor.data = hdrfile.data;
-    descriptor.image_format = ImageFormat::RGB32F;
-    descriptor.flags = TF_MUST_FREE; // Let the renderer free the resources once the texture is loaded
+    descriptor.hdr.width = hdrfile.width;
+    descriptor.hdr.height = hdrfile.height;
+    descriptor.hdr.mips = 0;
+    descriptor.hdr.data = hdrfile.data;
+    descriptor.hdr.image_format = ImageFormat::RGB32F;
+    descriptor.hdr.flags = TF_MUST_FREE; // Let the renderer free the resources once the texture is loaded
 
     return descriptor;
 }
 
-Environment EnvironmentLoader::upload(const Texture2DDescriptor& descriptor, hash_t resource_id)
+Environment EnvironmentLoader::upload(const EnvironmentDescriptor& descriptor, hash_t resource_id)
 {
     Environment environment;
-    TextureHandle handle = Renderer::create_texture_2D(descriptor);
-    environment.size = descriptor.height;
+    environment.resource_id = resource_id;
+    if(descriptor.cached)
+    {
+        environment.size = descriptor.maps.environment_map.width;
+        environment.environment_map = Renderer::create_cubemap(descriptor.maps.environment_map);
+        environment.diffuse_irradiance_map = Renderer::create_cubemap(descriptor.maps.diffuse_irradiance_map);
+        environment.prefiltered_map = Renderer::create_cubemap(descriptor.maps.prefiltered_map);
+        return environment;
+    }
+
+    TextureHandle handle = Renderer::create_texture_2D(descriptor.hdr);
+    environment.size = descriptor.hdr.height;
     environment.environment_map = Renderer3D::generate_cubemap_hdr(handle, environment.size);
     environment.diffuse_irradiance_map = Renderer3D::generate_irradiance_map(environment.environment_map);
     environment.prefiltered_map = Renderer3D::generate_prefiltered_map(environment.environment_map, environment.size);
-    environment.resource_id = resource_id;
     Renderer::destroy(handle);
+    IBLCache::save(descriptor.cache_key, environment);
 
     return environment;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "asset/environment.h"
+#include "asset/ibl_cache.h"
 #include "asset/loader_common.h"
 #include "render/texture_common.h"
 
@@ -8,11 +9,19 @@
 namespace erwin
 {
 
+struct EnvironmentDescriptor
+{
+    uint64_t cache_key = 0;
+    bool cached = false; // The cubemaps were found in the IBL cache, there is no HDR data to convert
+    Texture2DDescriptor hdr;
+    IBLMaps maps;
+};
+
 class EnvironmentLoader
 {
 public:
     using Resource = Environment;
-    using DataDescriptor = Texture2DDescriptor;
+    using DataDescriptor = EnvironmentDescriptor;
 
     static AssetMetaData build_meta_data(const std::string& file_path);
     static DataDescriptor load_from_file(const AssetMetaData& meta_data);
@@ -0,0 +1,301 @@
+#include "asset/ibl_cache.h"
+#include "core/application.h"
+#include "core/z_wrapper.h"
+#include "filesystem/atomic_write.h"
+#include "render/renderer.h"
+#include "render/renderer_config.h"
+#include "utils/fnv1a.hpp"
+#include <kibble/logger/logger.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace erwin
+{
+
+// Helpers for stream read/write pointer cast
+// Only well defined for PODs
+template <typename T, typename = std::enable_if_t<std::is_standard_layout_v<T> && std::is_trivial_v<T>>>
+static inline char* opaque_cast(T* in)
+{
+    return reinterpret_cast<char*>(in);
+}
+
+template <typename T, typename = std::enable_if_t<std::is_standard_layout_v<T> && std::is_trivial_v<T>>>
+static inline const char* opaque_cast(const T* in)
+{
+    return reinterpret_cast<const char*>(in);
+}
+
+struct IBLCacheHeader
+{
+    uint32_t magic;            // Magic number to check file format validity
+    uint32_t version;          // Format version
+    uint64_t key;              // Entry key, guards against hash collisions in file names
+    uint32_t environment_size; // Size of the environment map, the other cubemaps have a fixed size
+    uint32_t blob_sizes[3];    // Size of the deflated data of each cubemap
+};
+
+#define IBL_MAGIC 0x4c424945 // ASCII(EIBL)
+#define IBL_VERSION 1        // Also bump this when the IBL precompute shaders change
+
+// Cubemaps of an environment that were generated, and are being read back
+struct PendingEntry
+{
+    fs::path path;
+    uint64_t key;
+    uint32_t environment_size;
+    std::array<std::future<PixelData>, 3> pixel_data;
+};
+
+static struct
+{
+    std::vector<PendingEntry> pending;
+    std::vector<std::future<void>> writes;
+} s_storage;
+
+static inline bool is_enabled() { return CFG_.get<bool>("erwin.renderer.ibl_cache"_h, true); }
+
+static fs::path entry_path(uint64_t key)
+{
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return WFS_.get_aliased_directory("usr"_h) / "ibl_cache" / ss.str();
+}
+
+static inline std::array<CubemapDescriptor*, 3> as_array(IBLMaps& maps)
+{
+    return {&maps.environment_map, &maps.diffuse_irradiance_map, &maps.prefiltered_map};
+}
+
+static inline size_t data_size(const CubemapDescriptor& descriptor)
+{
+    return cubemap_mip_chain_size(descriptor.width, descriptor.mips, descriptor.image_format);
+}
+
+uint64_t IBLCache::make_key(const std::string& hdr_path)
+{
+    std::string contents = WFS_.get_file_as_string(hdr_path);
+    uint64_t key = fnv1a(contents.data(), contents.size());
+
+    // Precompute parameters
+    const uint32_t parameters[] = {IBL_VERSION, k_environment_map_mips, k_irradiance_map_size, k_prefiltered_map_size,
+                                   k_prefiltered_map_mips};
+    key = fnv1a(parameters, sizeof(parameters), key);
+    key = fnv1a(&k_irradiance_delta_sample, sizeof(float), key);
+    return key;
+}
+
+IBLMaps IBLCache::describe(uint32_t environment_size)
+{
+    IBLMaps maps;
+    maps.environment_map.width = environment_size;
+    maps.environment_map.height = environment_size;
+    maps.environment_map.mips = k_environment_map_mips;
+    maps.environment_map.filter = MIN_LINEAR_MIPMAP_LINEAR | MAG_LINEAR;
+
+    maps.diffuse_irradiance_map.width = k_irradiance_map_size;
+    maps.diffuse_irradiance_map.height = k_irradiance_map_size;
+    maps.diffuse_irradiance_map.mips = 0;
+    maps.diffuse_irradiance_map.filter = MIN_LINEAR | MAG_LINEAR;
+
+    maps.prefiltered_map.width = k_prefiltered_map_size;
+    maps.prefiltered_map.height = k_prefiltered_map_size;
+    maps.prefiltered_map.mips = k_prefiltered_map_mips;
+    maps.prefiltered_map.filter = MIN_LINEAR_MIPMAP_LINEAR | MAG_LINEAR;
+
+    for(auto* descriptor : as_array(maps))
+    {
+        descriptor->image_format = ImageFormat::RGB16F;
+        descriptor->wrap = TextureWrap::CLAMP_TO_EDGE;
+    }
+    return maps;
+}
+
+bool IBLCache::load(uint64_t key, IBLMaps& maps)
+{
+    W_PROFILE_FUNCTION()
+
+    if(!is_enabled())
+        return false;
+
+    std::ifstream ifs(entry_path(key), std::ios::binary);
+    if(!ifs.is_open())
+        return false;
+
+    IBLCacheHeader header;
+    ifs.read(opaque_cast(&header), sizeof(IBLCacheHeader));
+    if(!ifs || header.magic != IBL_MAGIC || header.version != IBL_VERSION || header.key != key)
+        return false;
+
+    maps = describe(header.environment_size);
+    auto descriptors = as_array(maps);
+    std::vector<uint8_t> blob;
+    for(size_t ii = 0; ii < descriptors.size(); ++ii)
+    {
+        blob.resize(header.blob_sizes[ii]);
+        ifs.read(opaque_cast(blob.data()), long(header.blob_sizes[ii]));
+
+        size_t size = data_size(*descriptors[ii]);
+        auto* texels = new uint8_t[size];
+        if(!ifs || erwin::uncompress_data(blob.data(), int(blob.size()), texels, int(size)) != int(size))
+        {
+            KLOGW("asset") << "Corrupted IBL cache entry, ignored." << std::endl;
+            delete[] texels;
+            for(size_t jj = 0; jj < ii; ++jj)
+                descriptors[jj]->release();
+            maps = IBLMaps();
+            return false;
+        }
+        descriptors[ii]->mip_data = texels;
+        descriptors[ii]->must_free = true;
+    }
+
+    return true;
+}
+
+void IBLCache::save(uint64_t key, const Environment& environment)
+{
+    if(!is_enabled())
+        return;
+
+    PendingEntry entry;
+    entry.path = entry_path(key);
+    entry.key = key;
+    entry.environment_size = environment.size;
+    entry.pixel_data = {Renderer::get_pixel_data(environment.environment_map),
+                        Renderer::get_pixel_data(environment.diffuse_irradiance_map),
+                        Renderer::get_pixel_data(environment.prefiltered_map)};
+    s_storage.pending.push_back(std::move(entry));
+}
+
+// Cubemaps that were never drawn to are read back as zeros
+static inline bool has_content(const uint8_t* data, size_t size)
+{
+    return std::any_of(data, data + size, [](uint8_t value) { return value != 0; });
+}
+
+static bool write_entry(const fs::path& path, uint64_t key, uint32_t environment_size,
+                        const std::array<const uint8_t*, 3>& data, const std::array<size_t, 3>& sizes)
+{
+    IBLCacheHeader header;
+    header.magic = IBL_MAGIC;
+    header.version = IBL_VERSION;
+    header.key = key;
+    header.environment_size = environment_size;
+
+    std::array<std::vector<uint8_t>, 3> blobs;
+    for(size_t ii = 0; ii < blobs.size(); ++ii)
+    {
+        // An empty map means that its generation draw call did not execute, the entry would be wrong forever
+        if(!has_content(data[ii], sizes[ii]))
+        {
+            KLOGW("asset") << "Generated IBL cubemap is empty, cache entry not saved." << std::endl;
+            return false;
+        }
+
+        blobs[ii].resize(size_t(erwin::get_max_compressed_len(int(sizes[ii]))));
+        int size = erwin::compress_data(data[ii], int(sizes[ii]), blobs[ii].data(), int(blobs[ii].size()));
+        if(size < 0)
+        {
+            KLOGW("asset") << "Cannot compress IBL cache entry." << std::endl;
+            return false;
+        }
+        header.blob_sizes[ii] = uint32_t(size);
+    }
+
+    bool written = write_file_atomic(path, [&header, &blobs](std::ostream& os) {
+        os.write(opaque_cast(&header), sizeof(IBLCacheHeader));
+        for(size_t ii = 0; ii < blobs.size(); ++ii)
+            os.write(opaque_cast(blobs[ii].data()), long(header.blob_sizes[ii]));
+    });
+    if(!written)
+    {
+        KLOGW("asset") << "Cannot write IBL cache entry:" << std::endl;
+        KLOGI << kb::KS_PATH_ << path << std::endl;
+    }
+    return written;
+}
+
+// Worker side of save(), takes ownership of the pixel data
+static void write_pixel_data(const fs::path& path, uint64_t key, uint32_t environment_size,
+                             const std::array<PixelData, 3>& pixel_data)
+{
+    write_entry(path, key, environment_size, {pixel_data[0].data, pixel_data[1].data, pixel_data[2].data},
+                {pixel_data[0].size, pixel_data[1].size, pixel_data[2].size});
+    for(const auto& data : pixel_data)
+        delete[] data.data;
+}
+
+bool IBLCache::write(uint64_t key, const IBLMaps& maps)
+{
+    W_PROFILE_FUNCTION()
+
+    if(!is_enabled())
+        return false;
+
+    const std::array<const CubemapDescriptor*, 3> descriptors = {&maps.environment_map, &maps.diffuse_irradiance_map,
+                                                                 &maps.prefiltered_map};
+    std::array<const uint8_t*, 3> data;
+    std::array<size_t, 3> sizes;
+    for(size_t ii = 0; ii < descriptors.size(); ++ii)
+    {
+        if(descriptors[ii]->mip_data == nullptr)
+            return false;
+        data[ii] = static_cast<const uint8_t*>(descriptors[ii]->mip_data);
+        sizes[ii] = data_size(*descriptors[ii]);
+    }
+    return write_entry(entry_path(key), key, maps.environment_map.width, data, sizes);
+}
+
+void IBLCache::update()
+{
+    auto is_ready = [](auto& fut) { return fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+
+    for(auto it = s_storage.writes.begin(); it != s_storage.writes.end();)
+    {
+        if(is_ready(*it))
+            it = s_storage.writes.erase(it);
+        else
+            ++it;
+    }
+
+    for(auto it = s_storage.pending.begin(); it != s_storage.pending.end();)
+    {
+        if(!std::all_of(it->pixel_data.begin(), it->pixel_data.end(), is_ready))
+        {
+            ++it;
+            continue;
+        }
+
+        std::array<PixelData, 3> pixel_data = {it->pixel_data[0].get(), it->pixel_data[1].get(),
+                                               it->pixel_data[2].get()};
+        // Backends that cannot read cubemaps back hand out no data
+        IBLMaps maps = describe(it->environment_size);
+        auto descriptors = as_array(maps);
+        bool complete = true;
+        for(size_t ii = 0; ii < descriptors.size(); ++ii)
+            complete &= (pixel_data[ii].data != nullptr && pixel_data[ii].size == data_size(*descriptors[ii]));
+
+        if(complete)
+        {
+            // Deflating takes a while, it is done off the main thread
+            s_storage.writes.push_back(std::async(std::launch::async, write_pixel_data, it->path, it->key,
+                                                  it->environment_size, pixel_data));
+        }
+        else
+        {
+            for(const auto& data : pixel_data)
+                delete[] data.data;
+        }
+        it = s_storage.pending.erase(it);
+    }
+}
+
+} // namespace erwin
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "asset/environment.h"
+#include "render/texture_common.h"
+
+namespace fs = std::filesystem;
+
+namespace erwin
+{
+
+// Cubemaps of a precomputed environment, with their data when they were read from the cache
+struct IBLMaps
+{
+    CubemapDescriptor environment_map;
+    CubemapDescriptor diffuse_irradiance_map;
+    CubemapDescriptor prefiltered_map;
+};
+
+// On-disk cache of the cubemaps generated from HDR environments. Entries are keyed by a hash of the HDR file
+// and of the precompute parameters of renderer_config.h, an edit of either invalidates them. The generated
+// cubemaps are read back asynchronously, deflated and written by a worker thread a few frames after generation.
+// Entries are stored in the "ibl_cache" directory of the user directory, the cache can be disabled with the
+// "erwin.renderer.ibl_cache" configuration key.
+class IBLCache
+{
+public:
+    // Compute the cache key of an HDR environment file
+    static uint64_t make_key(const std::string& hdr_path);
+    // Describe the cubemaps generated from an environment map of a given size, without data
+    static IBLMaps describe(uint32_t environment_size);
+    // Read a cache entry, cubemap data is handed to the renderer which will free it. Returns false on a cache miss.
+    static bool load(uint64_t key, IBLMaps& maps);
+    // Read back the cubemaps of a freshly generated environment and save them once they are available
+    // The generation draw calls must be blocking (see DrawCall::set_blocking()), entries whose cubemaps were never
+    // drawn to are not saved.
+    static void save(uint64_t key, const Environment& environment);
+    // Write an entry right away, from the cubemap data of the maps. Returns false if the entry was not written.
+    static bool write(uint64_t key, const IBLMaps& maps);
+    // Write the entries whose cubemaps have been read back, should be called once per frame
+    static void update();
+};
+
+} // namespace erwin
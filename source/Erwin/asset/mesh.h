@@ -1,11 +1,54 @@
 #pragma once
 
+#include <memory>
+#include <vector>
 #include "render/handles.h"
 #include "asset/bounding.h"
 
 namespace erwin
 {
 
+// Maximum amount of levels of detail of a mesh, full resolution level included
+[[maybe_unused]] static constexpr uint32_t k_max_mesh_lods = 4;
+
+// A coarser level of detail, as a range of the mesh index buffer sharing the vertices of the mesh
+struct MeshLOD
+{
+	uint32_t first_index = 0;
+	uint32_t index_count = 0;
+	float screen_size = 0.f; // Projected size (fraction of the viewport height) under which this level is used
+};
+
+// Model-space triangles of a mesh kept on the CPU, so that it can be rasterized as an occluder.
+// Only built for meshes used as occluders, from their coarsest level of detail (see AssetManager).
+struct MeshGeometry
+{
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+
+	// Extract the vertices referenced by a range of indices from interleaved vertex data, position must be
+	// the first attribute of a vertex
+	static inline std::shared_ptr<const MeshGeometry> make(const std::vector<float>& vertex_data, uint32_t vertex_size,
+	                                                       const uint32_t* indices, uint32_t index_count)
+	{
+		auto geometry = std::make_shared<MeshGeometry>();
+		std::vector<uint32_t> remap(vertex_data.size() / vertex_size, ~0u);
+		geometry->indices.resize(index_count);
+		for(uint32_t ii = 0; ii < index_count; ++ii)
+		{
+			uint32_t& index = remap[indices[ii]];
+			if(index == ~0u)
+			{
+				index = uint32_t(geometry->positions.size());
+				const float* position = &vertex_data[indices[ii] * vertex_size];
+				geometry->positions.push_back({position[0], position[1], position[2]});
+			}
+			geometry->indices[ii] = index;
+		}
+		return geometry;
+	}
+};
+
 struct Mesh
 {
 	VertexArrayHandle VAO;
@@ -13,6 +56,31 @@ struct Mesh
 	Extent extent;
 	hash_t resource_id;
 	bool procedural = false;
+	uint32_t index_count = 0;   // Number of indices of the mesh, at full resolution
+	uint32_t first_index = 0;   // Offset of the first index in the index buffer
+	uint32_t vertex_offset = 0; // Vertex range in the vertex buffer, only meaningful for pooled meshes
+	uint32_t vertex_count = 0;
+	uint32_t index_range = 0;   // Indices allocated to the mesh from first_index, all levels of detail included, only meaningful for pooled meshes
+	uint32_t lod_count = 1;     // Level 0 is the full resolution mesh, level ii > 0 is lods[ii-1]
+	MeshLOD lods[k_max_mesh_lods - 1];
+
+	inline uint32_t get_first_index(uint32_t lod) const { return (lod == 0) ? first_index : lods[lod - 1].first_index; }
+	inline uint32_t get_index_count(uint32_t lod) const { return (lod == 0) ? index_count : lods[lod - 1].index_count; }
+
+	// Select a level of detail from the projected size of the mesh. The thresholds of the levels at or
+	// below the current one are widened by the hysteresis ratio, and the others narrowed, so that a mesh
+	// hovering around a threshold does not switch back and forth.
+	inline uint32_t select_lod(float screen_size, uint32_t current_lod, float hysteresis) const
+	{
+		uint32_t lod = 0;
+		for(uint32_t ii = 1; ii < lod_count; ++ii)
+		{
+			float threshold = lods[ii - 1].screen_size * ((ii <= current_lod) ? (1.f + hysteresis) : (1.f - hysteresis));
+			if(screen_size < threshold)
+				lod = ii;
+		}
+		return lod;
+	}
 };
 
-} // namespace erwin
\ No newline at end of file
+} // namespace erwin
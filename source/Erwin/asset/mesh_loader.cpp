@@ -1,7 +1,10 @@
 #include "asset/mesh_loader.h"
 #include "core/application.h"
+#include "render/geometry_pool.h"
 #include "render/renderer.h"
 
+#include <algorithm>
+
 namespace erwin
 {
 
@@ -33,15 +36,29 @@ Mesh MeshLoader::upload(const wesh::WeshDescriptor& descriptor, hash_t resource_
         {"a_uv"_h, ShaderDataType::Vec2},
     });
 
-    IndexBufferHandle IBO = Renderer::create_index_buffer(
-        descriptor.index_data.data(), uint32_t(descriptor.index_data.size()), DrawPrimitive::Triangles);
-    VertexBufferHandle VBO = Renderer::create_vertex_buffer(
-        PBR_VBL, descriptor.vertex_data.data(), uint32_t(descriptor.vertex_data.size()), UsagePattern::Static);
-    VertexArrayHandle VAO = Renderer::create_vertex_array(VBO, IBO);
+    // Geometry is sub-allocated from the shared buffers of the layout, all levels of detail included
+    Mesh mesh = GeometryPool::allocate(PBR_VBL, descriptor.vertex_data, descriptor.index_data);
+    mesh.extent = descriptor.extent;
+    mesh.resource_id = resource_id;
 
-    return {VAO, PBR_VBL, descriptor.extent, resource_id};
+    // Levels of detail are ranges of the mesh indices, the full resolution level comes first
+    K_ASSERT(descriptor.lods[0].first_index == 0, "Full resolution level of detail must start the index data.");
+    uint32_t base_index = mesh.first_index;
+    mesh.index_count = descriptor.lods[0].index_count;
+    mesh.lod_count = std::min(uint32_t(descriptor.lods.size()), k_max_mesh_lods);
+    if(descriptor.lods.size() > k_max_mesh_lods)
+    {
+        KLOGW("asset") << "Mesh has " << descriptor.lods.size() << " levels of detail, only " << k_max_mesh_lods
+                       << " are used." << std::endl;
+    }
+    for(uint32_t ii = 1; ii < mesh.lod_count; ++ii)
+    {
+        const auto& lod = descriptor.lods[ii];
+        mesh.lods[ii - 1] = {base_index + lod.first_index, lod.index_count, lod.screen_size};
+    }
+    return mesh;
 }
 
-void MeshLoader::destroy(Mesh& mesh) { Renderer::destroy(mesh.VAO); }
+void MeshLoader::destroy(Mesh& mesh) { GeometryPool::release(mesh); }
 
 } // namespace erwin
\ No newline at end of file
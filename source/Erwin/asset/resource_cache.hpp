@@ -57,6 +57,7 @@ public:
     void sync_work();
 
     inline const AssetMetaData& get_meta_data(hash_t hname) const { return meta_data_.at(hname); }
+    inline bool has(hash_t hname) const { return meta_data_.find(hname) != meta_data_.end(); }
 
 private:
     struct FileLoadingTask
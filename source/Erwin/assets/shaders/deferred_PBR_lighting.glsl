@@ -34,6 +34,7 @@ void main()
 #include "engine/glow.glsl"
 #include "engine/normal_compression.glsl"
 #include "engine/cook_torrance.glsl"
+#include "engine/punctual_lights.glsl"
 
 SAMPLER_2D_(0); // albedo
 SAMPLER_2D_(1); // normal
@@ -93,6 +94,19 @@ void main()
                                  frag_metallic,
                                  frag_roughness);
 
+    // Punctual lights, only the ones assigned to the cluster of this fragment are evaluated
+    uvec2 cluster = clusters[cluster_index(v_uv, -frag_pos.z)];
+    for(uint ii = 0; ii < cluster.y; ++ii)
+    {
+        radiance += punctual_radiance(lights[light_index[cluster.x + ii]],
+                                      frag_pos,
+                                      frag_normal,
+                                      view_dir,
+                                      frag_albedo,
+                                      frag_metallic,
+                                      frag_roughness);
+    }
+
     vec3 ambient;
     if(bool(u_i_frame_flags & FRAME_FLAG_ENABLE_IBL))
     {
@@ -0,0 +1,24 @@
+// Per-instance data of instanced opaque PBR draw calls: transform_data followed by material_data,
+// each block aligned to 16 bytes. Written by the renderer when merging draw calls.
+struct PBRInstanceData
+{
+	mat4 m;    // model
+	mat4 mv;   // model-view
+	mat4 mvp;  // model-view-projection
+
+	vec4 tint;
+	int flags;
+	float emissive_scale;
+	float tiling_factor;
+	float parallax_height_scale;
+
+	// Uniform maps
+	vec4 uniform_albedo;
+	float uniform_metallic;
+	float uniform_roughness;
+};
+
+layout(std430, binding = 0) readonly buffer instance_data
+{
+	PBRInstanceData inst[];
+};
\ No newline at end of file
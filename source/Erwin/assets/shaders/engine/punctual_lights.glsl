@@ -0,0 +1,73 @@
+// Clustered punctual lights. The view frustum is divided in a grid of screen tiles, each split in
+// exponential depth slices. Each cluster references a range of the light index list.
+// Grid dimensions must match the k_light_cluster_* constants of the renderer configuration.
+// Requires engine/frame_ubo.glsl and engine/cook_torrance.glsl.
+#define LIGHT_CLUSTER_TILES_X 16
+#define LIGHT_CLUSTER_TILES_Y 9
+#define LIGHT_CLUSTER_SLICES 24
+
+#define LIGHT_TYPE_POINT 0
+#define LIGHT_TYPE_SPOT 1
+
+struct PunctualLight
+{
+	vec4 position_radius; // xyz: view-space position, w: radius of influence
+	vec4 color;           // rgb: color scaled by brightness
+	vec4 direction_type;  // xyz: view-space spot direction, w: light type
+	vec4 spot_angles;     // x: cosine of the inner cone angle, y: cosine of the outer cone angle
+};
+
+layout(std430, binding = 1) readonly buffer light_data
+{
+	PunctualLight lights[];
+};
+
+layout(std430, binding = 2) readonly buffer light_grid
+{
+	uvec2 clusters[]; // x: offset in the light index list, y: light count
+};
+
+layout(std430, binding = 3) readonly buffer light_indices
+{
+	uint light_index[];
+};
+
+// Cluster of a fragment, given its screen coordinates and its positive view-space depth
+uint cluster_index(vec2 uv, float depth)
+{
+	float near = u_v4_camera_params.x;
+	float far = u_v4_camera_params.y;
+	int slice = int(log(depth / near) * (float(LIGHT_CLUSTER_SLICES) / log(far / near)));
+	ivec3 cell = ivec3(ivec2(uv * vec2(LIGHT_CLUSTER_TILES_X, LIGHT_CLUSTER_TILES_Y)), slice);
+	cell = clamp(cell, ivec3(0), ivec3(LIGHT_CLUSTER_TILES_X - 1, LIGHT_CLUSTER_TILES_Y - 1, LIGHT_CLUSTER_SLICES - 1));
+	return uint(cell.x + LIGHT_CLUSTER_TILES_X * (cell.y + LIGHT_CLUSTER_TILES_Y * cell.z));
+}
+
+// Inverse square falloff, windowed so that it reaches zero at the radius of influence
+float distance_falloff(float dist2, float radius)
+{
+	float ratio2 = dist2 / (radius * radius);
+	float window = clamp(1.f - ratio2 * ratio2, 0.f, 1.f);
+	return (window * window) / max(dist2, 0.0001f);
+}
+
+// Radiance reflected towards the viewer by a punctual light, all vectors in view space
+vec3 punctual_radiance(PunctualLight light, vec3 frag_pos, vec3 normal, vec3 view_dir,
+                       vec3 albedo, float metallic, float roughness)
+{
+	vec3 to_light = light.position_radius.xyz - frag_pos;
+	float dist2 = dot(to_light, to_light);
+	float radius = light.position_radius.w;
+	if(dist2 >= radius * radius)
+		return vec3(0.f);
+
+	vec3 light_dir = to_light * inversesqrt(dist2);
+	float attenuation = distance_falloff(dist2, radius);
+	if(int(light.direction_type.w) == LIGHT_TYPE_SPOT)
+	{
+		float cos_angle = dot(-light_dir, light.direction_type.xyz);
+		attenuation *= smoothstep(light.spot_angles.y, light.spot_angles.x, cos_angle);
+	}
+
+	return CookTorrance(light.color.rgb * attenuation, light_dir, normal, view_dir, albedo, metallic, roughness);
+}
@@ -10,6 +10,8 @@
 #include "level/scene_manager.h"
 #include "memory/arena.h"
 #include "render/common_geometry.h"
+#include "render/frame_graph.h"
+#include "render/geometry_pool.h"
 #include "render/renderer.h"
 #include "render/renderer_2d.h"
 #include "render/renderer_3d.h"
@@ -278,6 +280,8 @@ bool Application::init()
                           settings_.get<bool>("client.display.topmost"_h, false),
                           settings_.get<bool>("client.display.vsync"_h, true),
                           settings_.get<bool>("client.display.host"_h, true)};
+        // The null backend runs without any window, graphics context or GUI
+        props.headless = (settings_.get_hash_lower("erwin.renderer.backend"_h, "OpenGL") == "null"_h);
 #ifdef W_DEBUG
         props.title += " [DEBUG]";
 #endif
@@ -296,6 +300,8 @@ bool Application::init()
         PostProcessingRenderer::init(event_bus_);
     }
 
+    // A headless window has no native handle ImGui could attach to
+    if(window_->get_native())
     {
         W_PROFILE_SCOPE("ImGui overlay creation")
         // Generate ImGui overlay
@@ -312,6 +318,13 @@ bool Application::init()
         layer_stack_.commit();
     }
 
+    // Move frame submission to a dedicated thread that owns the graphics context
+    if(settings_.get<bool>("erwin.renderer.render_thread"_h, false))
+    {
+        W_PROFILE_SCOPE("Render thread startup")
+        Renderer::spawn_render_thread();
+    }
+
     // Show memory content
 #ifdef W_DEBUG
     KLOG("memory", 1) << kb::KF_(204, 153, 0) << "--- System memory area ---" << std::endl;
@@ -328,10 +341,13 @@ bool Application::init()
 
 void Application::shutdown()
 {
+    // Get the graphics context back on the main thread
+    Renderer::kill_render_thread();
     {
         W_PROFILE_SCOPE("Layer stack shutdown")
         layer_stack_.clear();
-        IMGUI_LAYER->on_detach();
+        if(IMGUI_LAYER)
+            IMGUI_LAYER->on_detach();
     }
     {
         W_PROFILE_SCOPE("Application unloading")
@@ -344,6 +360,7 @@ void Application::shutdown()
         Renderer2D::shutdown();
         Renderer3D::shutdown();
         CommonGeometry::shutdown();
+        GeometryPool::shutdown();
         Renderer::shutdown();
     }
     {
@@ -354,7 +371,8 @@ void Application::shutdown()
 
 void Application::enable_vsync(bool value)
 {
-    window_->set_vsync(value);
+    // Swap interval is a property of the current context
+    Renderer::enqueue_task([this, value]() { window_->set_vsync(value); });
     vsync_enabled_ = value;
 }
 
@@ -428,6 +446,9 @@ void Application::run()
                 layer->render();
         }
 
+        // Execute the passes declared to the frame graph by the layers
+        FrameGraph::execute();
+
         {
 #ifndef W_PROFILE_RENDER
             W_PROFILE_SCOPE("Renderer flush")
@@ -438,7 +459,7 @@ void Application::run()
         // TODO: move this to renderer
         {
             W_PROFILE_SCOPE("ImGui render")
-            if(IMGUI_LAYER->is_enabled())
+            if(IMGUI_LAYER && IMGUI_LAYER->is_enabled())
             {
                 IMGUI_LAYER->begin();
                 on_imgui_new_frame_();
@@ -453,7 +474,11 @@ void Application::run()
         if(SceneManager::has_current())
             SceneManager::get_current().cleanup();
 
-        // Update window
+        // Present frame and update window
+        {
+            W_PROFILE_SCOPE("Present")
+            Renderer::present();
+        }
         window_->update();
 
         {W_PROFILE_SCOPE("Logger flush")}
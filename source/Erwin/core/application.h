@@ -73,6 +73,7 @@ private:
 
 protected:
     bool vsync_enabled_ = false;
+    WScope<Window> window_;
 
 private:
     bool is_running_ = true;
@@ -83,7 +84,6 @@ private:
     LayerStack layer_stack_;
     GameClock game_clock_;
     kb::kfs::FileSystem filesystem_;
-    WScope<Window> window_;
 
     static Application* pinstance_;
     std::function<void(void)> on_imgui_new_frame_ = []() {};
@@ -10,21 +10,21 @@
 namespace erwin
 {
 
-// Maximum amount of handles for every managed object
+// Initial capacity of the handle pool of every managed object, pools grow on demand
 // Default is 256, but the HANDLE_DECLARATION() macro overrides this setting
-template <typename HandleT>[[maybe_unused]] static constexpr uint32_t k_max_handles = 256;
+template <typename HandleT>[[maybe_unused]] static constexpr uint32_t k_handle_capacity = 256;
 
 typedef uint64_t HandleID;
 [[maybe_unused]] static constexpr uint32_t k_null_handle = 0xffffffff;
 
-#define HANDLE_DECLARATION(HANDLE_NAME, MAX_HANDLES)                                                                   \
+#define HANDLE_DECLARATION(HANDLE_NAME, CAPACITY)                                                                      \
     struct HANDLE_NAME                                                                                                 \
     {                                                                                                                  \
-        using PoolT = HandlePoolT<MAX_HANDLES>;                                                                        \
+        using PoolT = HandlePool;                                                                                      \
         static constexpr HandleID ID = ctti::type_id<HANDLE_NAME>().hash();                                            \
         static PoolT* s_ppool_;                                                                                        \
-        static void init_pool(LinearArena& arena);                                                                     \
-        static void destroy_pool(LinearArena& arena);                                                                  \
+        static void init_pool(uint32_t capacity);                                                                      \
+        static void destroy_pool();                                                                                    \
         static HANDLE_NAME acquire();                                                                                  \
         inline void release()                                                                                          \
         {                                                                                                              \
@@ -40,18 +40,18 @@ typedef uint64_t HandleID;
         friend std::ostream& operator<<(std::ostream& stream, const HANDLE_NAME&);                                     \
         uint32_t data = k_null_handle;                                                                                 \
     };                                                                                                                 \
-    template <> static constexpr uint32_t k_max_handles<HANDLE_NAME> = MAX_HANDLES
+    template <> static constexpr uint32_t k_handle_capacity<HANDLE_NAME> = CAPACITY
 
 #define HANDLE_DEFINITION(HANDLE_NAME)                                                                                 \
     HANDLE_NAME::PoolT* HANDLE_NAME::s_ppool_ = nullptr;                                                               \
-    void HANDLE_NAME::init_pool(LinearArena& arena)                                                                    \
+    void HANDLE_NAME::init_pool(uint32_t capacity)                                                                     \
     {                                                                                                                  \
         K_ASSERT_FMT(s_ppool_ == nullptr, "Memory pool for %s is already initialized.", #HANDLE_NAME);                 \
-        s_ppool_ = K_NEW(HandlePoolT<k_max_handles<HANDLE_NAME>>, arena);                                              \
+        s_ppool_ = new PoolT(capacity, k_handle_reuse_latency);                                                        \
     }                                                                                                                  \
-    void HANDLE_NAME::destroy_pool(LinearArena& arena)                                                                 \
+    void HANDLE_NAME::destroy_pool()                                                                                   \
     {                                                                                                                  \
-        K_DELETE(s_ppool_, arena);                                                                                     \
+        delete s_ppool_;                                                                                               \
         s_ppool_ = nullptr;                                                                                            \
     }                                                                                                                  \
     std::ostream& operator<<(std::ostream& stream, const HANDLE_NAME& h)                                               \
@@ -0,0 +1,15 @@
+#include "core/window.h"
+#include "platform/Null/null_window.h"
+#include "platform/OGL/glfw_window.h"
+
+namespace erwin
+{
+
+WScope<Window> Window::create(EventBus& event_bus, const WindowProps& props)
+{
+    if(props.headless)
+        return make_scope<NullWindow>(props);
+    return make_scope<GLFWWindow>(props, event_bus);
+}
+
+} // namespace erwin
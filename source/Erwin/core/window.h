@@ -17,6 +17,7 @@ struct WindowProps
 	bool always_on_top  = false;
 	bool vsync          = true;
 	bool host           = true;
+	bool headless       = false; // No window nor graphics context, for the null backend
 };
 
 class EventBus;
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <mutex>
 #include <thread>
 
 struct InstrumentorStorage
@@ -9,6 +10,7 @@ struct InstrumentorStorage
     InstrumentationSession* current_session = nullptr;
     int profile_count = 0;
     std::ofstream out_stream;
+    std::mutex mutex; // Profiles can be written from the render thread and recording threads
 };
 static InstrumentorStorage storage;
 
@@ -32,6 +34,7 @@ void Instrumentor::end_session()
 
 void Instrumentor::write_profile(const ProfileResult& result)
 {
+    const std::lock_guard<std::mutex> lock(storage.mutex);
     if(storage.profile_count++ > 0)
         storage.out_stream << ",";
 
@@ -49,6 +52,40 @@ void Instrumentor::write_profile(const ProfileResult& result)
     storage.out_stream.flush();
 }
 
+void Instrumentor::write_counters(const char* name, std::initializer_list<std::pair<const char*, long long>> values)
+{
+    if(storage.current_session == nullptr)
+        return;
+    if(!storage.current_session->enabled)
+        return;
+
+    long long timestamp =
+        std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now())
+            .time_since_epoch()
+            .count();
+
+    const std::lock_guard<std::mutex> lock(storage.mutex);
+    if(storage.profile_count++ > 0)
+        storage.out_stream << ",";
+
+    storage.out_stream << "{"
+                       << "\"cat\":\"counter\","
+                       << "\"name\":\"" << name << "\","
+                       << "\"ph\":\"C\","
+                       << "\"pid\":0,"
+                       << "\"ts\":" << timestamp << ","
+                       << "\"args\":{";
+    bool first = true;
+    for(const auto& [key, value] : values)
+    {
+        storage.out_stream << (first ? "" : ",") << "\"" << key << "\":" << value;
+        first = false;
+    }
+    storage.out_stream << "}}";
+
+    storage.out_stream.flush();
+}
+
 void Instrumentor::write_header()
 {
     storage.out_stream << "{\"otherData\": {},\"traceEvents\":[";
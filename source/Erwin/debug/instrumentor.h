@@ -4,7 +4,9 @@
 // Basic instrumentation profiler by Cherno
 
 #include <chrono>
+#include <initializer_list>
 #include <string>
+#include <utility>
 
 struct ProfileResult
 {
@@ -27,6 +29,8 @@ public:
     static void set_session_enabled(bool value);
     static void end_session();
     static void write_profile(const ProfileResult& result);
+    // Write a counter event, timestamped now. Values are displayed as stacked series named after their key.
+    static void write_counters(const char* name, std::initializer_list<std::pair<const char*, long long>> values);
     static void write_header();
     static void write_footer();
 };
@@ -23,25 +23,6 @@ void ComponentCamera3D::update_transform(const glm::mat4& to_world_space)
 
     // OPT: cache transform and skip computations if it has not changed
 
-    // * Update frustum planes
-    // Compute frustum corners in world space
-    glm::vec3 rbn = to_world_space * glm::vec4(frustum.right, frustum.bottom, frustum.near, 1.f);
-    glm::vec3 rbf = to_world_space * glm::vec4(frustum.right, frustum.bottom, frustum.far, 1.f);
-    glm::vec3 lbf = to_world_space * glm::vec4(frustum.left, frustum.bottom, frustum.far, 1.f);
-    glm::vec3 lbn = to_world_space * glm::vec4(frustum.left, frustum.bottom, frustum.near, 1.f);
-    glm::vec3 rtn = to_world_space * glm::vec4(frustum.right, frustum.top, frustum.near, 1.f);
-    // glm::vec3 rtf = to_world_space*glm::vec4(frustum.right, frustum.top,    frustum.far,  1.f);
-    glm::vec3 ltf = to_world_space * glm::vec4(frustum.left, frustum.top, frustum.far, 1.f);
-    glm::vec3 ltn = to_world_space * glm::vec4(frustum.left, frustum.top, frustum.near, 1.f);
-
-    // Compute side plane coefficients from these points
-    planes[0] = glm::normalize(glm::cross(lbf - lbn, ltn - lbn)); // left
-    planes[1] = glm::normalize(glm::cross(rtn - rbn, rbf - rbn)); // right
-    planes[2] = glm::normalize(glm::cross(rbn - lbn, lbf - lbn)); // bottom
-    planes[3] = glm::normalize(glm::cross(ltf - ltn, rtn - ltn)); // top
-    planes[4] = glm::normalize(glm::cross(ltn - lbn, rbn - lbn)); // near
-    planes[5] = glm::normalize(glm::cross(rbf - lbf, ltf - lbf)); // far
-
     // * Update directions
     right   =  glm::vec3(glm::column(to_world_space, 0));
     up      =  glm::vec3(glm::column(to_world_space, 1));
@@ -50,6 +31,21 @@ void ComponentCamera3D::update_transform(const glm::mat4& to_world_space)
     // * Update matrices
     view_matrix = glm::inverse(to_world_space);
     view_projection_matrix = projection_matrix * view_matrix;
+
+    // * Update frustum planes
+    // Extracted from the view-projection matrix rows (Gribb & Hartmann), so they are in world space
+    glm::vec4 row_x = glm::row(view_projection_matrix, 0);
+    glm::vec4 row_y = glm::row(view_projection_matrix, 1);
+    glm::vec4 row_z = glm::row(view_projection_matrix, 2);
+    glm::vec4 row_w = glm::row(view_projection_matrix, 3);
+    planes[0] = row_w + row_x; // left
+    planes[1] = row_w - row_x; // right
+    planes[2] = row_w + row_y; // bottom
+    planes[3] = row_w - row_y; // top
+    planes[4] = row_w + row_z; // near
+    planes[5] = row_w - row_z; // far
+    for(size_t ii = 0; ii < 6; ++ii)
+        planes[ii] /= glm::length(glm::vec3(planes[ii]));
 }
 
 } // namespace erwin
\ No newline at end of file
@@ -18,11 +18,13 @@ struct ComponentCamera3D
         float far = 0.f;
     };
 
+    // World-space planes, xyz is the inward unit normal and w the signed distance to the origin,
+    // so that a point p lies inside when dot(plane, vec4(p, 1)) >= 0
     struct FrustumPlanes
     {
-        inline const glm::vec3& operator[] (size_t index) const { return plane[index]; }
-        inline glm::vec3& operator[] (size_t index)             { return plane[index]; }
-        glm::vec3 plane[6]; // left, right, bottom, top, near, far
+        inline const glm::vec4& operator[] (size_t index) const { return plane[index]; }
+        inline glm::vec4& operator[] (size_t index)             { return plane[index]; }
+        glm::vec4 plane[6]; // left, right, bottom, top, near, far
     };
 
     void set_projection(const Frustum3D&);
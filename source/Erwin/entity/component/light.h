@@ -27,4 +27,22 @@ struct ComponentDirectionalLight
 	float arg_periapsis     = 0.f;
 };
 
+// Point light, positioned by the transform of its entity
+struct ComponentPointLight
+{
+	glm::vec3 color  = {1.f,1.f,1.f};
+	float brightness = 1.f;
+	float radius     = 10.f; // Distance past which the light has no influence
+};
+
+// Spot light, positioned and oriented by the transform of its entity. It points towards the local -z axis.
+struct ComponentSpotLight
+{
+	glm::vec3 color   = {1.f,1.f,1.f};
+	float brightness  = 1.f;
+	float radius      = 10.f; // Distance past which the light has no influence
+	float inner_angle = 20.f; // Half-angle of the cone of full intensity, in degrees
+	float outer_angle = 30.f; // Half-angle of the cone past which the light has no influence, in degrees
+};
+
 } // namespace erwin
\ No newline at end of file
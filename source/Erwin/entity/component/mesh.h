@@ -9,6 +9,7 @@ namespace erwin
 struct ComponentMesh
 {
 	Mesh mesh;
+	bool occluder = false; // Hide the meshes behind this one, its coarsest LOD is rasterized and should be solid
 
 	ComponentMesh()
 	{
@@ -33,4 +33,44 @@ void deserialize_xml<ComponentDirectionalLight>(rapidxml::xml_node<>* cmp_node,
     xml::parse_node(cmp_node, "brightness", cmp_dl.brightness);
 }
 
+template <>
+void serialize_xml<ComponentPointLight>(const ComponentPointLight& cmp, xml::XMLFile& file, rapidxml::xml_node<>* cmp_node)
+{
+    file.add_node(cmp_node, "color", kb::to_string(cmp.color).c_str());
+    file.add_node(cmp_node, "brightness", kb::to_string(cmp.brightness).c_str());
+    file.add_node(cmp_node, "radius", kb::to_string(cmp.radius).c_str());
+}
+
+template <>
+void deserialize_xml<ComponentPointLight>(rapidxml::xml_node<>* cmp_node, Scene& scene, EntityID e)
+{
+    auto& cmp_pl = scene.add_component<ComponentPointLight>(e);
+
+    xml::parse_node(cmp_node, "color", cmp_pl.color);
+    xml::parse_node(cmp_node, "brightness", cmp_pl.brightness);
+    xml::parse_node(cmp_node, "radius", cmp_pl.radius);
+}
+
+template <>
+void serialize_xml<ComponentSpotLight>(const ComponentSpotLight& cmp, xml::XMLFile& file, rapidxml::xml_node<>* cmp_node)
+{
+    file.add_node(cmp_node, "color", kb::to_string(cmp.color).c_str());
+    file.add_node(cmp_node, "brightness", kb::to_string(cmp.brightness).c_str());
+    file.add_node(cmp_node, "radius", kb::to_string(cmp.radius).c_str());
+    file.add_node(cmp_node, "inner_angle", kb::to_string(cmp.inner_angle).c_str());
+    file.add_node(cmp_node, "outer_angle", kb::to_string(cmp.outer_angle).c_str());
+}
+
+template <>
+void deserialize_xml<ComponentSpotLight>(rapidxml::xml_node<>* cmp_node, Scene& scene, EntityID e)
+{
+    auto& cmp_sl = scene.add_component<ComponentSpotLight>(e);
+
+    xml::parse_node(cmp_node, "color", cmp_sl.color);
+    xml::parse_node(cmp_node, "brightness", cmp_sl.brightness);
+    xml::parse_node(cmp_node, "radius", cmp_sl.radius);
+    xml::parse_node(cmp_node, "inner_angle", cmp_sl.inner_angle);
+    xml::parse_node(cmp_node, "outer_angle", cmp_sl.outer_angle);
+}
+
 } // namespace erwin
\ No newline at end of file
@@ -11,4 +11,16 @@ void serialize_xml<ComponentDirectionalLight>(const ComponentDirectionalLight& c
 template <>
 void deserialize_xml<ComponentDirectionalLight>(rapidxml::xml_node<>* cmp_node, Scene& scene, EntityID e);
 
+template <>
+void serialize_xml<ComponentPointLight>(const ComponentPointLight& cmp, xml::XMLFile& file, rapidxml::xml_node<>* cmp_node);
+
+template <>
+void deserialize_xml<ComponentPointLight>(rapidxml::xml_node<>* cmp_node, Scene& scene, EntityID e);
+
+template <>
+void serialize_xml<ComponentSpotLight>(const ComponentSpotLight& cmp, xml::XMLFile& file, rapidxml::xml_node<>* cmp_node);
+
+template <>
+void deserialize_xml<ComponentSpotLight>(rapidxml::xml_node<>* cmp_node, Scene& scene, EntityID e);
+
 } // namespace erwin
\ No newline at end of file
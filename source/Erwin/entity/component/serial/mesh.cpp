@@ -12,24 +12,30 @@ void serialize_xml<ComponentMesh>(const ComponentMesh& cmp, xml::XMLFile& file,
     if(cmp.mesh.procedural)
         file.add_attribute(cmp_node, "proc", "true");
     file.add_attribute(cmp_node, "id", kb::to_string(cmp.mesh.resource_id).c_str());
+    if(cmp.occluder)
+        file.add_attribute(cmp_node, "occluder", "true");
 }
 
 template <> void deserialize_xml<ComponentMesh>(rapidxml::xml_node<>* cmp_node, Scene& scene, EntityID e)
 {
     bool procedural = false;
+    bool occluder = false;
     size_t resource_id = 0;
     xml::parse_attribute(cmp_node, "proc", procedural);
     xml::parse_attribute(cmp_node, "id", resource_id);
+    xml::parse_attribute(cmp_node, "occluder", occluder);
 
     if(procedural)
     {
         auto& cmesh = scene.add_component<ComponentMesh>(e);
         cmesh.mesh = CommonGeometry::get_mesh(resource_id);
+        cmesh.occluder = occluder;
     }
     else
     {
-        AssetManager::on_ready<Mesh>(
-            resource_id, [&scene, e = e](const Mesh& mesh) { scene.add_component<ComponentMesh>(e, mesh); });
+        AssetManager::on_ready<Mesh>(resource_id, [&scene, e = e, occluder](const Mesh& mesh) {
+            scene.add_component<ComponentMesh>(e, mesh).occluder = occluder;
+        });
     }
 }
 
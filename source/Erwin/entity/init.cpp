@@ -23,6 +23,8 @@ template <> void inspector_GUI<ComponentMesh>(ComponentMesh& cmp, EntityID e, Sc
 template <> void inspector_GUI<ComponentPBRMaterial>(ComponentPBRMaterial& cmp, EntityID e, Scene&);
 template <> void inspector_GUI<ComponentDirectionalLightMaterial>(ComponentDirectionalLightMaterial& cmp, EntityID e, Scene&);
 template <> void inspector_GUI<ComponentDirectionalLight>(ComponentDirectionalLight& cmp, EntityID e, Scene&);
+template <> void inspector_GUI<ComponentPointLight>(ComponentPointLight& cmp, EntityID e, Scene&);
+template <> void inspector_GUI<ComponentSpotLight>(ComponentSpotLight& cmp, EntityID e, Scene&);
 template <> void inspector_GUI<ComponentScript>(ComponentScript& cmp, EntityID e, Scene&);
 
 namespace entity
@@ -37,6 +39,8 @@ void init_components()
     REFLECT_COMPONENT(ComponentPBRMaterial);
     REFLECT_COMPONENT(ComponentDirectionalLightMaterial);
     REFLECT_COMPONENT(ComponentDirectionalLight);
+    REFLECT_COMPONENT(ComponentPointLight);
+    REFLECT_COMPONENT(ComponentSpotLight);
     REFLECT_COMPONENT(ComponentScript);
 
     REFLECT_COMPONENT(ComponentDescription);
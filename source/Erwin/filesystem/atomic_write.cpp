@@ -0,0 +1,28 @@
+#include "filesystem/atomic_write.h"
+
+#include <fstream>
+
+namespace erwin
+{
+
+bool write_file_atomic(const fs::path& path, const std::function<void(std::ostream&)>& write)
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    fs::path tmp_path = fs::path(path).replace_extension(".tmp");
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary);
+        if(ofs.is_open())
+            write(ofs);
+        if(!ofs)
+        {
+            ofs.close();
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    fs::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+} // namespace erwin
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <ostream>
+
+namespace fs = std::filesystem;
+
+namespace erwin
+{
+
+// Write a file through a temporary file renamed once complete, so that an interrupted write never leaves
+// a truncated file behind. Parent directories are created. Returns false if the file was not written.
+extern bool write_file_atomic(const fs::path& path, const std::function<void(std::ostream&)>& write);
+
+} // namespace erwin
@@ -2,7 +2,7 @@
 #include "core/application.h"
 #include <kibble/logger/logger.h>
 
-namespace fs = std::filesystem;
+#include <fstream>
 
 namespace erwin
 {
@@ -37,19 +37,30 @@ struct WESHHeader
 
 #define WESH_MAGIC 0x48534557 // ASCII(WESH)
 #define WESH_VERSION_MAJOR 0
-#define WESH_VERSION_MINOR 3
+#define WESH_VERSION_MINOR 4
+#define WESH_VERSION_MINOR_LOD 4 // First minor version with levels of detail
 
 WeshDescriptor read(const std::string& path)
 {
     auto ifs = WFS_.get_input_stream(path);
+    return read(*ifs);
+}
 
+WeshDescriptor read(std::istream& stream)
+{
     // Read header & sanity check
     WESHHeader header;
-    ifs->read(opaque_cast(&header), sizeof(WESHHeader));
+    stream.read(opaque_cast(&header), sizeof(WESHHeader));
 
     K_ASSERT(header.magic == WESH_MAGIC, "Invalid WESH file: magic number mismatch.");
     K_ASSERT(header.version_major == WESH_VERSION_MAJOR, "Invalid WESH file: version (major) mismatch.");
-    K_ASSERT(header.version_minor == WESH_VERSION_MINOR, "Invalid WESH file: version (minor) mismatch.");
+    K_ASSERT(header.version_minor >= 3 && header.version_minor <= WESH_VERSION_MINOR,
+             "Invalid WESH file: version (minor) mismatch.");
+
+    uint32_t lod_count = 1;
+    if(header.version_minor >= WESH_VERSION_MINOR_LOD)
+        stream.read(opaque_cast(&lod_count), sizeof(uint32_t));
+    K_ASSERT(lod_count > 0, "Invalid WESH file: no level of detail.");
 
     KLOG("asset", 0) << "WESH Header:" << std::endl;
     KLOGI << "Version:   " << kb::KS_VALU_ << int(header.version_major) << "." << int(header.version_minor)
@@ -57,10 +68,12 @@ WeshDescriptor read(const std::string& path)
     KLOGI << "Vtx size:  " << kb::KS_VALU_ << header.vertex_size << std::endl;
     KLOGI << "Vtx count: " << kb::KS_VALU_ << header.vertex_count << std::endl;
     KLOGI << "Idx count: " << kb::KS_VALU_ << header.index_count << std::endl;
+    KLOGI << "LOD count: " << kb::KS_VALU_ << lod_count << std::endl;
 
     WeshDescriptor descriptor;
+    descriptor.vertex_size = header.vertex_size;
     // Read mesh extent
-    ifs->read(opaque_cast(&descriptor.extent.value), long(6 * sizeof(float)));
+    stream.read(opaque_cast(&descriptor.extent.value), long(6 * sizeof(float)));
 
     KLOG("asset", 0) << "Extent:" << std::endl;
     KLOGI << "xmin: " << descriptor.extent.xmin() << std::endl;
@@ -70,15 +83,58 @@ WeshDescriptor read(const std::string& path)
     KLOGI << "zmin: " << descriptor.extent.zmin() << std::endl;
     KLOGI << "zmax: " << descriptor.extent.zmax() << std::endl;
 
+    // Read level of detail table, older files hold a single level spanning all indices
+    descriptor.lods.resize(lod_count);
+    if(header.version_minor >= WESH_VERSION_MINOR_LOD)
+        stream.read(opaque_cast(descriptor.lods.data()), long(lod_count * sizeof(WeshLOD)));
+    else
+        descriptor.lods[0] = {0, header.index_count, 1.f};
+
     // Read vertex and indes data
     size_t vdata_float_count = header.vertex_count * header.vertex_size;
     descriptor.vertex_data.resize(vdata_float_count);
     descriptor.index_data.resize(header.index_count);
-    ifs->read(opaque_cast(descriptor.vertex_data.data()), long(vdata_float_count * sizeof(float)));
-    ifs->read(opaque_cast(descriptor.index_data.data()), long(header.index_count * sizeof(uint32_t)));
+    stream.read(opaque_cast(descriptor.vertex_data.data()), long(vdata_float_count * sizeof(float)));
+    stream.read(opaque_cast(descriptor.index_data.data()), long(header.index_count * sizeof(uint32_t)));
+
+    for(const auto& lod : descriptor.lods)
+    {
+        K_ASSERT(lod.first_index + lod.index_count <= header.index_count,
+                 "Invalid WESH file: level of detail out of index range.");
+    }
 
     return descriptor;
 }
 
+void write(std::ostream& stream, const WeshDescriptor& descriptor)
+{
+    K_ASSERT(!descriptor.lods.empty(), "WESH descriptor has no level of detail.");
+
+    WESHHeader header;
+    header.magic = WESH_MAGIC;
+    header.version_major = WESH_VERSION_MAJOR;
+    header.version_minor = WESH_VERSION_MINOR;
+    header.vertex_size = descriptor.vertex_size;
+    header.vertex_count = uint32_t(descriptor.vertex_data.size()) / descriptor.vertex_size;
+    header.index_count = uint32_t(descriptor.index_data.size());
+    uint32_t lod_count = uint32_t(descriptor.lods.size());
+
+    stream.write(opaque_cast(&header), sizeof(WESHHeader));
+    stream.write(opaque_cast(&lod_count), sizeof(uint32_t));
+    stream.write(opaque_cast(&descriptor.extent.value), long(6 * sizeof(float)));
+    stream.write(opaque_cast(descriptor.lods.data()), long(lod_count * sizeof(WeshLOD)));
+    stream.write(opaque_cast(descriptor.vertex_data.data()), long(descriptor.vertex_data.size() * sizeof(float)));
+    stream.write(opaque_cast(descriptor.index_data.data()), long(descriptor.index_data.size() * sizeof(uint32_t)));
+}
+
+bool write(const fs::path& path, const WeshDescriptor& descriptor)
+{
+    std::ofstream ofs(path, std::ios::binary);
+    if(!ofs.is_open())
+        return false;
+    write(ofs, descriptor);
+    return bool(ofs);
+}
+
 } // namespace wesh
 } // namespace erwin
\ No newline at end of file
@@ -4,25 +4,41 @@
     erWin mESH format for geometry storage
 */
 
+#include <filesystem>
+#include <iosfwd>
 #include <vector>
 #include "asset/bounding.h"
 
+namespace fs = std::filesystem;
 
 namespace erwin
 {
 namespace wesh
 {
 
+// A level of detail, as a range of the index data. All levels share the vertex data.
+struct WeshLOD
+{
+    uint32_t first_index;
+    uint32_t index_count;
+    float screen_size; // Projected size (fraction of the viewport height) under which this level is used
+};
+
 struct WeshDescriptor
 {
     Extent extent;
+    uint32_t vertex_size = 11; // Float count inside a vertex
     std::vector<float> vertex_data;
-    std::vector<uint32_t> index_data;
+    std::vector<uint32_t> index_data; // Indices of all levels of detail
+    std::vector<WeshLOD> lods;        // Level 0 is the full resolution mesh, files prior to version 0.4 only have this one
 };
 
 
 WeshDescriptor read(const std::string& path);
+WeshDescriptor read(std::istream& stream);
+bool write(const fs::path& path, const WeshDescriptor& descriptor);
+void write(std::ostream& stream, const WeshDescriptor& descriptor);
 
 
 } // namespace wesh
-} // namespace erwin
\ No newline at end of file
+} // namespace erwin
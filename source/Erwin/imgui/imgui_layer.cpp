@@ -1,5 +1,6 @@
 #include "imgui_layer.h"
 #include "core/application.h"
+#include "render/renderer.h"
 #include <kibble/logger/logger.h>
 
 #include "imgui.h"
@@ -7,10 +8,34 @@
 #include "examples/imgui_impl_opengl3.h"
 
 #include <iostream>
+#include <memory>
+#include <vector>
 
 namespace erwin
 {
 
+// Deep copy of the ImGui draw data. ImGui reuses its draw lists as soon as the next frame begins,
+// so this is what the render thread works with while the next frame is being built.
+struct DrawDataSnapshot
+{
+	explicit DrawDataSnapshot(const ImDrawData* source):
+	data(*source)
+	{
+		lists.reserve(size_t(source->CmdListsCount));
+		for(int ii=0; ii<source->CmdListsCount; ++ii)
+			lists.push_back(source->CmdLists[ii]->CloneOutput());
+		data.CmdLists = lists.data();
+	}
+
+	~DrawDataSnapshot()
+	{
+		for(ImDrawList* list: lists)
+			IM_DELETE(list);
+	}
+
+	ImDrawData data;
+	std::vector<ImDrawList*> lists;
+};
 
 ImGuiLayer::ImGuiLayer(Application& application):
 Layer(application, "ImGuiLayer")
@@ -53,7 +78,8 @@ void ImGuiLayer::on_detach()
 
 void ImGuiLayer::begin()
 {
-	ImGui_ImplOpenGL3_NewFrame();
+	// Device objects are lazily created by the OpenGL backend, this needs to happen on the render thread
+	Renderer::enqueue_task([]() { ImGui_ImplOpenGL3_NewFrame(); });
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 }
@@ -67,7 +93,13 @@ void ImGuiLayer::end()
 
 	// Rendering
 	ImGui::Render();
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	if(Renderer::has_render_thread())
+	{
+		auto snapshot = std::make_shared<DrawDataSnapshot>(ImGui::GetDrawData());
+		Renderer::enqueue_task([snapshot]() { ImGui_ImplOpenGL3_RenderDrawData(&snapshot->data); });
+	}
+	else
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
 	if(io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 	{
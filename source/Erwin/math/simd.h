@@ -0,0 +1,9 @@
+#pragma once
+
+// SSE is part of the x86-64 baseline, other architectures use the scalar code paths
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define W_SIMD_SSE 1
+#else
+#define W_SIMD_SSE 0
+#endif
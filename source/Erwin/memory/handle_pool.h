@@ -1,10 +1,177 @@
 #pragma once
 
-#include <kibble/util/sparse_set.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <kibble/assert/assert.h>
 
 namespace erwin
 {
 
-template <size_t SIZE> using HandlePoolT = kb::SecureSparsePool<uint32_t, SIZE, 16>;
+// Array indexed by handle, grown by fixed-size chunks that never move. Elements created before
+// a call to reserve() can still be accessed from another thread while the array grows.
+template <typename T, uint32_t CHUNK_SIZE = 256, uint32_t MAX_CHUNKS = 256> class HandleArray
+{
+public:
+    // Make sure every index below capacity can be accessed, new elements are default constructed
+    void reserve(uint32_t capacity)
+    {
+        uint32_t chunk_count = std::min((capacity + CHUNK_SIZE - 1) / CHUNK_SIZE, MAX_CHUNKS);
+        for(uint32_t ii = chunk_count_.load(std::memory_order_relaxed); ii < chunk_count; ++ii)
+            chunks_[ii] = std::make_unique<T[]>(CHUNK_SIZE);
+        if(chunk_count > chunk_count_.load(std::memory_order_relaxed))
+            chunk_count_.store(chunk_count, std::memory_order_release);
+    }
+
+    // Release all chunks
+    void clear()
+    {
+        for(auto& chunk : chunks_)
+            chunk.reset();
+        chunk_count_.store(0, std::memory_order_release);
+    }
+
+    inline T& operator[](uint32_t index) { return chunks_[index / CHUNK_SIZE][index % CHUNK_SIZE]; }
+    inline const T& operator[](uint32_t index) const { return chunks_[index / CHUNK_SIZE][index % CHUNK_SIZE]; }
+    inline uint32_t capacity() const { return chunk_count_.load(std::memory_order_acquire) * CHUNK_SIZE; }
+
+    // Call a function on each element
+    template <typename FuncT> void for_each(FuncT&& func)
+    {
+        uint32_t chunk_count = chunk_count_.load(std::memory_order_acquire);
+        for(uint32_t ii = 0; ii < chunk_count; ++ii)
+            for(uint32_t jj = 0; jj < CHUNK_SIZE; ++jj)
+                func(chunks_[ii][jj]);
+    }
+    template <typename FuncT> void for_each(FuncT&& func) const
+    {
+        uint32_t chunk_count = chunk_count_.load(std::memory_order_acquire);
+        for(uint32_t ii = 0; ii < chunk_count; ++ii)
+            for(uint32_t jj = 0; jj < CHUNK_SIZE; ++jj)
+                func(static_cast<const T&>(chunks_[ii][jj]));
+    }
+
+private:
+    std::unique_ptr<T[]> chunks_[MAX_CHUNKS];
+    std::atomic<uint32_t> chunk_count_ = 0;
+};
+
+// Sparse pool of 32 bits handles with guard bits, that grows on demand. The low 16 bits of a handle
+// are an index, the high 16 bits are a guard that is incremented each time the index is released,
+// so that dangling handles can be detected.
+// Handles are acquired and released on the main thread only, next_frame() is called there too.
+// They can be validated from any thread, but the render thread may see handles the main thread has
+// already released. A released index is retired for a few frames before it is handed out again, so that
+// the render thread is done with the storage of this index before it is reused.
+class HandlePool
+{
+public:
+    static constexpr uint32_t k_handle_mask = 0x0000ffff;
+    static constexpr uint32_t k_guard_mask = 0xffff0000;
+    static constexpr uint32_t k_guard_shift = 16;
+    // Index 0xffff is never allocated, it belongs to the null handle
+    static constexpr uint32_t k_max_capacity = 0xffff;
+
+    explicit HandlePool(uint32_t capacity, uint32_t reuse_latency = 0) : reuse_latency_(reuse_latency)
+    {
+        grow(std::clamp(capacity, 1u, k_max_capacity));
+    }
+
+    inline uint32_t acquire()
+    {
+        if(free_list_.empty())
+        {
+            K_ASSERT(capacity_ < k_max_capacity, "Handle pool is full.");
+            if(capacity_ == k_max_capacity)
+                return 0xffffffff;
+            grow(std::min(capacity_ * 2, k_max_capacity));
+        }
+
+        uint32_t index = free_list_.back();
+        free_list_.pop_back();
+        uint32_t slot = slots_[index].load(std::memory_order_relaxed) | k_live_bit;
+        slots_[index].store(slot, std::memory_order_release);
+        ++size_;
+        return ((slot & k_slot_guard_mask) << k_guard_shift) | index;
+    }
+
+    inline void release(uint32_t handle)
+    {
+        K_ASSERT(is_valid(handle), "Cannot release invalid handle.");
+        uint32_t index = handle & k_handle_mask;
+        uint32_t slot = slots_[index].load(std::memory_order_relaxed);
+        // Increment guard so that copies of this handle become invalid
+        slots_[index].store(((slot & k_slot_guard_mask) + 1) & k_slot_guard_mask, std::memory_order_release);
+        if(reuse_latency_ == 0)
+            free_list_.push_back(index);
+        else
+            retired_.push_back({index, frame_});
+        --size_;
+    }
+
+    // Retired indices whose latency has elapsed can be acquired again
+    inline void next_frame()
+    {
+        ++frame_;
+        while(!retired_.empty() && frame_ - retired_.front().frame >= reuse_latency_)
+        {
+            free_list_.push_back(retired_.front().index);
+            retired_.pop_front();
+        }
+    }
+
+    inline bool is_valid(uint32_t handle) const
+    {
+        uint32_t index = handle & k_handle_mask;
+        if(index >= slots_.capacity())
+            return false;
+        uint32_t slot = slots_[index].load(std::memory_order_acquire);
+        return (slot & k_live_bit) && (slot & k_slot_guard_mask) == (handle >> k_guard_shift);
+    }
+
+    // Amount of handles that can be acquired before the pool grows
+    inline uint32_t capacity() const { return capacity_.load(std::memory_order_acquire); }
+    // Incremented each time any pool grows. Storage indexed by handles only needs to be reserved again when it
+    // changes, see the backends reserve_handles().
+    static inline uint32_t get_growth_count() { return s_growth_count_.load(std::memory_order_acquire); }
+    // Amount of live handles
+    inline uint32_t size() const { return size_; }
+
+private:
+    void grow(uint32_t capacity)
+    {
+        uint32_t old_capacity = capacity_.load(std::memory_order_relaxed);
+        slots_.reserve(capacity);
+        // Free list is a stack, lower indices are acquired first
+        for(uint32_t ii = capacity; ii > old_capacity; --ii)
+            free_list_.push_back(ii - 1);
+        capacity_.store(capacity, std::memory_order_release);
+        s_growth_count_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+private:
+    static constexpr uint32_t k_slot_guard_mask = 0x0000ffff;
+    static constexpr uint32_t k_live_bit = 0x00010000;
+
+    struct RetiredIndex
+    {
+        uint32_t index;
+        uint32_t frame;
+    };
+
+    HandleArray<std::atomic<uint32_t>> slots_; // [live bit | guard]
+    std::vector<uint32_t> free_list_;
+    std::deque<RetiredIndex> retired_;
+    uint32_t reuse_latency_ = 0;
+    uint32_t frame_ = 0;
+    std::atomic<uint32_t> capacity_ = 0;
+    uint32_t size_ = 0;
+
+    static inline std::atomic<uint32_t> s_growth_count_{0};
+};
 
-} // namespace erwin
\ No newline at end of file
+} // namespace erwin
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+namespace erwin
+{
+
+// First-fit allocator of element ranges. Free ranges are sorted by offset, so that adjacent ranges
+// can be merged back on release.
+// Like handle indices, released ranges can be retired for a few frames before they are handed out again,
+// so that frames still in flight are done reading them. next_frame() must then be called once per frame.
+class RangeAllocator
+{
+public:
+    explicit RangeAllocator(uint32_t capacity, uint32_t reuse_latency = 0)
+        : free_{{0, capacity}}, reuse_latency_(reuse_latency)
+    {}
+
+    bool allocate(uint32_t size, uint32_t& offset)
+    {
+        auto it = std::find_if(free_.begin(), free_.end(), [size](const Range& range) { return range.size >= size; });
+        if(it == free_.end())
+            return false;
+
+        offset = it->offset;
+        it->offset += size;
+        it->size -= size;
+        if(it->size == 0)
+            free_.erase(it);
+        return true;
+    }
+
+    // Give a range back, it can be allocated again once the reuse latency has elapsed
+    inline void release(uint32_t offset, uint32_t size)
+    {
+        if(reuse_latency_ == 0)
+            insert(offset, size);
+        else
+            retired_.push_back({{offset, size}, frame_});
+    }
+
+    // Give back a range that was never used, it can be allocated again right away
+    inline void cancel(uint32_t offset, uint32_t size) { insert(offset, size); }
+
+    // Retired ranges whose latency has elapsed can be allocated again
+    inline void next_frame()
+    {
+        ++frame_;
+        while(!retired_.empty() && frame_ - retired_.front().frame >= reuse_latency_)
+        {
+            insert(retired_.front().range.offset, retired_.front().range.size);
+            retired_.pop_front();
+        }
+    }
+
+    // Number of disjoint free ranges, retired ranges excluded
+    inline size_t get_free_range_count() const { return free_.size(); }
+    // Amount of elements that can be allocated, retired ranges excluded
+    inline uint32_t get_free_size() const
+    {
+        uint32_t size = 0;
+        for(const auto& range : free_)
+            size += range.size;
+        return size;
+    }
+
+private:
+    void insert(uint32_t offset, uint32_t size)
+    {
+        auto next = std::lower_bound(free_.begin(), free_.end(), offset,
+                                     [](const Range& range, uint32_t value) { return range.offset < value; });
+        // Merge with previous and / or next free range if they are contiguous
+        bool merge_prev = (next != free_.begin()) && (std::prev(next)->offset + std::prev(next)->size == offset);
+        bool merge_next = (next != free_.end()) && (offset + size == next->offset);
+
+        if(merge_prev && merge_next)
+        {
+            std::prev(next)->size += size + next->size;
+            free_.erase(next);
+        }
+        else if(merge_prev)
+            std::prev(next)->size += size;
+        else if(merge_next)
+        {
+            next->offset = offset;
+            next->size += size;
+        }
+        else
+            free_.insert(next, {offset, size});
+    }
+
+private:
+    struct Range
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct RetiredRange
+    {
+        Range range;
+        uint32_t frame;
+    };
+
+    std::vector<Range> free_;
+    std::deque<RetiredRange> retired_;
+    uint32_t reuse_latency_ = 0;
+    uint32_t frame_ = 0;
+};
+
+} // namespace erwin
@@ -1,5 +1,6 @@
 #include "render/backend.h"
 #include "platform/OGL/ogl_backend.h"
+#include "platform/Null/null_backend.h"
 
 namespace erwin
 {
@@ -11,8 +12,15 @@ void gfx::set_backend(GfxAPI api)
 {
     api_ = api;
 
-    if(api_ == GfxAPI::OpenGL)
+    switch(api_)
+    {
+    case GfxAPI::None:
+        backend = std::make_unique<NullBackend>();
+        break;
+    case GfxAPI::OpenGL:
         backend = std::make_unique<OGLBackend>();
+        break;
+    }
 }
 
 
@@ -16,7 +16,7 @@ namespace erwin
 
 enum class GfxAPI
 {
-    None = 0,
+    None = 0, // Headless backend, see NullBackend
     OpenGL = 1
 };
 
@@ -45,6 +45,47 @@ struct ShaderCompatibility
     }
 };
 
+// Per-frame counters of the render state cache. A bind is a call to the device, a hit is a bind
+// that was skipped because the cached state already matched.
+struct StateCounters
+{
+    uint32_t state_changes = 0;          // Draw calls whose render state differed from the cached state
+    uint32_t state_hits = 0;             // Draw calls whose render state matched the cached state
+    uint32_t render_target_switches = 0; // Render state parts updated on state change
+    uint32_t cull_mode_changes = 0;
+    uint32_t blend_changes = 0;
+    uint32_t depth_stencil_changes = 0;
+    uint32_t shader_binds = 0;
+    uint32_t shader_hits = 0;
+    uint32_t texture_binds = 0;
+    uint32_t texture_hits = 0;
+    uint32_t cubemap_binds = 0;
+    uint32_t cubemap_hits = 0;
+    uint32_t VAO_binds = 0;
+    uint32_t VAO_hits = 0;
+    uint32_t pending_shader_draws = 0; // Draw calls skipped because their shader was still compiling
+
+    inline StateCounters& operator+=(const StateCounters& other)
+    {
+        state_changes += other.state_changes;
+        state_hits += other.state_hits;
+        render_target_switches += other.render_target_switches;
+        cull_mode_changes += other.cull_mode_changes;
+        blend_changes += other.blend_changes;
+        depth_stencil_changes += other.depth_stencil_changes;
+        shader_binds += other.shader_binds;
+        shader_hits += other.shader_hits;
+        texture_binds += other.texture_binds;
+        texture_hits += other.texture_hits;
+        cubemap_binds += other.cubemap_binds;
+        cubemap_hits += other.cubemap_hits;
+        VAO_binds += other.VAO_binds;
+        VAO_hits += other.VAO_hits;
+        pending_shader_draws += other.pending_shader_draws;
+        return *this;
+    }
+};
+
 class Backend
 {
 public:
@@ -60,6 +101,8 @@ public:
     virtual void read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels) = 0;
 
     // * Immediate
+    // Can be called from the main thread while the render thread is running. Handles are not checked for
+    // validity here, the main thread releases them as soon as their destruction is recorded.
     // Promise texture data
     virtual std::pair<uint64_t, std::future<PixelData>> future_texture_data() = 0;
     // Get handle of default render target
@@ -136,6 +179,12 @@ public:
     virtual void finish() = 0;
     // Force issued commands to yield in a finite time
     virtual void flush() = 0;
+    // Signal that a frame has been submitted, frame-scoped resources can be recycled
+    virtual void end_frame() = 0;
+
+    // * Statistics
+    // Get the state cache counters of the frame being submitted, they are reset by end_frame()
+    virtual const StateCounters& get_state_counters() const = 0;
 
     // * Debug
     // Get current error from graphics device
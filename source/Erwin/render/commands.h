@@ -32,6 +32,7 @@ enum class RenderCommand: uint16_t
 	Post,
 
 	GetPixelData,
+	GetCubemapPixelData,
 	GenerateCubemapMipmaps,
 	FramebufferScreenshot,
 
@@ -62,6 +63,16 @@ enum class DrawCommand: uint16_t
 
 
 
+// Indexed draw parameters of a multi-draw indirect call, layout imposed by glMultiDrawElementsIndirect()
+struct DrawElementsIndirectCommand
+{
+	uint32_t count;          // Number of indices
+	uint32_t instance_count; // Number of instances
+	uint32_t first_index;    // Offset of the first index in the index buffer
+	int32_t base_vertex;     // Value added to the indices
+	uint32_t base_instance;  // Offset of the first instance, shaders see it as gl_BaseInstance
+};
+
 // All the state needed by the renderer to perform a platform draw call
 struct DrawCall
 {
@@ -71,10 +82,16 @@ struct DrawCall
 		Array,
 		IndexedInstanced,
 		ArrayInstanced,
+		MultiIndirect,    // Several indexed draws, parameters are read from a buffer of DrawElementsIndirectCommand
 
 		Count
 	};
 
+	enum DrawCallFlags: uint8_t
+	{
+		Blocking = 1 << 0 // Wait for the shader to be built instead of skipping the draw call
+	};
+
 	#pragma pack(push,1)
 	struct Data
 	{
@@ -84,9 +101,12 @@ struct DrawCall
 
 		ShaderHandle shader;
 		VertexArrayHandle VAO;
+		uint8_t flags;
 	} data;
 	#pragma pack(pop)
 	uint32_t instance_count;
+	uint32_t draw_count;
+	ShaderStorageBufferHandle indirect_buffer;
 	uint32_t dependencies[k_max_draw_call_dependencies];
 	TextureHandle textures[k_max_texture_slots];
 	CubemapHandle cubemaps[k_max_cubemap_slots];
@@ -101,6 +121,7 @@ struct DrawCall
 		K_ASSERT(VAO.is_valid(), "Invalid VertexArrayHandle!");
 
 		instance_count   = 0;
+		draw_count       = 0;
 		dependency_count = 0;
 		texture_count    = 0;
 		cubemap_count    = 0;
@@ -110,6 +131,7 @@ struct DrawCall
 		data.VAO         = VAO;
 		data.count       = count;
 		data.offset      = offset;
+		data.flags       = 0;
 	}
 
 	inline void add_dependency(uint32_t token)
@@ -118,11 +140,26 @@ struct DrawCall
 		dependencies[dependency_count++] = token;
 	}
 
+	// One-shot draw calls (precomputations) are not repeated next frame, they must not be skipped while their
+	// shader is still being built asynchronously
+	inline void set_blocking()
+	{
+		data.flags |= Blocking;
+	}
+
 	inline void set_instance_count(uint32_t value)
 	{
 		instance_count = value;
 	}
 
+	// Set the buffer holding the draw commands of a MultiIndirect draw call, and their number
+	inline void set_indirect_buffer(ShaderStorageBufferHandle buffer, uint32_t count)
+	{
+		K_ASSERT(buffer.is_valid(), "Invalid ShaderStorageBufferHandle!");
+		indirect_buffer = buffer;
+		draw_count      = count;
+	}
+
 	// Set a texture at next slot
 	inline void add_texture(TextureHandle tex)
 	{
@@ -11,10 +11,14 @@
 namespace erwin
 {
 
+using geom_func_ptr_t = Extent (*)(const BufferLayout& layout, std::vector<float>& vdata, std::vector<uint32_t>& idata, pg::Parameters* params);
+
 struct NamedMesh
 {
 	Mesh mesh;
 	std::string name;
+	geom_func_ptr_t geom;
+	DrawPrimitive primitive;
 };
 
 struct CommonGeometryStorage
@@ -23,7 +27,6 @@ struct CommonGeometryStorage
 };
 static CommonGeometryStorage s_storage;
 
-using geom_func_ptr_t = Extent (*)(const BufferLayout& layout, std::vector<float>& vdata, std::vector<uint32_t>& idata, pg::Parameters* params);
 static VertexArrayHandle make_geometry(const std::string& name, VertexBufferLayoutHandle layout_handle, geom_func_ptr_t geom, DrawPrimitive primitive=DrawPrimitive::Triangles)
 {
 	std::vector<float> vdata;
@@ -37,7 +40,8 @@ static VertexArrayHandle make_geometry(const std::string& name, VertexBufferLayo
 	VertexBufferHandle VBO = Renderer::create_vertex_buffer(layout_handle, vdata.data(), uint32_t(vdata.size()), UsagePattern::Static);
 	VertexArrayHandle VAO = Renderer::create_vertex_array(VBO, IBO);
 
-	s_storage.meshes_.insert({hname, {{VAO, layout_handle, dims, hname, true}, name}});
+	Mesh mesh{VAO, layout_handle, dims, hname, true, uint32_t(idata.size())};
+	s_storage.meshes_.insert({hname, {mesh, name, geom, primitive}});
 	return VAO;
 }
 
@@ -94,6 +98,20 @@ const Mesh& CommonGeometry::get_mesh(hash_t name)
 	return it->second.mesh;
 }
 
+std::shared_ptr<const MeshGeometry> CommonGeometry::make_occluder_geometry(hash_t name)
+{
+	auto it = s_storage.meshes_.find(name);
+	if(it == s_storage.meshes_.end() || it->second.primitive != DrawPrimitive::Triangles)
+		return nullptr;
+
+	// Generated again rather than kept around, only occluders need it
+	std::vector<float> vdata;
+	std::vector<uint32_t> idata;
+	const auto& layout = Renderer::get_vertex_buffer_layout(it->second.mesh.layout);
+	(*it->second.geom)(layout, vdata, idata, nullptr);
+	return MeshGeometry::make(vdata, layout.get_stride() / sizeof(float), idata.data(), uint32_t(idata.size()));
+}
+
 void CommonGeometry::visit_meshes(MeshVisitor visit)
 {
 	for(auto&& [hname, nmesh]: s_storage.meshes_)
@@ -13,6 +13,8 @@ public:
 	using MeshVisitor = std::function<bool(const Mesh&, const std::string&)>;
 
 	static const Mesh& get_mesh(hash_t name);
+	// Generate the CPU geometry of a mesh for occlusion culling, null if the mesh is not made of triangles
+	static std::shared_ptr<const MeshGeometry> make_occluder_geometry(hash_t name);
 	static void visit_meshes(MeshVisitor visit);
 
 private:
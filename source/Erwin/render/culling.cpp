@@ -0,0 +1,139 @@
+#include "render/culling.h"
+#include "core/core.h"
+#include "math/simd.h"
+
+#include <cmath>
+
+namespace erwin
+{
+
+// Transform a model-space extent to a world-space AABB, given as center and half size
+static inline void world_bounds(const Extent& extent, const glm::mat4& model_matrix, glm::vec3& center, glm::vec3& half)
+{
+    auto&& [mid, model_half] = bound::to_vectors(extent);
+    center = glm::vec3(model_matrix * glm::vec4(mid, 1.f));
+    // The half size of the AABB enclosing a transformed box is the absolute linear part applied to its half size
+    half = glm::vec3(0.f);
+    for(int col = 0; col < 3; ++col)
+        half += glm::abs(glm::vec3(model_matrix[col])) * model_half[col];
+}
+
+// Signed distance of the box to the plane, negative when it lies entirely behind it
+static inline float plane_distance(const glm::vec4& plane, const glm::vec3& center, const glm::vec3& half)
+{
+    return glm::dot(glm::vec3(plane), center) + plane.w + glm::dot(glm::abs(glm::vec3(plane)), half);
+}
+
+FrustumCuller::FrustumCuller()
+{
+    // Degenerate planes every point lies in front of
+    for(size_t ii = 0; ii < 6; ++ii)
+        planes_[ii] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+}
+
+void FrustumCuller::set_planes(const ComponentCamera3D::FrustumPlanes& planes) { planes_ = planes; }
+
+void FrustumCuller::clear()
+{
+    batches_.clear();
+    count_ = 0;
+}
+
+void FrustumCuller::push(const Extent& extent, const glm::mat4& model_matrix)
+{
+    uint32_t lane = count_ % 4;
+    if(lane == 0)
+        batches_.push_back({});
+
+    glm::vec3 center, half;
+    world_bounds(extent, model_matrix, center, half);
+
+    auto& batch = batches_.back();
+    batch.center_x[lane] = center.x;
+    batch.center_y[lane] = center.y;
+    batch.center_z[lane] = center.z;
+    batch.half_x[lane] = half.x;
+    batch.half_y[lane] = half.y;
+    batch.half_z[lane] = half.z;
+    ++count_;
+}
+
+uint32_t FrustumCuller::cull()
+{
+    W_PROFILE_FUNCTION()
+
+    // Lanes past the last box of the last batch are computed but never read
+    visible_.resize(batches_.size() * 4);
+    uint32_t visible_count = 0;
+
+#if W_SIMD_SSE
+    __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6], abs_x[6], abs_y[6], abs_z[6];
+    for(size_t ii = 0; ii < 6; ++ii)
+    {
+        plane_x[ii] = _mm_set1_ps(planes_[ii].x);
+        plane_y[ii] = _mm_set1_ps(planes_[ii].y);
+        plane_z[ii] = _mm_set1_ps(planes_[ii].z);
+        plane_w[ii] = _mm_set1_ps(planes_[ii].w);
+        abs_x[ii] = _mm_set1_ps(std::abs(planes_[ii].x));
+        abs_y[ii] = _mm_set1_ps(std::abs(planes_[ii].y));
+        abs_z[ii] = _mm_set1_ps(std::abs(planes_[ii].z));
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    for(size_t bb = 0; bb < batches_.size(); ++bb)
+    {
+        const auto& batch = batches_[bb];
+        __m128 cx = _mm_load_ps(batch.center_x);
+        __m128 cy = _mm_load_ps(batch.center_y);
+        __m128 cz = _mm_load_ps(batch.center_z);
+        __m128 hx = _mm_load_ps(batch.half_x);
+        __m128 hy = _mm_load_ps(batch.half_y);
+        __m128 hz = _mm_load_ps(batch.half_z);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for(size_t ii = 0; ii < 6; ++ii)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[ii], cx), _mm_mul_ps(plane_y[ii], cy)),
+                                     _mm_add_ps(_mm_mul_ps(plane_z[ii], cz), plane_w[ii]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_x[ii], hx), _mm_mul_ps(abs_y[ii], hy)),
+                                       _mm_mul_ps(abs_z[ii], hz));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for(uint32_t lane = 0; lane < 4; ++lane)
+            visible_[bb * 4 + lane] = uint8_t((mask >> lane) & 1);
+    }
+#else
+    for(size_t bb = 0; bb < batches_.size(); ++bb)
+    {
+        const auto& batch = batches_[bb];
+        for(uint32_t lane = 0; lane < 4; ++lane)
+        {
+            glm::vec3 center(batch.center_x[lane], batch.center_y[lane], batch.center_z[lane]);
+            glm::vec3 half(batch.half_x[lane], batch.half_y[lane], batch.half_z[lane]);
+            bool inside = true;
+            for(size_t ii = 0; ii < 6; ++ii)
+                inside &= plane_distance(planes_[ii], center, half) >= 0.f;
+            visible_[bb * 4 + lane] = uint8_t(inside);
+        }
+    }
+#endif
+
+    for(uint32_t ii = 0; ii < count_; ++ii)
+        visible_count += visible_[ii];
+    return visible_count;
+}
+
+bool FrustumCuller::is_visible(const Extent& extent, const glm::mat4& model_matrix,
+                               const ComponentCamera3D::FrustumPlanes& planes)
+{
+    glm::vec3 center, half;
+    world_bounds(extent, model_matrix, center, half);
+    for(size_t ii = 0; ii < 6; ++ii)
+        if(plane_distance(planes[ii], center, half) < 0.f)
+            return false;
+    return true;
+}
+
+} // namespace erwin
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "asset/bounding.h"
+#include "entity/component/camera.h"
+#include "glm/glm.hpp"
+
+namespace erwin
+{
+
+/*
+	Frustum culling of mesh instances. Model-space extents are transformed to world-space AABBs and
+	packed four by four in SoA batches, then all batches are tested against the six frustum planes
+	at once, four boxes per SIMD instruction. A box is culled when it lies entirely behind a plane.
+	The test is conservative: boxes straddling a frustum corner outside of it are kept.
+*/
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	// Set the world-space planes boxes are tested against. Until then, nothing is culled.
+	void set_planes(const ComponentCamera3D::FrustumPlanes& planes);
+	// Remove all boxes
+	void clear();
+	// Queue the bounds of a mesh instance, visibility is then queried by push order
+	void push(const Extent& extent, const glm::mat4& model_matrix);
+	// Test all queued boxes, returns the number of visible ones
+	uint32_t cull();
+
+	inline bool is_visible(uint32_t index) const { return visible_[index] != 0; }
+	inline uint32_t get_count() const { return count_; }
+	inline const ComponentCamera3D::FrustumPlanes& get_planes() const { return planes_; }
+
+	// Test a single mesh instance
+	static bool is_visible(const Extent& extent, const glm::mat4& model_matrix, const ComponentCamera3D::FrustumPlanes& planes);
+
+private:
+	struct alignas(16) BoundsBatch
+	{
+		float center_x[4];
+		float center_y[4];
+		float center_z[4];
+		float half_x[4];
+		float half_y[4];
+		float half_z[4];
+	};
+
+	ComponentCamera3D::FrustumPlanes planes_;
+	std::vector<BoundsBatch> batches_;
+	std::vector<uint8_t> visible_;
+	uint32_t count_ = 0;
+};
+
+} // namespace erwin
@@ -0,0 +1,794 @@
+#include "render/frame_capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+#include "render/commands.h"
+#include "render/framebuffer_layout.h"
+#include <kibble/logger/logger.h>
+
+namespace erwin
+{
+
+using HandleType = CapturedCommand::HandleType;
+using HandleUsage = CapturedCommand::HandleUsage;
+using PointerType = CapturedCommand::PointerType;
+
+static constexpr uint32_t k_capture_magic = 0x43575245; // "ERWC"
+static constexpr uint32_t k_capture_version = 4;
+static constexpr uint32_t k_frame_magic = 0x4d415246; // "FRAM"
+
+// Size of a texel as read from client memory by the backend on texture creation
+static size_t client_texel_size(ImageFormat format)
+{
+    switch(format)
+    {
+    case ImageFormat::R8:
+        return 1;
+    case ImageFormat::RGB8:
+    case ImageFormat::SRGB8:
+        return 3;
+    case ImageFormat::RGBA8:
+    case ImageFormat::SRGB_ALPHA:
+    case ImageFormat::RG16_SNORM:
+        return 4;
+    case ImageFormat::RGB16_SNORM:
+        return 6;
+    case ImageFormat::RGBA16_SNORM:
+    case ImageFormat::RG16F:
+        return 8;
+    case ImageFormat::RGB16F:
+    case ImageFormat::RGB32F:
+        return 12;
+    case ImageFormat::RGBA16F:
+    case ImageFormat::RGBA32F:
+        return 16;
+    case ImageFormat::DEPTH_COMPONENT16:
+        return 2;
+    case ImageFormat::DEPTH_COMPONENT24:
+    case ImageFormat::DEPTH_COMPONENT32F:
+    case ImageFormat::DEPTH24_STENCIL8:
+        return 4;
+    case ImageFormat::DEPTH32F_STENCIL8:
+        return 8;
+    default: // Compressed formats are uploaded with a size of one byte per texel
+        return 1;
+    }
+}
+
+// Reads the fields of a command from a command buffer and keeps track of the handles and pointers
+class CommandReader
+{
+public:
+    CommandReader(memory::LinearBuffer<>& storage, CapturedCommand& command)
+        : storage_(storage), command_(command), begin_(static_cast<uint8_t*>(storage.head()))
+    {}
+
+    // Command data is copied once all the fields have been read
+    ~CommandReader() { command_.data.assign(begin_, static_cast<uint8_t*>(storage_.head())); }
+
+    inline uint16_t offset() const { return uint16_t(static_cast<uint8_t*>(storage_.head()) - begin_); }
+
+    template <typename T> inline T read()
+    {
+        T value;
+        storage_.read(&value);
+        return value;
+    }
+
+    inline void read_str()
+    {
+        std::string str;
+        storage_.read_str(str);
+    }
+
+    template <typename HandleT> inline HandleT read_handle(HandleType type, HandleUsage usage = HandleUsage::Use)
+    {
+        command_.handles.push_back({offset(), type, usage});
+        return read<HandleT>();
+    }
+
+    // Read a pointer to a data blob of known size
+    inline void read_pointer(PointerType type, size_t size)
+    {
+        uint16_t ptr_offset = offset();
+        add_pointer(ptr_offset, read<const void*>(), type, size);
+    }
+
+    inline void add_pointer(uint16_t ptr_offset, const void* ptr, PointerType type, size_t size)
+    {
+        CapturedCommand::PointerField field{ptr_offset, (ptr != nullptr) ? type : PointerType::Null, 0, {}};
+        if(ptr != nullptr)
+        {
+            auto* bytes = static_cast<const uint8_t*>(ptr);
+            field.data.assign(bytes, bytes + size);
+        }
+        command_.pointers.push_back(std::move(field));
+    }
+
+    inline void add_dependency(uint16_t ptr_offset, uint32_t index)
+    {
+        command_.pointers.push_back({ptr_offset, PointerType::Dependency, index, {}});
+    }
+
+    inline void read_promise_token()
+    {
+        command_.promise_token = offset();
+        read<uint64_t>();
+    }
+
+private:
+    memory::LinearBuffer<>& storage_;
+    CapturedCommand& command_;
+    uint8_t* begin_;
+};
+
+bool FrameCapture::open(const fs::path& path, uint32_t frame_count)
+{
+    if(is_open())
+    {
+        KLOGW("render") << "Frame capture already in progress, ignoring request." << std::endl;
+        return false;
+    }
+
+    stream_.open(path, std::ios::binary);
+    if(!stream_.is_open())
+    {
+        KLOGE("render") << "Cannot open frame capture file:" << std::endl;
+        KLOGI << kb::KS_PATH_ << path << std::endl;
+        return false;
+    }
+
+    KLOGN("render") << "Capturing " << frame_count << " frame(s) to:" << std::endl;
+    KLOGI << kb::KS_PATH_ << path << std::endl;
+
+    path_ = path;
+    remaining_frames_ = frame_count;
+    frame_index_ = 0;
+    FramebufferHandle default_target = gfx::backend->default_render_target();
+    stream_.write(reinterpret_cast<const char*>(&k_capture_magic), sizeof(uint32_t));
+    stream_.write(reinterpret_cast<const char*>(&k_capture_version), sizeof(uint32_t));
+    stream_.write(reinterpret_cast<const char*>(&default_target.data), sizeof(uint32_t));
+    return true;
+}
+
+void FrameCapture::read_render_command(uint16_t type, uint64_t key, memory::LinearBuffer<>& storage,
+                                       CapturedCommand& command)
+{
+    command.type = type;
+    command.key = key;
+    CommandReader reader(storage, command);
+
+    switch(RenderCommand(type))
+    {
+    case RenderCommand::CreateIndexBuffer: {
+        reader.read_handle<IndexBufferHandle>(HandleType::IndexBuffer, HandleUsage::Create);
+        auto count = reader.read<uint32_t>();
+        reader.read<DrawPrimitive>();
+        reader.read<UsagePattern>();
+        reader.read_pointer(PointerType::Auxiliary, count * sizeof(uint32_t));
+        break;
+    }
+    case RenderCommand::CreateVertexBuffer: {
+        reader.read_handle<VertexBufferHandle>(HandleType::VertexBuffer, HandleUsage::Create);
+        auto layout = reader.read_handle<VertexBufferLayoutHandle>(HandleType::VertexBufferLayout);
+        auto count = reader.read<uint32_t>();
+        reader.read<UsagePattern>();
+        reader.read_pointer(PointerType::Auxiliary, count * sizeof(float));
+        // Layouts are created immediately, save a copy so that the replayer can recreate them
+        const BufferLayout& buffer_layout = gfx::backend->get_vertex_buffer_layout(layout);
+        command.layout.assign(buffer_layout.begin(), buffer_layout.end());
+        break;
+    }
+    case RenderCommand::CreateVertexArray: {
+        reader.read_handle<VertexArrayHandle>(HandleType::VertexArray, HandleUsage::Create);
+        reader.read_handle<IndexBufferHandle>(HandleType::IndexBuffer);
+        reader.read_handle<VertexBufferHandle>(HandleType::VertexBuffer);
+        break;
+    }
+    case RenderCommand::CreateVertexArrayMultipleVBO: {
+        reader.read_handle<VertexArrayHandle>(HandleType::VertexArray, HandleUsage::Create);
+        reader.read_handle<IndexBufferHandle>(HandleType::IndexBuffer);
+        auto VBO_count = reader.read<uint8_t>();
+        for(uint8_t ii = 0; ii < VBO_count; ++ii)
+            reader.read_handle<VertexBufferHandle>(HandleType::VertexBuffer);
+        break;
+    }
+    case RenderCommand::CreateUniformBuffer:
+    case RenderCommand::CreateShaderStorageBuffer: {
+        bool is_UBO = (RenderCommand(type) == RenderCommand::CreateUniformBuffer);
+        auto handle = reader.read_handle<UniformBufferHandle>(
+            is_UBO ? HandleType::UniformBuffer : HandleType::ShaderStorageBuffer, HandleUsage::Create);
+        auto size = reader.read<uint32_t>();
+        reader.read<UsagePattern>();
+        reader.read_str();
+        reader.read_pointer(PointerType::Auxiliary, size);
+        if(is_UBO)
+            UBO_sizes_[handle.data] = size;
+        break;
+    }
+    case RenderCommand::CreateShader: {
+        reader.read_handle<ShaderHandle>(HandleType::Shader, HandleUsage::Create);
+        reader.read_str();
+        reader.read_str();
+        break;
+    }
+    case RenderCommand::CreateTexture2D: {
+        reader.read_handle<TextureHandle>(HandleType::Texture, HandleUsage::Create);
+        uint16_t desc_offset = reader.offset();
+        auto desc = reader.read<Texture2DDescriptor>();
+        // Data marked for release is deleted by the backend, data owned by the caller only needs to live until
+        // the command is dispatched
+        PointerType data_type = PointerType::Owned;
+        if(desc.must_free())
+            data_type = is_floating_point(desc.image_format) ? PointerType::HeapFloats : PointerType::HeapBytes;
+        reader.add_pointer(uint16_t(desc_offset + offsetof(Texture2DDescriptor, data)), desc.data, data_type,
+                           desc.width * desc.height * client_texel_size(desc.image_format));
+        break;
+    }
+    case RenderCommand::CreateCubemap: {
+        reader.read_handle<CubemapHandle>(HandleType::Cubemap, HandleUsage::Create);
+        uint16_t desc_offset = reader.offset();
+        auto desc = reader.read<CubemapDescriptor>();
+        for(size_t face = 0; face < 6; ++face)
+            reader.add_pointer(uint16_t(desc_offset + offsetof(CubemapDescriptor, face_data) + face * sizeof(void*)),
+                               desc.face_data[face], PointerType::Owned,
+                               desc.width * desc.height * client_texel_size(desc.image_format));
+        reader.add_pointer(uint16_t(desc_offset + offsetof(CubemapDescriptor, mip_data)), desc.mip_data,
+                           desc.must_free ? PointerType::HeapBytes : PointerType::Owned,
+                           cubemap_mip_chain_size(desc.width, desc.mips, desc.image_format));
+        break;
+    }
+    case RenderCommand::CreateFramebuffer: {
+        auto handle = reader.read_handle<FramebufferHandle>(HandleType::Framebuffer, HandleUsage::Create);
+        reader.read<uint32_t>();
+        reader.read<uint32_t>();
+        reader.read<uint8_t>();
+        auto count = reader.read<uint32_t>();
+        reader.read_pointer(PointerType::Auxiliary, count * sizeof(FramebufferLayoutElement));
+        // Attachment handles are registered immediately, save them so that the replayer can remap them
+        uint32_t texture_count = gfx::backend->get_framebuffer_texture_count(handle);
+        for(uint32_t ii = 0; ii < texture_count; ++ii)
+        {
+            command.texture_vector.handles.push_back(gfx::backend->get_framebuffer_texture(handle, ii));
+            command.texture_vector.debug_names.push_back(gfx::backend->get_framebuffer_texture_name(handle, ii));
+        }
+        command.texture_vector.cubemap = gfx::backend->get_framebuffer_cubemap(handle);
+        if(!command.texture_vector.cubemap.is_null())
+            command.texture_vector.debug_names.push_back(gfx::backend->get_framebuffer_texture_name(handle, 0));
+        break;
+    }
+    case RenderCommand::UpdateIndexBuffer: {
+        reader.read_handle<IndexBufferHandle>(HandleType::IndexBuffer);
+        auto count = reader.read<uint32_t>();
+        reader.read_pointer(PointerType::Auxiliary, count * sizeof(uint32_t));
+        reader.read<uint32_t>();
+        break;
+    }
+    case RenderCommand::UpdateVertexBuffer: {
+        reader.read_handle<VertexBufferHandle>(HandleType::VertexBuffer);
+        auto size = reader.read<uint32_t>();
+        reader.read_pointer(PointerType::Auxiliary, size);
+        reader.read<uint32_t>();
+        break;
+    }
+    case RenderCommand::UpdateUniformBuffer:
+    case RenderCommand::UpdateShaderStorageBuffer: {
+        static constexpr HandleType k_types[] = {HandleType::UniformBuffer, HandleType::ShaderStorageBuffer};
+        reader.read_handle<UniformBufferHandle>(k_types[type - uint16_t(RenderCommand::UpdateUniformBuffer)]);
+        auto size = reader.read<uint32_t>();
+        reader.read_pointer(PointerType::Auxiliary, size);
+        break;
+    }
+    case RenderCommand::ShaderAttachUniformBuffer: {
+        reader.read_handle<ShaderHandle>(HandleType::Shader);
+        reader.read_handle<UniformBufferHandle>(HandleType::UniformBuffer);
+        break;
+    }
+    case RenderCommand::ShaderAttachStorageBuffer: {
+        reader.read_handle<ShaderHandle>(HandleType::Shader);
+        reader.read_handle<ShaderStorageBufferHandle>(HandleType::ShaderStorageBuffer);
+        break;
+    }
+    case RenderCommand::UpdateFramebuffer: {
+        reader.read_handle<FramebufferHandle>(HandleType::Framebuffer);
+        reader.read<uint32_t>();
+        reader.read<uint32_t>();
+        break;
+    }
+    case RenderCommand::ClearFramebuffers:
+        break;
+    case RenderCommand::SetHostWindowSize: {
+        reader.read<uint32_t>();
+        reader.read<uint32_t>();
+        break;
+    }
+    case RenderCommand::GetPixelData: {
+        reader.read_handle<TextureHandle>(HandleType::Texture);
+        reader.read_promise_token();
+        break;
+    }
+    case RenderCommand::GetCubemapPixelData: {
+        reader.read_handle<CubemapHandle>(HandleType::Cubemap);
+        reader.read_promise_token();
+        break;
+    }
+    case RenderCommand::GenerateCubemapMipmaps: {
+        reader.read_handle<CubemapHandle>(HandleType::Cubemap);
+        break;
+    }
+    case RenderCommand::FramebufferScreenshot: {
+        reader.read_handle<FramebufferHandle>(HandleType::Framebuffer);
+        reader.read_str();
+        break;
+    }
+    case RenderCommand::DestroyIndexBuffer:
+    case RenderCommand::DestroyVertexBufferLayout:
+    case RenderCommand::DestroyVertexBuffer:
+    case RenderCommand::DestroyVertexArray:
+    case RenderCommand::DestroyUniformBuffer:
+    case RenderCommand::DestroyShaderStorageBuffer:
+    case RenderCommand::DestroyShader:
+    case RenderCommand::DestroyTexture2D:
+    case RenderCommand::DestroyCubemap: {
+        static constexpr HandleType k_types[] = {
+            HandleType::IndexBuffer,   HandleType::VertexBufferLayout,  HandleType::VertexBuffer,
+            HandleType::VertexArray,   HandleType::UniformBuffer,       HandleType::ShaderStorageBuffer,
+            HandleType::Shader,        HandleType::Texture,             HandleType::Cubemap};
+        reader.read_handle<IndexBufferHandle>(k_types[type - uint16_t(RenderCommand::DestroyIndexBuffer)],
+                                              HandleUsage::Release);
+        break;
+    }
+    case RenderCommand::DestroyFramebuffer: {
+        reader.read_handle<FramebufferHandle>(HandleType::Framebuffer, HandleUsage::Release);
+        reader.read<bool>();
+        break;
+    }
+    default:
+        K_ASSERT_FMT(false, "Unknown render command type: %hu", type);
+    }
+}
+
+void FrameCapture::read_draw_command(uint16_t type, uint64_t key, memory::LinearBuffer<>& storage,
+                                     const std::map<void*, uint32_t>& heads, CapturedCommand& command)
+{
+    command.type = type;
+    command.key = key;
+    CommandReader reader(storage, command);
+
+    switch(DrawCommand(type))
+    {
+    case DrawCommand::Draw: {
+        auto dependency_count = reader.read<uint8_t>();
+        for(uint8_t ii = 0; ii < dependency_count; ++ii)
+        {
+            uint16_t ptr_offset = reader.offset();
+            auto* dependency = reader.read<void*>();
+            reader.add_dependency(ptr_offset, heads.at(dependency));
+        }
+        auto dc_type = reader.read<DrawCall::DrawCallType>();
+        uint16_t data_offset = reader.offset();
+        reader.read<DrawCall::Data>();
+        command.handles.push_back({uint16_t(data_offset + offsetof(DrawCall::Data, shader)), HandleType::Shader,
+                                   HandleUsage::Use});
+        command.handles.push_back({uint16_t(data_offset + offsetof(DrawCall::Data, VAO)), HandleType::VertexArray,
+                                   HandleUsage::Use});
+        auto texture_count = reader.read<uint8_t>();
+        for(uint8_t ii = 0; ii < texture_count; ++ii)
+            reader.read_handle<TextureHandle>(HandleType::Texture);
+        auto cubemap_count = reader.read<uint8_t>();
+        for(uint8_t ii = 0; ii < cubemap_count; ++ii)
+            reader.read_handle<CubemapHandle>(HandleType::Cubemap);
+        if(dc_type == DrawCall::IndexedInstanced || dc_type == DrawCall::ArrayInstanced)
+            reader.read<uint32_t>();
+        else if(dc_type == DrawCall::MultiIndirect)
+        {
+            reader.read_handle<ShaderStorageBufferHandle>(HandleType::ShaderStorageBuffer);
+            reader.read<uint32_t>();
+        }
+        break;
+    }
+    case DrawCommand::Clear: {
+        reader.read_handle<FramebufferHandle>(HandleType::Framebuffer);
+        reader.read<uint32_t>();
+        reader.read<uint32_t>();
+        break;
+    }
+    case DrawCommand::BlitDepth: {
+        reader.read_handle<FramebufferHandle>(HandleType::Framebuffer);
+        reader.read_handle<FramebufferHandle>(HandleType::Framebuffer);
+        break;
+    }
+    case DrawCommand::UpdateShaderStorageBuffer: {
+        reader.read_handle<ShaderStorageBufferHandle>(HandleType::ShaderStorageBuffer);
+        auto size = reader.read<uint32_t>();
+        reader.read_pointer(PointerType::Auxiliary, size);
+        break;
+    }
+    case DrawCommand::UpdateUniformBuffer: {
+        auto handle = reader.read_handle<UniformBufferHandle>(HandleType::UniformBuffer);
+        auto size = reader.read<uint32_t>();
+        // A size of 0 maps the whole buffer
+        if(size == 0)
+        {
+            auto findit = UBO_sizes_.find(handle.data);
+            if(findit == UBO_sizes_.end())
+                KLOGW("render") << "Captured update of a uniform buffer created before capture, data is dropped."
+                                << std::endl;
+            else
+                size = findit->second;
+        }
+        reader.read_pointer(PointerType::Auxiliary, size);
+        break;
+    }
+    default:
+        K_ASSERT_FMT(false, "Unknown draw command type: %hu", type);
+    }
+}
+
+template <typename T> static inline void write_pod(std::ofstream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T> static inline void read_pod(std::ifstream& stream, T& value)
+{
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+static void write_command(std::ofstream& stream, const CapturedCommand& command)
+{
+    write_pod(stream, command.type);
+    write_pod(stream, command.key);
+    write_pod(stream, uint32_t(command.data.size()));
+    stream.write(reinterpret_cast<const char*>(command.data.data()), std::streamsize(command.data.size()));
+
+    write_pod(stream, uint16_t(command.handles.size()));
+    for(const auto& field : command.handles)
+        write_pod(stream, field);
+
+    write_pod(stream, uint16_t(command.pointers.size()));
+    for(const auto& field : command.pointers)
+    {
+        write_pod(stream, field.offset);
+        write_pod(stream, field.type);
+        write_pod(stream, field.dependency);
+        write_pod(stream, uint32_t(field.data.size()));
+        stream.write(reinterpret_cast<const char*>(field.data.data()), std::streamsize(field.data.size()));
+    }
+
+    write_pod(stream, command.promise_token);
+
+    write_pod(stream, uint32_t(command.layout.size()));
+    for(const auto& element : command.layout)
+        write_pod(stream, element);
+
+    const auto& ftv = command.texture_vector;
+    write_pod(stream, uint32_t(ftv.handles.size()));
+    for(auto handle : ftv.handles)
+        write_pod(stream, handle.data);
+    write_pod(stream, uint32_t(ftv.debug_names.size()));
+    for(auto name : ftv.debug_names)
+        write_pod(stream, name);
+    write_pod(stream, ftv.cubemap.data);
+}
+
+static void read_command(std::ifstream& stream, CapturedCommand& command)
+{
+    uint32_t size;
+    read_pod(stream, command.type);
+    read_pod(stream, command.key);
+    read_pod(stream, size);
+    command.data.resize(size);
+    stream.read(reinterpret_cast<char*>(command.data.data()), size);
+
+    uint16_t count;
+    read_pod(stream, count);
+    command.handles.resize(count);
+    for(auto& field : command.handles)
+        read_pod(stream, field);
+
+    read_pod(stream, count);
+    command.pointers.resize(count);
+    for(auto& field : command.pointers)
+    {
+        read_pod(stream, field.offset);
+        read_pod(stream, field.type);
+        read_pod(stream, field.dependency);
+        read_pod(stream, size);
+        field.data.resize(size);
+        stream.read(reinterpret_cast<char*>(field.data.data()), size);
+    }
+
+    read_pod(stream, command.promise_token);
+
+    read_pod(stream, size);
+    command.layout.resize(size);
+    for(auto& element : command.layout)
+        read_pod(stream, element);
+
+    auto& ftv = command.texture_vector;
+    read_pod(stream, size);
+    ftv.handles.resize(size);
+    for(auto& handle : ftv.handles)
+        read_pod(stream, handle.data);
+    read_pod(stream, size);
+    ftv.debug_names.resize(size);
+    for(auto& name : ftv.debug_names)
+        read_pod(stream, name);
+    read_pod(stream, ftv.cubemap.data);
+}
+
+static void write_command_list(std::ofstream& stream, const std::vector<CapturedCommand>& commands)
+{
+    write_pod(stream, uint32_t(commands.size()));
+    for(const auto& command : commands)
+        write_command(stream, command);
+}
+
+static void read_command_list(std::ifstream& stream, std::vector<CapturedCommand>& commands)
+{
+    uint32_t count;
+    read_pod(stream, count);
+    commands.resize(count);
+    for(auto& command : commands)
+        read_command(stream, command);
+}
+
+void FrameCapture::write(const CapturedFrame& frame)
+{
+    if(!is_open())
+        return;
+
+    write_pod(stream_, k_frame_magic);
+    write_command_list(stream_, frame.pre_buffer);
+    write_pod(stream_, uint32_t(frame.queue.size()));
+    for(const auto& commands : frame.queue)
+        write_command_list(stream_, commands);
+    write_command_list(stream_, frame.post_buffer);
+
+    ++frame_index_;
+    if(--remaining_frames_ == 0)
+    {
+        stream_.close();
+        UBO_sizes_.clear();
+        KLOGN("render") << "Frame capture complete (" << frame_index_ << " frames):" << std::endl;
+        KLOGI << kb::KS_PATH_ << path_ << std::endl;
+    }
+}
+
+bool FrameCapture::load(const fs::path& path, std::vector<CapturedFrame>& frames, FramebufferHandle& default_target)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if(!stream.is_open())
+    {
+        KLOGE("render") << "Cannot open frame capture file:" << std::endl;
+        KLOGI << kb::KS_PATH_ << path << std::endl;
+        return false;
+    }
+
+    uint32_t magic, version;
+    read_pod(stream, magic);
+    read_pod(stream, version);
+    if(magic != k_capture_magic || version != k_capture_version)
+    {
+        KLOGE("render") << "Not a frame capture file, or unsupported version:" << std::endl;
+        KLOGI << kb::KS_PATH_ << path << std::endl;
+        return false;
+    }
+    read_pod(stream, default_target.data);
+
+    while(stream.peek() != std::ifstream::traits_type::eof())
+    {
+        read_pod(stream, magic);
+        if(magic != k_frame_magic)
+        {
+            KLOGE("render") << "Corrupted frame capture, stopped after " << frames.size() << " frames." << std::endl;
+            return false;
+        }
+
+        auto& frame = frames.emplace_back();
+        read_command_list(stream, frame.pre_buffer);
+        uint32_t buffer_count;
+        read_pod(stream, buffer_count);
+        frame.queue.resize(buffer_count);
+        for(auto& commands : frame.queue)
+            read_command_list(stream, commands);
+        read_command_list(stream, frame.post_buffer);
+    }
+
+    return true;
+}
+
+static uint32_t acquire_handle(HandleType type)
+{
+    switch(type)
+    {
+    case HandleType::IndexBuffer:
+        return IndexBufferHandle::acquire().data;
+    case HandleType::VertexBufferLayout:
+        return VertexBufferLayoutHandle::acquire().data;
+    case HandleType::VertexBuffer:
+        return VertexBufferHandle::acquire().data;
+    case HandleType::VertexArray:
+        return VertexArrayHandle::acquire().data;
+    case HandleType::UniformBuffer:
+        return UniformBufferHandle::acquire().data;
+    case HandleType::ShaderStorageBuffer:
+        return ShaderStorageBufferHandle::acquire().data;
+    case HandleType::Texture:
+        return TextureHandle::acquire().data;
+    case HandleType::Cubemap:
+        return CubemapHandle::acquire().data;
+    case HandleType::Shader:
+        return ShaderHandle::acquire().data;
+    case HandleType::Framebuffer:
+        return FramebufferHandle::acquire().data;
+    default:
+        return k_null_handle;
+    }
+}
+
+FrameReplayer::FrameReplayer(FramebufferHandle captured_default_target)
+{
+    handle_maps_[size_t(HandleType::Framebuffer)][captured_default_target.data] =
+        gfx::backend->default_render_target().data;
+}
+
+FrameReplayer::~FrameReplayer() { end_frame(true); }
+
+bool FrameReplayer::remap(const CapturedCommand& command, const CapturedCommand::HandleField& field, uint32_t& data)
+{
+    auto& map = handle_maps_[size_t(field.type)];
+    auto findit = map.find(data);
+    if(findit != map.end())
+    {
+        data = findit->second;
+        if(field.usage == HandleUsage::Release)
+            map.erase(findit);
+        return true;
+    }
+
+    // Layouts are not created by a command, recreate them on first use
+    if(field.type == HandleType::VertexBufferLayout && !command.layout.empty())
+    {
+        uint32_t replay_data = gfx::backend->create_vertex_buffer_layout(command.layout).data;
+        map[data] = replay_data;
+        data = replay_data;
+        return true;
+    }
+
+    return false;
+}
+
+bool FrameReplayer::relocate(const CapturedCommand& command, Renderer::AuxArena& arena,
+                             const std::vector<void*>& dependencies, std::vector<uint8_t>& data)
+{
+    // Check that every resource this command depends on is known before anything gets acquired
+    for(const auto& field : command.handles)
+    {
+        uint32_t handle_data;
+        std::memcpy(&handle_data, command.data.data() + field.offset, sizeof(uint32_t));
+        if(field.usage != HandleUsage::Create && handle_data != k_null_handle &&
+           handle_maps_[size_t(field.type)].find(handle_data) == handle_maps_[size_t(field.type)].end() &&
+           !(field.type == HandleType::VertexBufferLayout && !command.layout.empty()))
+        {
+            ++skipped_count_;
+            return false;
+        }
+    }
+    for(const auto& field : command.pointers)
+    {
+        if(field.type == PointerType::Dependency &&
+           (field.dependency >= dependencies.size() || dependencies[field.dependency] == nullptr))
+        {
+            ++skipped_count_;
+            return false;
+        }
+    }
+
+    data = command.data;
+
+    // Remap handles
+    for(const auto& field : command.handles)
+    {
+        uint32_t handle_data;
+        std::memcpy(&handle_data, data.data() + field.offset, sizeof(uint32_t));
+        if(handle_data == k_null_handle)
+            continue;
+
+        if(field.usage == HandleUsage::Create)
+        {
+            uint32_t replay_data = acquire_handle(field.type);
+            handle_maps_[size_t(field.type)][handle_data] = replay_data;
+            handle_data = replay_data;
+        }
+        else
+            remap(command, field, handle_data);
+
+        std::memcpy(data.data() + field.offset, &handle_data, sizeof(uint32_t));
+
+        // Framebuffer attachments are registered immediately on creation
+        if(field.type == HandleType::Framebuffer && field.usage == HandleUsage::Create)
+        {
+            FramebufferTextureVector ftv;
+            ftv.debug_names = command.texture_vector.debug_names;
+            for(auto texture : command.texture_vector.handles)
+            {
+                TextureHandle replay_texture = TextureHandle::acquire();
+                handle_maps_[size_t(HandleType::Texture)][texture.data] = replay_texture.data;
+                ftv.handles.push_back(replay_texture);
+            }
+            if(!command.texture_vector.cubemap.is_null())
+            {
+                ftv.cubemap = CubemapHandle::acquire();
+                handle_maps_[size_t(HandleType::Cubemap)][command.texture_vector.cubemap.data] = ftv.cubemap.data;
+            }
+            gfx::backend->add_framebuffer_texture_vector(FramebufferHandle{handle_data}, ftv);
+        }
+    }
+
+    // Relocate pointed-to data
+    for(const auto& field : command.pointers)
+    {
+        void* ptr = nullptr;
+        size_t size = field.data.size();
+        switch(field.type)
+        {
+        case PointerType::Null:
+            break;
+        case PointerType::Auxiliary:
+            ptr = K_NEW_ARRAY_DYNAMIC_ALIGN(uint8_t, size, arena, 8);
+            break;
+        case PointerType::Owned:
+            ptr = owned_.emplace_back(std::make_unique<uint8_t[]>(size)).get();
+            break;
+        case PointerType::HeapBytes:
+            ptr = new uint8_t[size];
+            break;
+        case PointerType::HeapFloats:
+            ptr = new float[size / sizeof(float)];
+            break;
+        case PointerType::Dependency:
+            ptr = dependencies[field.dependency];
+            break;
+        }
+        if(ptr != nullptr && field.type != PointerType::Dependency)
+            std::memcpy(ptr, field.data.data(), size);
+        std::memcpy(data.data() + field.offset, &ptr, sizeof(void*));
+    }
+
+    // Texture data read back by the backend is released by the replayer
+    if(command.promise_token != CapturedCommand::k_no_token)
+    {
+        auto&& [token, fut] = gfx::backend->future_texture_data();
+        std::memcpy(data.data() + command.promise_token, &token, sizeof(uint64_t));
+        pixel_data_.push_back(std::move(fut));
+    }
+
+    return true;
+}
+
+void FrameReplayer::end_frame(bool wait)
+{
+    owned_.clear();
+    // Texture data is read back asynchronously by the backend, a few more frames may be needed
+    auto is_ready = [](auto& fut) { return fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+    while(wait && !std::all_of(pixel_data_.begin(), pixel_data_.end(), is_ready))
+        Renderer::flush();
+
+    for(auto it = pixel_data_.begin(); it != pixel_data_.end();)
+    {
+        if(wait || it->wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            delete[] it->get().data;
+            it = pixel_data_.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+} // namespace erwin
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "render/backend.h"
+#include "render/renderer.h"
+
+namespace fs = std::filesystem;
+
+namespace erwin
+{
+
+// A render or draw command, as written to a command buffer. The location of every handle and pointer
+// inside the command data is kept alongside, so that handles can be remapped and pointed-to data can
+// be relocated when the command is replayed.
+struct CapturedCommand
+{
+    enum class HandleType : uint8_t
+    {
+        IndexBuffer,
+        VertexBufferLayout,
+        VertexBuffer,
+        VertexArray,
+        UniformBuffer,
+        ShaderStorageBuffer,
+        Texture,
+        Cubemap,
+        Shader,
+        Framebuffer,
+
+        Count
+    };
+
+    enum class HandleUsage : uint8_t
+    {
+        Use,     // Handle must refer to a resource known to the replayer
+        Create,  // Handle is acquired by the replayer
+        Release  // Resource is destroyed by this command
+    };
+
+    enum class PointerType : uint8_t
+    {
+        Null,       // Null pointer, left as is
+        Auxiliary,  // Data copied to the frame auxiliary arena
+        Owned,      // Data owned by the replayer until the frame is submitted
+        HeapBytes,  // Data released by the backend with delete[] as an uint8_t array
+        HeapFloats, // Data released by the backend with delete[] as a float array
+        Dependency  // Address of another command in the same draw command buffer
+    };
+
+    struct HandleField
+    {
+        uint16_t offset;
+        HandleType type;
+        HandleUsage usage;
+    };
+
+    struct PointerField
+    {
+        uint16_t offset;
+        PointerType type;
+        uint32_t dependency; // Index of the referenced command, for PointerType::Dependency
+        std::vector<uint8_t> data;
+    };
+
+    static constexpr uint16_t k_no_token = 0xffff;
+
+    uint64_t key;
+    uint16_t type;
+    std::vector<uint8_t> data; // Command data, type excluded
+    std::vector<HandleField> handles;
+    std::vector<PointerField> pointers;
+    uint16_t promise_token = k_no_token; // Offset of a texture data promise token
+    // State created immediately at submission, outside of the command buffers
+    std::vector<BufferLayoutElement> layout;   // CreateVertexBuffer: vertex buffer layout elements
+    FramebufferTextureVector texture_vector;   // CreateFramebuffer: attachment handles and names
+};
+
+// All the commands submitted during a frame, before sorting
+struct CapturedFrame
+{
+    std::vector<CapturedCommand> pre_buffer;
+    std::vector<std::vector<CapturedCommand>> queue; // One list per draw command buffer
+    std::vector<CapturedCommand> post_buffer;
+};
+
+// Serializes whole frames to a binary capture file, see Renderer::capture_frames()
+class FrameCapture
+{
+public:
+    // Start capturing a given amount of frames to a file
+    bool open(const fs::path& path, uint32_t frame_count);
+    inline bool is_open() const { return remaining_frames_ > 0; }
+
+    // Decode a render command whose type was just read, storage head is moved past the command
+    void read_render_command(uint16_t type, uint64_t key, memory::LinearBuffer<>& storage, CapturedCommand& command);
+    // Decode a draw command whose type was just read. Dependencies are resolved using a map of the
+    // command heads in the same buffer to their submission index.
+    void read_draw_command(uint16_t type, uint64_t key, memory::LinearBuffer<>& storage,
+                           const std::map<void*, uint32_t>& heads, CapturedCommand& command);
+    // Append a frame to the capture file, the file is closed after the last requested frame
+    void write(const CapturedFrame& frame);
+
+    // Load all the frames of a capture file. The default render target handle used during capture is also returned.
+    static bool load(const fs::path& path, std::vector<CapturedFrame>& frames, FramebufferHandle& default_target);
+
+private:
+    std::ofstream stream_;
+    fs::path path_;
+    uint32_t remaining_frames_ = 0;
+    uint32_t frame_index_ = 0;
+    // Size of the uniform buffers created during capture, UBO updates of size 0 map the whole buffer
+    std::map<uint32_t, uint32_t> UBO_sizes_;
+};
+
+// Turns captured commands back into command data that can be submitted, see Renderer::replay().
+// Handles created during capture are mapped to handles acquired during replay.
+class FrameReplayer
+{
+public:
+    explicit FrameReplayer(FramebufferHandle captured_default_target);
+    ~FrameReplayer();
+
+    // Patch a copy of the command data: handles are remapped, and data is relocated.
+    // Dependencies are the addresses of the replayed commands in the same buffer, nullptr if skipped.
+    // Returns false if the command cannot be replayed: it references a resource that was not created during
+    // capture, or it has side effects outside of the renderer (framebuffer screenshots).
+    bool relocate(const CapturedCommand& command, Renderer::AuxArena& arena, const std::vector<void*>& dependencies,
+                  std::vector<uint8_t>& data);
+    // Release the data owned by the last replayed frame, and the texture data read back by the backend.
+    // Must be called once the frame has been submitted. When waiting for texture data, empty frames are
+    // flushed until the backend has read it all back.
+    void end_frame(bool wait = false);
+
+    inline uint32_t get_skipped_count() const { return skipped_count_; }
+
+private:
+    bool remap(const CapturedCommand& command, const CapturedCommand::HandleField& field, uint32_t& data);
+
+private:
+    std::map<uint32_t, uint32_t> handle_maps_[size_t(CapturedCommand::HandleType::Count)];
+    std::vector<std::unique_ptr<uint8_t[]>> owned_;
+    std::vector<std::future<PixelData>> pixel_data_;
+    uint32_t skipped_count_ = 0;
+};
+
+} // namespace erwin
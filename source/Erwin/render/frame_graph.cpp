@@ -0,0 +1,114 @@
+#include "render/frame_graph.h"
+
+#include <algorithm>
+#include <map>
+
+#include "render/framebuffer_pool.h"
+#include "render/renderer.h"
+
+namespace erwin
+{
+
+struct Pass
+{
+	hash_t name;
+	std::vector<hash_t> reads;
+	std::vector<hash_t> writes;
+	FrameGraph::PassFunc execute;
+	uint8_t layer_id;
+	bool alive;
+};
+
+struct Lifetime
+{
+	uint32_t first_pass;
+	uint32_t last_pass;
+};
+
+static struct
+{
+	std::vector<Pass> passes;
+	uint32_t executed_count = 0;
+	uint32_t culled_count = 0;
+} s_storage;
+
+void FrameGraph::add_pass(hash_t name, std::vector<hash_t> reads, std::vector<hash_t> writes, PassFunc execute)
+{
+	s_storage.passes.push_back({name, std::move(reads), std::move(writes), std::move(execute), Renderer::next_layer_id(name), false});
+}
+
+uint32_t FrameGraph::get_executed_pass_count()
+{
+	return s_storage.executed_count;
+}
+
+uint32_t FrameGraph::get_culled_pass_count()
+{
+	return s_storage.culled_count;
+}
+
+void FrameGraph::execute()
+{
+	W_PROFILE_FUNCTION()
+
+	auto& passes = s_storage.passes;
+
+	// Walk the passes backwards: a pass is needed if it has side effects outside of the transient framebuffers,
+	// or if it writes a transient framebuffer read by a pass that is needed
+	std::vector<hash_t> needed;
+	auto is_needed = [&needed](hash_t name) { return std::find(needed.begin(), needed.end(), name) != needed.end(); };
+	for(auto it = passes.rbegin(); it != passes.rend(); ++it)
+	{
+		auto& pass = *it;
+		pass.alive = std::any_of(pass.writes.begin(), pass.writes.end(),
+			[&is_needed](hash_t name) { return !FramebufferPool::is_transient(name) || is_needed(name); });
+		if(!pass.alive)
+			continue;
+		for(hash_t name: pass.reads)
+			if(FramebufferPool::is_transient(name) && !is_needed(name))
+				needed.push_back(name);
+	}
+
+	// Lifetime of each transient framebuffer, as a span of alive passes
+	std::map<hash_t, Lifetime> lifetimes;
+	for(uint32_t ii = 0; ii < passes.size(); ++ii)
+	{
+		if(!passes[ii].alive)
+			continue;
+		auto extend = [&lifetimes, ii](hash_t name)
+		{
+			if(!FramebufferPool::is_transient(name))
+				return;
+			auto [it, inserted] = lifetimes.insert(std::make_pair(name, Lifetime{ii, ii}));
+			it->second.last_pass = ii;
+		};
+		std::for_each(passes[ii].reads.begin(), passes[ii].reads.end(), extend);
+		std::for_each(passes[ii].writes.begin(), passes[ii].writes.end(), extend);
+	}
+
+	// Bind transient framebuffers in order of first use, so that storage released by earlier passes can be reused
+	std::vector<std::pair<hash_t, Lifetime>> order(lifetimes.begin(), lifetimes.end());
+	std::sort(order.begin(), order.end(),
+		[](const auto& a, const auto& b) { return a.second.first_pass < b.second.first_pass; });
+	FramebufferPool::begin_transients();
+	for(const auto& [name, lifetime]: order)
+		FramebufferPool::bind_transient(name, lifetime.first_pass, lifetime.last_pass);
+
+	s_storage.executed_count = 0;
+	s_storage.culled_count = 0;
+	for(auto& pass: passes)
+	{
+		if(pass.alive)
+		{
+			pass.execute(pass.layer_id);
+			++s_storage.executed_count;
+		}
+		else
+			++s_storage.culled_count;
+	}
+
+	FramebufferPool::end_transients();
+	passes.clear();
+}
+
+} // namespace erwin
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "core/core.h"
+
+namespace erwin
+{
+
+/*
+	Passes that render to or sample from framebuffers of the FramebufferPool can be declared to the frame graph
+	instead of submitting their draw calls directly. Each pass declares the framebuffers it reads and writes.
+	Once all layers are rendered, the graph is compiled:
+	- Passes that write to persistent framebuffers (or to the default render target) are kept, along with the
+	  passes that produce the transient framebuffers they read. All other passes are culled.
+	- Transient framebuffers are bound to storage for the span of passes that use them, storage is shared
+	  between transient framebuffers whose lifetimes do not overlap.
+	Then the remaining passes are executed in declaration order. A layer id is reserved for each pass when it
+	is declared, so its draw calls are sorted as if they had been submitted at that point.
+*/
+class FrameGraph
+{
+public:
+	using PassFunc = std::function<void(uint8_t layer_id)>;
+
+	// Declare a pass for the current frame, with the names of the framebuffers it reads and writes
+	static void add_pass(hash_t name, std::vector<hash_t> reads, std::vector<hash_t> writes, PassFunc execute);
+
+	// Amount of passes executed and culled during the last frame
+	static uint32_t get_executed_pass_count();
+	static uint32_t get_culled_pass_count();
+
+private:
+	friend class Application;
+
+	// Compile and execute the passes declared this frame
+	static void execute();
+};
+
+} // namespace erwin
@@ -1,24 +1,72 @@
 #include "render/framebuffer_pool.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "render/renderer.h"
 #include "core/intern_string.h"
 #include <kibble/logger/logger.h>
 #include "event/event_bus.h"
 #include "event/window_events.h"
+#include "utils/fnv1a.hpp"
 
 namespace erwin
 {
 
+// Transient framebuffer storage that has not been used for this amount of frames is released
+static constexpr uint32_t k_transient_max_idle_frames = 60;
+
+struct TransientFramebuffer
+{
+	FramebufferLayout layout;
+	uint64_t layout_hash;
+	FramebufferHandle bound; // Storage used this frame, null if unused
+};
+
+// Storage shared by transient framebuffers of the same dimensions and attachment formats
+struct TransientStorage
+{
+	FramebufferHandle handle;
+	uint32_t width;
+	uint32_t height;
+	uint8_t flags;
+	uint64_t layout_hash;
+	uint32_t busy_until; // Last pass of the current user in the frame graph
+	uint32_t idle_frames;
+	bool used;
+};
+
 struct FramebufferPoolStorage
 {
 	std::map<hash_t, FramebufferHandle> framebuffers_;
 	std::map<hash_t, WScope<FbConstraint>> constraints_;
 	std::map<hash_t, uint8_t> flags_;
+	std::map<hash_t, TransientFramebuffer> transients_;
+	std::vector<TransientStorage> transient_storage_;
+	bool executing_graph_ = false; // Transient framebuffers are only bound while the frame graph executes
 
 	uint32_t current_width_;
 	uint32_t current_height_;
 };
 static FramebufferPoolStorage s_storage;
 
+static uint64_t hash_layout(const FramebufferLayout& layout)
+{
+	// Hash the fields of each element that describe its texture storage. Attachment names are irrelevant,
+	// framebuffers with differently named attachments of the same formats can share storage.
+	uint64_t hash = k_fnv1a_seed;
+	auto combine = [&hash](uint64_t value) { hash = fnv1a_combine(hash, value); };
+	for(const auto& element: layout)
+	{
+		combine(uint64_t(element.image_format));
+		combine(element.filter);
+		combine(uint64_t(element.wrap));
+		combine(element.mips);
+		combine(element.lazy_mipmap);
+	}
+	return hash;
+}
+
 static bool on_framebuffer_resize_event(const FramebufferResizeEvent& event)
 {
 	s_storage.current_width_  = uint32_t(event.width);
@@ -29,13 +77,23 @@ static bool on_framebuffer_resize_event(const FramebufferResizeEvent& event)
 	{
 		// Fixed contraint ? Do nothing.
 		if(constraint->is_fixed()) continue;
+		// Transient framebuffers are not resized, their storage is recreated on demand
+		auto it = s_storage.framebuffers_.find(name);
+		if(it == s_storage.framebuffers_.end()) continue;
 
 		uint32_t width  = constraint->get_width(s_storage.current_width_);
-		uint32_t height = constraint->get_width(s_storage.current_height_);
+		uint32_t height = constraint->get_height(s_storage.current_height_);
 
-		Renderer::update_framebuffer(s_storage.framebuffers_[name], width, height);
+		Renderer::update_framebuffer(it->second, width, height);
 	}
 
+	// Transient storage of the old dimensions will not be used anymore
+	for(auto&& storage: s_storage.transient_storage_)
+		Renderer::destroy(storage.handle);
+	s_storage.transient_storage_.clear();
+	for(auto&& [name, transient]: s_storage.transients_)
+		transient.bound = {};
+
 	return false;
 }
 
@@ -52,12 +110,24 @@ void FramebufferPool::shutdown()
 {
 	for(auto&& [name, fb]: s_storage.framebuffers_)
 		Renderer::destroy(fb);
+	for(auto&& storage: s_storage.transient_storage_)
+		Renderer::destroy(storage.handle);
+	s_storage.transient_storage_.clear();
+	s_storage.transients_.clear();
 
 	KLOGN("render") << "Framebuffer pool released." << std::endl;
 }
 
 FramebufferHandle FramebufferPool::get_framebuffer(hash_t name)
 {
+	auto tit = s_storage.transients_.find(name);
+	if(tit != s_storage.transients_.end())
+	{
+		// Storage of a transient framebuffer changes from a frame to another, and is shared with other framebuffers
+		K_ASSERT(s_storage.executing_graph_, "[FramebufferPool] Transient framebuffers can only be used by frame graph passes.");
+		return tit->second.bound;
+	}
+
 	// Check that a framebuffer is registered to this name
 	auto it = s_storage.framebuffers_.find(name);
 	K_ASSERT(it != s_storage.framebuffers_.end(), "[FramebufferPool] Invalid framebuffer name.");
@@ -136,7 +206,7 @@ FramebufferHandle FramebufferPool::create_framebuffer(hash_t name, WScope<FbCons
 	}
 
 	uint32_t width  = constraint->get_width(s_storage.current_width_);
-	uint32_t height = constraint->get_width(s_storage.current_height_);
+	uint32_t height = constraint->get_height(s_storage.current_height_);
 
 	FramebufferHandle handle = Renderer::create_framebuffer(width, height, flags, layout);
 	s_storage.framebuffers_.insert(std::make_pair(name, handle));
@@ -148,4 +218,82 @@ FramebufferHandle FramebufferPool::create_framebuffer(hash_t name, WScope<FbCons
 	return handle;
 }
 
+void FramebufferPool::create_transient_framebuffer(hash_t name, WScope<FbConstraint> constraint, uint8_t flags, const FramebufferLayout& layout)
+{
+	// Check that no framebuffer is already registered to this name
+	if(s_storage.constraints_.find(name) != s_storage.constraints_.end())
+	{
+		KLOGW("render") << "Framebuffer " << istr::resolve(name) << " already exists, ignoring." << std::endl;
+		return;
+	}
+
+	s_storage.transients_.insert(std::make_pair(name, TransientFramebuffer{layout, hash_layout(layout), {}}));
+	s_storage.constraints_.insert(std::make_pair(name, std::move(constraint)));
+	s_storage.flags_.insert(std::make_pair(name, flags));
+
+	KLOG("render",1) << "Declared transient framebuffer: " << kb::KS_NAME_ << istr::resolve(name) << std::endl;
+}
+
+bool FramebufferPool::is_transient(hash_t name)
+{
+	return s_storage.transients_.find(name) != s_storage.transients_.end();
+}
+
+void FramebufferPool::begin_transients()
+{
+	s_storage.executing_graph_ = true;
+	for(auto&& [name, transient]: s_storage.transients_)
+		transient.bound = {};
+	for(auto&& storage: s_storage.transient_storage_)
+	{
+		storage.used = false;
+		storage.busy_until = 0;
+	}
+}
+
+FramebufferHandle FramebufferPool::bind_transient(hash_t name, uint32_t first_pass, uint32_t last_pass)
+{
+	auto it = s_storage.transients_.find(name);
+	K_ASSERT(it != s_storage.transients_.end(), "[FramebufferPool] Invalid transient framebuffer name.");
+	auto& transient = it->second;
+	uint32_t width  = get_width(name);
+	uint32_t height = get_height(name);
+	uint8_t flags   = s_storage.flags_[name];
+
+	// Alias storage of the same description that is no longer used by the passes before this one
+	for(auto&& storage: s_storage.transient_storage_)
+	{
+		if(storage.width != width || storage.height != height || storage.flags != flags || storage.layout_hash != transient.layout_hash)
+			continue;
+		if(storage.used && storage.busy_until >= first_pass)
+			continue;
+
+		storage.used = true;
+		storage.busy_until = last_pass;
+		transient.bound = storage.handle;
+		return transient.bound;
+	}
+
+	FramebufferHandle handle = Renderer::create_framebuffer(width, height, flags, transient.layout);
+	s_storage.transient_storage_.push_back({handle, width, height, flags, transient.layout_hash, last_pass, 0, true});
+	transient.bound = handle;
+
+	KLOG("render",1) << "Allocated transient framebuffer storage: " << kb::KS_NAME_ << istr::resolve(name) << ' ' << kb::KC_ << handle << std::endl;
+
+	return handle;
+}
+
+void FramebufferPool::end_transients()
+{
+	s_storage.executing_graph_ = false;
+	for(auto&& storage: s_storage.transient_storage_)
+	{
+		storage.idle_frames = storage.used ? 0 : storage.idle_frames + 1;
+		if(storage.idle_frames > k_transient_max_idle_frames)
+			Renderer::destroy(storage.handle);
+	}
+	s_storage.transient_storage_.erase(std::remove_if(s_storage.transient_storage_.begin(), s_storage.transient_storage_.end(),
+		[](const TransientStorage& storage) { return storage.idle_frames > k_transient_max_idle_frames; }), s_storage.transient_storage_.end());
+}
+
 } // namespace erwin
\ No newline at end of file
@@ -101,9 +101,24 @@ public:
 	// Create a framebuffer inside the pool, specifying a name, size constraints relative to the viewport,
 	// a layout for color buffers, and optional depth / depth-stencil textures
 	static FramebufferHandle create_framebuffer(hash_t name, WScope<FbConstraint> constraint, uint8_t flags, const FramebufferLayout& layout);
+	// Declare a transient framebuffer. No storage is allocated until a frame graph pass uses it, and its storage
+	// may be shared with other transient framebuffers of the same size and attachment formats whose lifetimes do
+	// not overlap. Its content does not survive the frame. get_framebuffer() may only be called on it by frame graph
+	// passes, and returns a null handle when no pass uses it this frame.
+	static void create_transient_framebuffer(hash_t name, WScope<FbConstraint> constraint, uint8_t flags, const FramebufferLayout& layout);
+	// Check if a framebuffer was declared transient
+	static bool is_transient(hash_t name);
 
 private:
 	friend class Application;
+	friend class FrameGraph;
+
+	// Unbind all transient framebuffers, before a new frame graph is compiled
+	static void begin_transients();
+	// Bind storage to a transient framebuffer, used from pass first_pass to pass last_pass (included) of the frame graph
+	static FramebufferHandle bind_transient(hash_t name, uint32_t first_pass, uint32_t last_pass);
+	// Release the storage that has not been used for a while
+	static void end_transients();
 
 	// Initialize pool with default framebuffer dimensions
 	static void init(uint32_t initial_width, uint32_t initial_height, EventBus& event_bus /*TMP*/);
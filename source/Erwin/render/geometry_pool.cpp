@@ -0,0 +1,142 @@
+#include "render/geometry_pool.h"
+#include "core/core.h"
+#include "memory/range_allocator.h"
+#include "render/renderer.h"
+#include "render/renderer_config.h"
+#include <kibble/logger/logger.h>
+
+#include <algorithm>
+#include <map>
+
+namespace erwin
+{
+
+struct GeometryBlock
+{
+    VertexBufferHandle VBO;
+    IndexBufferHandle IBO;
+    VertexArrayHandle VAO;
+    RangeAllocator vertices;
+    RangeAllocator indices;
+};
+
+struct GeometryPoolStorage
+{
+    // [(layout index, primitive), blocks]
+    std::map<std::pair<uint16_t, DrawPrimitive>, std::vector<GeometryBlock>> pools;
+};
+static GeometryPoolStorage s_storage;
+
+static GeometryBlock& create_block(VertexBufferLayoutHandle layout, DrawPrimitive primitive, uint32_t vertex_capacity,
+                                   uint32_t index_capacity, uint32_t vertex_size)
+{
+    VertexBufferHandle VBO = Renderer::create_vertex_buffer(layout, nullptr, vertex_capacity * vertex_size,
+                                                            UsagePattern::Dynamic);
+    IndexBufferHandle IBO = Renderer::create_index_buffer(nullptr, index_capacity, primitive, UsagePattern::Dynamic);
+    VertexArrayHandle VAO = Renderer::create_vertex_array(VBO, IBO);
+
+    KLOG("render", 1) << "Geometry pool: new block for layout #" << layout.index() << " (" << vertex_capacity
+                      << " vertices, " << index_capacity << " indices)" << std::endl;
+
+    auto& blocks = s_storage.pools[{layout.index(), primitive}];
+    // Frames in flight may still draw from released ranges, they are retired like handle indices
+    blocks.push_back({VBO, IBO, VAO, RangeAllocator(vertex_capacity, k_handle_reuse_latency),
+                      RangeAllocator(index_capacity, k_handle_reuse_latency)});
+    return blocks.back();
+}
+
+Mesh GeometryPool::allocate(VertexBufferLayoutHandle layout, const std::vector<float>& vertex_data,
+                            const std::vector<uint32_t>& index_data, DrawPrimitive primitive)
+{
+    W_PROFILE_FUNCTION()
+
+    K_ASSERT(layout.is_valid(), "Invalid VertexBufferLayoutHandle!");
+    uint32_t vertex_size = Renderer::get_vertex_buffer_layout(layout).get_stride() / sizeof(float);
+    uint32_t vertex_count = uint32_t(vertex_data.size()) / vertex_size;
+    uint32_t index_count = uint32_t(index_data.size());
+    K_ASSERT(vertex_count > 0 && index_count > 0, "Cannot pool empty geometry.");
+
+    // Find a block with enough room for both ranges
+    GeometryBlock* block = nullptr;
+    uint32_t vertex_offset = 0;
+    uint32_t first_index = 0;
+    for(auto& candidate : s_storage.pools[{layout.index(), primitive}])
+    {
+        if(!candidate.vertices.allocate(vertex_count, vertex_offset))
+            continue;
+        if(!candidate.indices.allocate(index_count, first_index))
+        {
+            candidate.vertices.cancel(vertex_offset, vertex_count);
+            continue;
+        }
+        block = &candidate;
+        break;
+    }
+
+    if(block == nullptr)
+    {
+        block = &create_block(layout, primitive, std::max(vertex_count, k_geometry_pool_block_vertices),
+                              std::max(index_count, k_geometry_pool_block_indices), vertex_size);
+        block->vertices.allocate(vertex_count, vertex_offset);
+        block->indices.allocate(index_count, first_index);
+    }
+
+    // Rebase indices on the vertex range of the mesh
+    std::vector<uint32_t> rebased(index_data);
+    if(vertex_offset != 0)
+        for(auto& index : rebased)
+            index += vertex_offset;
+
+    Renderer::update_vertex_buffer(block->VBO, vertex_data.data(), uint32_t(vertex_data.size() * sizeof(float)),
+                                   vertex_offset * vertex_size * uint32_t(sizeof(float)));
+    Renderer::update_index_buffer(block->IBO, rebased.data(), index_count, first_index);
+
+    Mesh mesh;
+    mesh.VAO = block->VAO;
+    mesh.layout = layout;
+    mesh.index_count = index_count;
+    mesh.first_index = first_index;
+    mesh.vertex_offset = vertex_offset;
+    mesh.vertex_count = vertex_count;
+    mesh.index_range = index_count;
+    return mesh;
+}
+
+void GeometryPool::release(const Mesh& mesh)
+{
+    for(auto&& [key, blocks] : s_storage.pools)
+    {
+        auto it = std::find_if(blocks.begin(), blocks.end(),
+                               [&mesh](const GeometryBlock& block) { return block.VAO == mesh.VAO; });
+        if(it != blocks.end())
+        {
+            it->vertices.release(mesh.vertex_offset, mesh.vertex_count);
+            it->indices.release(mesh.first_index, mesh.index_range);
+            return;
+        }
+    }
+    KLOGW("render") << "Geometry pool: released mesh does not belong to any block." << std::endl;
+}
+
+void GeometryPool::next_frame()
+{
+    for(auto&& [key, blocks] : s_storage.pools)
+    {
+        for(auto& block : blocks)
+        {
+            block.vertices.next_frame();
+            block.indices.next_frame();
+        }
+    }
+}
+
+void GeometryPool::shutdown()
+{
+    // Destroying a vertex array also destroys its buffers
+    for(auto&& [key, blocks] : s_storage.pools)
+        for(const auto& block : blocks)
+            Renderer::destroy(block.VAO);
+    s_storage.pools.clear();
+}
+
+} // namespace erwin
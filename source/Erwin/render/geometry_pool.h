@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "render/handles.h"
+#include "render/buffer_layout.h"
+#include "asset/mesh.h"
+
+namespace erwin
+{
+
+/*
+	Shared geometry buffers. Meshes of the same vertex layout and primitive are sub-allocated
+	from a few large blocks (VBO + IBO + VAO), instead of owning a vertex array each. This way
+	consecutive draws of different meshes need no vertex array switch, and can be merged into
+	a single multi-draw.
+	Vertex and index ranges are managed by first-fit free lists, coalesced on release. Released ranges
+	are only reused after k_handle_reuse_latency frames, when no frame in flight can draw from them.
+*/
+class GeometryPool
+{
+public:
+	// Allocate vertex and index ranges for a mesh and upload its data. Indices are relative to the
+	// first vertex of the mesh and are rebased on upload, so draws never need a base vertex.
+	// Extent and resource id of the returned mesh are left for the caller to fill.
+	static Mesh allocate(VertexBufferLayoutHandle layout, const std::vector<float>& vertex_data,
+	                     const std::vector<uint32_t>& index_data, DrawPrimitive primitive = DrawPrimitive::Triangles);
+	// Give the ranges of a pooled mesh back
+	static void release(const Mesh& mesh);
+	// Retired ranges whose latency has elapsed can be allocated again, called once per frame by the renderer
+	static void next_frame();
+
+private:
+	friend class Application;
+
+	static void shutdown();
+};
+
+} // namespace erwin
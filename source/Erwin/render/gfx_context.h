@@ -10,6 +10,8 @@ public:
 	virtual void init() = 0;
 	virtual void swap_buffers() const = 0;
 	virtual void make_current() const = 0;
+	// Detach this context from the calling thread, so it can be made current on another thread
+	virtual void release_current() const = 0;
 };
 
 } // namespace erwin
\ No newline at end of file
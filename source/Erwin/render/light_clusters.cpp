@@ -0,0 +1,264 @@
+#include "render/light_clusters.h"
+#include "core/core.h"
+#include "render/render_workers.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace erwin
+{
+
+static constexpr uint32_t k_no_slice = 0xffff0000; // First slice after the last one
+
+void LightClusters::init(uint32_t tiles_x, uint32_t tiles_y, uint32_t slices, uint32_t max_lights,
+                         uint32_t max_indices)
+{
+    K_ASSERT(slices < 0xffff, "Too many depth slices.");
+    tiles_x_ = tiles_x;
+    tiles_y_ = tiles_y;
+    slices_ = slices;
+    max_lights_ = max_lights;
+    max_indices_ = max_indices;
+    near_ = 0.f;
+    far_ = 0.f;
+
+    lights_.reserve(max_lights);
+    spheres_.reserve(max_lights);
+    slice_ranges_.reserve(max_lights);
+    bounds_.resize(tiles_x * tiles_y * slices);
+    grid_.assign(tiles_x * tiles_y * slices, {0, 0});
+    indices_.resize(max_indices);
+    hits_.resize(slices);
+    for(auto& hits : hits_)
+        hits.counts.resize(tiles_x * tiles_y);
+}
+
+void LightClusters::clear() { lights_.clear(); }
+
+bool LightClusters::add_point_light(const glm::vec3& position, float radius, const glm::vec3& color)
+{
+    if(lights_.size() >= max_lights_)
+        return false;
+
+    lights_.push_back({glm::vec4(position, radius), glm::vec4(color, 0.f), glm::vec4(0.f), glm::vec4(0.f)});
+    return true;
+}
+
+bool LightClusters::add_spot_light(const glm::vec3& position, const glm::vec3& direction, float radius,
+                                   float inner_angle, float outer_angle, const glm::vec3& color)
+{
+    if(lights_.size() >= max_lights_)
+        return false;
+
+    // Cone angles are capped below 90 degrees, so that the cone has a finite bounding sphere.
+    // The inner cone is kept strictly inside the outer one, the shader interpolates between them.
+    float cos_outer = std::cos(std::min(outer_angle, glm::radians(89.f)));
+    float cos_inner = std::max(std::cos(inner_angle), cos_outer + 1e-4f);
+    lights_.push_back({glm::vec4(position, radius), glm::vec4(color, 0.f), glm::vec4(glm::normalize(direction), 1.f),
+                       glm::vec4(cos_inner, cos_outer, 0.f, 0.f)});
+    return true;
+}
+
+glm::vec4 LightClusters::spot_bounding_sphere(const glm::vec3& position, const glm::vec3& direction, float radius,
+                                              float cos_outer)
+{
+    // Narrow cones are enclosed by the sphere passing through the apex and the rim of the cap,
+    // wide ones by the sphere centered on the rim disk
+    if(cos_outer > 0.70710678f)
+    {
+        float sphere_radius = radius / (2.f * cos_outer);
+        return glm::vec4(position + direction * sphere_radius, sphere_radius);
+    }
+    float sin_outer = std::sqrt(1.f - cos_outer * cos_outer);
+    return glm::vec4(position + direction * (radius * cos_outer), radius * sin_outer);
+}
+
+uint32_t LightClusters::get_slice(float depth) const
+{
+    if(depth <= near_)
+        return 0;
+    return std::min(uint32_t(std::log(depth / near_) * slice_scale_), slices_ - 1);
+}
+
+void LightClusters::update_bounds(const glm::vec4& proj_params, float near, float far)
+{
+    near_ = near;
+    far_ = far;
+    proj_params_ = proj_params;
+    slice_scale_ = float(slices_) / std::log(far / near);
+
+    // Tile corners at the near and far depths of a slice, the AABB encloses the four rays through them
+    for(uint32_t zz = 0; zz < slices_; ++zz)
+    {
+        float depth_near = near * std::pow(far / near, float(zz) / float(slices_));
+        float depth_far = near * std::pow(far / near, float(zz + 1) / float(slices_));
+        for(uint32_t yy = 0; yy < tiles_y_; ++yy)
+        {
+            float y0 = (-1.f + 2.f * float(yy) / float(tiles_y_)) * proj_params.y;
+            float y1 = (-1.f + 2.f * float(yy + 1) / float(tiles_y_)) * proj_params.y;
+            for(uint32_t xx = 0; xx < tiles_x_; ++xx)
+            {
+                float x0 = (-1.f + 2.f * float(xx) / float(tiles_x_)) * proj_params.x;
+                float x1 = (-1.f + 2.f * float(xx + 1) / float(tiles_x_)) * proj_params.x;
+                auto& bounds = bounds_[get_cluster(xx, yy, zz)];
+                bounds.min = {std::min(x0 * depth_near, x0 * depth_far), std::min(y0 * depth_near, y0 * depth_far),
+                              -depth_far};
+                bounds.max = {std::max(x1 * depth_near, x1 * depth_far), std::max(y1 * depth_near, y1 * depth_far),
+                              -depth_near};
+            }
+        }
+    }
+}
+
+// Screen tile range covered by a view-space interval [lo,hi] seen at depths in [depth_a,depth_b],
+// along an axis of the tile grid. Returns false if the interval is offscreen.
+static inline bool tile_range(float lo, float hi, float depth_a, float depth_b, float ray_scale, uint32_t tiles,
+                              uint32_t& first, uint32_t& last)
+{
+    float ndc_lo = std::min(lo / (ray_scale * depth_a), lo / (ray_scale * depth_b));
+    float ndc_hi = std::max(hi / (ray_scale * depth_a), hi / (ray_scale * depth_b));
+    if(ndc_hi < -1.f || ndc_lo > 1.f)
+        return false;
+
+    float scale = 0.5f * float(tiles);
+    first = uint32_t(std::clamp((ndc_lo + 1.f) * scale, 0.f, float(tiles - 1)));
+    last = uint32_t(std::clamp((ndc_hi + 1.f) * scale, 0.f, float(tiles - 1)));
+    return true;
+}
+
+void LightClusters::assign_slice(uint32_t slice)
+{
+    auto& hits = hits_[slice];
+    hits.tiles.clear();
+    hits.lights.clear();
+    std::fill(hits.counts.begin(), hits.counts.end(), 0);
+
+    const auto& slice_bounds = bounds_[get_cluster(0, 0, slice)];
+    float depth_near = -slice_bounds.max.z;
+    float depth_far = -slice_bounds.min.z;
+
+    for(uint32_t ii = 0; ii < uint32_t(lights_.size()); ++ii)
+    {
+        uint32_t first_slice = slice_ranges_[ii] >> 16;
+        uint32_t last_slice = slice_ranges_[ii] & 0xffff;
+        if(slice < first_slice || slice > last_slice)
+            continue;
+
+        // Screen footprint of the part of the sphere inside this slice
+        const glm::vec4& sphere = spheres_[ii];
+        float depth_a = std::max(depth_near, -sphere.z - sphere.w);
+        float depth_b = std::min(depth_far, -sphere.z + sphere.w);
+        uint32_t x0, x1, y0, y1;
+        if(!tile_range(sphere.x - sphere.w, sphere.x + sphere.w, depth_a, depth_b, proj_params_.x, tiles_x_, x0, x1) ||
+           !tile_range(sphere.y - sphere.w, sphere.y + sphere.w, depth_a, depth_b, proj_params_.y, tiles_y_, y0, y1))
+            continue;
+
+        // Sphere-AABB test against each candidate cluster
+        glm::vec3 center(sphere);
+        float radius2 = sphere.w * sphere.w;
+        for(uint32_t yy = y0; yy <= y1; ++yy)
+        {
+            for(uint32_t xx = x0; xx <= x1; ++xx)
+            {
+                const auto& bounds = bounds_[get_cluster(xx, yy, slice)];
+                glm::vec3 delta = glm::clamp(center, bounds.min, bounds.max) - center;
+                if(glm::dot(delta, delta) > radius2)
+                    continue;
+
+                uint32_t tile = xx + tiles_x_ * yy;
+                hits.tiles.push_back(tile);
+                hits.lights.push_back(ii);
+                ++hits.counts[tile];
+            }
+        }
+    }
+}
+
+void LightClusters::write_slice(uint32_t slice, uint32_t base)
+{
+    // Counting sort of the light-cluster pairs by tile, lights stay in ascending order within a cluster
+    auto& hits = hits_[slice];
+    uint32_t first_cluster = get_cluster(0, 0, slice);
+    uint32_t offset = base;
+    for(uint32_t tile = 0; tile < uint32_t(hits.counts.size()); ++tile)
+    {
+        uint32_t count = hits.counts[tile];
+        uint32_t begin = std::min(offset, max_indices_);
+        uint32_t end = std::min(offset + count, max_indices_);
+        grid_[first_cluster + tile] = {begin, end - begin};
+        hits.counts[tile] = offset; // Now the write cursor of the tile
+        offset += count;
+    }
+
+    for(size_t kk = 0; kk < hits.tiles.size(); ++kk)
+    {
+        uint32_t index = hits.counts[hits.tiles[kk]]++;
+        if(index < max_indices_)
+            indices_[index] = hits.lights[kk];
+    }
+}
+
+void LightClusters::build(const glm::mat4& view_matrix, const glm::vec4& proj_params, float near, float far,
+                          RenderWorkers* workers)
+{
+    W_PROFILE_FUNCTION()
+
+    if(near != near_ || far != far_ || proj_params != proj_params_)
+        update_bounds(proj_params, near, far);
+
+    index_count_ = 0;
+    saturated_ = false;
+    if(lights_.empty())
+    {
+        std::fill(grid_.begin(), grid_.end(), ClusterRange{0, 0});
+        return;
+    }
+
+    // Transform lights to view space and find the depth slices their bounding sphere overlaps
+    spheres_.resize(lights_.size());
+    slice_ranges_.resize(lights_.size());
+    for(size_t ii = 0; ii < lights_.size(); ++ii)
+    {
+        auto& light = lights_[ii];
+        float radius = light.position_radius.w;
+        glm::vec3 position(view_matrix * glm::vec4(glm::vec3(light.position_radius), 1.f));
+        glm::vec3 direction(view_matrix * glm::vec4(glm::vec3(light.direction_type), 0.f));
+        light.position_radius = glm::vec4(position, radius);
+        light.direction_type = glm::vec4(direction, light.direction_type.w);
+
+        spheres_[ii] = (light.direction_type.w > 0.f)
+                           ? spot_bounding_sphere(position, direction, radius, light.spot_angles.y)
+                           : glm::vec4(position, radius);
+        float depth_min = -spheres_[ii].z - spheres_[ii].w;
+        float depth_max = -spheres_[ii].z + spheres_[ii].w;
+        if(depth_max < near || depth_min > far)
+            slice_ranges_[ii] = k_no_slice;
+        else
+            slice_ranges_[ii] = (get_slice(std::max(depth_min, near)) << 16) | get_slice(std::min(depth_max, far));
+    }
+
+    // Slices are assigned independently, then written at consecutive offsets of the index list
+    if(workers)
+        workers->parallel_for(slices_, [this](uint32_t slice) { assign_slice(slice); });
+    else
+        for(uint32_t slice = 0; slice < slices_; ++slice)
+            assign_slice(slice);
+
+    std::vector<uint32_t> bases(slices_);
+    uint32_t total = 0;
+    for(uint32_t slice = 0; slice < slices_; ++slice)
+    {
+        bases[slice] = total;
+        total += uint32_t(hits_[slice].lights.size());
+    }
+    index_count_ = std::min(total, max_indices_);
+    saturated_ = (total > max_indices_);
+
+    if(workers)
+        workers->parallel_for(slices_, [this, &bases](uint32_t slice) { write_slice(slice, bases[slice]); });
+    else
+        for(uint32_t slice = 0; slice < slices_; ++slice)
+            write_slice(slice, bases[slice]);
+}
+
+} // namespace erwin
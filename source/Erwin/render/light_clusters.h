@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace erwin
+{
+
+class RenderWorkers;
+
+// A punctual light as read by the deferred lighting shader, packed like the PunctualLight struct
+// of engine/punctual_lights.glsl
+struct PunctualLight
+{
+	glm::vec4 position_radius; // xyz: view-space position, w: radius of influence
+	glm::vec4 color;           // rgb: color scaled by brightness, a: padding
+	glm::vec4 direction_type;  // xyz: view-space spot direction, w: light type (0: point, 1: spot)
+	glm::vec4 spot_angles;     // x: cosine of the inner cone angle, y: cosine of the outer cone angle, zw: padding
+};
+
+// Slice of the light index list assigned to a cluster
+struct ClusterRange
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+/*
+	Clustered light assignment. The view frustum is divided in froxels: a grid of screen tiles, each
+	split in depth slices of exponentially increasing thickness. Each light is bounded by a view-space
+	sphere, which is tested against the AABB of every cluster it may overlap. The result is a compact
+	list of light indices, and for each cluster the range of this list it should walk.
+	Depth slices are independent, they are processed in parallel when worker threads are available.
+	Clusters are indexed by x + tiles_x * (y + tiles_y * slice), tile (0,0) being the bottom-left one.
+*/
+class LightClusters
+{
+public:
+	// The light index list holds at most max_indices entries, lights past this are dropped from the
+	// clusters that overflow it
+	void init(uint32_t tiles_x, uint32_t tiles_y, uint32_t slices, uint32_t max_lights, uint32_t max_indices);
+	// Remove all lights
+	void clear();
+	// Queue a point light, world space. Returns false if the maximum light count was reached.
+	bool add_point_light(const glm::vec3& position, float radius, const glm::vec3& color);
+	// Queue a spot light, world space. Angles are the half-angles of the cones, in radians.
+	bool add_spot_light(const glm::vec3& position, const glm::vec3& direction, float radius, float inner_angle,
+	                    float outer_angle, const glm::vec3& color);
+	// Assign queued lights to clusters. proj_params are the camera projection parameters, their xy
+	// components scale NDC coordinates to a view-space ray at unit depth. Lights are transformed to
+	// view space in place, so they must be cleared before the lights of another view are queued.
+	void build(const glm::mat4& view_matrix, const glm::vec4& proj_params, float near, float far,
+	           RenderWorkers* workers = nullptr);
+
+	// Depth slice a view-space depth (positive distance along the view axis) falls in
+	uint32_t get_slice(float depth) const;
+
+	inline uint32_t get_light_count() const { return uint32_t(lights_.size()); }
+	inline const PunctualLight* get_lights() const { return lights_.data(); }
+	inline uint32_t get_cluster_count() const { return uint32_t(grid_.size()); }
+	inline const ClusterRange* get_grid() const { return grid_.data(); }
+	inline uint32_t get_index_count() const { return index_count_; }
+	inline const uint32_t* get_indices() const { return indices_.data(); }
+	inline uint32_t get_cluster(uint32_t x, uint32_t y, uint32_t slice) const { return x + tiles_x_ * (y + tiles_y_ * slice); }
+	// True if the last build dropped lights because the index list was full
+	inline bool is_saturated() const { return saturated_; }
+
+	// Bounding sphere of a spot light cone of outer half-angle below 90 degrees, xyz: center, w: radius
+	static glm::vec4 spot_bounding_sphere(const glm::vec3& position, const glm::vec3& direction, float radius,
+	                                      float cos_outer);
+
+private:
+	struct Bounds
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	// Light-cluster pairs of a depth slice
+	struct SliceHits
+	{
+		std::vector<uint32_t> tiles;
+		std::vector<uint32_t> lights;
+		std::vector<uint32_t> counts;
+	};
+
+	void update_bounds(const glm::vec4& proj_params, float near, float far);
+	void assign_slice(uint32_t slice);
+	void write_slice(uint32_t slice, uint32_t base);
+
+private:
+	uint32_t tiles_x_ = 0;
+	uint32_t tiles_y_ = 0;
+	uint32_t slices_ = 0;
+	uint32_t max_lights_ = 0;
+	uint32_t max_indices_ = 0;
+	uint32_t index_count_ = 0;
+	bool saturated_ = false;
+
+	float near_ = 0.f;
+	float far_ = 0.f;
+	float slice_scale_ = 0.f;
+	glm::vec4 proj_params_ = glm::vec4(0.f);
+
+	std::vector<PunctualLight> lights_;  // World space until built
+	std::vector<glm::vec4> spheres_;     // View-space bounding spheres
+	std::vector<uint32_t> slice_ranges_; // First and last slice of each light, packed as two 16-bit halves
+	std::vector<Bounds> bounds_;         // View-space AABB of each cluster
+	std::vector<SliceHits> hits_;
+	std::vector<ClusterRange> grid_;
+	std::vector<uint32_t> indices_;
+};
+
+} // namespace erwin
@@ -0,0 +1,276 @@
+#include "render/occlusion.h"
+#include "core/core.h"
+#include "math/simd.h"
+#include "render/render_workers.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace erwin
+{
+
+// Depth margin below which an instance is considered to lie on an occluder surface, so that an occluder
+// never hides itself
+static constexpr float k_depth_bias = 1e-6f;
+
+// Triangles of a box, vertices as given by bound::to_model_space_vertices()
+static constexpr uint32_t k_box_indices[36] = {0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 5, 1, 0, 4, 5,
+                                               3, 2, 6, 3, 6, 7, 1, 6, 2, 1, 5, 6, 0, 3, 7, 0, 7, 4};
+
+void OcclusionBuffer::init(uint32_t width, uint32_t height, uint32_t tile_size)
+{
+    K_ASSERT(width % 4 == 0, "Occlusion buffer width must be a multiple of 4.");
+    K_ASSERT(width % tile_size == 0 && height % tile_size == 0,
+             "Occlusion buffer dimensions must be multiples of the tile size.");
+
+    width_ = width;
+    height_ = height;
+    tile_size_ = tile_size;
+    tiles_x_ = width / tile_size;
+    tiles_y_ = height / tile_size;
+    depth_.assign(width_ * height_, 1.f);
+    tile_max_.assign(tiles_x_ * tiles_y_, 1.f);
+}
+
+void OcclusionBuffer::set_view_projection(const glm::mat4& view_projection)
+{
+    view_projection_ = view_projection;
+    clear();
+}
+
+void OcclusionBuffer::clear() { triangles_.clear(); }
+
+void OcclusionBuffer::add_occluder(const Extent& extent, const glm::mat4& model_matrix)
+{
+    std::array<glm::vec3, 8> vertices;
+    bound::to_model_space_vertices(extent, vertices);
+    add_occluder(vertices.data(), k_box_indices, 36, model_matrix);
+}
+
+void OcclusionBuffer::add_occluder(const glm::vec3* vertices, const uint32_t* indices, uint32_t index_count,
+                                   const glm::mat4& model_matrix)
+{
+    glm::mat4 mvp = view_projection_ * model_matrix;
+    for(uint32_t ii = 0; ii + 2 < index_count; ii += 3)
+        add_clip_triangle(mvp * glm::vec4(vertices[indices[ii]], 1.f), mvp * glm::vec4(vertices[indices[ii + 1]], 1.f),
+                          mvp * glm::vec4(vertices[indices[ii + 2]], 1.f));
+}
+
+void OcclusionBuffer::add_clip_triangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    // Clip against the near plane (z >= -w), a triangle becomes at most a quad
+    const glm::vec4 in[3] = {v0, v1, v2};
+    glm::vec4 out[4];
+    uint32_t count = 0;
+    for(uint32_t ii = 0; ii < 3; ++ii)
+    {
+        const glm::vec4& a = in[ii];
+        const glm::vec4& b = in[(ii + 1) % 3];
+        float da = a.z + a.w;
+        float db = b.z + b.w;
+        if(da >= 0.f)
+            out[count++] = a;
+        if((da >= 0.f) != (db >= 0.f))
+            out[count++] = a + (b - a) * (da / (da - db));
+    }
+
+    if(count < 3)
+        return;
+    add_screen_triangle(out[0], out[1], out[2]);
+    if(count == 4)
+        add_screen_triangle(out[0], out[2], out[3]);
+}
+
+void OcclusionBuffer::add_screen_triangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    Triangle triangle;
+    const glm::vec4* clip[3] = {&v0, &v1, &v2};
+    for(uint32_t ii = 0; ii < 3; ++ii)
+    {
+        glm::vec3 ndc = glm::vec3(*clip[ii]) / clip[ii]->w;
+        triangle.vertices[ii] = {(ndc.x * 0.5f + 0.5f) * float(width_), (ndc.y * 0.5f + 0.5f) * float(height_),
+                                 ndc.z * 0.5f + 0.5f};
+    }
+
+    // Counter-clockwise winding, so that all edge functions are positive inside
+    const auto& a = triangle.vertices[0];
+    const auto& b = triangle.vertices[1];
+    const auto& c = triangle.vertices[2];
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if(std::abs(area) < 1e-6f)
+        return;
+    if(area < 0.f)
+        std::swap(triangle.vertices[1], triangle.vertices[2]);
+
+    triangle.xmin = std::min({a.x, b.x, c.x});
+    triangle.xmax = std::max({a.x, b.x, c.x});
+    triangle.ymin = std::min({a.y, b.y, c.y});
+    triangle.ymax = std::max({a.y, b.y, c.y});
+    if(triangle.xmax < 0.f || triangle.ymax < 0.f || triangle.xmin >= float(width_) ||
+       triangle.ymin >= float(height_))
+        return;
+
+    triangles_.push_back(triangle);
+}
+
+void OcclusionBuffer::rasterize(RenderWorkers* workers)
+{
+    W_PROFILE_FUNCTION()
+
+    if(workers)
+        workers->parallel_for(tiles_y_, [this](uint32_t band) { rasterize_band(band); });
+    else
+        for(uint32_t band = 0; band < tiles_y_; ++band)
+            rasterize_band(band);
+}
+
+void OcclusionBuffer::rasterize_band(uint32_t band)
+{
+    int32_t band_y0 = int32_t(band * tile_size_);
+    int32_t band_y1 = band_y0 + int32_t(tile_size_);
+    std::fill(depth_.begin() + band_y0 * int32_t(width_), depth_.begin() + band_y1 * int32_t(width_), 1.f);
+
+    for(const auto& triangle : triangles_)
+    {
+        // Pixels are sampled at their center
+        int32_t y0 = std::max(band_y0, int32_t(std::floor(triangle.ymin)));
+        int32_t y1 = std::min(band_y1, int32_t(std::ceil(triangle.ymax)));
+        int32_t x0 = std::max(0, int32_t(std::floor(triangle.xmin))) & ~3;
+        int32_t x1 = std::min(int32_t(width_), int32_t(std::ceil(triangle.xmax)));
+        if(y0 >= y1 || x0 >= x1)
+            continue;
+
+        // Edge functions, edge ii is opposite to vertex ii so that they are barycentric weights once normalized
+        const auto& v = triangle.vertices;
+        float edge_dx[3], edge_dy[3], edge_c[3];
+        for(uint32_t ii = 0; ii < 3; ++ii)
+        {
+            const auto& a = v[(ii + 1) % 3];
+            const auto& b = v[(ii + 2) % 3];
+            // E(x, y) = (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x)
+            edge_dx[ii] = -(b.y - a.y);
+            edge_dy[ii] = b.x - a.x;
+            edge_c[ii] = (b.y - a.y) * a.x - (b.x - a.x) * a.y;
+        }
+        float inv_area = 1.f / ((v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x));
+
+        for(int32_t y = y0; y < y1; ++y)
+        {
+            float py = float(y) + 0.5f;
+            float* row = depth_.data() + y * int32_t(width_);
+#if W_SIMD_SSE
+            __m128 e_dx[3], e_row[3];
+            for(uint32_t ii = 0; ii < 3; ++ii)
+            {
+                e_dx[ii] = _mm_set1_ps(edge_dx[ii]);
+                e_row[ii] = _mm_set1_ps(edge_dy[ii] * py + edge_c[ii]);
+            }
+            const __m128 z0 = _mm_set1_ps(v[0].z * inv_area);
+            const __m128 z1 = _mm_set1_ps(v[1].z * inv_area);
+            const __m128 z2 = _mm_set1_ps(v[2].z * inv_area);
+            const __m128 zero = _mm_setzero_ps();
+            for(int32_t x = x0; x < x1; x += 4)
+            {
+                __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+                __m128 w0 = _mm_add_ps(_mm_mul_ps(e_dx[0], px), e_row[0]);
+                __m128 w1 = _mm_add_ps(_mm_mul_ps(e_dx[1], px), e_row[1]);
+                __m128 w2 = _mm_add_ps(_mm_mul_ps(e_dx[2], px), e_row[2]);
+                __m128 inside =
+                    _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+                if(_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, z0), _mm_mul_ps(w1, z1)), _mm_mul_ps(w2, z2));
+                __m128 depth = _mm_loadu_ps(row + x);
+                __m128 nearest = _mm_min_ps(depth, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, depth)));
+            }
+#else
+            for(int32_t x = x0; x < x1; ++x)
+            {
+                float px = float(x) + 0.5f;
+                float w[3];
+                for(uint32_t ii = 0; ii < 3; ++ii)
+                    w[ii] = edge_dx[ii] * px + edge_dy[ii] * py + edge_c[ii];
+                if(w[0] < 0.f || w[1] < 0.f || w[2] < 0.f)
+                    continue;
+                float z = (w[0] * v[0].z + w[1] * v[1].z + w[2] * v[2].z) * inv_area;
+                row[x] = std::min(row[x], z);
+            }
+#endif
+        }
+    }
+
+    // Farthest depth of each tile in the band
+    for(uint32_t tx = 0; tx < tiles_x_; ++tx)
+    {
+        float farthest = 0.f;
+        for(int32_t y = band_y0; y < band_y1; ++y)
+        {
+            const float* row = depth_.data() + y * int32_t(width_) + tx * tile_size_;
+            farthest = std::max(farthest, *std::max_element(row, row + tile_size_));
+        }
+        tile_max_[band * tiles_x_ + tx] = farthest;
+    }
+}
+
+bool OcclusionBuffer::is_visible(const Extent& extent, const glm::mat4& model_matrix) const
+{
+    // Screen-space bounding rectangle and nearest depth of the box
+    std::array<glm::vec3, 8> vertices;
+    bound::to_model_space_vertices(extent, vertices);
+    glm::mat4 mvp = view_projection_ * model_matrix;
+    float xmin = std::numeric_limits<float>::max();
+    float xmax = -std::numeric_limits<float>::max();
+    float ymin = std::numeric_limits<float>::max();
+    float ymax = -std::numeric_limits<float>::max();
+    float min_depth = std::numeric_limits<float>::max();
+    for(const auto& vertex : vertices)
+    {
+        glm::vec4 clip = mvp * glm::vec4(vertex, 1.f);
+        // Box crosses the near plane
+        if(clip.z + clip.w < 0.f)
+            return true;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        float x = (ndc.x * 0.5f + 0.5f) * float(width_);
+        float y = (ndc.y * 0.5f + 0.5f) * float(height_);
+        xmin = std::min(xmin, x);
+        xmax = std::max(xmax, x);
+        ymin = std::min(ymin, y);
+        ymax = std::max(ymax, y);
+        min_depth = std::min(min_depth, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Every pixel the rectangle touches must be covered by a nearer occluder
+    int32_t x0 = std::max(0, int32_t(std::floor(xmin)));
+    int32_t x1 = std::min(int32_t(width_), int32_t(std::ceil(xmax)));
+    int32_t y0 = std::max(0, int32_t(std::floor(ymin)));
+    int32_t y1 = std::min(int32_t(height_), int32_t(std::ceil(ymax)));
+    // Off-screen, this is for frustum culling to decide
+    if(x0 >= x1 || y0 >= y1)
+        return true;
+
+    int32_t tile = int32_t(tile_size_);
+    for(int32_t ty = y0 / tile; ty <= (y1 - 1) / tile; ++ty)
+    {
+        for(int32_t tx = x0 / tile; tx <= (x1 - 1) / tile; ++tx)
+        {
+            // Whole tile is nearer
+            if(tile_max_[uint32_t(ty) * tiles_x_ + uint32_t(tx)] + k_depth_bias < min_depth)
+                continue;
+
+            for(int32_t y = std::max(y0, ty * tile); y < std::min(y1, (ty + 1) * tile); ++y)
+            {
+                const float* row = depth_.data() + y * int32_t(width_);
+                for(int32_t x = std::max(x0, tx * tile); x < std::min(x1, (tx + 1) * tile); ++x)
+                    if(row[x] + k_depth_bias >= min_depth)
+                        return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace erwin
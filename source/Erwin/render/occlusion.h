@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "asset/bounding.h"
+#include "glm/glm.hpp"
+
+namespace erwin
+{
+
+class RenderWorkers;
+
+/*
+	CPU occlusion culling. Occluder triangles are rasterized into a low resolution depth buffer,
+	and mesh instances are tested against it before any draw call is built. Depth is stored as
+	window-space depth in [0,1], cleared to the far plane. Each tile of the buffer also keeps its
+	farthest depth, so that most tests are resolved a whole tile at a time.
+	Rasterization is split in bands of tile rows, bands can be rasterized by worker threads.
+	Occluders must be solid: only their actual surface should hide anything.
+*/
+class OcclusionBuffer
+{
+public:
+	// Buffer width must be a multiple of 4 and both dimensions multiples of the tile size
+	void init(uint32_t width, uint32_t height, uint32_t tile_size);
+	// Set the camera, this removes all occluders
+	void set_view_projection(const glm::mat4& view_projection);
+	// Remove all occluders
+	void clear();
+	// Add a box occluder
+	void add_occluder(const Extent& extent, const glm::mat4& model_matrix);
+	// Add an occluder made of model-space triangles
+	void add_occluder(const glm::vec3* vertices, const uint32_t* indices, uint32_t index_count,
+	                  const glm::mat4& model_matrix);
+	// Rasterize the occluders. Bands of tile rows are distributed to the workers, if any.
+	void rasterize(RenderWorkers* workers = nullptr);
+	// Check if any part of a mesh instance bounding box may be visible. The buffer must have been rasterized.
+	bool is_visible(const Extent& extent, const glm::mat4& model_matrix) const;
+
+	inline bool has_occluders() const { return !triangles_.empty(); }
+	inline uint32_t get_width() const { return width_; }
+	inline uint32_t get_height() const { return height_; }
+	inline const float* get_depth() const { return depth_.data(); }
+
+private:
+	// Screen-space triangle, xy in pixels, z in window-space depth
+	struct Triangle
+	{
+		glm::vec3 vertices[3];
+		float xmin, xmax, ymin, ymax;
+	};
+
+	void add_clip_triangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+	void add_screen_triangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+	void rasterize_band(uint32_t band);
+
+private:
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+	uint32_t tile_size_ = 8;
+	uint32_t tiles_x_ = 0;
+	uint32_t tiles_y_ = 0;
+	glm::mat4 view_projection_ = glm::mat4(1.f);
+	std::vector<Triangle> triangles_;
+	std::vector<float> depth_;
+	std::vector<float> tile_max_; // Farthest depth of each tile
+};
+
+} // namespace erwin
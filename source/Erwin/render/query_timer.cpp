@@ -3,6 +3,7 @@
 #include <kibble/logger/logger.h>
 
 #include "platform/OGL/ogl_query_timer.h"
+#include "platform/Null/null_query_timer.h"
 
 namespace erwin
 {
@@ -12,12 +13,23 @@ WScope<QueryTimer> QueryTimer::create()
     switch(gfx::get_backend())
     {
         case GfxAPI::None:
-            KLOGE("render") << "QueryTimer: not implemented for GfxAPI::None." << std::endl;
-            return nullptr;
+            return make_scope<NullQueryTimer>();
 
         case GfxAPI::OpenGL:
             return make_scope<OGLQueryTimer>();
     }
 }
 
+WScope<PassQueryTimer> PassQueryTimer::create()
+{
+    switch(gfx::get_backend())
+    {
+        case GfxAPI::None:
+            return make_scope<NullPassQueryTimer>();
+
+        case GfxAPI::OpenGL:
+            return make_scope<OGLPassQueryTimer>();
+    }
+}
+
 } // namespace erwin
\ No newline at end of file
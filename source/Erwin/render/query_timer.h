@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <utility>
+#include <vector>
 
 #include "core/core.h"
 
@@ -22,4 +24,27 @@ public:
     static WScope<QueryTimer> create();
 };
 
+// Interface for GPU timestamps bracketing the passes of a frame. Results are read back frames later,
+// and only once they are available, so that the CPU never waits for the GPU.
+class PassQueryTimer
+{
+public:
+    using PassTime = std::pair<uint8_t, std::chrono::nanoseconds>; // layer id, elapsed GPU time
+
+    virtual ~PassQueryTimer() = default;
+
+    // Start recording the timestamps of a new frame
+    virtual void begin_frame() = 0;
+    // Record a timestamp at the start of a pass, the previous pass ends there
+    virtual void begin_pass(uint8_t layer_id) = 0;
+    // Record the timestamp ending the last pass
+    virtual void end_frame() = 0;
+    // Get the GPU time of each pass of the most recent frame whose results are available.
+    // Returns false if no new results are available.
+    virtual bool collect(std::vector<PassTime>& results) = 0;
+
+    // Factory method for the creation of a graphics API specific timer
+    static WScope<PassQueryTimer> create();
+};
+
 } // namespace erwin
@@ -0,0 +1,97 @@
+#include "render/render_thread.h"
+#include "render/gfx_context.h"
+#include <kibble/assert/assert.h>
+#include <kibble/logger/logger.h>
+
+namespace erwin
+{
+
+RenderThread::~RenderThread()
+{
+    if(running_)
+        kill();
+}
+
+void RenderThread::spawn(const GFXContext& context)
+{
+    K_ASSERT(!running_, "Render thread is already running.");
+    KLOGN("render") << "[RenderThread] Spawning render thread." << std::endl;
+
+    // A context can only be current on a single thread at a time
+    context_ = &context;
+    context_->release_current();
+    stop_ = false;
+    busy_ = false;
+    running_ = true;
+    thread_ = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::kill()
+{
+    K_ASSERT(running_, "Render thread is not running.");
+    KLOGN("render") << "[RenderThread] Killing render thread." << std::endl;
+
+    // Execute what remains to be executed
+    flush();
+    sync();
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_kick_.notify_one();
+    thread_.join();
+    running_ = false;
+
+    context_->make_current();
+    context_ = nullptr;
+}
+
+void RenderThread::enqueue(Task&& task) { pending_.push_back(std::move(task)); }
+
+void RenderThread::flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_done_.wait(lock, [this]() { return !busy_; });
+        // Swap vectors instead of moving them, so the allocated capacity is recycled
+        std::swap(pending_, in_flight_);
+        busy_ = !in_flight_.empty();
+    }
+    cv_kick_.notify_one();
+}
+
+void RenderThread::sync()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_done_.wait(lock, [this]() { return !busy_; });
+}
+
+void RenderThread::run()
+{
+    context_->make_current();
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_kick_.wait(lock, [this]() { return busy_ || stop_; });
+            if(stop_ && !busy_)
+                break;
+        }
+
+        // The in flight batch is not touched by the producer until busy_ is reset
+        for(auto& task : in_flight_)
+            task();
+        in_flight_.clear();
+
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+        }
+        cv_done_.notify_all();
+    }
+
+    context_->release_current();
+}
+
+} // namespace erwin
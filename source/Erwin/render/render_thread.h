@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace erwin
+{
+
+class GFXContext;
+// Thread that owns the graphics context and executes GPU work on behalf of the main thread.
+// Tasks are batched with enqueue() and handed over as a whole with flush(). At most one batch is
+// in flight at any time, so the main thread can record frame N+1 while frame N is being submitted.
+class RenderThread
+{
+public:
+    using Task = std::function<void()>;
+
+    RenderThread() = default;
+    ~RenderThread();
+
+    // Start the thread and transfer the ownership of the context to it
+    void spawn(const GFXContext& context);
+    // Execute the remaining tasks, join the thread and make the context current on the calling thread again
+    void kill();
+    // Add a task to the pending batch
+    void enqueue(Task&& task);
+    // Wait for the batch in flight to complete, then hand over the pending batch
+    void flush();
+    // Wait for the batch in flight to complete
+    void sync();
+
+    inline bool is_running() const { return running_; }
+
+private:
+    void run();
+
+private:
+    const GFXContext* context_ = nullptr;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_kick_;
+    std::condition_variable cv_done_;
+    std::vector<Task> pending_;
+    std::vector<Task> in_flight_;
+    bool busy_ = false;
+    bool stop_ = false;
+    bool running_ = false;
+};
+
+} // namespace erwin
@@ -0,0 +1,100 @@
+#include "render/render_workers.h"
+#include <kibble/assert/assert.h>
+#include <kibble/logger/logger.h>
+
+namespace erwin
+{
+
+RenderWorkers::~RenderWorkers()
+{
+    if(!threads_.empty())
+        kill();
+}
+
+void RenderWorkers::spawn(uint32_t count)
+{
+    K_ASSERT(threads_.empty(), "Render workers are already running.");
+    if(count == 0)
+        return;
+
+    KLOGN("render") << "[RenderWorkers] Spawning " << count << " worker threads." << std::endl;
+    stop_ = false;
+    threads_.reserve(count);
+    for(uint32_t ii = 0; ii < count; ++ii)
+        threads_.emplace_back(&RenderWorkers::run, this);
+}
+
+void RenderWorkers::kill()
+{
+    if(threads_.empty())
+        return;
+
+    KLOGN("render") << "[RenderWorkers] Killing worker threads." << std::endl;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_kick_.notify_all();
+    for(auto& thread : threads_)
+        thread.join();
+    threads_.clear();
+}
+
+void RenderWorkers::parallel_for(uint32_t count, const Task& task)
+{
+    // Not worth waking the workers up
+    if(threads_.empty() || count < 2)
+    {
+        for(uint32_t ii = 0; ii < count; ++ii)
+            task(ii);
+        return;
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        next_.store(0, std::memory_order_relaxed);
+        active_ = uint32_t(threads_.size());
+        ++generation_;
+    }
+    cv_kick_.notify_all();
+
+    execute();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_done_.wait(lock, [this]() { return active_ == 0; });
+    task_ = nullptr;
+}
+
+void RenderWorkers::execute()
+{
+    for(uint32_t ii = next_.fetch_add(1, std::memory_order_relaxed); ii < count_;
+        ii = next_.fetch_add(1, std::memory_order_relaxed))
+        (*task_)(ii);
+}
+
+void RenderWorkers::run()
+{
+    uint64_t generation = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_kick_.wait(lock, [this, generation]() { return stop_ || generation_ != generation; });
+            if(stop_)
+                break;
+            generation = generation_;
+        }
+
+        execute();
+
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+        }
+        cv_done_.notify_one();
+    }
+}
+
+} // namespace erwin
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace erwin
+{
+
+// Pool of worker threads the renderer uses to spread CPU-side frame preparation over several cores.
+// Work is submitted as a parallel loop, and the submitting thread takes part in it. Indices are handed
+// out dynamically, so uneven workloads balance themselves.
+class RenderWorkers
+{
+public:
+    using Task = std::function<void(uint32_t)>;
+
+    RenderWorkers() = default;
+    ~RenderWorkers();
+
+    // Start count worker threads, 0 means every loop runs on the calling thread
+    void spawn(uint32_t count);
+    // Join all worker threads
+    void kill();
+    // Call task for each index in [0, count), return once all calls have completed
+    void parallel_for(uint32_t count, const Task& task);
+
+    inline uint32_t get_worker_count() const { return uint32_t(threads_.size()); }
+
+private:
+    void run();
+    void execute();
+
+private:
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_kick_;
+    std::condition_variable cv_done_;
+    const Task* task_ = nullptr;
+    uint32_t count_ = 0;
+    std::atomic<uint32_t> next_{0};
+    uint32_t active_ = 0;     // Number of workers still busy with the current loop
+    uint64_t generation_ = 0; // Incremented for each loop, so that a worker never runs the same loop twice
+    bool stop_ = false;
+};
+
+} // namespace erwin
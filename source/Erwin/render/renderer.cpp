@@ -1,14 +1,25 @@
 #include "render/renderer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <fstream>
+#include <mutex>
+#include <thread>
 
 #include "core/clock.hpp"
 #include "core/application.h"
 #include "memory/arena.h"
 #include "memory/handle_pool.h"
+#include "math/utils.h"
 #include "render/backend.h"
+#include "render/frame_capture.h"
+#include "render/geometry_pool.h"
 #include "render/query_timer.h"
+#include "render/render_thread.h"
+#include "render/render_workers.h"
+#include "utils/fnv1a.hpp"
+#include "utils/radix_sort.hpp"
 #include <kibble/logger/logger.h>
 #include <kibble/math/color.h>
 
@@ -38,34 +49,379 @@ namespace erwin
          |_|  \_\___|_| |_|\__,_|\___|_|     \___\_\\__,_|\___|\__,_|\___|
 */
 
-template <std::size_t SIZE> struct CommandBuffer
+// Command data storage made of chained pages. A page is allocated whenever the current one
+// cannot hold a command of usual size (k_max_command_size), so that a command never straddles two
+// pages and a page can be handed to the backend for decoding. A command that outgrows its page while
+// it is written is moved to a new page large enough for it. The amount of memory used is tracked on
+// each frame, and the storage is right-sized on reset: a chain is replaced by a single page large
+// enough for the high-water mark, and pages much larger than needed for some time are shrunk.
+// Pages are heap allocated rather than taken from the frame arena, as they outlive the frame.
+class CommandStorage
 {
-    typedef std::pair<uint64_t, void*> Entry;
+public:
+    inline void init(const char* debug_name)
+    {
+        debug_name_ = debug_name;
+        add_page(k_min_command_page_size);
+    }
+
+    // Start a new command, a new page is chained if needed
+    void begin_command();
+    // Keep track of the memory used by the command just written, and get its address
+    void* end_command();
+    template <typename T> inline void write(T* source)
+    {
+        reserve(sizeof(T));
+        pages_[current_]->buffer.write(source);
+    }
+    inline void write_str(const std::string& str)
+    {
+        // Length prefix and terminator included
+        reserve(str.size() + sizeof(uint64_t) + 1);
+        pages_[current_]->buffer.write_str(str);
+    }
+    // Get the page a command was written to
+    memory::LinearBuffer<>& page_of(void* cmd);
+    // Rewind storage and right-size it for the next frame
+    void reset();
 
-    CommandBuffer() = default;
-    CommandBuffer(memory::HeapArea& area, std::size_t size, const char* debug_name) { init(area, size, debug_name); }
+    inline std::size_t get_high_water_mark() const { return high_water_; }
+
+private:
+    struct Page
+    {
+        memory::HeapArea area;
+        memory::LinearBuffer<> buffer;
+        uint8_t* begin;
+        std::size_t size;
+        std::size_t used = 0;
+    };
 
-    inline void init(memory::HeapArea& area, std::size_t size, const char* debug_name)
+    void add_page(std::size_t size);
+    // Make room for a write to the current command, move the command to a new page if needed
+    inline void reserve(std::size_t size)
+    {
+        const Page& page = *pages_[current_];
+        if(page.size - std::size_t(static_cast<uint8_t*>(page.buffer.head()) - page.begin) < size)
+            move_command(size);
+    }
+    void move_command(std::size_t size);
+    inline std::size_t get_capacity() const
     {
-        count = 0;
-        storage.init(area, size, debug_name);
+        std::size_t capacity = 0;
+        for(const auto& page : pages_)
+            capacity += page->size;
+        return capacity;
+    }
+
+private:
+    std::vector<std::unique_ptr<Page>> pages_;
+    std::size_t current_ = 0;
+    void* command_ = nullptr; // Address of the command being written
+    std::size_t high_water_ = 0;
+    uint32_t frames_ = 0;
+    const char* debug_name_ = nullptr;
+};
+
+void CommandStorage::add_page(std::size_t size)
+{
+    auto page = std::make_unique<Page>();
+    // Heap area blocks are aligned, leave some room for padding
+    page->area.init(size + 1_kB);
+    page->buffer.init(page->area, size, debug_name_);
+    page->begin = static_cast<uint8_t*>(page->buffer.head());
+    page->size = size;
+    pages_.push_back(std::move(page));
+}
+
+void CommandStorage::begin_command()
+{
+    Page* page = pages_[current_].get();
+    void* head = page->buffer.head();
+    if(page->size - std::size_t(static_cast<uint8_t*>(head) - page->begin) < k_max_command_size)
+    {
+        // Grow geometrically, the storage capacity doubles with each new page
+        if(++current_ == pages_.size())
+            add_page(get_capacity());
+        head = pages_[current_]->buffer.head();
+    }
+    command_ = head;
+}
+
+void CommandStorage::move_command(std::size_t size)
+{
+    Page* page = pages_[current_].get();
+    auto* begin = static_cast<uint8_t*>(command_);
+    std::size_t written = std::size_t(static_cast<uint8_t*>(page->buffer.head()) - begin);
+    KLOGW("render") << "Command larger than " << k_max_command_size / 1024 << "kB in " << debug_name_
+                    << ", moved to a new page." << std::endl;
+
+    // The partial command is left behind in the old page, it is not referenced by any entry.
+    // Pages after the current one are empty, the new page is inserted right after it.
+    std::size_t page_size =
+        std::max(get_capacity(), std::size_t(math::np2(uint32_t(written + size + k_max_command_size))));
+    page->buffer.seek(command_);
+    page->used = std::size_t(begin - page->begin);
+    add_page(page_size);
+    std::rotate(pages_.begin() + long(current_) + 1, pages_.end() - 1, pages_.end());
+
+    Page* target = pages_[++current_].get();
+    command_ = target->buffer.head();
+    for(std::size_t ii = 0; ii < written; ++ii)
+        target->buffer.write(begin + ii);
+}
+
+void* CommandStorage::end_command()
+{
+    Page* page = pages_[current_].get();
+    page->used = std::size_t(static_cast<uint8_t*>(page->buffer.head()) - page->begin);
+    K_ASSERT_FMT(page->used <= page->size, "Command storage overflow in %s.", debug_name_);
+    return command_;
+}
+
+memory::LinearBuffer<>& CommandStorage::page_of(void* cmd)
+{
+    if(pages_.size() == 1)
+        return pages_[0]->buffer;
+
+    auto* addr = static_cast<uint8_t*>(cmd);
+    for(auto& page : pages_)
+        if(addr >= page->begin && addr < page->begin + page->size)
+            return page->buffer;
+
+    K_ASSERT_FMT(false, "Command does not belong to %s.", debug_name_);
+    return pages_[0]->buffer;
+}
+
+void CommandStorage::reset()
+{
+    std::size_t used = 0;
+    for(auto& page : pages_)
+    {
+        used += page->used;
+        page->used = 0;
+        page->buffer.reset();
+    }
+    current_ = 0;
+    high_water_ = std::max(high_water_, used);
+
+    // A single page must be able to hold the whole frame
+    std::size_t target =
+        std::max(k_min_command_page_size, std::size_t(math::np2(uint32_t(high_water_ + k_max_command_size))));
+    std::size_t capacity = get_capacity();
+    bool chained = pages_.size() > 1;
+    bool oversized = (++frames_ >= k_command_buffer_shrink_frames) && (target * 4 <= capacity);
+    if(chained || oversized)
+    {
+        KLOG("render", 0) << "Resizing " << debug_name_ << ": " << capacity / 1024 << "kB -> " << target / 1024
+                          << "kB" << std::endl;
+        pages_.clear();
+        add_page(target);
+    }
+    if(frames_ >= k_command_buffer_shrink_frames)
+    {
+        frames_ = 0;
+        high_water_ = 0;
+    }
+}
+
+// Command entries and the storage they point to. Entries grow on demand, and are shrunk
+// along with the storage when the amount of commands per frame drops.
+struct CommandBuffer
+{
+    typedef std::pair<uint64_t, void*> Entry;
+
+    inline void init(const char* debug_name)
+    {
+        storage.init(debug_name);
+        entries.reserve(k_min_command_entries);
     }
 
     inline void reset()
     {
+        entry_high_water = std::max(entry_high_water, entries.size());
         storage.reset();
-        count = 0;
+        entries.clear();
+        if(++frames >= k_command_buffer_shrink_frames)
+        {
+            std::size_t target =
+                std::max(std::size_t(k_min_command_entries), std::size_t(math::np2(uint32_t(entry_high_water))));
+            if(target * 4 <= entries.capacity())
+            {
+                std::vector<Entry> shrunk;
+                shrunk.reserve(target);
+                entries.swap(shrunk);
+            }
+            frames = 0;
+            entry_high_water = 0;
+        }
+    }
+
+    // Record the command written to storage since storage.begin_command()
+    inline uint32_t push(uint64_t key)
+    {
+        entries.push_back({key, storage.end_command()});
+        return uint32_t(entries.size() - 1);
+    }
+
+    // Sort entries by key. Keys are stored separately from commands to avoid touching
+    // data too much during sort calls. Small buffers are cheaper to sort with std::sort,
+    // larger ones are radix sorted using a scratch buffer that lives in the per-frame arena.
+    inline void sort(Renderer::AuxArena& arena)
+    {
+        if(entries.size() < k_radix_sort_threshold)
+        {
+            std::sort(entries.begin(), entries.end(),
+                      [&](const Entry& item1, const Entry& item2) { return item1.first < item2.first; });
+            return;
+        }
+
+        Entry* scratch = K_NEW_ARRAY_DYNAMIC(Entry, entries.size(), arena);
+        radix_sort(entries.data(), scratch, entries.size());
     }
 
-    inline bool is_full() const { return count >= SIZE; }
+    CommandStorage storage;
+    std::vector<Entry> entries;
+    std::size_t entry_high_water = 0;
+    uint32_t frames = 0;
+};
+
+using RenderCommandBuffer = CommandBuffer;
+
+// Draw command buffer owned by a single recording thread. Data copied alongside
+// the draw commands (dependencies payloads) is allocated in a per-buffer arena.
+struct DrawCommandBuffer : public CommandBuffer
+{
+    inline void reset()
+    {
+        CommandBuffer::reset();
+        draw_call_count = 0;
+    }
 
-    std::size_t count;
-    memory::LinearBuffer<> storage;
-    Entry entries[SIZE];
+    Renderer::AuxArena* arena = nullptr;
+    size_t arena_size = 0; // Capacity of the arena in bytes
+    uint32_t draw_call_count = 0;
 };
 
-using RenderCommandBuffer = CommandBuffer<k_max_render_commands>;
-using DrawCommandBuffer = CommandBuffer<k_max_draw_calls>;
+// Index of the draw command buffer the current thread records to. 0 is the main thread buffer.
+static thread_local uint32_t t_recording_slot = 0;
+
+// Keeps track of the worker command buffers bound to a recording thread. Slots are shared by
+// both frame queues, so a worker records to the same buffer index from one frame to the next.
+class RecordingSlots
+{
+public:
+    void init(uint32_t count);
+    // Bind the calling thread to a free slot
+    bool bind();
+    // Free the slot bound to the calling thread
+    void unbind();
+    // Check that the calling thread is allowed to record draw commands
+    inline bool is_recording_thread() const
+    {
+        return t_recording_slot != 0 || std::this_thread::get_id() == main_thread_id_;
+    }
+    inline uint32_t get_count() const { return count_; }
+
+private:
+    uint32_t count_ = 1;
+    bool used_[k_max_recording_threads];
+    std::mutex mutex_;
+    std::thread::id main_thread_id_;
+};
+
+void RecordingSlots::init(uint32_t count)
+{
+    count_ = count;
+    main_thread_id_ = std::this_thread::get_id();
+    used_[0] = true;
+    for(uint32_t ii = 1; ii < count_; ++ii)
+        used_[ii] = false;
+}
+
+bool RecordingSlots::bind()
+{
+    K_ASSERT(std::this_thread::get_id() != main_thread_id_, "Main thread cannot be bound to a worker command buffer.");
+    K_ASSERT(t_recording_slot == 0, "Thread is already bound to a command buffer.");
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for(uint32_t ii = 1; ii < count_; ++ii)
+    {
+        if(!used_[ii])
+        {
+            used_[ii] = true;
+            t_recording_slot = ii;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RecordingSlots::unbind()
+{
+    if(t_recording_slot == 0)
+        return;
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    used_[t_recording_slot] = false;
+    t_recording_slot = 0;
+}
+
+// Cursor over command data. Commands are written packed, so they can be decoded without seeking the
+// page they live in. This way worker threads can decode commands of a shared page concurrently.
+class CommandReader
+{
+public:
+    explicit CommandReader(const void* head) : head_(static_cast<const uint8_t*>(head)) {}
+
+    template <typename T> inline void read(T* target)
+    {
+        memcpy(target, head_, sizeof(T));
+        head_ += sizeof(T);
+    }
+    inline void* head() const { return const_cast<uint8_t*>(head_); }
+
+private:
+    const uint8_t* head_;
+};
+
+// Dispatch-ready draw command. The page holding the command is resolved, and its dependencies unrolled
+// ahead of time, so that the dispatching thread only needs to seek and hand data to the backend.
+struct DependencyPacket
+{
+    void* cmd;
+    memory::LinearBuffer<>* page;
+};
+
+struct DrawPacket
+{
+    uint64_t key;
+    void* body; // Command data following the type and the dependency list
+    memory::LinearBuffer<>* page;
+    uint32_t first_dependency; // Index of the first dependency in the partition dependency array
+    uint16_t type;
+    uint8_t dependency_count;
+};
+
+// Draw commands sharing the same view (highest 16 bits of the sorting key). Partitions are independent,
+// so they are sorted and decoded in parallel.
+struct ViewPartition
+{
+    // Command address and index of the buffer it was recorded to
+    struct Source
+    {
+        void* cmd;
+        uint32_t buffer;
+    };
+    using Entry = std::pair<uint64_t, Source>;
+
+    uint16_t view;
+    float sort_time = 0.f; // Microseconds, when profiling is enabled
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch;
+    std::vector<DrawPacket> packets;
+    std::vector<DependencyPacket> dependencies;
+};
 
 class RenderQueue
 {
@@ -74,55 +430,99 @@ public:
     friend class DrawCommandWriter;
 
     RenderQueue() = default;
-    explicit RenderQueue(memory::HeapArea& area);
+    RenderQueue(memory::HeapArea& area, Renderer::AuxArena& main_arena, size_t main_arena_size, uint32_t buffer_count);
     ~RenderQueue();
 
-    void init(memory::HeapArea& area);
+    void init(memory::HeapArea& area, Renderer::AuxArena& main_arena, size_t main_arena_size, uint32_t buffer_count);
 
     // * These functions change the queue state persistently
     // Set clear color for this queue
     inline void set_clear_color(const glm::vec4& clear_color) { clear_color_ = clear_color; }
-    // Check if the queue is full
-    inline bool is_full() const { return command_buffer_.is_full(); }
-    // Sort queue by sorting key
-    void sort();
-    // Dispatch all commands
+    // Get the draw command buffer bound to the calling thread
+    inline DrawCommandBuffer& get_command_buffer() { return command_buffers_[t_recording_slot]; }
+    // Get the total amount of draw calls recorded this frame
+    uint32_t get_draw_call_count() const;
+    // Get the debug name of a layer id requested this frame
+    inline hash_t get_layer_name(uint8_t layer_id) const { return layer_names_[layer_id]; }
+    // Partition the draw commands of all buffers by view, then sort and decode partitions in parallel
+    void sort(RenderWorkers& workers);
+    // Dispatch all commands, partition after partition
     void flush();
     // Clear queue
     void reset();
+    // Serialize the commands of each buffer, in submission order
+    void capture(FrameCapture& capture, std::vector<std::vector<CapturedCommand>>& buffers);
+    // Record captured commands, buffer by buffer
+    void replay(const std::vector<std::vector<CapturedCommand>>& buffers, FrameReplayer& replayer);
 
 private:
     uint8_t current_view_id_;
+    hash_t layer_names_[256];
     glm::vec4 clear_color_;
-    DrawCommandBuffer command_buffer_;
+    uint32_t buffer_count_ = 1;
+    DrawCommandBuffer command_buffers_[k_max_recording_threads];
+    Renderer::AuxArena worker_arenas_[k_max_recording_threads - 1];
+    // Partitions are kept from one frame to the next so that their storage is recycled
+    std::vector<ViewPartition> partitions_;
+    uint32_t partition_count_ = 0;
+
+private:
+    ViewPartition& get_partition(uint16_t view);
+    void prepare_partition(ViewPartition& partition);
 };
 
-RenderQueue::RenderQueue(memory::HeapArea& area) { init(area); }
+RenderQueue::RenderQueue(memory::HeapArea& area, Renderer::AuxArena& main_arena, size_t main_arena_size,
+                         uint32_t buffer_count)
+{
+    init(area, main_arena, main_arena_size, buffer_count);
+}
 
 RenderQueue::~RenderQueue() {}
 
-void RenderQueue::init(memory::HeapArea& area)
+void RenderQueue::init(memory::HeapArea& area, Renderer::AuxArena& main_arena, size_t main_arena_size,
+                       uint32_t buffer_count)
 {
     clear_color_ = {0.f, 0.f, 0.f, 0.f};
-    command_buffer_.init(area, CFG_.get<size_t>("erwin.memory.renderer.queue_buffer"_h, 512_kB), "RenderQueue");
     current_view_id_ = 0;
+    std::fill(std::begin(layer_names_), std::end(layer_names_), 0);
+    buffer_count_ = buffer_count;
+
+    // Main thread buffer shares the frame auxiliary arena
+    command_buffers_[0].init("RenderQueue");
+    command_buffers_[0].arena = &main_arena;
+    command_buffers_[0].arena_size = main_arena_size;
+
+    size_t worker_arena_size = CFG_.get<size_t>("erwin.memory.renderer.worker_auxiliary_arena"_h, 512_kB);
+    for(uint32_t ii = 1; ii < buffer_count_; ++ii)
+    {
+        command_buffers_[ii].init("RenderQueue-Worker");
+        worker_arenas_[ii - 1].init(area, worker_arena_size, "Auxiliary-Worker");
+        command_buffers_[ii].arena = &worker_arenas_[ii - 1];
+        command_buffers_[ii].arena_size = worker_arena_size;
+    }
 }
 
-void RenderQueue::sort()
+uint32_t RenderQueue::get_draw_call_count() const
 {
-    W_PROFILE_RENDER_FUNCTION()
-
-    // Keys stored separately from commands to avoid touching data too
-    // much during sort calls
-    std::sort(std::begin(command_buffer_.entries), std::begin(command_buffer_.entries) + command_buffer_.count,
-              [&](const DrawCommandBuffer::Entry& item1, const DrawCommandBuffer::Entry& item2) {
-                  return item1.first < item2.first;
-              });
+    uint32_t count = 0;
+    for(uint32_t ii = 0; ii < buffer_count_; ++ii)
+        count += command_buffers_[ii].draw_call_count;
+    return count;
 }
 
 void RenderQueue::reset()
 {
-    command_buffer_.reset();
+    for(uint32_t ii = 0; ii < buffer_count_; ++ii)
+        command_buffers_[ii].reset();
+    for(uint32_t ii = 1; ii < buffer_count_; ++ii)
+        worker_arenas_[ii - 1].reset();
+    for(uint32_t ii = 0; ii < partition_count_; ++ii)
+    {
+        partitions_[ii].entries.clear();
+        partitions_[ii].packets.clear();
+        partitions_[ii].dependencies.clear();
+    }
+    partition_count_ = 0;
     current_view_id_ = 0;
 }
 
@@ -140,6 +540,8 @@ struct FrameDrawCallData
 
     inline void on_submit(const DrawCall& dc, uint64_t key)
     {
+        // Draw calls can be submitted from multiple recording threads
+        const std::lock_guard<std::mutex> lock(mutex);
         draw_calls.insert(
             std::make_pair(key, DrawCallSummary{dc.data.state_flags, dc.type, dc.data.shader.index(), submitted++}));
     }
@@ -159,6 +561,7 @@ struct FrameDrawCallData
     void export_json();
 
     std::multimap<uint64_t, DrawCallSummary> draw_calls;
+    std::mutex mutex;
     fs::path json_path;
     bool tracking = false;
     uint32_t submitted = 0;
@@ -166,6 +569,8 @@ struct FrameDrawCallData
 
 void FrameDrawCallData::export_json()
 {
+    // Frame is exported on the thread that submits it, while the next one may be recorded
+    const std::lock_guard<std::mutex> lock(mutex);
     KLOGN("render") << "Exporting frame draw call profile:" << std::endl;
     KLOGI << kb::KS_PATH_ << json_path << std::endl;
 
@@ -200,6 +605,212 @@ void FrameDrawCallData::export_json()
 }
 #endif
 
+// Remembers a hash of the last payload uploaded to each uniform / shader storage buffer during a flush,
+// so that dependencies uploading the same content to the same buffer again can be skipped.
+class UploadCache
+{
+public:
+    // Check if a dependency upload is redundant. Storage head is left unchanged.
+    // Uploads that are not redundant are recorded as the new content of their target buffer.
+    bool is_redundant(uint16_t type, memory::LinearBuffer<>& storage);
+    // Forget the content of a shader storage buffer updated outside of the cache
+    inline void invalidate(ShaderStorageBufferHandle handle)
+    {
+        if(handle.index() < SSBOs_.capacity())
+            SSBOs_[handle.index()] = Content{};
+    }
+    // Forget all buffer contents, must be called before each flush
+    inline void reset()
+    {
+        // Handles referenced by the commands to flush were acquired before this point
+        UBOs_.reserve(UniformBufferHandle::s_ppool_->capacity());
+        SSBOs_.reserve(ShaderStorageBufferHandle::s_ppool_->capacity());
+        UBOs_.for_each([](Content& content) { content = Content{}; });
+        SSBOs_.for_each([](Content& content) { content = Content{}; });
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    inline uint32_t get_hits() const { return hits_; }
+    inline uint32_t get_misses() const { return misses_; }
+
+private:
+    struct Content
+    {
+        uint64_t hash = 0;
+        const void* data = nullptr;
+        uint32_t size = 0;
+    };
+
+    bool check(Content& content, const void* data, uint32_t size);
+
+private:
+    HandleArray<Content> UBOs_;
+    HandleArray<Content> SSBOs_;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+};
+
+bool UploadCache::check(Content& content, const void* data, uint32_t size)
+{
+    // A size of 0 means the whole buffer is updated, its size is only known to the backend
+    uint64_t hash = fnv1a(data, size);
+    if(size != 0 && content.data != nullptr && content.size == size && content.hash == hash &&
+       (content.data == data || memcmp(content.data, data, size) == 0))
+    {
+        ++hits_;
+        return true;
+    }
+
+    ++misses_;
+    content = (size != 0) ? Content{hash, data, size} : Content{};
+    return false;
+}
+
+bool UploadCache::is_redundant(uint16_t type, memory::LinearBuffer<>& storage)
+{
+    if(type != uint16_t(DrawCommand::UpdateUniformBuffer) && type != uint16_t(DrawCommand::UpdateShaderStorageBuffer))
+        return false;
+
+    // Both update commands share the same layout: handle, size, data pointer
+    void* head = storage.head();
+    uint32_t handle_data;
+    uint32_t size;
+    void* data;
+    storage.read(&handle_data);
+    storage.read(&size);
+    storage.read(&data);
+    storage.seek(head);
+
+    auto& contents = (type == uint16_t(DrawCommand::UpdateUniformBuffer)) ? UBOs_ : SSBOs_;
+    uint32_t index = handle_data & HandlePool::k_handle_mask;
+    if(index >= contents.capacity())
+        return false;
+    return check(contents[index], data, size);
+}
+
+// Folds runs of consecutive indexed draw calls that only differ by their UBO updates into a single
+// instanced draw call. The UBO payloads of a run are packed into the SSBO of an instanced variant
+// of the shader, see Renderer::enable_draw_merging().
+class DrawMerger
+{
+public:
+    struct Target
+    {
+        ShaderHandle instanced_shader;
+        ShaderStorageBufferHandle instance_buffer;
+        uint32_t capacity = 0; // Size of the instance buffer in bytes, 0 if merging is disabled
+    };
+
+    inline void init(bool enabled)
+    {
+        enabled_ = enabled;
+        area_.init(2_kB);
+        commands_.init(area_, 1_kB, "DrawMerger");
+    }
+
+    inline void set_target(ShaderHandle shader, const Target& target)
+    {
+        targets_.reserve(shader.index() + 1u);
+        targets_[shader.index()] = target;
+    }
+    inline void remove_target(ShaderHandle shader)
+    {
+        if(shader.index() < targets_.capacity())
+            targets_[shader.index()] = Target{};
+    }
+
+    // Dispatch a draw command, or hold it back while it can be merged with the next ones
+    void push(const DrawPacket& packet, const DependencyPacket* dependencies);
+    // Dispatch the pending run of draw calls
+    void flush();
+
+    // Amount of draw calls saved since last reset
+    inline uint32_t get_merged_count() const { return merged_count_; }
+    inline void reset_merged_count() { merged_count_ = 0; }
+
+private:
+    // Instance data is read as an std430 array of structs containing vec4s / matrices
+    static constexpr uint32_t k_instance_alignment = 16;
+
+    // Draw command data needed to decide whether two draw calls can be merged
+    struct DrawInfo
+    {
+        DrawCall::Data data;
+        uint8_t texture_count;
+        uint8_t cubemap_count;
+        uint8_t dependency_count;
+        TextureHandle textures[k_max_texture_slots];
+        CubemapHandle cubemaps[k_max_cubemap_slots];
+        UniformBufferHandle UBOs[k_max_draw_call_dependencies];
+        uint32_t sizes[k_max_draw_call_dependencies];
+        void* payloads[k_max_draw_call_dependencies];
+        uint32_t stride; // Size of the packed payloads of a single instance
+    };
+
+    struct Candidate
+    {
+        const DrawPacket* packet;
+        const DependencyPacket* dependencies;
+    };
+
+    // Decode a command, returns false if it is not a mergeable draw call
+    bool decode(const DrawPacket& packet, const DependencyPacket* dependencies, DrawInfo& info) const;
+    static bool is_compatible(const DrawInfo& first, const DrawInfo& other);
+
+private:
+    bool enabled_ = true;
+    HandleArray<Target> targets_;
+    DrawInfo head_; // First draw call of the current run
+    std::vector<Candidate> run_;
+    std::vector<uint8_t> instance_data_;
+    uint32_t merged_count_ = 0;
+    // Instanced draw commands are written here before being dispatched
+    memory::HeapArea area_;
+    memory::LinearBuffer<> commands_;
+};
+
+// Breaks the time spent in flush down by pass (layer id), when profiling is enabled.
+// GPU times come from timestamp queries that are read back only once available, so they lag a few frames behind.
+class PassProfiler
+{
+public:
+    inline void init() { GPU_timer_ = PassQueryTimer::create(); }
+    inline void release() { GPU_timer_ = nullptr; }
+
+    void begin_frame(const RenderQueue& queue);
+    // Start timing a new pass, the current one ends
+    void begin_pass(uint8_t layer_id);
+    // Write the timings of this frame to the statistics
+    void end_frame(Renderer::Statistics& stats);
+
+    // Account for the key sort of a view of the current pass
+    inline void add_sort_time(float time)
+    {
+        if(in_pass_)
+            passes_.back().CPU_sort_time += time;
+    }
+    inline void begin_dependencies() { dependency_clock_.restart(); }
+    inline void end_dependencies() { dependency_time_ += dependency_clock_.get_elapsed_time(); }
+    inline void count_draw_call() { ++draw_call_count_; }
+
+private:
+    void end_pass();
+
+private:
+    const RenderQueue* queue_ = nullptr;
+    WScope<PassQueryTimer> GPU_timer_;
+    std::vector<Renderer::PassStatistics> passes_;
+    std::vector<PassQueryTimer::PassTime> GPU_times_;
+    float last_GPU_times_[256] = {0.f}; // Indexed by layer id
+    kb::nanoClock pass_clock_;
+    kb::nanoClock dependency_clock_;
+    std::chrono::nanoseconds dependency_time_{0};
+    uint32_t draw_call_count_ = 0;
+    bool in_pass_ = false;
+    bool active_ = false; // Profiling can be toggled while a frame is being flushed
+};
+
 /*
            _____ _
           / ____| |
@@ -214,38 +825,75 @@ void FrameDrawCallData::export_json()
 static int FRONT = 0;
 static int BACK = 1;
 
+// All the data recorded during a frame. Two sets of frame data are used alternately, so that
+// a frame can be recorded while the previous one is being submitted by the render thread.
+// Data forwarded to the renderer (DataOwnership::Forward) must live in the frame auxiliary arena
+// or in the arena of the recording thread, see Renderer::get_arena().
+struct FrameStorage
+{
+    inline void init(memory::HeapArea& area, uint32_t recording_threads)
+    {
+        pre_buffer_.init("CB-Pre");
+        post_buffer_.init("CB-Post");
+        size_t arena_size = CFG_.get<size_t>("erwin.memory.renderer.auxiliary_arena"_h, 2_MB);
+        auxiliary_arena_.init(area, arena_size, "Auxiliary");
+        queue_.init(area, auxiliary_arena_, arena_size, recording_threads);
+        queue_.set_clear_color(glm::vec4(0.f, 0.f, 0.f, 0.f));
+    }
+
+    RenderCommandBuffer pre_buffer_;
+    RenderCommandBuffer post_buffer_;
+    Renderer::AuxArena auxiliary_arena_;
+    RenderQueue queue_;
+    // Culling results, can be reported by recording threads
+    std::atomic<uint32_t> visible_count_{0};
+    std::atomic<uint32_t> culled_count_{0};
+    std::atomic<uint32_t> occluded_count_{0};
+    // Profiling state sampled when the frame started being recorded, the frame is profiled as a whole
+    bool profiling_ = false;
+};
+
+// Buffers owned by a vertex array, their handles are released with it
+struct VertexArrayDependencies
+{
+    std::vector<VertexBufferHandle> vbos;
+    IndexBufferHandle ibo = {};
+};
+
 static struct RendererStorage
 {
     inline void init(memory::HeapArea* area)
     {
         renderer_memory_ = area;
-        pre_buffer_.init(*renderer_memory_, CFG_.get<size_t>("erwin.memory.renderer.pre_buffer"_h, 512_kB), "CB-Pre");
-        post_buffer_.init(*renderer_memory_, CFG_.get<size_t>("erwin.memory.renderer.post_buffer"_h, 512_kB),
-                          "CB-Post");
-        auxiliary_arena_.init(*renderer_memory_, CFG_.get<size_t>("erwin.memory.renderer.auxiliary_arena"_h, 2_MB),
-                              "Auxiliary");
-        handle_arena_.init(*renderer_memory_, k_render_handle_alloc_size, "RenderHandles");
-        queue_.init(*renderer_memory_);
-
-// Init handle pools
-#define DO_ACTION(HANDLE_NAME) HANDLE_NAME::init_pool(handle_arena_);
+        uint32_t recording_threads = std::clamp(CFG_.get<uint32_t>("erwin.renderer.max_recording_threads"_h, 4), 1u,
+                                                k_max_recording_threads);
+        recording_slots_.init(recording_threads);
+        draw_merger_.init(CFG_.get<bool>("erwin.renderer.merge_draw_calls"_h, true));
+        for(auto& frame : frames_)
+            frame.init(*renderer_memory_, recording_threads);
+        recording_frame_ = 0;
+        frames_[0].profiling_ = profiling_requested_.load(std::memory_order_relaxed);
+
+// Init handle pools, initial capacities can be overridden in the configuration
+#define DO_ACTION(HANDLE_NAME)                                                                                         \
+    HANDLE_NAME::init_pool(                                                                                            \
+        CFG_.get<uint32_t>(H_("erwin.renderer.handles." #HANDLE_NAME), k_handle_capacity<HANDLE_NAME>));
         FOR_ALL_HANDLES
 #undef DO_ACTION
-
-        // Init render queue
-        queue_.set_clear_color(glm::vec4(0.f, 0.f, 0.f, 0.f));
     }
 
     inline void release()
     {
+        vertex_array_dependencies_.clear();
 // Destroy handle pools
-#define DO_ACTION(HANDLE_NAME) HANDLE_NAME::destroy_pool(handle_arena_);
+#define DO_ACTION(HANDLE_NAME) HANDLE_NAME::destroy_pool();
         FOR_ALL_HANDLES
 #undef DO_ACTION
     }
 
     bool initialized_ = false;
-    bool profiling_enabled_ = false;
+    std::atomic<bool> profiling_requested_{false}; // Written by the main thread, sampled once per frame
+    bool profiling_enabled_ = false;               // Snapshot of the frame being submitted, submitting thread only
 
     WScope<QueryTimer> query_timer;
     Renderer::Statistics stats[2]; // Double buffered
@@ -253,59 +901,468 @@ static struct RendererStorage
     FrameDrawCallData draw_call_data;
 #endif
 
+    // Frame data commands are currently recorded to
+    inline FrameStorage& recording() { return frames_[recording_frame_]; }
+
     memory::HeapArea* renderer_memory_ = nullptr;
-    RenderCommandBuffer pre_buffer_;
-    RenderCommandBuffer post_buffer_;
-    Renderer::AuxArena auxiliary_arena_;
-    LinearArena handle_arena_;
-    RenderQueue queue_;
+    FrameStorage frames_[2];
+    uint32_t recording_frame_ = 0;
+    RecordingSlots recording_slots_;
+    RenderThread render_thread_;
+    RenderWorkers flush_workers_;
+    FrameCapture frame_capture_;
+    DrawMerger draw_merger_;
+    UploadCache upload_cache_;
+    PassProfiler pass_profiler_;
+    std::map<uint16_t, VertexArrayDependencies> vertex_array_dependencies_; // Main thread only
 } s_storage;
 
-void RenderQueue::flush()
+// Handles are released on the main thread when their destruction is recorded, the backend only ever sees their
+// index. Pools hold released indices back for k_handle_reuse_latency frames, until the backend is done with them.
+static void register_vertex_array(VertexArrayHandle handle, const std::vector<VertexBufferHandle>& vbs,
+                                  IndexBufferHandle ib)
+{
+    s_storage.vertex_array_dependencies_[handle.index()] = {vbs, ib};
+}
+
+static void release_vertex_array(VertexArrayHandle handle)
+{
+    auto findit = s_storage.vertex_array_dependencies_.find(handle.index());
+    if(findit != s_storage.vertex_array_dependencies_.end())
+    {
+        for(VertexBufferHandle vbo : findit->second.vbos)
+            vbo.release();
+        if(!findit->second.ibo.is_null())
+            findit->second.ibo.release();
+        s_storage.vertex_array_dependencies_.erase(findit);
+    }
+    handle.release();
+}
+
+static void release_framebuffer(FramebufferHandle handle, bool detach_textures)
+{
+    // Detached textures are owned by the caller from now on
+    if(!detach_textures)
+    {
+        uint32_t texture_count = gfx::backend->get_framebuffer_texture_count(handle);
+        for(uint32_t ii = 0; ii < texture_count; ++ii)
+        {
+            TextureHandle texture = gfx::backend->get_framebuffer_texture(handle, ii);
+            texture.release();
+        }
+        CubemapHandle cubemap = gfx::backend->get_framebuffer_cubemap(handle);
+        if(!cubemap.is_null())
+            cubemap.release();
+    }
+    handle.release();
+}
+
+ViewPartition& RenderQueue::get_partition(uint16_t view)
+{
+    for(uint32_t ii = 0; ii < partition_count_; ++ii)
+        if(partitions_[ii].view == view)
+            return partitions_[ii];
+
+    if(partition_count_ == partitions_.size())
+        partitions_.emplace_back();
+    auto& partition = partitions_[partition_count_++];
+    partition.view = view;
+    return partition;
+}
+
+void RenderQueue::sort(RenderWorkers& workers)
 {
     W_PROFILE_RENDER_FUNCTION()
-    // Set clear color
-    gfx::backend->set_clear_color(clear_color_.r, clear_color_.g, clear_color_.b, clear_color_.a);
 
-    // Execute all draw commands in command buffer
-    for(size_t ii = 0; ii < command_buffer_.count; ++ii)
+    // Dependencies are submitted with the k_skip key and are only ever dispatched through the
+    // draw command that references them, they are not partitioned.
+    // Buffers are visited in index order, so that ties are broken by buffer index, then by submission order.
+    ViewPartition* last = nullptr;
+    for(uint32_t ii = 0; ii < buffer_count_; ++ii)
+    {
+        for(auto&& [key, cmd] : command_buffers_[ii].entries)
+        {
+            if(key == SortKey::k_skip)
+                continue;
+            // Commands of a view are mostly submitted in a row
+            uint16_t view = uint16_t(key >> 48);
+            if(last == nullptr || last->view != view)
+                last = &get_partition(view);
+            last->entries.push_back({key, {cmd, ii}});
+        }
+    }
+
+    // Views are the most significant bits of the key, dispatching partitions in view order preserves the global order
+    std::sort(partitions_.begin(), partitions_.begin() + partition_count_,
+              [](const ViewPartition& a, const ViewPartition& b) { return a.view < b.view; });
+
+    workers.parallel_for(partition_count_, [this](uint32_t ii) { prepare_partition(partitions_[ii]); });
+}
+
+void RenderQueue::prepare_partition(ViewPartition& partition)
+{
+    // The radix sort is stable, and skips the passes over the view bytes all keys share
+    auto& entries = partition.entries;
+    kb::nanoClock sort_clock;
+    if(entries.size() < k_radix_sort_threshold)
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const auto& item1, const auto& item2) { return item1.first < item2.first; });
+    else
+    {
+        partition.scratch.resize(entries.size());
+        radix_sort(entries.data(), partition.scratch.data(), entries.size());
+    }
+    if(s_storage.profiling_enabled_)
+        partition.sort_time =
+            float(std::chrono::duration_cast<std::chrono::nanoseconds>(sort_clock.get_elapsed_time()).count()) / 1000.f;
+
+    // Resolve pages and unroll dependencies. Page lookups only read the storage, and commands are read
+    // through a private cursor, so partitions sharing a page can be decoded concurrently.
+    partition.packets.resize(entries.size());
+    for(std::size_t ii = 0; ii < entries.size(); ++ii)
     {
-        auto&& [key, cmd] = command_buffer_.entries[ii];
+        auto&& [key, source] = entries[ii];
+        auto& command_storage = command_buffers_[source.buffer].storage;
+        auto& packet = partition.packets[ii];
+        packet.key = key;
+        packet.page = &command_storage.page_of(source.cmd);
+        packet.first_dependency = uint32_t(partition.dependencies.size());
+        packet.dependency_count = 0;
+
+        CommandReader reader(source.cmd);
+        reader.read(&packet.type);
+        if(packet.type == uint16_t(DrawCommand::Draw))
+        {
+            reader.read(&packet.dependency_count);
+            for(uint8_t jj = 0; jj < packet.dependency_count; ++jj)
+            {
+                void* dep;
+                reader.read(&dep);
+                partition.dependencies.push_back({dep, &command_storage.page_of(dep)});
+            }
+        }
+        packet.body = reader.head();
+    }
+}
+
+static void dispatch_draw_command(const DrawPacket& packet, const DependencyPacket* dependencies)
+{
+#if W_RC_PROFILE_DRAW_CALLS
+    if(s_storage.draw_call_data.tracking)
+        s_storage.draw_call_data.on_dispatch(packet.key);
+#endif
+
+    // If type is a draw call, dispatch dependencies first. They were unrolled when the partition was prepared.
+    if(packet.type == uint16_t(DrawCommand::Draw))
+    {
+        if(s_storage.profiling_enabled_)
+        {
+            s_storage.pass_profiler_.begin_dependencies();
+            s_storage.pass_profiler_.count_draw_call();
+        }
+        for(uint8_t jj = 0; jj < packet.dependency_count; ++jj)
+        {
+            auto& dep_storage = *dependencies[jj].page;
+            dep_storage.seek(dependencies[jj].cmd);
+            uint16_t dep_type;
+            dep_storage.read(&dep_type);
+            // Skip uploads of the content a buffer already holds
+            if(!s_storage.upload_cache_.is_redundant(dep_type, dep_storage))
+                gfx::backend->dispatch_draw(dep_type, dep_storage);
+        }
+        if(s_storage.profiling_enabled_)
+            s_storage.pass_profiler_.end_dependencies();
+    }
+
+    packet.page->seek(packet.body);
+    gfx::backend->dispatch_draw(packet.type, *packet.page);
+}
 
-        // k_skip is the max key value possible, so if we arrive here, simply break out of the loop
-        if(key == SortKey::k_skip)
-            break;
+bool DrawMerger::decode(const DrawPacket& packet, const DependencyPacket* dependencies, DrawInfo& info) const
+{
+    if(packet.type != uint16_t(DrawCommand::Draw))
+        return false;
+
+    info.dependency_count = packet.dependency_count;
+    auto& storage = *packet.page;
+    storage.seek(packet.body);
+
+    DrawCall::DrawCallType dc_type;
+    storage.read(&dc_type);
+    storage.read(&info.data);
+    if(dc_type != DrawCall::Indexed || info.dependency_count == 0 || info.data.shader.index() >= targets_.capacity() ||
+       targets_[info.data.shader.index()].capacity == 0)
+        return false;
+
+    storage.read(&info.texture_count);
+    for(uint8_t ii = 0; ii < info.texture_count; ++ii)
+        storage.read(&info.textures[ii]);
+    storage.read(&info.cubemap_count);
+    for(uint8_t ii = 0; ii < info.cubemap_count; ++ii)
+        storage.read(&info.cubemaps[ii]);
+
+    // Only UBO updates of known size can be packed as instance data
+    info.stride = 0;
+    for(uint8_t ii = 0; ii < info.dependency_count; ++ii)
+    {
+        auto& dep_storage = *dependencies[ii].page;
+        dep_storage.seek(dependencies[ii].cmd);
+        uint16_t dep_type;
+        dep_storage.read(&dep_type);
+        if(dep_type != uint16_t(DrawCommand::UpdateUniformBuffer))
+            return false;
+        dep_storage.read(&info.UBOs[ii]);
+        dep_storage.read(&info.sizes[ii]);
+        dep_storage.read(&info.payloads[ii]);
+        if(info.sizes[ii] == 0)
+            return false;
+        info.stride += (info.sizes[ii] + k_instance_alignment - 1) & ~(k_instance_alignment - 1);
+    }
+
+    return info.stride <= targets_[info.data.shader.index()].capacity;
+}
+
+bool DrawMerger::is_compatible(const DrawInfo& first, const DrawInfo& other)
+{
+    if(memcmp(&first.data, &other.data, sizeof(DrawCall::Data)) || first.texture_count != other.texture_count ||
+       first.cubemap_count != other.cubemap_count || first.dependency_count != other.dependency_count)
+        return false;
+
+    for(uint8_t ii = 0; ii < first.texture_count; ++ii)
+        if(first.textures[ii] != other.textures[ii])
+            return false;
+    for(uint8_t ii = 0; ii < first.cubemap_count; ++ii)
+        if(first.cubemaps[ii] != other.cubemaps[ii])
+            return false;
+    for(uint8_t ii = 0; ii < first.dependency_count; ++ii)
+        if(first.UBOs[ii] != other.UBOs[ii] || first.sizes[ii] != other.sizes[ii])
+            return false;
+
+    return true;
+}
+
+void DrawMerger::push(const DrawPacket& packet, const DependencyPacket* dependencies)
+{
+    DrawInfo info;
+    if(!enabled_ || !decode(packet, dependencies, info))
+    {
+        flush();
+        dispatch_draw_command(packet, dependencies);
+        return;
+    }
+
+    // A run is broken by any difference in state, and by the instance buffer capacity
+    if(!run_.empty() && (!is_compatible(head_, info) ||
+                         instance_data_.size() + info.stride > targets_[info.data.shader.index()].capacity))
+        flush();
+
+    if(run_.empty())
+        head_ = info;
+
+    // Pack UBO payloads in dependency order, each one aligned like an std430 struct member
+    std::size_t offset = instance_data_.size();
+    instance_data_.resize(offset + info.stride, 0);
+    for(uint8_t ii = 0; ii < info.dependency_count; ++ii)
+    {
+        memcpy(instance_data_.data() + offset, info.payloads[ii], info.sizes[ii]);
+        offset += (info.sizes[ii] + k_instance_alignment - 1) & ~(k_instance_alignment - 1);
+    }
+    run_.push_back({&packet, dependencies});
+}
+
+void DrawMerger::flush()
+{
+    if(run_.empty())
+        return;
 
+    if(run_.size() == 1)
+    {
+        dispatch_draw_command(*run_[0].packet, run_[0].dependencies);
+    }
+    else
+    {
 #if W_RC_PROFILE_DRAW_CALLS
         if(s_storage.draw_call_data.tracking)
-            s_storage.draw_call_data.on_dispatch(key);
+            for(const auto& candidate : run_)
+                s_storage.draw_call_data.on_dispatch(candidate.packet->key);
 #endif
-        command_buffer_.storage.seek(cmd);
+        const auto& target = targets_[head_.data.shader.index()];
+
+        // Instance buffer update, followed by an instanced draw call using the instanced shader variant
+        commands_.reset();
+        uint32_t size = uint32_t(instance_data_.size());
+        void* data = instance_data_.data();
+        commands_.write(&target.instance_buffer);
+        commands_.write(&size);
+        commands_.write(&data);
+
+        DrawCall::DrawCallType dc_type = DrawCall::IndexedInstanced;
+        DrawCall::Data dc_data = head_.data;
+        dc_data.shader = target.instanced_shader;
+        uint32_t instance_count = uint32_t(run_.size());
+        commands_.write(&dc_type);
+        commands_.write(&dc_data);
+        commands_.write(&head_.texture_count);
+        for(uint8_t ii = 0; ii < head_.texture_count; ++ii)
+            commands_.write(&head_.textures[ii]);
+        commands_.write(&head_.cubemap_count);
+        for(uint8_t ii = 0; ii < head_.cubemap_count; ++ii)
+            commands_.write(&head_.cubemaps[ii]);
+        commands_.write(&instance_count);
+
+        commands_.reset();
+        gfx::backend->dispatch_draw(uint16_t(DrawCommand::UpdateShaderStorageBuffer), commands_);
+        gfx::backend->dispatch_draw(uint16_t(DrawCommand::Draw), commands_);
+        if(s_storage.profiling_enabled_)
+            s_storage.pass_profiler_.count_draw_call();
+        s_storage.upload_cache_.invalidate(target.instance_buffer);
+        merged_count_ += instance_count - 1;
+    }
 
-        uint16_t type;
-        command_buffer_.storage.read(&type);
+    run_.clear();
+    instance_data_.clear();
+}
+
+void PassProfiler::begin_frame(const RenderQueue& queue)
+{
+    queue_ = &queue;
+    passes_.clear();
+    in_pass_ = false;
+    active_ = true;
+    GPU_timer_->begin_frame();
+}
+
+void PassProfiler::begin_pass(uint8_t layer_id)
+{
+    if(!active_)
+        return;
+    end_pass();
+    passes_.push_back({});
+    passes_.back().layer_id = layer_id;
+    passes_.back().name = queue_->get_layer_name(layer_id);
+    dependency_time_ = std::chrono::nanoseconds(0);
+    draw_call_count_ = 0;
+    in_pass_ = true;
+    GPU_timer_->begin_pass(layer_id);
+    pass_clock_.restart();
+}
 
-        // If type is a draw call, unroll and dispatch dependencies first
-        if(type == uint16_t(DrawCommand::Draw))
+void PassProfiler::end_pass()
+{
+    if(!in_pass_)
+        return;
+    auto& pass = passes_.back();
+    pass.CPU_dispatch_time =
+        float(std::chrono::duration_cast<std::chrono::nanoseconds>(pass_clock_.get_elapsed_time()).count()) / 1000.f;
+    pass.CPU_dependency_time = float(dependency_time_.count()) / 1000.f;
+    pass.draw_call_count = draw_call_count_;
+    in_pass_ = false;
+}
+
+void PassProfiler::end_frame(Renderer::Statistics& stats)
+{
+    if(!active_)
+        return;
+    active_ = false;
+    end_pass();
+    GPU_timer_->end_frame();
+
+    // Never wait for the GPU: keep the last known times of each layer id
+    if(GPU_timer_->collect(GPU_times_))
+        for(auto&& [layer_id, duration] : GPU_times_)
+            last_GPU_times_[layer_id] = float(duration.count()) / 1000.f;
+    for(auto& pass : passes_)
+        pass.GPU_time = last_GPU_times_[pass.layer_id];
+
+    stats.passes = passes_;
+}
+
+void RenderQueue::flush()
+{
+    W_PROFILE_RENDER_FUNCTION()
+    // Set clear color
+    gfx::backend->set_clear_color(clear_color_.r, clear_color_.g, clear_color_.b, clear_color_.a);
+
+    // Partitions are sorted by view, and views by layer id
+    uint32_t current_layer_id = 256;
+    for(uint32_t ii = 0; ii < partition_count_; ++ii)
+    {
+        const auto& partition = partitions_[ii];
+
+        // Draw calls are not merged across passes, so that pass timings are accurate
+        uint8_t layer_id = uint8_t(partition.view >> 8);
+        if(layer_id != current_layer_id)
         {
-            uint8_t dependency_count;
-            static void* deps[k_max_draw_call_dependencies];
-            command_buffer_.storage.read(&dependency_count);
-            for(uint8_t jj = 0; jj < dependency_count; ++jj)
-                command_buffer_.storage.read(&deps[jj]);
-
-            void* ret = command_buffer_.storage.head();
-            for(uint8_t jj = 0; jj < dependency_count; ++jj)
+            s_storage.draw_merger_.flush();
+            if(s_storage.profiling_enabled_)
+                s_storage.pass_profiler_.begin_pass(layer_id);
+            current_layer_id = layer_id;
+        }
+        if(s_storage.profiling_enabled_)
+            s_storage.pass_profiler_.add_sort_time(partition.sort_time);
+
+        for(const auto& packet : partition.packets)
+            s_storage.draw_merger_.push(packet, partition.dependencies.data() + packet.first_dependency);
+    }
+    s_storage.draw_merger_.flush();
+}
+
+// Write relocated command data to a command buffer, see Renderer::replay()
+static void* write_replayed_command(CommandBuffer& cmdbuf, uint16_t type, uint64_t key,
+                                    const std::vector<uint8_t>& data)
+{
+    cmdbuf.storage.begin_command();
+    cmdbuf.storage.write(&type);
+    for(uint8_t byte : data)
+        cmdbuf.storage.write(&byte);
+    cmdbuf.push(key);
+    return cmdbuf.entries.back().second;
+}
+
+void RenderQueue::capture(FrameCapture& capture, std::vector<std::vector<CapturedCommand>>& buffers)
+{
+    buffers.resize(buffer_count_);
+    for(uint32_t ii = 0; ii < buffer_count_; ++ii)
+    {
+        auto& cmdbuf = command_buffers_[ii];
+        // Draw calls reference their dependencies by address
+        std::map<void*, uint32_t> heads;
+        for(uint32_t jj = 0; jj < cmdbuf.entries.size(); ++jj)
+            heads[cmdbuf.entries[jj].second] = jj;
+
+        buffers[ii].resize(cmdbuf.entries.size());
+        for(uint32_t jj = 0; jj < cmdbuf.entries.size(); ++jj)
+        {
+            auto&& [key, cmd] = cmdbuf.entries[jj];
+            auto& storage = cmdbuf.storage.page_of(cmd);
+            storage.seek(cmd);
+            uint16_t type;
+            storage.read(&type);
+            capture.read_draw_command(type, key, storage, heads, buffers[ii][jj]);
+        }
+    }
+}
+
+void RenderQueue::replay(const std::vector<std::vector<CapturedCommand>>& buffers, FrameReplayer& replayer)
+{
+    std::vector<uint8_t> data;
+    for(size_t ii = 0; ii < buffers.size(); ++ii)
+    {
+        // Buffers captured with more recording threads than available are merged into the last one
+        auto& cmdbuf = command_buffers_[std::min(uint32_t(ii), buffer_count_ - 1)];
+        std::vector<void*> heads;
+        heads.reserve(buffers[ii].size());
+        for(const auto& command : buffers[ii])
+        {
+            void* head = nullptr;
+            if(replayer.relocate(command, *cmdbuf.arena, heads, data))
             {
-                command_buffer_.storage.seek(deps[jj]);
-                uint16_t dep_type;
-                command_buffer_.storage.read(&dep_type);
-                gfx::backend->dispatch_draw(dep_type, command_buffer_.storage);
+                head = write_replayed_command(cmdbuf, command.type, command.key, data);
+                if(command.type == uint16_t(DrawCommand::Draw) && s_storage.profiling_enabled_)
+                    ++cmdbuf.draw_call_count;
             }
-            command_buffer_.storage.seek(ret);
+            heads.push_back(head);
         }
-
-        gfx::backend->dispatch_draw(type, command_buffer_.storage);
     }
 }
 
@@ -314,8 +1371,9 @@ class RenderCommandWriter
 {
 public:
     explicit RenderCommandWriter(RenderCommand type)
-        : type_(type), cmdbuf_(get_command_buffer(type_)), head_(cmdbuf_.storage.head())
+        : type_(type), cmdbuf_(get_command_buffer(type_))
     {
+        cmdbuf_.storage.begin_command();
         cmdbuf_.storage.write(&type_);
     }
 
@@ -324,9 +1382,8 @@ public:
 
     inline void submit()
     {
-        K_ASSERT_FMT(!cmdbuf_.is_full(), "Command buffer %d is full!", int(type_));
-        uint64_t key = uint64_t(cmdbuf_.count);
-        cmdbuf_.entries[cmdbuf_.count++] = {key, head_};
+        uint64_t key = uint64_t(cmdbuf_.entries.size());
+        cmdbuf_.push(key);
     }
 
 private:
@@ -341,9 +1398,9 @@ private:
         switch(phase)
         {
         case Phase::Pre:
-            return s_storage.pre_buffer_;
+            return s_storage.recording().pre_buffer_;
         case Phase::Post:
-            return s_storage.post_buffer_;
+            return s_storage.recording().post_buffer_;
         }
     }
 
@@ -356,7 +1413,6 @@ private:
 private:
     RenderCommand type_;
     RenderCommandBuffer& cmdbuf_;
-    void* head_;
 };
 
 // Helper class for draw command buffer access
@@ -364,25 +1420,26 @@ class DrawCommandWriter
 {
 public:
     explicit DrawCommandWriter(DrawCommand type)
-        : type_(type), cmdbuf_(s_storage.queue_.command_buffer_), head_(cmdbuf_.storage.head())
+        : type_(type), cmdbuf_(s_storage.recording().queue_.get_command_buffer())
     {
+        K_ASSERT(s_storage.recording_slots_.is_recording_thread(),
+                 "Draw command submitted from a thread that is not bound to a command buffer.");
+        cmdbuf_.storage.begin_command();
         cmdbuf_.storage.write(&type_);
     }
 
     template <typename T> inline void write(T* source) { cmdbuf_.storage.write(source); }
     inline void write_str(const std::string& str) { cmdbuf_.storage.write_str(str); }
+    // Dependencies are always recorded to the same buffer as the draw command that references them
+    inline void* get_dependency(uint32_t token) const { return cmdbuf_.entries[token].second; }
+    inline Renderer::AuxArena& get_arena() { return *cmdbuf_.arena; }
+    inline void count_draw_call() { ++cmdbuf_.draw_call_count; }
 
-    inline uint32_t submit(uint64_t key)
-    {
-        K_ASSERT(!cmdbuf_.is_full(), "Render queue is full!");
-        cmdbuf_.entries[cmdbuf_.count] = {key, head_};
-        return uint32_t(cmdbuf_.count++);
-    }
+    inline uint32_t submit(uint64_t key) { return cmdbuf_.push(key); }
 
 private:
     DrawCommand type_;
     DrawCommandBuffer& cmdbuf_;
-    void* head_;
 };
 
 void Renderer::init(memory::HeapArea& area)
@@ -407,6 +1464,9 @@ void Renderer::init(memory::HeapArea& area)
     case "opengl"_h:
         gfx::set_backend(GfxAPI::OpenGL);
         break;
+    case "null"_h:
+        gfx::set_backend(GfxAPI::None);
+        break;
     default: {
         KLOGF("render") << "Non recognized renderer backend string: "
                         << CFG_.get<std::string>("erwin.renderer.backend"_h, "OpenGL") << std::endl;
@@ -415,6 +1475,18 @@ void Renderer::init(memory::HeapArea& area)
     }
 
     s_storage.query_timer = QueryTimer::create();
+    s_storage.pass_profiler_.init();
+
+    // Queue partitions are sorted and decoded by worker threads, the flushing thread takes part
+    uint32_t max_flush_threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    s_storage.flush_workers_.spawn(
+        std::min(CFG_.get<uint32_t>("erwin.renderer.flush_threads"_h, 3), max_flush_threads));
+
+    // Frames can be captured from startup, so that the capture holds every resource creation command
+    uint32_t capture_frames = CFG_.get<uint32_t>("erwin.renderer.capture_frames"_h, 0);
+    if(capture_frames > 0)
+        s_storage.frame_capture_.open(CFG_.get<std::string>("erwin.renderer.capture_path"_h, "capture.erwc"),
+                                      capture_frames);
 
     KLOGI << "done" << std::endl;
 
@@ -436,9 +1508,12 @@ void Renderer::shutdown()
         return;
     }
 
+    kill_render_thread();
     flush();
     KLOGN("render") << "[Renderer] Releasing renderer storage." << std::endl;
 
+    s_storage.flush_workers_.kill();
+    s_storage.pass_profiler_.release();
     gfx::backend->release();
 
     s_storage.release();
@@ -447,16 +1522,35 @@ void Renderer::shutdown()
     KLOGI << "done" << std::endl;
 }
 
-uint8_t Renderer::next_layer_id()
+uint8_t Renderer::next_layer_id(hash_t name)
 {
-    K_ASSERT(s_storage.queue_.current_view_id_ < 255, "View id overflow.");
-    return s_storage.queue_.current_view_id_++;
+    auto& queue = s_storage.recording().queue_;
+    K_ASSERT(queue.current_view_id_ < 255, "View id overflow.");
+    queue.layer_names_[queue.current_view_id_] = name;
+    return queue.current_view_id_++;
 }
 
-Renderer::AuxArena& Renderer::get_arena() { return s_storage.auxiliary_arena_; }
+Renderer::AuxArena& Renderer::get_arena() { return *s_storage.recording().queue_.get_command_buffer().arena; }
+
+size_t Renderer::get_arena_size() { return s_storage.recording().queue_.get_command_buffer().arena_size; }
+
+void Renderer::report_culling(uint32_t visible_count, uint32_t culled_count, uint32_t occluded_count)
+{
+    auto& frame = s_storage.recording();
+    frame.visible_count_.fetch_add(visible_count, std::memory_order_relaxed);
+    frame.culled_count_.fetch_add(culled_count, std::memory_order_relaxed);
+    frame.occluded_count_.fetch_add(occluded_count, std::memory_order_relaxed);
+}
+
+bool Renderer::bind_recording_thread() { return s_storage.recording_slots_.bind(); }
+
+void Renderer::unbind_recording_thread() { s_storage.recording_slots_.unbind(); }
 
 #ifdef W_DEBUG
-void Renderer::set_profiling_enabled(bool value) { s_storage.profiling_enabled_ = value; }
+void Renderer::set_profiling_enabled(bool value)
+{
+    s_storage.profiling_requested_.store(value, std::memory_order_relaxed);
+}
 
 const Renderer::Statistics& Renderer::get_stats() { return s_storage.stats[BACK]; }
 #endif
@@ -469,30 +1563,168 @@ void Renderer::track_draw_calls(const fs::path& json_path)
 #endif
 }
 
+void Renderer::enable_draw_merging(ShaderHandle shader, ShaderHandle instanced_shader,
+                                   ShaderStorageBufferHandle instance_buffer, uint32_t instance_buffer_size)
+{
+    K_ASSERT(shader.is_valid(), "Invalid ShaderHandle!");
+    K_ASSERT(instanced_shader.is_valid(), "Invalid ShaderHandle!");
+    K_ASSERT(instance_buffer.is_valid(), "Invalid ShaderStorageBufferHandle!");
+
+    // Merging happens during submission, on the thread that owns the graphics context
+    DrawMerger::Target target{instanced_shader, instance_buffer, instance_buffer_size};
+    enqueue_task([shader, target]() { s_storage.draw_merger_.set_target(shader, target); });
+}
+
+void Renderer::disable_draw_merging(ShaderHandle shader)
+{
+    K_ASSERT(shader.is_valid(), "Invalid ShaderHandle!");
+    enqueue_task([shader]() { s_storage.draw_merger_.remove_target(shader); });
+}
+
+void Renderer::capture_frames(const fs::path& path, uint32_t frame_count)
+{
+    // The capture starts with the frame being recorded, it is the next one the render thread submits
+    enqueue_task([path, frame_count]() { s_storage.frame_capture_.open(path, frame_count); });
+}
+
+// Replayed commands go through the same handle bookkeeping as the commands of the immediate API.
+// Command data starts with the handle of the resource, see the Renderer::create_*() and destroy() functions.
+static void track_replayed_command(uint16_t type, const std::vector<uint8_t>& data)
+{
+    size_t offset = 0;
+    auto read = [&data, &offset](auto& value) {
+        std::memcpy(&value, data.data() + offset, sizeof(value));
+        offset += sizeof(value);
+    };
+    auto release = [&read](auto handle) {
+        read(handle);
+        handle.release();
+    };
+
+    switch(RenderCommand(type))
+    {
+    case RenderCommand::CreateVertexArray: {
+        VertexArrayHandle handle;
+        IndexBufferHandle ib;
+        VertexBufferHandle vb;
+        read(handle);
+        read(ib);
+        read(vb);
+        register_vertex_array(handle, {vb}, ib);
+        break;
+    }
+    case RenderCommand::CreateVertexArrayMultipleVBO: {
+        VertexArrayHandle handle;
+        IndexBufferHandle ib;
+        uint8_t VBO_count;
+        read(handle);
+        read(ib);
+        read(VBO_count);
+        std::vector<VertexBufferHandle> vbs(VBO_count);
+        for(auto& vb : vbs)
+            read(vb);
+        register_vertex_array(handle, vbs, ib);
+        break;
+    }
+    case RenderCommand::DestroyIndexBuffer:
+        release(IndexBufferHandle{});
+        break;
+    case RenderCommand::DestroyVertexBufferLayout:
+        release(VertexBufferLayoutHandle{});
+        break;
+    case RenderCommand::DestroyVertexBuffer:
+        release(VertexBufferHandle{});
+        break;
+    case RenderCommand::DestroyVertexArray: {
+        VertexArrayHandle handle;
+        read(handle);
+        release_vertex_array(handle);
+        break;
+    }
+    case RenderCommand::DestroyUniformBuffer:
+        release(UniformBufferHandle{});
+        break;
+    case RenderCommand::DestroyShaderStorageBuffer:
+        release(ShaderStorageBufferHandle{});
+        break;
+    case RenderCommand::DestroyShader:
+        release(ShaderHandle{});
+        break;
+    case RenderCommand::DestroyTexture2D:
+        release(TextureHandle{});
+        break;
+    case RenderCommand::DestroyCubemap:
+        release(CubemapHandle{});
+        break;
+    case RenderCommand::DestroyFramebuffer: {
+        FramebufferHandle handle;
+        bool detach_textures;
+        read(handle);
+        read(detach_textures);
+        release_framebuffer(handle, detach_textures);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void Renderer::replay(const CapturedFrame& frame, FrameReplayer& replayer, bool draw_only)
+{
+    FrameStorage& recording = s_storage.recording();
+    std::vector<uint8_t> data;
+    const std::vector<void*> no_dependency;
+
+    auto replay_render_commands = [&](const std::vector<CapturedCommand>& commands, RenderCommandBuffer& cmdbuf) {
+        for(const auto& command : commands)
+        {
+            // Screenshots are not replayed, they would be written to disk again
+            if(command.type == uint16_t(RenderCommand::FramebufferScreenshot))
+                continue;
+            if(replayer.relocate(command, recording.auxiliary_arena_, no_dependency, data))
+            {
+                track_replayed_command(command.type, data);
+                write_replayed_command(cmdbuf, command.type, command.key, data);
+            }
+        }
+    };
+
+    if(!draw_only)
+        replay_render_commands(frame.pre_buffer, recording.pre_buffer_);
+    recording.queue_.replay(frame.queue, replayer);
+    if(!draw_only)
+        replay_render_commands(frame.post_buffer, recording.post_buffer_);
+}
+
 FramebufferHandle Renderer::default_render_target() { return gfx::backend->default_render_target(); }
 
 TextureHandle Renderer::get_framebuffer_texture(FramebufferHandle handle, uint32_t index)
 {
+    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
     return gfx::backend->get_framebuffer_texture(handle, index);
 }
 
 CubemapHandle Renderer::get_framebuffer_cubemap(FramebufferHandle handle)
 {
+    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
     return gfx::backend->get_framebuffer_cubemap(handle);
 }
 
 hash_t Renderer::get_framebuffer_texture_name(FramebufferHandle handle, uint32_t index)
 {
+    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
     return gfx::backend->get_framebuffer_texture_name(handle, index);
 }
 
 uint32_t Renderer::get_framebuffer_texture_count(FramebufferHandle handle)
 {
+    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
     return gfx::backend->get_framebuffer_texture_count(handle);
 }
 
 void* Renderer::get_native_texture_handle(TextureHandle handle)
 {
+    K_ASSERT(handle.is_valid(), "Invalid TextureHandle.");
     return gfx::backend->get_native_texture_handle(handle);
 }
 
@@ -503,6 +1735,7 @@ VertexBufferLayoutHandle Renderer::create_vertex_buffer_layout(const std::vector
 
 const BufferLayout& Renderer::get_vertex_buffer_layout(VertexBufferLayoutHandle handle)
 {
+    K_ASSERT(handle.is_valid(), "Invalid VertexBufferLayoutHandle!");
     return gfx::backend->get_vertex_buffer_layout(handle);
 }
 
@@ -524,38 +1757,53 @@ static void flush_command_buffer(RenderCommandBuffer& cmdbuf)
     W_PROFILE_RENDER_FUNCTION()
 
     // Dispatch render commands in specified command buffer
-    for(size_t ii = 0; ii < cmdbuf.count; ++ii)
+    for(auto&& [key, cmd] : cmdbuf.entries)
     {
-        auto&& [key, cmd] = cmdbuf.entries[ii];
-        cmdbuf.storage.seek(cmd);
+        auto& storage = cmdbuf.storage.page_of(cmd);
+        storage.seek(cmd);
         uint16_t type;
-        cmdbuf.storage.read(&type);
-        gfx::backend->dispatch_command(type, cmdbuf.storage);
+        storage.read(&type);
+        gfx::backend->dispatch_command(type, storage);
     }
     cmdbuf.reset();
 }
 
-static void sort_commands()
+// Serialize all the commands recorded in a frame, before they are sorted
+static void capture_frame(FrameStorage& frame)
 {
     W_PROFILE_RENDER_FUNCTION()
-    // Keys stored separately from commands to avoid touching data too
-    // much during sort calls
-    std::sort(std::begin(s_storage.pre_buffer_.entries),
-              std::begin(s_storage.pre_buffer_.entries) + s_storage.pre_buffer_.count,
-              [&](const RenderCommandBuffer::Entry& item1, const RenderCommandBuffer::Entry& item2) {
-                  return item1.first < item2.first;
-              });
-    std::sort(std::begin(s_storage.post_buffer_.entries),
-              std::begin(s_storage.post_buffer_.entries) + s_storage.post_buffer_.count,
-              [&](const RenderCommandBuffer::Entry& item1, const RenderCommandBuffer::Entry& item2) {
-                  return item1.first < item2.first;
-              });
+
+    auto& capture = s_storage.frame_capture_;
+    auto capture_render_commands = [&capture](RenderCommandBuffer& cmdbuf, std::vector<CapturedCommand>& commands) {
+        commands.resize(cmdbuf.entries.size());
+        for(size_t ii = 0; ii < cmdbuf.entries.size(); ++ii)
+        {
+            auto&& [key, cmd] = cmdbuf.entries[ii];
+            auto& storage = cmdbuf.storage.page_of(cmd);
+            storage.seek(cmd);
+            uint16_t type;
+            storage.read(&type);
+            capture.read_render_command(type, key, storage, commands[ii]);
+        }
+    };
+
+    CapturedFrame captured;
+    capture_render_commands(frame.pre_buffer_, captured.pre_buffer);
+    frame.queue_.capture(capture, captured.queue);
+    capture_render_commands(frame.post_buffer_, captured.post_buffer);
+    capture.write(captured);
 }
 
-void Renderer::flush()
+// Sort and dispatch all the commands recorded in a frame, on the thread that owns the graphics context
+static void submit_frame(FrameStorage& frame)
 {
     W_PROFILE_RENDER_FUNCTION()
+    if(s_storage.frame_capture_.is_open())
+        capture_frame(frame);
+
     static kb::nanoClock flush_clock;
+    static kb::nanoClock sort_clock;
+    s_storage.profiling_enabled_ = frame.profiling_;
     if(s_storage.profiling_enabled_)
     {
         s_storage.query_timer->start();
@@ -563,17 +1811,52 @@ void Renderer::flush()
     }
 
     // Sort command buffers
-    sort_commands();
+    frame.pre_buffer_.sort(frame.auxiliary_arena_);
+    frame.post_buffer_.sort(frame.auxiliary_arena_);
     // Dispatch pre buffer commands
-    flush_command_buffer(s_storage.pre_buffer_);
-    // Sort, flush and reset queue
-    s_storage.queue_.sort();
-    s_storage.queue_.flush();
-    s_storage.queue_.reset();
+    flush_command_buffer(frame.pre_buffer_);
+    // Sort, merge, flush and reset queue
+    if(s_storage.profiling_enabled_)
+        sort_clock.restart();
+    frame.queue_.sort(s_storage.flush_workers_);
+    if(s_storage.profiling_enabled_)
+    {
+        s_storage.stats[FRONT].CPU_sort_time =
+            float(std::chrono::duration_cast<std::chrono::microseconds>(sort_clock.get_elapsed_time()).count());
+        s_storage.pass_profiler_.begin_frame(frame.queue_);
+    }
+    s_storage.draw_merger_.reset_merged_count();
+    s_storage.upload_cache_.reset();
+    frame.queue_.flush();
+    if(s_storage.profiling_enabled_)
+    {
+        s_storage.pass_profiler_.end_frame(s_storage.stats[FRONT]);
+        s_storage.stats[FRONT].draw_call_count = frame.queue_.get_draw_call_count();
+        s_storage.stats[FRONT].merged_draw_call_count = s_storage.draw_merger_.get_merged_count();
+        s_storage.stats[FRONT].dependency_upload_hits = s_storage.upload_cache_.get_hits();
+        s_storage.stats[FRONT].dependency_upload_misses = s_storage.upload_cache_.get_misses();
+        s_storage.stats[FRONT].visible_count = frame.visible_count_;
+        s_storage.stats[FRONT].culled_count = frame.culled_count_;
+        s_storage.stats[FRONT].occluded_count = frame.occluded_count_;
+    }
+    frame.visible_count_ = 0;
+    frame.culled_count_ = 0;
+    frame.occluded_count_ = 0;
+    frame.queue_.reset();
     // Dispatch post buffer commands
-    flush_command_buffer(s_storage.post_buffer_);
-    // Reset auxiliary memory arena for next frame
-    s_storage.auxiliary_arena_.reset();
+    flush_command_buffer(frame.post_buffer_);
+    // State counters are reset by the backend at the end of the frame
+    const auto& counters = gfx::backend->get_state_counters();
+    if(s_storage.profiling_enabled_)
+        s_storage.stats[FRONT].state_counters = counters;
+    W_PROFILE_RENDER_COUNTERS("State changes", {"changes", counters.state_changes}, {"hits", counters.state_hits})
+    W_PROFILE_RENDER_COUNTERS("Binds", {"shader", counters.shader_binds}, {"texture", counters.texture_binds},
+                              {"cubemap", counters.cubemap_binds}, {"VAO", counters.VAO_binds})
+    W_PROFILE_RENDER_COUNTERS("Bind hits", {"shader", counters.shader_hits}, {"texture", counters.texture_hits},
+                              {"cubemap", counters.cubemap_hits}, {"VAO", counters.VAO_hits})
+    gfx::backend->end_frame();
+    // Reset auxiliary memory arena, frame data can now be recorded to again
+    frame.auxiliary_arena_.reset();
     // BUGFIX: Avoids a nasty bug where multiple framebuffers will have garbage size
     // if nothing gets drawn to the default framebuffer when using ImGui::Docking / OpenGL
     // This solves the problem, but I'm still not completely sure why.
@@ -593,11 +1876,77 @@ void Renderer::flush()
         s_storage.stats[FRONT].CPU_flush_time =
             float(std::chrono::duration_cast<std::chrono::microseconds>(CPU_flush_duration).count());
     }
+}
+
+void Renderer::flush()
+{
+    W_PROFILE_RENDER_FUNCTION()
+
+    FrameStorage& frame = s_storage.recording();
+    if(s_storage.render_thread_.is_running())
+    {
+        // Wait for the previous frame to be submitted, its data is going to be recorded to next.
+        // Statistics are only written by the render thread during submission, so they can be swapped now.
+        s_storage.render_thread_.sync();
+        std::swap(FRONT, BACK);
+        // Submission is kicked by present(), after the tasks that depend on this frame are enqueued
+        s_storage.render_thread_.enqueue([&frame]() { submit_frame(frame); });
+    }
+    else
+    {
+        submit_frame(frame);
+        std::swap(FRONT, BACK);
+    }
+
+    s_storage.recording_frame_ ^= 1;
+    // The frame to record was submitted already, a toggle only affects whole frames
+    s_storage.recording().profiling_ = s_storage.profiling_requested_.load(std::memory_order_relaxed);
 
-    std::swap(FRONT, BACK);
-    s_storage.stats[FRONT].draw_call_count = 0;
+// Retired handle indices and geometry ranges become available again
+#define DO_ACTION(HANDLE_NAME) HANDLE_NAME::s_ppool_->next_frame();
+    FOR_ALL_HANDLES
+#undef DO_ACTION
+    GeometryPool::next_frame();
+}
+
+void Renderer::enqueue_task(std::function<void()>&& task)
+{
+    if(s_storage.render_thread_.is_running())
+        s_storage.render_thread_.enqueue(std::move(task));
+    else
+        task();
 }
 
+void Renderer::present()
+{
+    W_PROFILE_RENDER_FUNCTION()
+
+    const GFXContext& context = Application::get_instance().get_window().get_context();
+    enqueue_task([&context]() { context.swap_buffers(); });
+    if(s_storage.render_thread_.is_running())
+        s_storage.render_thread_.flush();
+}
+
+void Renderer::spawn_render_thread()
+{
+    if(s_storage.render_thread_.is_running())
+        return;
+
+    // Everything recorded so far (resource creation during init) is submitted on this thread
+    flush();
+    s_storage.render_thread_.spawn(Application::get_instance().get_window().get_context());
+}
+
+void Renderer::kill_render_thread()
+{
+    if(!s_storage.render_thread_.is_running())
+        return;
+
+    s_storage.render_thread_.kill();
+}
+
+bool Renderer::has_render_thread() { return s_storage.render_thread_.is_running(); }
+
 /*
            _____                                          _
           / ____|                                        | |
@@ -616,7 +1965,7 @@ IndexBufferHandle Renderer::create_index_buffer(const uint32_t* index_data, uint
     uint32_t* auxiliary = nullptr;
     if(index_data)
     {
-        auxiliary = K_NEW_ARRAY_DYNAMIC(uint32_t, count, s_storage.auxiliary_arena_);
+        auxiliary = K_NEW_ARRAY_DYNAMIC(uint32_t, count, s_storage.recording().auxiliary_arena_);
         memcpy(auxiliary, index_data, count * sizeof(uint32_t));
     }
     else
@@ -645,7 +1994,7 @@ VertexBufferHandle Renderer::create_vertex_buffer(VertexBufferLayoutHandle layou
     float* auxiliary = nullptr;
     if(vertex_data)
     {
-        auxiliary = K_NEW_ARRAY_DYNAMIC(float, count, s_storage.auxiliary_arena_);
+        auxiliary = K_NEW_ARRAY_DYNAMIC(float, count, s_storage.recording().auxiliary_arena_);
         memcpy(auxiliary, vertex_data, count * sizeof(float));
     }
     else
@@ -676,6 +2025,7 @@ VertexArrayHandle Renderer::create_vertex_array(VertexBufferHandle vb, IndexBuff
     cw.write(&vb);
     cw.submit();
 
+    register_vertex_array(handle, {vb}, ib);
     return handle;
 }
 
@@ -697,6 +2047,7 @@ VertexArrayHandle Renderer::create_vertex_array(const std::vector<VertexBufferHa
     }
     cw.submit();
 
+    register_vertex_array(handle, vbs, ib);
     return handle;
 }
 
@@ -709,7 +2060,7 @@ UniformBufferHandle Renderer::create_uniform_buffer(const std::string& name, con
     uint8_t* auxiliary = nullptr;
     if(data)
     {
-        auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.auxiliary_arena_);
+        auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.recording().auxiliary_arena_);
         memcpy(auxiliary, data, size);
     }
     else
@@ -736,7 +2087,7 @@ ShaderStorageBufferHandle Renderer::create_shader_storage_buffer(const std::stri
     uint8_t* auxiliary = nullptr;
     if(data)
     {
-        auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.auxiliary_arena_);
+        auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.recording().auxiliary_arena_);
         memcpy(auxiliary, data, size);
     }
     else
@@ -757,6 +2108,7 @@ ShaderStorageBufferHandle Renderer::create_shader_storage_buffer(const std::stri
 ShaderHandle Renderer::create_shader(const fs::path& filepath, const std::string& name)
 {
     ShaderHandle handle = ShaderHandle::acquire();
+    SortKey::register_shader(handle);
 
     RenderCommandWriter cw(RenderCommand::CreateShader);
     cw.write(&handle);
@@ -826,7 +2178,7 @@ FramebufferHandle Renderer::create_framebuffer(uint32_t width, uint32_t height,
 
     // Allocate auxiliary data
     FramebufferLayoutElement* auxiliary =
-        K_NEW_ARRAY_DYNAMIC_ALIGN(FramebufferLayoutElement, count, s_storage.auxiliary_arena_, 8);
+        K_NEW_ARRAY_DYNAMIC_ALIGN(FramebufferLayoutElement, count, s_storage.recording().auxiliary_arena_, 8);
     memcpy(auxiliary, layout.data(), count * sizeof(FramebufferLayoutElement));
 
     RenderCommandWriter cw(RenderCommand::CreateFramebuffer);
@@ -841,33 +2193,35 @@ FramebufferHandle Renderer::create_framebuffer(uint32_t width, uint32_t height,
     return handle;
 }
 
-void Renderer::update_index_buffer(IndexBufferHandle handle, const uint32_t* data, uint32_t count)
+void Renderer::update_index_buffer(IndexBufferHandle handle, const uint32_t* data, uint32_t count, uint32_t offset)
 {
     K_ASSERT(handle.is_valid(), "Invalid IndexBufferHandle!");
     K_ASSERT(data, "No data!");
 
-    uint32_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint32_t, count, s_storage.auxiliary_arena_);
-    memcpy(auxiliary, data, count);
+    uint32_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint32_t, count, s_storage.recording().auxiliary_arena_);
+    memcpy(auxiliary, data, count * sizeof(uint32_t));
 
     RenderCommandWriter cw(RenderCommand::UpdateIndexBuffer);
     cw.write(&handle);
     cw.write(&count);
     cw.write(&auxiliary);
+    cw.write(&offset);
     cw.submit();
 }
 
-void Renderer::update_vertex_buffer(VertexBufferHandle handle, const void* data, uint32_t size)
+void Renderer::update_vertex_buffer(VertexBufferHandle handle, const void* data, uint32_t size, uint32_t offset)
 {
     K_ASSERT(handle.is_valid(), "Invalid VertexBufferHandle!");
     K_ASSERT(data, "No data!");
 
-    uint8_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.auxiliary_arena_);
+    uint8_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.recording().auxiliary_arena_);
     memcpy(auxiliary, data, size);
 
     RenderCommandWriter cw(RenderCommand::UpdateVertexBuffer);
     cw.write(&handle);
     cw.write(&size);
     cw.write(&auxiliary);
+    cw.write(&offset);
     cw.submit();
 }
 
@@ -876,7 +2230,7 @@ void Renderer::update_uniform_buffer(UniformBufferHandle handle, const void* dat
     K_ASSERT(handle.is_valid(), "Invalid UniformBufferHandle!");
     K_ASSERT(data, "No data!");
 
-    uint8_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.auxiliary_arena_);
+    uint8_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.recording().auxiliary_arena_);
     memcpy(auxiliary, data, size);
 
     RenderCommandWriter cw(RenderCommand::UpdateUniformBuffer);
@@ -891,7 +2245,7 @@ void Renderer::update_shader_storage_buffer(ShaderStorageBufferHandle handle, co
     K_ASSERT(handle.is_valid(), "Invalid ShaderStorageBufferHandle!");
     K_ASSERT(data, "No data!");
 
-    uint8_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.auxiliary_arena_);
+    uint8_t* auxiliary = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.recording().auxiliary_arena_);
     memcpy(auxiliary, data, size);
 
     RenderCommandWriter cw(RenderCommand::UpdateShaderStorageBuffer);
@@ -961,6 +2315,19 @@ std::future<PixelData> Renderer::get_pixel_data(TextureHandle handle)
     return std::move(fut);
 }
 
+std::future<PixelData> Renderer::get_pixel_data(CubemapHandle handle)
+{
+    K_ASSERT(handle.is_valid(), "Invalid CubemapHandle.");
+
+    auto&& [token, fut] = gfx::backend->future_texture_data();
+    RenderCommandWriter cw(RenderCommand::GetCubemapPixelData);
+    cw.write(&handle);
+    cw.write(&token);
+    cw.submit();
+
+    return std::move(fut);
+}
+
 void Renderer::generate_mipmaps(CubemapHandle cubemap)
 {
     K_ASSERT(cubemap.is_valid(), "Invalid CubemapHandle!");
@@ -987,6 +2354,8 @@ void Renderer::destroy(IndexBufferHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyIndexBuffer);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(VertexBufferLayoutHandle handle)
@@ -996,6 +2365,8 @@ void Renderer::destroy(VertexBufferLayoutHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyVertexBufferLayout);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(VertexBufferHandle handle)
@@ -1005,6 +2376,8 @@ void Renderer::destroy(VertexBufferHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyVertexBuffer);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(VertexArrayHandle handle)
@@ -1014,6 +2387,8 @@ void Renderer::destroy(VertexArrayHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyVertexArray);
     cw.write(&handle);
     cw.submit();
+
+    release_vertex_array(handle);
 }
 
 void Renderer::destroy(UniformBufferHandle handle)
@@ -1023,6 +2398,8 @@ void Renderer::destroy(UniformBufferHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyUniformBuffer);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(ShaderStorageBufferHandle handle)
@@ -1032,15 +2409,20 @@ void Renderer::destroy(ShaderStorageBufferHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyShaderStorageBuffer);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(ShaderHandle handle)
 {
     K_ASSERT(handle.is_valid(), "Invalid ShaderHandle!");
+    SortKey::unregister_shader(handle);
 
     RenderCommandWriter cw(RenderCommand::DestroyShader);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(TextureHandle handle)
@@ -1050,6 +2432,8 @@ void Renderer::destroy(TextureHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyTexture2D);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(CubemapHandle handle)
@@ -1059,6 +2443,8 @@ void Renderer::destroy(CubemapHandle handle)
     RenderCommandWriter cw(RenderCommand::DestroyCubemap);
     cw.write(&handle);
     cw.submit();
+
+    handle.release();
 }
 
 void Renderer::destroy(FramebufferHandle handle, bool detach_textures)
@@ -1069,6 +2455,8 @@ void Renderer::destroy(FramebufferHandle handle, bool detach_textures)
     cw.write(&handle);
     cw.write(&detach_textures);
     cw.submit();
+
+    release_framebuffer(handle, detach_textures);
 }
 
 void Renderer::submit(uint64_t key, const DrawCall& dc)
@@ -1084,7 +2472,7 @@ void Renderer::submit(uint64_t key, const DrawCall& dc)
     cw.write(&dc.dependency_count);
     for(uint8_t ii = 0; ii < dc.dependency_count; ++ii)
     {
-        void* ptr = s_storage.queue_.command_buffer_.entries[dc.dependencies[ii]].second;
+        void* ptr = cw.get_dependency(dc.dependencies[ii]);
         cw.write(&ptr);
     }
 
@@ -1098,9 +2486,14 @@ void Renderer::submit(uint64_t key, const DrawCall& dc)
         cw.write(&dc.cubemaps[ii]);
     if(dc.type == DrawCall::IndexedInstanced || dc.type == DrawCall::ArrayInstanced)
         cw.write(&dc.instance_count);
+    else if(dc.type == DrawCall::MultiIndirect)
+    {
+        cw.write(&dc.indirect_buffer);
+        cw.write(&dc.draw_count);
+    }
 
-    if(s_storage.profiling_enabled_)
-        ++s_storage.stats[FRONT].draw_call_count;
+    if(s_storage.recording().profiling_)
+        cw.count_draw_call();
 
     cw.submit(key);
 }
@@ -1143,7 +2536,7 @@ uint32_t Renderer::update_shader_storage_buffer(ShaderStorageBufferHandle handle
 
     if(data && bool(copy))
     {
-        void* data_copy = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.auxiliary_arena_);
+        void* data_copy = K_NEW_ARRAY_DYNAMIC(uint8_t, size, cw.get_arena());
         memcpy(data_copy, data, size);
         cw.write(&data_copy);
     }
@@ -1165,7 +2558,7 @@ uint32_t Renderer::update_uniform_buffer(UniformBufferHandle handle, const void*
 
     if(data && bool(copy))
     {
-        void* data_copy = K_NEW_ARRAY_DYNAMIC(uint8_t, size, s_storage.auxiliary_arena_);
+        void* data_copy = K_NEW_ARRAY_DYNAMIC(uint8_t, size, cw.get_arena());
         memcpy(data_copy, data, size);
         cw.write(&data_copy);
     }
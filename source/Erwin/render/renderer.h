@@ -6,7 +6,9 @@
 #include <functional>
 #include <future>
 #include <utility>
+#include <vector>
 
+#include "render/backend.h"
 #include "render/buffer_layout.h"
 #include "render/commands.h"
 #include "render/framebuffer_layout.h"
@@ -24,11 +26,13 @@ namespace erwin
 
 enum class DataOwnership : uint8_t
 {
-    Forward = 0, // Do not copy data, forward pointer as is
+    Forward = 0, // Do not copy data, forward pointer as is. Data must outlive submission, see Renderer::get_arena()
     Copy = 1     // Copy data to renderer memory
 };
 
 struct DrawCall;
+struct CapturedFrame;
+class FrameReplayer;
 #if W_RC_PROFILE_DRAW_CALLS
 struct FrameDrawCallData;
 #endif
@@ -40,18 +44,51 @@ public:
                                     kb::memory::policy::NoMemoryTracking>
         AuxArena;
 
+    // Timings of a single pass (all the draw commands sharing a layer id), in microseconds
+    struct PassStatistics
+    {
+        uint8_t layer_id = 0;
+        hash_t name = 0;                 // Debug name given to next_layer_id(), 0 if none
+        uint32_t draw_call_count = 0;    // Draw calls dispatched, an instanced draw call from merging counts as one
+        float CPU_sort_time = 0.f;       // Key sort of the views of this pass, views are sorted in parallel
+        float CPU_dispatch_time = 0.f;   // Dependencies included
+        float CPU_dependency_time = 0.f; // Dispatch of draw call dependencies
+        float GPU_time = 0.f;            // Read back a few frames late, from the last frame that used this layer id
+    };
+
     struct Statistics
     {
         float GPU_render_time = 0.f;
         float CPU_flush_time = 0.f;
+        float CPU_sort_time = 0.f; // Wall time, partitioning by view included
+        std::vector<PassStatistics> passes; // In dispatch order
         uint32_t draw_call_count = 0;
+        uint32_t merged_draw_call_count = 0; // Draw calls folded into instanced draw calls during flush
+        uint32_t dependency_upload_hits = 0;   // Buffer uploads skipped, the buffer already held the same content
+        uint32_t dependency_upload_misses = 0; // Buffer uploads performed
+        uint32_t visible_count = 0; // Mesh instances that passed culling
+        uint32_t culled_count = 0;  // Mesh instances outside of the view frustum
+        uint32_t occluded_count = 0; // Mesh instances hidden by occluders
+        StateCounters state_counters; // Backend state cache binds and hits
     };
 
     // * The following functions have immediate effect
-    // Require a layer id for a pass
-    static uint8_t next_layer_id();
-    // Get the renderer memory arena, for per-frame data allocation outside of the renderer
+    // Require a layer id for a pass, the optional name is used to report pass statistics
+    static uint8_t next_layer_id(hash_t name = 0);
+    // Get the renderer memory arena bound to the calling thread, for per-frame data allocation outside of the renderer
     static AuxArena& get_arena();
+    // Get the capacity in bytes of the arena returned by get_arena(), it is shared by all the draw commands recorded
+    // by the calling thread during a frame
+    static size_t get_arena_size();
+    // Count mesh instances kept and rejected by the culling of a front-end renderer, reported in the statistics
+    static void report_culling(uint32_t visible_count, uint32_t culled_count, uint32_t occluded_count = 0);
+    // Bind the calling worker thread to a draw command buffer of its own. Draw commands (and their dependencies)
+    // submitted from this thread are recorded there, then merged by key with the other buffers on flush.
+    // Returns false if all worker buffers are taken. Render commands and next_layer_id() stay main thread only,
+    // and recording must be complete before flush() is called.
+    static bool bind_recording_thread();
+    // Release the draw command buffer bound to the calling thread. Recorded commands are kept until next flush.
+    static void unbind_recording_thread();
     // Get a handle to the default framebuffer (screen)
     static FramebufferHandle default_render_target();
     // Get a handle to a specified color or depth attachment of a given framebuffer
@@ -80,6 +117,14 @@ public:
                       const glm::vec4& clear_color = {0.f, 0.f, 0.f, 0.f});
     // Blit depth buffer / texture from source to target
     static void blit_depth(uint64_t key, FramebufferHandle source, FramebufferHandle target);
+    // Let runs of consecutive indexed draw calls using a shader be merged into a single instanced draw call at flush
+    // time. Draw calls of a run share their state, VAO and textures, and only depend on UBO updates of non-zero size.
+    // The UBO payloads of a run are packed in dependency order, 16 bytes aligned, into an SSBO attached to an
+    // instanced variant of the shader, which fetches its per-draw data using gl_InstanceID.
+    static void enable_draw_merging(ShaderHandle shader, ShaderHandle instanced_shader,
+                                    ShaderStorageBufferHandle instance_buffer, uint32_t instance_buffer_size);
+    // Stop merging the draw calls using a shader
+    static void disable_draw_merging(ShaderHandle shader);
     // * Draw call dependencies
     // Update an SSBO's data
     static uint32_t update_shader_storage_buffer(ShaderStorageBufferHandle handle, const void* data, uint32_t size,
@@ -88,8 +133,20 @@ public:
     static uint32_t update_uniform_buffer(UniformBufferHandle handle, const void* data, uint32_t size,
                                           DataOwnership copy);
 
-    // Force renderer to dispatch all render/draw commands
+    // Force renderer to dispatch all render/draw commands. When the render thread is running, the frame is handed over
+    // to it instead, and is submitted after present() is called while the next frame is being recorded.
     static void flush();
+    // Swap the host window buffers after the last flushed frame, and kick the render thread if any
+    static void present();
+    // Execute a task on the thread that owns the graphics context, after the last flushed frame.
+    // The task is executed immediately if the render thread is not running.
+    static void enqueue_task(std::function<void()>&& task);
+    // Transfer frame submission and the ownership of the graphics context to a dedicated render thread
+    static void spawn_render_thread();
+    // Join the render thread and get the graphics context back on the calling thread
+    static void kill_render_thread();
+    // Check if frames are submitted by a dedicated render thread
+    static bool has_render_thread();
 
     // * The following functions will initialize a render command and push it to the appropriate buffer
     // PRE-BUFFER -> executed before draw commands
@@ -109,8 +166,11 @@ public:
     static CubemapHandle create_cubemap(const CubemapDescriptor& desc);
     static FramebufferHandle create_framebuffer(uint32_t width, uint32_t height, uint8_t flags,
                                                 const FramebufferLayout& layout);
-    static void update_index_buffer(IndexBufferHandle handle, const uint32_t* data, uint32_t count);
-    static void update_vertex_buffer(VertexBufferHandle handle, const void* data, uint32_t size);
+    // Update a range of an index buffer, offset is expressed in indices
+    static void update_index_buffer(IndexBufferHandle handle, const uint32_t* data, uint32_t count,
+                                    uint32_t offset = 0);
+    // Update a range of a vertex buffer, offset is expressed in bytes
+    static void update_vertex_buffer(VertexBufferHandle handle, const void* data, uint32_t size, uint32_t offset = 0);
     static void update_uniform_buffer(UniformBufferHandle handle, const void* data, uint32_t size);
     static void update_shader_storage_buffer(ShaderStorageBufferHandle handle, const void* data, uint32_t size);
     static void shader_attach_uniform_buffer(ShaderHandle shader, UniformBufferHandle ubo);
@@ -119,8 +179,14 @@ public:
     static void clear_framebuffers();
     static void set_host_window_size(uint32_t width, uint32_t height);
     // POST-BUFFER -> executed after draw commands
+    // Read back the RGBA8 pixels of a texture. The data is available a few frames later, never wait for it
+    // before the next flush. Caller owns the data.
     static std::future<PixelData> get_pixel_data(TextureHandle handle);
+    // Read back the half float texels of all faces and mip levels of a RGB16F or RGBA16F cubemap,
+    // laid out as described by cubemap_mip_chain_size()
+    static std::future<PixelData> get_pixel_data(CubemapHandle handle);
     static void generate_mipmaps(CubemapHandle cubemap);
+    // Save a framebuffer to a png file, pixels are read back and encoded asynchronously
     static void framebuffer_screenshot(FramebufferHandle fb, const fs::path& filepath);
     static void destroy(IndexBufferHandle handle);
     static void destroy(VertexBufferLayoutHandle handle);
@@ -134,10 +200,16 @@ public:
     static void destroy(FramebufferHandle handle, bool detach_textures = false);
 
 #ifdef W_DEBUG
+    // Enable/Disable profiling, takes effect on the next frame to be recorded
     static void set_profiling_enabled(bool value = true);
     static const Statistics& get_stats();
 #endif
     static void track_draw_calls(const fs::path& json_path);
+    // Serialize the next frames to be submitted to a binary file, for offline replay. See render/frame_capture.h
+    static void capture_frames(const fs::path& path, uint32_t frame_count = 1);
+    // Record the commands of a captured frame as if they were submitted by the client, handles are remapped by
+    // the replayer. When draw_only is set, pre-buffer and post-buffer commands are skipped.
+    static void replay(const CapturedFrame& frame, FrameReplayer& replayer, bool draw_only = false);
 
 private:
     friend class Application;
@@ -137,7 +137,7 @@ void Renderer2D::begin_pass(const OrthographicCamera2D& camera, bool transparent
     state.depth_stencil_state.depth_test_enabled = true;
 
     s_storage.pass_state = state.encode();
-    s_storage.view_id = Renderer::next_layer_id();
+    s_storage.view_id = Renderer::next_layer_id("Sprites"_h);
 
     // Set scene data
     s_storage.view_projection_matrix = camera.get_view_projection_matrix();
@@ -4,6 +4,7 @@
 #include "asset/material.h"
 #include "asset/mesh.h"
 #include "asset/texture.h"
+#include "core/application.h"
 #include "entity/component/PBR_material.h"
 #include "entity/component/camera.h"
 #include "entity/component/dirlight_material.h"
@@ -13,9 +14,21 @@
 #include "glm/gtx/euler_angles.hpp"
 #include "math/transform.h"
 #include "render/common_geometry.h"
+#include "render/culling.h"
+#include "render/light_clusters.h"
+#include "render/occlusion.h"
+#include "render/render_workers.h"
 #include "render/renderer.h"
+#include "render/renderer_config.h"
+#include "utils/fnv1a.hpp"
+#include <kibble/logger/logger.h>
 
+#include <algorithm>
+#include <limits>
 #include <set>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 
 namespace erwin
 {
@@ -58,6 +71,18 @@ struct TransformData
     glm::mat4 mvp;
 };
 
+// Consecutive opaque PBR draw calls are merged into instanced draw calls, see Renderer::enable_draw_merging().
+// Instance data is the transform data followed by the material data, packed like the InstanceData struct
+// of the instanced shader.
+static constexpr uint32_t k_max_PBR_instances = 256;
+static constexpr uint32_t k_PBR_instance_size =
+    sizeof(TransformData) + ((sizeof(ComponentPBRMaterial::MaterialData) + 15) & ~15u);
+// Multi-draw indirect batches use the same instance data layout, larger batches are split
+static constexpr uint32_t k_max_PBR_indirect_instances = 16384;
+// The instance data and draw commands of a batch are allocated in the arena of the recording thread, a batch
+// may only take this fraction of it
+static constexpr uint32_t k_PBR_indirect_arena_fraction = 4;
+
 struct EquirectangularConversionData
 {
     glm::vec2 viewport_size;
@@ -76,10 +101,19 @@ struct PrefilterEnvmapData
     float source_resolution;
 };
 
+// Level of detail selected for a draw record in a view, and the camera update it was last selected on
+struct LODState
+{
+    uint8_t lod;
+    uint32_t update;
+};
+
 static struct
 {
     // Resources
     ShaderHandle opaque_PBR_shader;
+    ShaderHandle opaque_PBR_instanced_shader;
+    ShaderHandle opaque_PBR_indirect_shader;
     ShaderHandle forward_sun_shader;
     ShaderHandle line_shader;
     ShaderHandle dirlight_shader;
@@ -95,10 +129,28 @@ static struct
     UniformBufferHandle equirectangular_conversion_ubo;
     UniformBufferHandle diffuse_irradiance_ubo;
     UniformBufferHandle prefilter_env_map_ubo;
+    ShaderStorageBufferHandle opaque_PBR_instance_ssbo;
+    ShaderStorageBufferHandle opaque_PBR_indirect_instance_ssbo;
+    ShaderStorageBufferHandle opaque_PBR_indirect_command_ssbo;
+    ShaderStorageBufferHandle light_ssbo;
+    ShaderStorageBufferHandle light_grid_ssbo;
+    ShaderStorageBufferHandle light_index_ssbo;
     TextureHandle BRDF_integration_map;
 
     FrameData frame_data;
     Environment environment;
+    FrustumCuller culler;
+    OcclusionBuffer occlusion;
+    LightClusters light_clusters;
+    RenderWorkers culling_workers;
+    bool occlusion_dirty = false;
+    bool light_grid_empty = false; // Last uploaded light grid has no light
+    bool light_indices_saturated = false;
+
+    // LOD selection state per view and draw record id, hashed together
+    std::unordered_map<uint64_t, LODState> lod_states;
+    uint64_t view_key = 0;
+    uint32_t camera_updates = 0;
 
     // State
     uint64_t pass_state;
@@ -136,6 +188,11 @@ void Renderer3D::init()
 
     // TODO: use universal paths
     s_storage.opaque_PBR_shader = Renderer::create_shader("sysres://shaders/deferred_PBR.glsl", "lines");
+    s_storage.opaque_PBR_instanced_shader =
+        Renderer::create_shader("sysres://shaders/deferred_PBR_instanced.glsl", "deferred_PBR_instanced");
+    // Same program as the instanced variant, but with its own instance buffer attached
+    s_storage.opaque_PBR_indirect_shader =
+        Renderer::create_shader("sysres://shaders/deferred_PBR_instanced.glsl", "deferred_PBR_indirect");
     s_storage.forward_sun_shader = Renderer::create_shader("sysres://shaders/forward_sun.glsl", "lines");
     s_storage.line_shader = Renderer::create_shader("sysres://shaders/line_shader.glsl", "lines");
     s_storage.dirlight_shader = Renderer::create_shader("sysres://shaders/deferred_PBR_lighting.glsl", "deferred_PBR_lighting");
@@ -157,16 +214,41 @@ void Renderer3D::init()
         Renderer::create_uniform_buffer("parameters", nullptr, sizeof(DiffuseIrradianceData), UsagePattern::Dynamic);
     s_storage.prefilter_env_map_ubo =
         Renderer::create_uniform_buffer("parameters", nullptr, sizeof(PrefilterEnvmapData), UsagePattern::Dynamic);
+    s_storage.opaque_PBR_instance_ssbo = Renderer::create_shader_storage_buffer(
+        "instance_data", nullptr, k_max_PBR_instances * k_PBR_instance_size, UsagePattern::Dynamic);
+    s_storage.opaque_PBR_indirect_instance_ssbo = Renderer::create_shader_storage_buffer(
+        "instance_data", nullptr, k_max_PBR_indirect_instances * k_PBR_instance_size, UsagePattern::Dynamic);
+    s_storage.opaque_PBR_indirect_command_ssbo = Renderer::create_shader_storage_buffer(
+        "indirect_commands", nullptr, k_max_PBR_indirect_instances * sizeof(DrawElementsIndirectCommand),
+        UsagePattern::Dynamic);
+    s_storage.light_ssbo = Renderer::create_shader_storage_buffer(
+        "light_data", nullptr, k_max_punctual_lights * sizeof(PunctualLight), UsagePattern::Dynamic);
+    s_storage.light_grid_ssbo = Renderer::create_shader_storage_buffer(
+        "light_grid", nullptr,
+        k_light_cluster_tiles_x * k_light_cluster_tiles_y * k_light_cluster_slices * sizeof(ClusterRange),
+        UsagePattern::Dynamic);
+    s_storage.light_index_ssbo = Renderer::create_shader_storage_buffer(
+        "light_indices", nullptr, k_max_light_indices * sizeof(uint32_t), UsagePattern::Dynamic);
 
     Renderer::shader_attach_uniform_buffer(s_storage.opaque_PBR_shader, s_storage.opaque_PBR_material_ubo);
     Renderer::shader_attach_uniform_buffer(s_storage.opaque_PBR_shader, s_storage.frame_ubo);
     Renderer::shader_attach_uniform_buffer(s_storage.opaque_PBR_shader, s_storage.transform_ubo);
+    Renderer::shader_attach_uniform_buffer(s_storage.opaque_PBR_instanced_shader, s_storage.frame_ubo);
+    Renderer::shader_attach_storage_buffer(s_storage.opaque_PBR_instanced_shader, s_storage.opaque_PBR_instance_ssbo);
+    Renderer::shader_attach_uniform_buffer(s_storage.opaque_PBR_indirect_shader, s_storage.frame_ubo);
+    Renderer::shader_attach_storage_buffer(s_storage.opaque_PBR_indirect_shader,
+                                           s_storage.opaque_PBR_indirect_instance_ssbo);
+    Renderer::enable_draw_merging(s_storage.opaque_PBR_shader, s_storage.opaque_PBR_instanced_shader,
+                                  s_storage.opaque_PBR_instance_ssbo, k_max_PBR_instances * k_PBR_instance_size);
 
     Renderer::shader_attach_uniform_buffer(s_storage.forward_sun_shader, s_storage.sun_material_ubo);
     Renderer::shader_attach_uniform_buffer(s_storage.forward_sun_shader, s_storage.frame_ubo);
     Renderer::shader_attach_uniform_buffer(s_storage.forward_sun_shader, s_storage.transform_ubo);
 
     Renderer::shader_attach_uniform_buffer(s_storage.dirlight_shader, s_storage.transform_ubo);
+    Renderer::shader_attach_storage_buffer(s_storage.dirlight_shader, s_storage.light_ssbo);
+    Renderer::shader_attach_storage_buffer(s_storage.dirlight_shader, s_storage.light_grid_ssbo);
+    Renderer::shader_attach_storage_buffer(s_storage.dirlight_shader, s_storage.light_index_ssbo);
     Renderer::shader_attach_uniform_buffer(s_storage.line_shader, s_storage.line_ubo);
     Renderer::shader_attach_uniform_buffer(s_storage.skybox_shader, s_storage.frame_ubo);
     Renderer::shader_attach_uniform_buffer(s_storage.equirectangular_to_cubemap_shader, s_storage.equirectangular_conversion_ubo);
@@ -181,10 +263,21 @@ void Renderer3D::init()
     const auto& freetex =
         AssetManager::load<FreeTexture, Texture2DDescriptor>(0, "sysres://textures/ibl_brdf_integration.png", brdf_lut_desc);
     s_storage.BRDF_integration_map = freetex.handle;
+
+    // Occluders are rasterized and lights are clustered on worker threads, the main thread takes part
+    s_storage.occlusion.init(k_occlusion_buffer_width, k_occlusion_buffer_height, k_occlusion_tile_size);
+    s_storage.light_clusters.init(k_light_cluster_tiles_x, k_light_cluster_tiles_y, k_light_cluster_slices,
+                                  k_max_punctual_lights, k_max_light_indices);
+    s_storage.light_grid_empty = false;
+    uint32_t max_culling_threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    s_storage.culling_workers.spawn(
+        std::min(CFG_.get<uint32_t>("erwin.renderer.culling_threads"_h, 2), max_culling_threads));
 }
 
 void Renderer3D::shutdown()
 {
+    s_storage.culling_workers.kill();
+    Renderer::disable_draw_merging(s_storage.opaque_PBR_shader);
     Renderer::destroy(s_storage.BRDF_integration_map);
     Renderer::destroy(s_storage.prefilter_env_map_ubo);
     Renderer::destroy(s_storage.diffuse_irradiance_ubo);
@@ -193,6 +286,12 @@ void Renderer3D::shutdown()
     Renderer::destroy(s_storage.frame_ubo);
     Renderer::destroy(s_storage.line_ubo);
     Renderer::destroy(s_storage.opaque_PBR_material_ubo);
+    Renderer::destroy(s_storage.opaque_PBR_instance_ssbo);
+    Renderer::destroy(s_storage.opaque_PBR_indirect_instance_ssbo);
+    Renderer::destroy(s_storage.opaque_PBR_indirect_command_ssbo);
+    Renderer::destroy(s_storage.light_ssbo);
+    Renderer::destroy(s_storage.light_grid_ssbo);
+    Renderer::destroy(s_storage.light_index_ssbo);
     Renderer::destroy(s_storage.sun_material_ubo);
     Renderer::destroy(s_storage.equirectangular_to_cubemap_shader);
     Renderer::destroy(s_storage.diffuse_irradiance_shader);
@@ -201,10 +300,12 @@ void Renderer3D::shutdown()
     Renderer::destroy(s_storage.dirlight_shader);
     Renderer::destroy(s_storage.line_shader);
     Renderer::destroy(s_storage.forward_sun_shader);
+    Renderer::destroy(s_storage.opaque_PBR_indirect_shader);
+    Renderer::destroy(s_storage.opaque_PBR_instanced_shader);
     Renderer::destroy(s_storage.opaque_PBR_shader);
 }
 
-void Renderer3D::update_camera(const ComponentCamera3D& camera, const Transform3D& transform)
+void Renderer3D::update_camera(const ComponentCamera3D& camera, const Transform3D& transform, uint64_t view_id)
 {
     glm::vec2 fb_size = FramebufferPool::get_screen_size();
     float near = camera.frustum.near;
@@ -225,6 +326,66 @@ void Renderer3D::update_camera(const ComponentCamera3D& camera, const Transform3
     s_storage.frame_data.camera_params = glm::vec4(near, far, 0.f, 0.f);
     s_storage.frame_data.framebuffer_size = glm::vec4(fb_size, fb_size.x / fb_size.y, 0.f);
     s_storage.frame_data.proj_params = camera.projection_parameters;
+
+    s_storage.culler.set_planes(camera.planes);
+    s_storage.occlusion.set_view_projection(camera.view_projection_matrix);
+    s_storage.occlusion_dirty = false;
+
+    // Records drawn in two views keep a LOD for each of them.
+    // State of records that stopped being drawn is discarded periodically.
+    s_storage.view_key = fnv1a(&view_id, sizeof(uint64_t));
+    if(++s_storage.camera_updates % k_lod_state_lifetime == 0)
+    {
+        for(auto it = s_storage.lod_states.begin(); it != s_storage.lod_states.end();)
+        {
+            if(s_storage.camera_updates - it->second.update > k_lod_state_lifetime)
+                it = s_storage.lod_states.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+void Renderer3D::add_occluder(const Extent& extent, const glm::mat4& model_matrix)
+{
+    s_storage.occlusion.add_occluder(extent, model_matrix);
+    s_storage.occlusion_dirty = true;
+}
+
+void Renderer3D::add_occluder(const MeshGeometry& geometry, const glm::mat4& model_matrix)
+{
+    // The bounding box of an arbitrary mesh would hide what lies in its concavities
+    s_storage.occlusion.add_occluder(geometry.positions.data(), geometry.indices.data(),
+                                     uint32_t(geometry.indices.size()), model_matrix);
+    s_storage.occlusion_dirty = true;
+}
+
+// Occluders are rasterized lazily, by the first test that follows their submission
+static bool is_occluded(const Extent& extent, const glm::mat4& model_matrix)
+{
+    if(!s_storage.occlusion.has_occluders())
+        return false;
+    if(s_storage.occlusion_dirty)
+    {
+        s_storage.occlusion.rasterize(&s_storage.culling_workers);
+        s_storage.occlusion_dirty = false;
+    }
+    return !s_storage.occlusion.is_visible(extent, model_matrix);
+}
+
+// Projected size of the bounding sphere of a mesh instance, as a fraction of the viewport height
+static float screen_size(const Extent& extent, const glm::mat4& model_matrix)
+{
+    auto&& [mid, half] = bound::to_vectors(extent);
+    float scale = std::max({glm::length(glm::vec3(model_matrix[0])), glm::length(glm::vec3(model_matrix[1])),
+                            glm::length(glm::vec3(model_matrix[2]))});
+    float radius = glm::length(half) * scale;
+    glm::vec3 center(model_matrix * glm::vec4(mid, 1.f));
+    float distance = glm::distance(center, glm::vec3(s_storage.frame_data.eye_position));
+    // Camera inside the sphere: always the finest level
+    if(distance <= radius)
+        return std::numeric_limits<float>::max();
+    return radius / (distance * s_storage.frame_data.proj_params.y);
 }
 
 void Renderer3D::update_light(const ComponentDirectionalLight& dir_light)
@@ -246,6 +407,17 @@ void Renderer3D::update_light(const ComponentDirectionalLight& dir_light)
     }
 }
 
+void Renderer3D::add_point_light(const ComponentPointLight& light, const glm::vec3& position)
+{
+    s_storage.light_clusters.add_point_light(position, light.radius, light.color * light.brightness);
+}
+
+void Renderer3D::add_spot_light(const ComponentSpotLight& light, const glm::vec3& position, const glm::vec3& direction)
+{
+    s_storage.light_clusters.add_spot_light(position, direction, light.radius, glm::radians(light.inner_angle),
+                                            glm::radians(light.outer_angle), light.color * light.brightness);
+}
+
 void Renderer3D::update_frame_data() { Renderer::update_uniform_buffer(s_storage.frame_ubo, &s_storage.frame_data, sizeof(FrameData)); }
 
 void Renderer3D::set_environment(const Environment& environment) { s_storage.environment = environment; }
@@ -272,7 +444,8 @@ CubemapHandle Renderer3D::generate_cubemap_hdr(TextureHandle hdr_tex, uint32_t s
 {
     // Create an ad-hoc framebuffer to render to a cubemap
     FramebufferLayout layout{
-        {"cubemap"_h, ImageFormat::RGB16F, MIN_LINEAR_MIPMAP_LINEAR | MAG_LINEAR, TextureWrap::CLAMP_TO_EDGE, 5, true}};
+        {"cubemap"_h, ImageFormat::RGB16F, MIN_LINEAR_MIPMAP_LINEAR | MAG_LINEAR, TextureWrap::CLAMP_TO_EDGE,
+         k_environment_map_mips, true}};
     FramebufferHandle fb = Renderer::create_framebuffer(size, size, FB_CUBEMAP_ATTACHMENT, layout);
     CubemapHandle cubemap = Renderer::get_framebuffer_cubemap(fb);
 
@@ -297,6 +470,7 @@ CubemapHandle Renderer3D::generate_cubemap_hdr(TextureHandle hdr_tex, uint32_t s
 
     VertexArrayHandle quad = CommonGeometry::get_mesh("quad"_h).VAO;
     DrawCall dc(DrawCall::Indexed, state_flags, s_storage.equirectangular_to_cubemap_shader, quad);
+    dc.set_blocking();
     dc.set_texture(hdr_tex);
     dc.add_dependency(Renderer::update_uniform_buffer(s_storage.equirectangular_conversion_ubo, static_cast<void*>(&data),
                                                       sizeof(EquirectangularConversionData), DataOwnership::Copy));
@@ -312,7 +486,7 @@ CubemapHandle Renderer3D::generate_cubemap_hdr(TextureHandle hdr_tex, uint32_t s
 
 CubemapHandle Renderer3D::generate_irradiance_map(CubemapHandle env_map)
 {
-    constexpr uint32_t ecm_size = 32;
+    constexpr uint32_t ecm_size = k_irradiance_map_size;
 
     // Create an ad-hoc framebuffer to render to a cubemap
     FramebufferLayout layout{{"cubemap"_h, ImageFormat::RGB16F, MIN_LINEAR | MAG_LINEAR, TextureWrap::CLAMP_TO_EDGE}};
@@ -321,7 +495,7 @@ CubemapHandle Renderer3D::generate_irradiance_map(CubemapHandle env_map)
 
     DiffuseIrradianceData data;
     data.viewport_size = {ecm_size, ecm_size};
-    data.delta_sample = 0.025f;
+    data.delta_sample = k_irradiance_delta_sample;
 
     // Render a single quad, the geometry shader will perform layered rendering with 6 invocations
     RenderState state;
@@ -338,6 +512,7 @@ CubemapHandle Renderer3D::generate_irradiance_map(CubemapHandle env_map)
 
     VertexArrayHandle quad = CommonGeometry::get_mesh("quad"_h).VAO;
     DrawCall dc(DrawCall::Indexed, state_flags, s_storage.diffuse_irradiance_shader, quad);
+    dc.set_blocking();
     dc.set_cubemap(env_map);
     dc.add_dependency(Renderer::update_uniform_buffer(s_storage.diffuse_irradiance_ubo, static_cast<void*>(&data),
                                                       sizeof(DiffuseIrradianceData), DataOwnership::Copy));
@@ -352,8 +527,8 @@ CubemapHandle Renderer3D::generate_irradiance_map(CubemapHandle env_map)
 
 CubemapHandle Renderer3D::generate_prefiltered_map(CubemapHandle env_map, uint32_t source_resolution)
 {
-    constexpr uint32_t pfm_size = 512;
-    constexpr uint8_t max_mips = 5;
+    constexpr uint32_t pfm_size = k_prefiltered_map_size;
+    constexpr uint8_t max_mips = k_prefiltered_map_mips + 1;
 
     // Create an ad-hoc framebuffer to render to a cubemap
     FramebufferLayout layout{
@@ -386,6 +561,7 @@ CubemapHandle Renderer3D::generate_prefiltered_map(CubemapHandle env_map, uint32
 
         VertexArrayHandle quad = CommonGeometry::get_mesh("quad"_h).VAO;
         DrawCall dc(DrawCall::Indexed, state_flags, s_storage.prefilter_env_map_shader, quad);
+        dc.set_blocking();
         dc.set_cubemap(env_map);
         dc.add_dependency(Renderer::update_uniform_buffer(s_storage.prefilter_env_map_ubo, static_cast<void*>(&data),
                                                           sizeof(PrefilterEnvmapData), DataOwnership::Copy));
@@ -412,7 +588,7 @@ void Renderer3D::begin_deferred_pass()
     state.depth_stencil_state.depth_test_enabled = true;
 
     s_storage.pass_state = state.encode();
-    s_storage.layer_id = Renderer::next_layer_id();
+    s_storage.layer_id = Renderer::next_layer_id("Deferred"_h);
 }
 
 void Renderer3D::end_deferred_pass()
@@ -436,7 +612,7 @@ void Renderer3D::end_deferred_pass()
     state.depth_stencil_state.depth_lock = true;
 
     uint64_t state_flags = state.encode();
-    uint8_t layer_id = Renderer::next_layer_id();
+    uint8_t layer_id = Renderer::next_layer_id("DeferredLighting"_h);
     SortKey key;
     key.set_sequence(0, layer_id, s_storage.dirlight_shader);
 
@@ -452,6 +628,32 @@ void Renderer3D::end_deferred_pass()
         dc.set_cubemap(s_storage.environment.prefiltered_map, 1);
     }
 
+    // Assign punctual lights to clusters and upload them. An empty grid only needs to be uploaded once.
+    auto& clusters = s_storage.light_clusters;
+    clusters.build(s_storage.frame_data.view_matrix, s_storage.frame_data.proj_params,
+                   s_storage.frame_data.camera_params.x, s_storage.frame_data.camera_params.y,
+                   &s_storage.culling_workers);
+    if(clusters.is_saturated() && !s_storage.light_indices_saturated)
+        KLOGW("render") << "Light index list is full, some lights were dropped." << std::endl;
+    s_storage.light_indices_saturated = clusters.is_saturated();
+    if(clusters.get_light_count() > 0 || !s_storage.light_grid_empty)
+    {
+        dc.add_dependency(Renderer::update_shader_storage_buffer(
+            s_storage.light_grid_ssbo, clusters.get_grid(), clusters.get_cluster_count() * sizeof(ClusterRange),
+            DataOwnership::Copy));
+        s_storage.light_grid_empty = (clusters.get_index_count() == 0);
+    }
+    if(clusters.get_index_count() > 0)
+    {
+        dc.add_dependency(Renderer::update_shader_storage_buffer(s_storage.light_ssbo, clusters.get_lights(),
+                                                                 clusters.get_light_count() * sizeof(PunctualLight),
+                                                                 DataOwnership::Copy));
+        dc.add_dependency(Renderer::update_shader_storage_buffer(s_storage.light_index_ssbo, clusters.get_indices(),
+                                                                 clusters.get_index_count() * sizeof(uint32_t),
+                                                                 DataOwnership::Copy));
+    }
+    clusters.clear();
+
     Renderer::submit(key.encode(), dc);
 
     // Blit GBuffer's depth buffer into LBuffer
@@ -472,7 +674,7 @@ void Renderer3D::begin_forward_pass(BlendState blend_state)
     state.depth_stencil_state.depth_test_enabled = true;
 
     s_storage.pass_state = state.encode();
-    s_storage.layer_id = Renderer::next_layer_id();
+    s_storage.layer_id = Renderer::next_layer_id("Forward"_h);
 }
 
 void Renderer3D::end_forward_pass() {}
@@ -487,14 +689,47 @@ void Renderer3D::begin_line_pass(bool enable_depth_test)
     state.depth_stencil_state.depth_test_enabled = enable_depth_test;
 
     s_storage.pass_state = state.encode();
-    s_storage.layer_id = Renderer::next_layer_id();
+    s_storage.layer_id = Renderer::next_layer_id("Lines"_h);
 }
 
 void Renderer3D::end_line_pass() {}
 
+// Select the level of detail of a mesh instance. Instances with an id switch with hysteresis from the LOD
+// they had in the current view.
+static uint32_t select_lod(const Mesh& mesh, const glm::mat4& model_matrix, uint64_t id)
+{
+    if(mesh.lod_count < 2)
+        return 0;
+
+    float size = screen_size(mesh.extent, model_matrix);
+    if(id == PBRDrawRecord::k_no_id)
+        return mesh.select_lod(size, 0, 0.f);
+
+    // Hash collisions only share hysteresis state
+    auto [it, inserted] =
+        s_storage.lod_states.try_emplace(s_storage.view_key ^ id, LODState{0, s_storage.camera_updates});
+    uint32_t lod = inserted ? mesh.select_lod(size, 0, 0.f) : mesh.select_lod(size, it->second.lod, k_lod_hysteresis);
+    it->second = {uint8_t(lod), s_storage.camera_updates};
+    return lod;
+}
+
 void Renderer3D::draw_mesh_PBR_opaque(const Mesh& mesh, const glm::mat4& model_matrix, const TextureGroup& texture_group,
-                                      const void* material_data)
+                                      const void* material_data, uint64_t id)
 {
+    if(!FrustumCuller::is_visible(mesh.extent, model_matrix, s_storage.culler.get_planes()))
+    {
+        Renderer::report_culling(0, 1);
+        return;
+    }
+    if(is_occluded(mesh.extent, model_matrix))
+    {
+        Renderer::report_culling(0, 0, 1);
+        return;
+    }
+    Renderer::report_culling(1, 0);
+
+    uint32_t lod = select_lod(mesh, model_matrix, id);
+
     // Compute matrices
     TransformData transform_data;
     transform_data.m = model_matrix;
@@ -507,7 +742,8 @@ void Renderer3D::draw_mesh_PBR_opaque(const Mesh& mesh, const glm::mat4& model_m
     SortKey key;
     key.set_depth(depth, s_storage.layer_id, s_storage.pass_state, s_storage.opaque_PBR_shader);
 
-    DrawCall dc(DrawCall::Indexed, s_storage.pass_state, s_storage.opaque_PBR_shader, mesh.VAO);
+    DrawCall dc(DrawCall::Indexed, s_storage.pass_state, s_storage.opaque_PBR_shader, mesh.VAO, mesh.get_index_count(lod),
+                mesh.get_first_index(lod));
     dc.add_dependency(Renderer::update_uniform_buffer(s_storage.transform_ubo, static_cast<void*>(&transform_data), sizeof(TransformData),
                                                       DataOwnership::Copy));
     dc.add_dependency(Renderer::update_uniform_buffer(s_storage.opaque_PBR_material_ubo, material_data,
@@ -518,6 +754,135 @@ void Renderer3D::draw_mesh_PBR_opaque(const Mesh& mesh, const glm::mat4& model_m
     Renderer::submit(key.encode(), dc);
 }
 
+static inline uint64_t texture_group_hash(const TextureGroup& group)
+{
+    uint64_t hash = k_fnv1a_seed;
+    for(uint32_t ii = 0; ii < group.texture_count; ++ii)
+        hash = fnv1a_combine(hash, group.textures[ii].index());
+    return hash;
+}
+
+static inline bool same_textures(const TextureGroup& a, const TextureGroup& b)
+{
+    if(a.texture_count != b.texture_count)
+        return false;
+    for(uint32_t ii = 0; ii < a.texture_count; ++ii)
+        if(a.textures[ii] != b.textures[ii])
+            return false;
+    return true;
+}
+
+void Renderer3D::draw_mesh_batch_PBR_opaque(const std::vector<PBRDrawRecord>& records)
+{
+    W_PROFILE_FUNCTION()
+
+    if(records.empty())
+        return;
+
+    // Frustum culling, all records are tested in SIMD batches before any draw call is built.
+    // Occlusion is only tested for the records that passed.
+    s_storage.culler.clear();
+    for(const auto& record : records)
+        s_storage.culler.push(record.mesh->extent, record.model_matrix);
+    uint32_t visible_count = s_storage.culler.cull();
+    uint32_t culled_count = uint32_t(records.size()) - visible_count;
+
+    // Sort records by vertex array and texture group, then by mesh LOD so that instances of the same pooled
+    // index range are contiguous, in submission order otherwise.
+    // Hash collisions only split groups, as group boundaries are checked exactly.
+    // Order entries: [group key, first index, record index, index count]
+    std::vector<std::tuple<uint64_t, uint32_t, uint32_t, uint32_t>> order;
+    order.reserve(visible_count);
+    for(uint32_t ii = 0; ii < records.size(); ++ii)
+    {
+        const auto& record = records[ii];
+        if(!s_storage.culler.is_visible(ii) || is_occluded(record.mesh->extent, record.model_matrix))
+            continue;
+        uint64_t group_key = (uint64_t(record.mesh->VAO.index()) << 48) |
+                             (texture_group_hash(record.material->material.texture_group) & 0xffffffffffffull);
+
+        uint32_t lod = select_lod(*record.mesh, record.model_matrix, record.id);
+        order.push_back({group_key, record.mesh->get_first_index(lod), ii, record.mesh->get_index_count(lod)});
+    }
+    Renderer::report_culling(uint32_t(order.size()), culled_count, visible_count - uint32_t(order.size()));
+    if(order.empty())
+        return;
+    std::sort(order.begin(), order.end());
+
+    auto same_group = [](const PBRDrawRecord& a, const PBRDrawRecord& b) {
+        return a.mesh->VAO == b.mesh->VAO &&
+               same_textures(a.material->material.texture_group, b.material->material.texture_group);
+    };
+
+    auto& arena = Renderer::get_arena();
+    const size_t max_batch_size =
+        std::clamp(Renderer::get_arena_size() /
+                       (k_PBR_indirect_arena_fraction * (k_PBR_instance_size + sizeof(DrawElementsIndirectCommand))),
+                   size_t(1), size_t(k_max_PBR_indirect_instances));
+    size_t begin = 0;
+    while(begin < order.size())
+    {
+        const auto& first = records[std::get<2>(order[begin])];
+        size_t end = begin + 1;
+        while(end < order.size() && end - begin < max_batch_size &&
+              same_group(first, records[std::get<2>(order[end])]))
+            ++end;
+
+        // Pack instance data and draw commands in frame memory, consecutive instances of the same mesh share
+        // a draw command
+        uint32_t instance_count = uint32_t(end - begin);
+        auto* instance_data = K_NEW_ARRAY_DYNAMIC(uint8_t, instance_count * k_PBR_instance_size, arena);
+        auto* commands = K_NEW_ARRAY_DYNAMIC(DrawElementsIndirectCommand, instance_count, arena);
+        memset(instance_data, 0, instance_count * k_PBR_instance_size);
+        uint32_t command_count = 0;
+        float min_depth = std::numeric_limits<float>::max();
+        uint32_t last_first_index = 0;
+        for(uint32_t ii = 0; ii < instance_count; ++ii)
+        {
+            auto&& [group_key, first_index, record_index, index_count] = order[begin + ii];
+            const auto& record = records[record_index];
+
+            TransformData transform_data;
+            transform_data.m = record.model_matrix;
+            transform_data.mv = s_storage.frame_data.view_matrix * transform_data.m;
+            transform_data.mvp = s_storage.frame_data.view_projection_matrix * transform_data.m;
+            glm::vec4 clip = glm::column(transform_data.mvp, 3);
+            min_depth = std::min(min_depth, clip.z / clip.w);
+
+            uint8_t* instance = instance_data + ii * k_PBR_instance_size;
+            memcpy(instance, &transform_data, sizeof(TransformData));
+            memcpy(instance + sizeof(TransformData), &record.material->material_data,
+                   sizeof(ComponentPBRMaterial::MaterialData));
+
+            // All records of a group share a vertex array, the first index identifies a mesh LOD
+            if(command_count > 0 && last_first_index == first_index)
+                ++commands[command_count - 1].instance_count;
+            else
+                commands[command_count++] = {index_count, 1, first_index, 0, ii};
+            last_first_index = first_index;
+        }
+
+        SortKey key;
+        key.set_depth(min_depth, s_storage.layer_id, s_storage.pass_state, s_storage.opaque_PBR_indirect_shader);
+
+        DrawCall dc(DrawCall::MultiIndirect, s_storage.pass_state, s_storage.opaque_PBR_indirect_shader,
+                    first.mesh->VAO);
+        dc.add_dependency(Renderer::update_shader_storage_buffer(s_storage.opaque_PBR_indirect_instance_ssbo,
+                                                                 instance_data, instance_count * k_PBR_instance_size,
+                                                                 DataOwnership::Forward));
+        dc.add_dependency(Renderer::update_shader_storage_buffer(
+            s_storage.opaque_PBR_indirect_command_ssbo, commands,
+            uint32_t(command_count * sizeof(DrawElementsIndirectCommand)), DataOwnership::Forward));
+        dc.set_indirect_buffer(s_storage.opaque_PBR_indirect_command_ssbo, command_count);
+        const auto& texture_group = first.material->material.texture_group;
+        for(uint32_t ii = 0; ii < texture_group.texture_count; ++ii)
+            dc.set_texture(texture_group.textures[ii], ii);
+
+        Renderer::submit(key.encode(), dc);
+        begin = end;
+    }
+}
+
 void Renderer3D::draw_quad_billboard_forward(const glm::mat4& model_matrix, const void* material_data)
 {
     // Compute matrices
@@ -579,7 +944,7 @@ void Renderer3D::draw_skybox(CubemapHandle cubemap)
     auto state_flags = state.encode();
 
     SortKey key;
-    auto layer_id = Renderer::next_layer_id();
+    auto layer_id = Renderer::next_layer_id("Skybox"_h);
     key.set_sequence(0, layer_id, s_storage.skybox_shader);
 
     DrawCall dc(DrawCall::Indexed, state_flags, s_storage.skybox_shader, cube);
@@ -4,6 +4,9 @@
 #include "render/handles.h"
 #include "glm/glm.hpp"
 
+#include <cstdint>
+#include <vector>
+
 /*
  * REFACTOR:
  * 		Organize code into multiple RenderPass derived objects and get rid of this class entirely
@@ -18,18 +21,38 @@ namespace erwin
 
 struct TextureGroup;
 struct Mesh;
+struct MeshGeometry;
+struct Extent;
 struct ComponentCamera3D;
 struct Transform3D;
 struct ComponentDirectionalLight;
+struct ComponentPointLight;
+struct ComponentSpotLight;
+struct ComponentPBRMaterial;
 struct Environment;
 
+// A mesh instance drawn by Renderer3D::draw_mesh_batch_PBR_opaque()
+struct PBRDrawRecord
+{
+	const Mesh* mesh;
+	const ComponentPBRMaterial* material;
+	glm::mat4 model_matrix;
+	uint64_t id = k_no_id; // Stable instance identifier (e.g. entity), LODs switch with hysteresis if set
+
+	static constexpr uint64_t k_no_id = ~0ull;
+};
+
 // 3D renderer front-end, handles forward and deferred rendering
 class Renderer3D
 {
 public:
-	// Setup frame data
-	static void update_camera(const ComponentCamera3D& camera, const Transform3D& transform);
+	// Setup frame data. Each view keeps its own mesh LOD selection state, the view id must identify the view
+	// across frames: the camera entity, mixed with a scene-specific value when several scenes are rendered.
+	static void update_camera(const ComponentCamera3D& camera, const Transform3D& transform, uint64_t view_id = 0);
 	static void update_light(const ComponentDirectionalLight& dir_light);
+	// Add a punctual light to the next deferred lighting pass, world space
+	static void add_point_light(const ComponentPointLight& light, const glm::vec3& position);
+	static void add_spot_light(const ComponentSpotLight& light, const glm::vec3& position, const glm::vec3& direction);
 	static void update_frame_data();
 	// Set an irradiance cubemap for PBR
 	static void set_environment(const Environment& environment);
@@ -63,9 +86,20 @@ public:
 	// End forward line-pass
 	static void end_line_pass();
 
+	// Add a box occluder for the current camera. Meshes entirely hidden behind occluders are not drawn,
+	// occluders must be submitted before the meshes they may hide. The whole box is rasterized, the actual
+	// occluder must fill it.
+	static void add_occluder(const Extent& extent, const glm::mat4& model_matrix);
+	// Add a mesh occluder from its CPU geometry, see AssetManager::get_occluder_geometry()
+	static void add_occluder(const MeshGeometry& geometry, const glm::mat4& model_matrix);
+
 	// Draw a textured mesh
 	// TMP
-	static void draw_mesh_PBR_opaque(const Mesh& mesh, const glm::mat4& model_matrix, const TextureGroup& texture_group, const void* material_data=nullptr);
+	// The optional id works like PBRDrawRecord::id
+	static void draw_mesh_PBR_opaque(const Mesh& mesh, const glm::mat4& model_matrix, const TextureGroup& texture_group, const void* material_data=nullptr, uint64_t id=PBRDrawRecord::k_no_id);
+	// Draw a batch of textured meshes with multi-draw indirect calls. Records sharing a vertex array and textures
+	// are drawn by a single call, their transform and material data are fetched from a storage buffer.
+	static void draw_mesh_batch_PBR_opaque(const std::vector<PBRDrawRecord>& records);
 	static void draw_quad_billboard_forward(const glm::mat4& model_matrix, const void* material_data=nullptr);
 	// Render a cubemap as a skybox (whole pass)
 	static void draw_skybox(CubemapHandle cubemap);
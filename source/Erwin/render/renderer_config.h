@@ -1,14 +1,17 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #ifdef W_PROFILE_RENDER
 #include "debug/instrumentor.h"
 #define W_PROFILE_RENDER_SCOPE(name) InstrumentationTimer timer##__LINE__(name);
 #define W_PROFILE_RENDER_FUNCTION() W_PROFILE_RENDER_SCOPE(__PRETTY_FUNCTION__)
+#define W_PROFILE_RENDER_COUNTERS(name, ...) Instrumentor::write_counters(name, {__VA_ARGS__});
 #else
 #define W_PROFILE_RENDER_SCOPE(name)
 #define W_PROFILE_RENDER_FUNCTION()
+#define W_PROFILE_RENDER_COUNTERS(name, ...)
 #endif
 
 namespace erwin
@@ -20,24 +23,76 @@ namespace erwin
 [[maybe_unused]] static constexpr uint32_t k_max_texture_slots = 32;
 // Maximum amount of cubemap slots per draw call
 [[maybe_unused]] static constexpr uint32_t k_max_cubemap_slots = 8;
-// Maximum amount of render commands per frame, per command buffer
-[[maybe_unused]] static constexpr uint32_t k_max_render_commands = 2048;
-// Maximum amount of draw calls per frame
-[[maybe_unused]] static constexpr uint32_t k_max_draw_calls = 8192;
+// Initial amount of entries per command buffer, buffers grow past this as needed
+[[maybe_unused]] static constexpr uint32_t k_min_command_entries = 256;
+// Size of the first storage page of a command buffer, pages are chained when full
+[[maybe_unused]] static constexpr std::size_t k_min_command_page_size = 16 * 1024;
+// Room left in a command page for the next command. Larger commands are moved to a page of their own.
+[[maybe_unused]] static constexpr std::size_t k_max_command_size = 4 * 1024;
+// Command buffers are right-sized to their high-water mark over this amount of frames
+[[maybe_unused]] static constexpr uint32_t k_command_buffer_shrink_frames = 256;
+// Command buffers with at least this amount of entries are radix sorted, smaller ones use std::sort
+[[maybe_unused]] static constexpr uint32_t k_radix_sort_threshold = 1024;
+// Maximum amount of threads recording draw commands concurrently, main thread included
+[[maybe_unused]] static constexpr uint32_t k_max_recording_threads = 8;
 // Maximum amount of dependencies per draw call
 [[maybe_unused]] static constexpr uint32_t k_max_draw_call_dependencies = 8;
+// Amount of uniform data draw call dependencies can stream per frame through the uniform ring,
+// past this uniform buffers are updated in place
+[[maybe_unused]] static constexpr uint32_t k_uniform_ring_segment_size = 2 * 1024 * 1024;
+// Same for shader storage data and indirect draw commands, past this shader storage buffers are updated in place
+[[maybe_unused]] static constexpr uint32_t k_storage_ring_segment_size = 16 * 1024 * 1024;
+// Destroyed resources are kept alive by the backend until the GPU is done with the frame that destroyed them.
+// If the GPU still uses them after this amount of frames, the CPU waits.
+[[maybe_unused]] static constexpr uint32_t k_max_destruction_latency = 3;
+// Handles are released on the main thread when a destruction is recorded. The backend keeps the resource for at most
+// k_max_destruction_latency frames after submission, which lags one frame behind with a render thread. Released
+// indices are not reused before the backend is done with them, and the frame that released them is no longer in flight.
+[[maybe_unused]] static constexpr uint32_t k_handle_reuse_latency = k_max_destruction_latency + 2;
+// Storage of destroyed buffers and textures is kept for reuse by allocations of the same size, for this amount of frames
+[[maybe_unused]] static constexpr uint32_t k_storage_cache_frames = 60;
+// Pixels are read back asynchronously by the backend, if they are not available after this amount of frames the CPU waits
+[[maybe_unused]] static constexpr uint32_t k_max_readback_latency = 2;
+// Occluders are rasterized by the CPU into a depth buffer of this size, tested against in tiles of this size.
+// The width must be a multiple of 4 and both dimensions multiples of the tile size.
+[[maybe_unused]] static constexpr uint32_t k_occlusion_buffer_width = 256;
+[[maybe_unused]] static constexpr uint32_t k_occlusion_buffer_height = 128;
+[[maybe_unused]] static constexpr uint32_t k_occlusion_tile_size = 8;
+// Punctual lights are assigned to the clusters of a froxel grid: screen tiles split in exponential depth slices.
+// Grid dimensions must match the LIGHT_CLUSTER_* constants of engine/punctual_lights.glsl.
+[[maybe_unused]] static constexpr uint32_t k_light_cluster_tiles_x = 16;
+[[maybe_unused]] static constexpr uint32_t k_light_cluster_tiles_y = 9;
+[[maybe_unused]] static constexpr uint32_t k_light_cluster_slices = 24;
+// Maximum amount of punctual lights per view, and of light references in all clusters
+[[maybe_unused]] static constexpr uint32_t k_max_punctual_lights = 1024;
+[[maybe_unused]] static constexpr uint32_t k_max_light_indices = 1 << 17;
+// Image based lighting precompute. Mip counts do not include the base level. These are part of the IBL cache key.
+[[maybe_unused]] static constexpr uint32_t k_environment_map_mips = 5;
+[[maybe_unused]] static constexpr uint32_t k_irradiance_map_size = 32;
+[[maybe_unused]] static constexpr float k_irradiance_delta_sample = 0.025f;
+[[maybe_unused]] static constexpr uint32_t k_prefiltered_map_size = 512;
+[[maybe_unused]] static constexpr uint32_t k_prefiltered_map_mips = 4; // One level per roughness step
+// Relative margin around mesh LOD switch distances, avoids popping back and forth at the threshold
+[[maybe_unused]] static constexpr float k_lod_hysteresis = 0.1f;
+// LOD selection state of draw records that were not drawn for this many camera updates is discarded
+[[maybe_unused]] static constexpr uint32_t k_lod_state_lifetime = 64;
+// Mesh geometry is sub-allocated from shared vertex and index buffers, one set of blocks per vertex layout.
+// Blocks have these capacities, unless a mesh is bigger.
+[[maybe_unused]] static constexpr uint32_t k_geometry_pool_block_vertices = 1 << 18;
+[[maybe_unused]] static constexpr uint32_t k_geometry_pool_block_indices = 1 << 20;
 
-// Maximum amount of managed objects
-[[maybe_unused]] static constexpr uint32_t k_max_index_buffers = 512;
-[[maybe_unused]] static constexpr uint32_t k_max_vertex_buffer_layouts = 64;
-[[maybe_unused]] static constexpr uint32_t k_max_vertex_buffers = 512;
-[[maybe_unused]] static constexpr uint32_t k_max_vertex_arrays = 512;
-[[maybe_unused]] static constexpr uint32_t k_max_uniform_buffers = 256;
-[[maybe_unused]] static constexpr uint32_t k_max_shader_storage_buffers = 64;
-[[maybe_unused]] static constexpr uint32_t k_max_textures = 256;
-[[maybe_unused]] static constexpr uint32_t k_max_cubemaps = 256;
-[[maybe_unused]] static constexpr uint32_t k_max_shaders = 256;
-[[maybe_unused]] static constexpr uint32_t k_max_framebuffers = 256;
+// Initial capacity of the handle pools of managed objects. They can be overridden in the configuration
+// (erwin.renderer.handles.<HandleName>), pools grow on demand up to 65535 handles.
+[[maybe_unused]] static constexpr uint32_t k_index_buffers_capacity = 512;
+[[maybe_unused]] static constexpr uint32_t k_vertex_buffer_layouts_capacity = 64;
+[[maybe_unused]] static constexpr uint32_t k_vertex_buffers_capacity = 512;
+[[maybe_unused]] static constexpr uint32_t k_vertex_arrays_capacity = 512;
+[[maybe_unused]] static constexpr uint32_t k_uniform_buffers_capacity = 256;
+[[maybe_unused]] static constexpr uint32_t k_shader_storage_buffers_capacity = 64;
+[[maybe_unused]] static constexpr uint32_t k_textures_capacity = 256;
+[[maybe_unused]] static constexpr uint32_t k_cubemaps_capacity = 256;
+[[maybe_unused]] static constexpr uint32_t k_shaders_capacity = 256;
+[[maybe_unused]] static constexpr uint32_t k_framebuffers_capacity = 256;
 
 // DEBUG
 [[maybe_unused]] static constexpr bool k_enable_state_cache = true;
@@ -1,6 +1,7 @@
 #include "render/renderer_pp.h"
 #include "render/common_geometry.h"
 #include "render/renderer.h"
+#include "render/frame_graph.h"
 #include "event/event_bus.h"
 #include "event/window_events.h"
 #include "imgui.h"
@@ -77,8 +78,9 @@ static struct
 	ShaderHandle lighten_shader;
 	ShaderHandle bloom_blur_shader;
 	FramebufferHandle final_render_target;
-	FramebufferHandle bloom_fbos[k_bloom_stage_count];
-	FramebufferHandle bloom_combine_fbo;
+	hash_t final_render_target_name = "default"_h;
+	hash_t bloom_fbos[k_bloom_stage_count];
+	hash_t bloom_combine_fbo = "BloomCombine"_h;
 	float bloom_stage_ratios[k_bloom_stage_count];
 
 #if !BLOOM_RETAIL
@@ -94,7 +96,7 @@ void PostProcessingRenderer::init(EventBus& event_bus)
 
     s_storage.final_render_target = Renderer::default_render_target();
 
-    // Create framebuffers for bloom pass
+    // Create framebuffers for bloom pass. They are transient: only allocated when bloom is used in a frame
     {
 	    FramebufferLayout layout
 	    {
@@ -105,17 +107,16 @@ void PostProcessingRenderer::init(EventBus& event_bus)
 			std::string fb_name     = "bloom_" + std::to_string(ii);
 			hash_t h_fb_name     = H_(fb_name.c_str());
 			float ratio = s_storage.bloom_stage_ratios[ii] = 1.f/(2.f+float(ii));//1.f/(pow(2.f,ii+1.f));
+			s_storage.bloom_fbos[ii] = h_fb_name;
 #if BLOOM_FBO_NP2
-			s_storage.bloom_fbos[ii] = FramebufferPool::create_framebuffer(h_fb_name, make_scope<FbRatioNP2Constraint>(ratio, ratio), FB_NONE, layout);
+			FramebufferPool::create_transient_framebuffer(h_fb_name, make_scope<FbRatioNP2Constraint>(ratio, ratio), FB_NONE, layout);
 #else
-			s_storage.bloom_fbos[ii] = FramebufferPool::create_framebuffer(h_fb_name, make_scope<FbRatioConstraint>(ratio, ratio), FB_NONE, layout);
+			FramebufferPool::create_transient_framebuffer(h_fb_name, make_scope<FbRatioConstraint>(ratio, ratio), FB_NONE, layout);
 #endif
 		}
 
 		// Bloom output framebuffer
-		std::string fb_name = "BloomCombine";
-		hash_t h_fb_name    = H_(fb_name.c_str());
-		s_storage.bloom_combine_fbo = FramebufferPool::create_framebuffer(h_fb_name, make_scope<FbRatioConstraint>(0.5f,0.5f), FB_NONE, layout);
+		FramebufferPool::create_transient_framebuffer(s_storage.bloom_combine_fbo, make_scope<FbRatioConstraint>(0.5f,0.5f), FB_NONE, layout);
 	}
 
 	// Initialize Gaussian kernel for bloom blur passes
@@ -166,41 +167,45 @@ void PostProcessingRenderer::shutdown()
 void PostProcessingRenderer::set_final_render_target(hash_t fb_hname)
 {
 	if(fb_hname == "default"_h || fb_hname == 0)
+	{
 		s_storage.final_render_target = Renderer::default_render_target();
+		s_storage.final_render_target_name = "default"_h;
+	}
 	else
+	{
 		s_storage.final_render_target = FramebufferPool::get_framebuffer(fb_hname);
+		s_storage.final_render_target_name = fb_hname;
+	}
 }
 
 void PostProcessingRenderer::bloom_pass(hash_t source_fb, uint32_t glow_index)
 {
-	FramebufferHandle source_fb_handle = FramebufferPool::get_framebuffer(source_fb);
-
-	VertexArrayHandle quad = CommonGeometry::get_mesh("quad"_h).VAO;
+	// Each stage is a pair of passes, so that the lifetime of a stage framebuffer ends before the next stage begins,
+	// and stage framebuffers of the same size can share storage
+	for(uint32_t ii=0; ii<k_bloom_stage_count; ++ii)
+	{
+		// * Given glow buffer as input, perform horizontal blur, output to bloom_xx
+		FrameGraph::add_pass("BloomBlurH"_h, {source_fb}, {s_storage.bloom_fbos[ii]}, [source_fb, glow_index, ii](uint8_t view_id)
+		{
+			FramebufferHandle source_fb_handle = FramebufferPool::get_framebuffer(source_fb);
+			VertexArrayHandle quad = CommonGeometry::get_mesh("quad"_h).VAO;
+			glm::vec2 screen_size = FramebufferPool::get_screen_size();
 
-	BlurUBOData blur_data;
+			BlurUBOData blur_data;
 #if !BLOOM_RETAIL
-	blur_data.kernel_half_size = s_storage.gk.half_size;
-	memcpy(blur_data.kernel_weights, s_storage.gk.weights, math::k_max_kernel_coefficients);
+			blur_data.kernel_half_size = s_storage.gk.half_size;
+			memcpy(blur_data.kernel_weights, s_storage.gk.weights, math::k_max_kernel_coefficients);
 #endif
-	glm::vec2 screen_size = FramebufferPool::get_screen_size();
-
-	uint8_t view_id = Renderer::next_layer_id();
-	SortKey key;
-	RenderState state;
-	state.rasterizer_state.cull_mode = CullMode::Back;
-	state.rasterizer_state.clear_flags = CLEAR_COLOR_FLAG;
-	state.blend_state = BlendState::Opaque;
-	state.depth_stencil_state.depth_test_enabled = false;
-
-	// * For each bloom stage xx, given glow buffer as input,
-	//   perform horizontal blur, output to bloom_xx
-	{
-		for(uint32_t ii=0; ii<k_bloom_stage_count; ++ii)
-		{
 			glm::vec2 target_size = screen_size * s_storage.bloom_stage_ratios[ii];
 			blur_data.offset = {1.f/target_size.x, 0.f}; // Offset is horizontal
 
-			state.render_target = s_storage.bloom_fbos[ii].index();
+			SortKey key;
+			RenderState state;
+			state.rasterizer_state.cull_mode = CullMode::Back;
+			state.rasterizer_state.clear_flags = CLEAR_COLOR_FLAG;
+			state.blend_state = BlendState::Opaque;
+			state.depth_stencil_state.depth_test_enabled = false;
+			state.render_target = FramebufferPool::get_framebuffer(s_storage.bloom_fbos[ii]).index();
 			uint64_t state_flags = state.encode();
 			key.set_sequence(s_storage.sequence++, view_id, s_storage.bloom_blur_shader);
 
@@ -208,71 +213,96 @@ void PostProcessingRenderer::bloom_pass(hash_t source_fb, uint32_t glow_index)
 			dc.set_texture(Renderer::get_framebuffer_texture(source_fb_handle, glow_index));
 			dc.add_dependency(Renderer::update_uniform_buffer(s_storage.blur_ubo, &blur_data, sizeof(BlurUBOData), DataOwnership::Copy));
 			Renderer::submit(key.encode(), dc);
-		}
-	}
+		});
 
-	state.blend_state = BlendState::Light;
-	state.render_target = s_storage.bloom_combine_fbo.index();
-	uint64_t state_flags = state.encode();
-	// * For each bloom stage xx, given framebuffer bloom_tmp_xx as input,
-	//   perform vertical blur, output to bloom_combine
-	{
-		for(uint32_t ii=0; ii<k_bloom_stage_count; ++ii)
+		// * Given framebuffer bloom_xx as input, perform vertical blur, accumulate to bloom_combine
+		FrameGraph::add_pass("BloomBlurV"_h, {s_storage.bloom_fbos[ii]}, {s_storage.bloom_combine_fbo}, [ii](uint8_t view_id)
 		{
+			VertexArrayHandle quad = CommonGeometry::get_mesh("quad"_h).VAO;
+			glm::vec2 screen_size = FramebufferPool::get_screen_size();
+
+			BlurUBOData blur_data;
+#if !BLOOM_RETAIL
+			blur_data.kernel_half_size = s_storage.gk.half_size;
+			memcpy(blur_data.kernel_weights, s_storage.gk.weights, math::k_max_kernel_coefficients);
+#endif
 			glm::vec2 target_size = screen_size * s_storage.bloom_stage_ratios[ii];
 			blur_data.offset = {0.f, 1.f/target_size.y}; // Offset is vertical
 
+			SortKey key;
+			RenderState state;
+			state.rasterizer_state.cull_mode = CullMode::Back;
+			// The target is cleared on render target switch, only the first stage may clear it
+			state.rasterizer_state.clear_flags = (ii == 0) ? CLEAR_COLOR_FLAG : CLEAR_NONE;
+			state.blend_state = BlendState::Light;
+			state.depth_stencil_state.depth_test_enabled = false;
+			state.render_target = FramebufferPool::get_framebuffer(s_storage.bloom_combine_fbo).index();
+			uint64_t state_flags = state.encode();
 			key.set_sequence(s_storage.sequence++, view_id, s_storage.bloom_blur_shader);
 
 			DrawCall dc(DrawCall::Indexed, state_flags, s_storage.bloom_blur_shader, quad);
-			dc.set_texture(Renderer::get_framebuffer_texture(s_storage.bloom_fbos[ii], 0));
+			dc.set_texture(Renderer::get_framebuffer_texture(FramebufferPool::get_framebuffer(s_storage.bloom_fbos[ii]), 0));
 			dc.add_dependency(Renderer::update_uniform_buffer(s_storage.blur_ubo, &blur_data, sizeof(BlurUBOData), DataOwnership::Copy));
 			Renderer::submit(key.encode(), dc);
-		}
+		});
 	}
 }
 
 void PostProcessingRenderer::combine(hash_t framebuffer, uint32_t index, bool use_bloom)
 {
     W_PROFILE_FUNCTION()
-	s_storage.pp_data.fb_size = FramebufferPool::get_size(framebuffer);
-	s_storage.pp_data.set_flag_enabled(PP_EN_BLOOM, use_bloom);
-    
-	uint8_t view_id = Renderer::next_layer_id();
-	SortKey key;
-	RenderState state;
-	state.render_target = s_storage.final_render_target.index();
-	state.rasterizer_state.cull_mode = CullMode::Back;
-	state.rasterizer_state.clear_flags = CLEAR_COLOR_FLAG;
-	state.blend_state = BlendState::Alpha;
-	state.depth_stencil_state.depth_test_enabled = false;
-
-	key.set_sequence(s_storage.sequence++, view_id, s_storage.pp_shader);
-	DrawCall dc(DrawCall::Indexed, state.encode(), s_storage.pp_shader, CommonGeometry::get_mesh("quad"_h).VAO);
-	dc.set_texture(Renderer::get_framebuffer_texture(FramebufferPool::get_framebuffer(framebuffer), index));
+
+	std::vector<hash_t> reads = {framebuffer};
 	if(use_bloom)
-		dc.set_texture(Renderer::get_framebuffer_texture(FramebufferPool::get_framebuffer("BloomCombine"_h), 0), 1);
-	dc.add_dependency(Renderer::update_uniform_buffer(s_storage.pp_ubo, &s_storage.pp_data, sizeof(PostProcessingData), DataOwnership::Copy));
-	Renderer::submit(key.encode(), dc);
+		reads.push_back(s_storage.bloom_combine_fbo);
+
+	// Bloom passes are culled if their output is not used
+	FramebufferHandle final_render_target = s_storage.final_render_target;
+	FrameGraph::add_pass("PostProcessing"_h, reads, {s_storage.final_render_target_name},
+		[framebuffer, index, use_bloom, final_render_target](uint8_t view_id)
+	{
+		s_storage.pp_data.fb_size = FramebufferPool::get_size(framebuffer);
+		s_storage.pp_data.set_flag_enabled(PP_EN_BLOOM, use_bloom);
+
+		SortKey key;
+		RenderState state;
+		state.render_target = final_render_target.index();
+		state.rasterizer_state.cull_mode = CullMode::Back;
+		state.rasterizer_state.clear_flags = CLEAR_COLOR_FLAG;
+		state.blend_state = BlendState::Alpha;
+		state.depth_stencil_state.depth_test_enabled = false;
+
+		key.set_sequence(s_storage.sequence++, view_id, s_storage.pp_shader);
+		DrawCall dc(DrawCall::Indexed, state.encode(), s_storage.pp_shader, CommonGeometry::get_mesh("quad"_h).VAO);
+		dc.set_texture(Renderer::get_framebuffer_texture(FramebufferPool::get_framebuffer(framebuffer), index));
+		if(use_bloom)
+			dc.set_texture(Renderer::get_framebuffer_texture(FramebufferPool::get_framebuffer(s_storage.bloom_combine_fbo), 0), 1);
+		dc.add_dependency(Renderer::update_uniform_buffer(s_storage.pp_ubo, &s_storage.pp_data, sizeof(PostProcessingData), DataOwnership::Copy));
+		Renderer::submit(key.encode(), dc);
+	});
 }
 
 void PostProcessingRenderer::lighten(hash_t framebuffer, uint32_t index)
 {
     W_PROFILE_FUNCTION()
-    
-	uint8_t view_id = Renderer::next_layer_id();
-	SortKey key;
-	RenderState state;
-	state.render_target = s_storage.final_render_target.index();
-	state.rasterizer_state.cull_mode = CullMode::Back;
-	state.rasterizer_state.clear_flags = CLEAR_COLOR_FLAG;
-	state.blend_state = BlendState::Light;
-	state.depth_stencil_state.depth_test_enabled = false;
-
-	key.set_sequence(s_storage.sequence++, view_id, s_storage.lighten_shader);
-	DrawCall dc(DrawCall::Indexed, state.encode(), s_storage.lighten_shader, CommonGeometry::get_mesh("quad"_h).VAO);
-	dc.set_texture(Renderer::get_framebuffer_texture(FramebufferPool::get_framebuffer(framebuffer), index));
-	Renderer::submit(key.encode(), dc);
+
+	FramebufferHandle final_render_target = s_storage.final_render_target;
+	FrameGraph::add_pass("Lighten"_h, {framebuffer}, {s_storage.final_render_target_name},
+		[framebuffer, index, final_render_target](uint8_t view_id)
+	{
+		SortKey key;
+		RenderState state;
+		state.render_target = final_render_target.index();
+		state.rasterizer_state.cull_mode = CullMode::Back;
+		state.rasterizer_state.clear_flags = CLEAR_COLOR_FLAG;
+		state.blend_state = BlendState::Light;
+		state.depth_stencil_state.depth_test_enabled = false;
+
+		key.set_sequence(s_storage.sequence++, view_id, s_storage.lighten_shader);
+		DrawCall dc(DrawCall::Indexed, state.encode(), s_storage.lighten_shader, CommonGeometry::get_mesh("quad"_h).VAO);
+		dc.set_texture(Renderer::get_framebuffer_texture(FramebufferPool::get_framebuffer(framebuffer), index));
+		Renderer::submit(key.encode(), dc);
+	});
 }
 
 static bool s_enable_chromatic_aberration  = true;
@@ -1,5 +1,7 @@
 #include "render/sort_key.h"
 
+#include <vector>
+
 namespace erwin
 {
 
@@ -32,6 +34,62 @@ constexpr uint64_t k_3_seq_mask      = uint64_t(0x00ffffff) << k_3_seq_shift;
 constexpr uint64_t k_3_shader_mask   = uint64_t(0x000000ff) << k_3_shader_shift;
 constexpr uint64_t k_3_subseq_mask   = uint64_t(0x000000ff) << k_3_subseq_shift;
 
+// Compact shader ids, a slot holds id+1 for registered shaders and 0 otherwise
+static struct
+{
+	HandleArray<uint16_t> slots;
+	std::vector<uint8_t> free_ids;
+	uint16_t ref_counts[256] = {0};
+	bool initialized = false;
+} s_shader_ids;
+
+void SortKey::register_shader(ShaderHandle shader_handle)
+{
+	if(!s_shader_ids.initialized)
+	{
+		// Lower ids are handed out first
+		for(int ii = 255; ii >= 0; --ii)
+			s_shader_ids.free_ids.push_back(uint8_t(ii));
+		s_shader_ids.initialized = true;
+	}
+
+	uint8_t id;
+	if(!s_shader_ids.free_ids.empty())
+	{
+		id = s_shader_ids.free_ids.back();
+		s_shader_ids.free_ids.pop_back();
+	}
+	else
+		id = uint8_t(shader_handle.index() & 0xff);
+
+	++s_shader_ids.ref_counts[id];
+	s_shader_ids.slots.reserve(shader_handle.index() + 1u);
+	s_shader_ids.slots[shader_handle.index()] = uint16_t(id + 1);
+}
+
+void SortKey::unregister_shader(ShaderHandle shader_handle)
+{
+	if(shader_handle.index() >= s_shader_ids.slots.capacity())
+		return;
+	uint16_t& slot = s_shader_ids.slots[shader_handle.index()];
+	if(slot == 0)
+		return;
+
+	uint8_t id = uint8_t(slot - 1);
+	if(--s_shader_ids.ref_counts[id] == 0)
+		s_shader_ids.free_ids.push_back(id);
+	slot = 0;
+}
+
+uint8_t SortKey::get_shader_id(ShaderHandle shader_handle)
+{
+	// Unregistered shaders (created outside of the renderer API) fall back to their index
+	if(shader_handle.index() >= s_shader_ids.slots.capacity())
+		return uint8_t(shader_handle.index() & 0xff);
+	uint16_t slot = s_shader_ids.slots[shader_handle.index()];
+	return (slot != 0) ? uint8_t(slot - 1) : uint8_t(shader_handle.index() & 0xff);
+}
+
 uint64_t SortKey::encode() const
 {
 	uint64_t head = ((uint64_t(view)     << k_view_shift     ) & k_view_mask)
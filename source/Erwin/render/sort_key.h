@@ -21,15 +21,24 @@ struct SortKey
 
 	static constexpr uint64_t k_skip = std::numeric_limits<uint64_t>::max();
 
+	// Layer id (see Renderer::next_layer_id()) of an encoded key, stored in the highest byte
+	static inline uint8_t get_layer_id(uint64_t key) { return uint8_t(key >> 56); }
+
 	// Encode key structure into a 64 bits number (the actual sorting key)
 	uint64_t encode() const;
 
+	// Shaders are identified by a compact 8-bit id in the key, so that shader handle indices are not
+	// limited to 256. When more than 256 shaders are alive, ids are shared, which only affects batching.
+	// Registration must happen on the main thread, ids can be read from any recording thread.
+	static void register_shader(ShaderHandle shader_handle);
+	static void unregister_shader(ShaderHandle shader_handle);
+	static uint8_t get_shader_id(ShaderHandle shader_handle);
+
 	inline void set_depth(float _depth, uint8_t layer_id, uint64_t state_flags, ShaderHandle shader_handle, uint8_t _sub_sequence=0)
 	{
-		K_ASSERT(shader_handle.index()<256, "Shader index out of bounds in shader sorting key section.");
 		view         = uint16_t(uint16_t(layer_id)<<8);
 		view        |= uint8_t((state_flags & k_framebuffer_mask) >> k_framebuffer_shift);
-		shader       = uint8_t(shader_handle.index());
+		shader       = get_shader_id(shader_handle);
 		sub_sequence = _sub_sequence;
 		depth        = uint32_t(glm::clamp(std::fabs(_depth), 0.f, 1.f) * 0x00ffffff);
 		blending     = RenderState::is_transparent(state_flags);
@@ -38,9 +47,8 @@ struct SortKey
 
 	inline void set_sequence(uint32_t _sequence, uint8_t layer_id, ShaderHandle shader_handle, uint8_t _sub_sequence=0)
 	{
-		K_ASSERT(shader_handle.index()<256, "Shader index out of bounds in shader sorting key section.");
 		view         = uint16_t(uint16_t(layer_id)<<8);
-		shader       = uint8_t(shader_handle.index());
+		shader       = get_shader_id(shader_handle);
 		sub_sequence = _sub_sequence;
 		sequence     = _sequence;
 		blending     = false;
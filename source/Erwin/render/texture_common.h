@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 namespace erwin
@@ -73,6 +75,50 @@ static bool is_floating_point(ImageFormat format)
            format == ImageFormat::RGBA32F);
 }
 
+// Storage size of a texel in bits, block compressed formats are averaged over their 4x4 blocks
+static inline uint32_t bits_per_texel(ImageFormat format)
+{
+    switch(format)
+    {
+    case ImageFormat::R8:                              return 8;
+    case ImageFormat::RGB8:                            return 24;
+    case ImageFormat::RGBA8:                           return 32;
+    case ImageFormat::RG16F:                           return 32;
+    case ImageFormat::RGB16F:                          return 48;
+    case ImageFormat::RGBA16F:                         return 64;
+    case ImageFormat::RGB32F:                          return 96;
+    case ImageFormat::RGBA32F:                         return 128;
+    case ImageFormat::SRGB8:                           return 24;
+    case ImageFormat::SRGB_ALPHA:                      return 32;
+    case ImageFormat::RG16_SNORM:                      return 32;
+    case ImageFormat::RGB16_SNORM:                     return 48;
+    case ImageFormat::RGBA16_SNORM:                    return 64;
+    case ImageFormat::COMPRESSED_RGB_S3TC_DXT1:        return 4;
+    case ImageFormat::COMPRESSED_RGBA_S3TC_DXT1:       return 4;
+    case ImageFormat::COMPRESSED_RGBA_S3TC_DXT3:       return 8;
+    case ImageFormat::COMPRESSED_RGBA_S3TC_DXT5:       return 8;
+    case ImageFormat::COMPRESSED_SRGB_S3TC_DXT1:       return 4;
+    case ImageFormat::COMPRESSED_SRGB_ALPHA_S3TC_DXT1: return 4;
+    case ImageFormat::COMPRESSED_SRGB_ALPHA_S3TC_DXT3: return 8;
+    case ImageFormat::COMPRESSED_SRGB_ALPHA_S3TC_DXT5: return 8;
+    case ImageFormat::DEPTH_COMPONENT16:               return 16;
+    case ImageFormat::DEPTH_COMPONENT24:               return 32;
+    case ImageFormat::DEPTH_COMPONENT32F:              return 32;
+    case ImageFormat::DEPTH24_STENCIL8:                return 32;
+    case ImageFormat::DEPTH32F_STENCIL8:               return 64;
+    default:                                           return 0;
+    }
+}
+
+// Size in bytes of a 2D texture and its mip levels
+static inline size_t texture_storage_size(uint32_t width, uint32_t height, uint32_t mips, ImageFormat format)
+{
+    size_t size = 0;
+    for(uint32_t level = 0; level <= mips; ++level)
+        size += size_t(std::max(1u, width >> level)) * size_t(std::max(1u, height >> level));
+    return size * bits_per_texel(format) / 8;
+}
+
 enum TextureFlags: uint8_t
 {
     TF_NONE        = 0,
@@ -147,8 +193,35 @@ struct CubemapDescriptor
     uint8_t filter = MIN_LINEAR | MAG_LINEAR;
     TextureWrap wrap = TextureWrap::CLAMP_TO_EDGE;
     bool lazy_mipmap = false;
+    // Optional half float texels of all mip levels, see cubemap_mip_chain_size(). Supersedes face_data
+    // and mipmap generation. Only for RGB16F and RGBA16F cubemaps.
+    void* mip_data = nullptr;
+    bool must_free = false; // Let the renderer free mip_data once the cubemap is created
+
+    void release()
+    {
+        if(must_free)
+        {
+            delete[] (static_cast<uint8_t*>(mip_data));
+            mip_data = nullptr;
+        }
+    }
 };
 
+// Size in bytes of the half float texels of all faces and mip levels of a RGB16F or RGBA16F cubemap.
+// Texels are ordered by mip level, then by face (+X, -X, +Y, -Y, +Z, -Z), then by row.
+inline size_t cubemap_mip_chain_size(uint32_t width, uint32_t mips, ImageFormat format)
+{
+    size_t texel_size = (format == ImageFormat::RGBA16F) ? 8 : 6;
+    size_t size = 0;
+    for(uint32_t level = 0; level <= mips; ++level)
+    {
+        size_t level_width = std::max(1u, width >> level);
+        size += 6 * level_width * level_width * texel_size;
+    }
+    return size;
+}
+
 struct PixelData
 {
     uint8_t* data;
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace erwin
+{
+
+// 64-bit FNV-1a, fast and good enough for cache keys and change detection. Not suitable for adversarial input.
+static constexpr uint64_t k_fnv1a_seed = 0xcbf29ce484222325ull;
+static constexpr uint64_t k_fnv1a_prime = 0x100000001b3ull;
+
+// Hash a byte range, a previous hash can be passed as a seed to chain ranges
+inline uint64_t fnv1a(const void* data, std::size_t size, uint64_t seed = k_fnv1a_seed)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for(std::size_t ii = 0; ii < size; ++ii)
+        hash = (hash ^ bytes[ii]) * k_fnv1a_prime;
+    return hash;
+}
+
+// Mix a whole value into a hash in a single step
+inline uint64_t fnv1a_combine(uint64_t hash, uint64_t value) { return (hash ^ value) * k_fnv1a_prime; }
+
+} // namespace erwin
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace erwin
+{
+
+// LSD radix sort for (64 bits key, payload) pairs, 8 bits per pass.
+// Sorting is stable and happens in place, a scratch buffer of at least count elements is needed.
+// All byte histograms are computed in a single read pass, and passes for which every key
+// shares the same byte value are skipped altogether. Already sorted inputs are detected and left untouched.
+template <typename T> void radix_sort(std::pair<uint64_t, T>* data, std::pair<uint64_t, T>* scratch, std::size_t count)
+{
+    constexpr std::size_t k_passes = sizeof(uint64_t);
+    constexpr std::size_t k_radix = 256;
+
+    if(count < 2)
+        return;
+
+    uint32_t histograms[k_passes][k_radix];
+    std::memset(histograms, 0, sizeof(histograms));
+
+    bool sorted = true;
+    uint64_t last_key = data[0].first;
+    for(std::size_t ii = 0; ii < count; ++ii)
+    {
+        uint64_t key = data[ii].first;
+        sorted &= (last_key <= key);
+        last_key = key;
+        for(std::size_t pass = 0; pass < k_passes; ++pass)
+            ++histograms[pass][(key >> (pass * 8)) & 0xff];
+    }
+
+    if(sorted)
+        return;
+
+    auto* src = data;
+    auto* dst = scratch;
+    for(std::size_t pass = 0; pass < k_passes; ++pass)
+    {
+        const std::size_t shift = pass * 8;
+        uint32_t* offsets = histograms[pass];
+
+        // Every key has the same byte value at this position, this pass would be an identity permutation
+        if(offsets[(src[0].first >> shift) & 0xff] == count)
+            continue;
+
+        // Exclusive prefix sum to get bucket offsets
+        uint32_t sum = 0;
+        for(std::size_t bucket = 0; bucket < k_radix; ++bucket)
+        {
+            uint32_t bucket_count = offsets[bucket];
+            offsets[bucket] = sum;
+            sum += bucket_count;
+        }
+
+        for(std::size_t ii = 0; ii < count; ++ii)
+            dst[offsets[(src[ii].first >> shift) & 0xff]++] = src[ii];
+
+        std::swap(src, dst);
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if(src != data)
+        std::copy(src, src + count, data);
+}
+
+} // namespace erwin
@@ -0,0 +1,1072 @@
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "core/application.h"
+#include "core/core.h"
+#include "platform/Null/null_backend.h"
+#include "render/framebuffer_layout.h"
+#include "render/renderer_config.h"
+#include "utils/promise_storage.hpp"
+#include <kibble/logger/logger.h>
+#include <kibble/math/color.h>
+
+namespace erwin
+{
+
+static constexpr uint16_t k_invalid_index = 0xffff;
+
+// Minimal description of a device resource, enough for handle bookkeeping
+struct NullResource
+{
+    bool alive = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t size = 0;
+
+    inline void init(uint32_t _size, uint32_t _width = 0, uint32_t _height = 0)
+    {
+        alive = true;
+        size = _size;
+        width = _width;
+        height = _height;
+    }
+
+    inline void release() { alive = false; }
+};
+
+struct NullFramebuffer
+{
+    bool alive = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t flags = 0;
+
+    inline bool has_cubemap() const { return bool(flags & FBFlag::FB_CUBEMAP_ATTACHMENT); }
+};
+
+// Buffers owned by a vertex array, their handles are released by the renderer
+struct NullVertexArrayDependencies
+{
+    std::vector<VertexBufferHandle> vbos;
+    IndexBufferHandle ibo = {};
+
+    inline void clear()
+    {
+        vbos.clear();
+        ibo = {};
+    }
+};
+
+static struct NullDeviceStorage
+{
+    void init()
+    {
+        state_cache_ = RenderState().encode();
+        reserved_growth_count_ = ~HandlePool::get_growth_count(); // Force a reservation
+        reserve_handles();
+        vertex_buffer_layouts.reserve(VertexBufferLayoutHandle::s_ppool_->capacity());
+        clear_resources();
+
+        default_framebuffer_ = FramebufferHandle::acquire();
+        current_framebuffer_index_ = default_framebuffer_.index();
+
+        invalidate_texture_cache();
+        invalidate_cubemap_cache();
+        last_VAO_index = k_invalid_index;
+        last_shader_index = k_invalid_index;
+        stats = {};
+        counters = {};
+        records.clear();
+    }
+
+    void release()
+    {
+        flush_deferred_releases();
+        default_framebuffer_.release();
+        clear_resources();
+    }
+
+    inline void flush_deferred_releases()
+    {
+        for(auto& release : deferred_releases)
+            release();
+        deferred_releases.clear();
+    }
+
+    inline void clear_resources()
+    {
+        index_buffers.for_each([](auto& obj) { obj.release(); });
+        vertex_buffers.for_each([](auto& obj) { obj.release(); });
+        vertex_arrays.for_each([](auto& obj) { obj.release(); });
+        uniform_buffers.for_each([](auto& obj) { obj.release(); });
+        shader_storage_buffers.for_each([](auto& obj) { obj.release(); });
+        shaders.for_each([](auto& obj) { obj.release(); });
+        textures.for_each([](auto& obj) { obj.release(); });
+        cubemaps.for_each([](auto& obj) { obj.release(); });
+        framebuffers.for_each([](auto& obj) { obj.alive = false; });
+        vertex_buffer_layouts.for_each([](auto& obj) { obj = nullptr; });
+        vertex_array_dependencies.for_each([](auto& obj) { obj.clear(); });
+
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        framebuffer_textures_.clear();
+    }
+
+    inline FramebufferTextureVector get_texture_vector(uint16_t framebuffer_index)
+    {
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        return framebuffer_textures_[framebuffer_index];
+    }
+
+    // Handle pools grow on demand, make sure every handle acquired so far has its storage. Pools grow on the
+    // main thread before the commands using the new handles are submitted, so this is only needed after a growth.
+    // Vertex buffer layouts are created on the main thread and reserved there.
+    inline void reserve_handles()
+    {
+        uint32_t growth_count = HandlePool::get_growth_count();
+        if(growth_count == reserved_growth_count_)
+            return;
+        reserved_growth_count_ = growth_count;
+
+        vertex_array_dependencies.reserve(VertexArrayHandle::s_ppool_->capacity());
+        index_buffers.reserve(IndexBufferHandle::s_ppool_->capacity());
+        vertex_buffers.reserve(VertexBufferHandle::s_ppool_->capacity());
+        vertex_arrays.reserve(VertexArrayHandle::s_ppool_->capacity());
+        uniform_buffers.reserve(UniformBufferHandle::s_ppool_->capacity());
+        shader_storage_buffers.reserve(ShaderStorageBufferHandle::s_ppool_->capacity());
+        shaders.reserve(ShaderHandle::s_ppool_->capacity());
+        textures.reserve(TextureHandle::s_ppool_->capacity());
+        cubemaps.reserve(CubemapHandle::s_ppool_->capacity());
+        framebuffers.reserve(FramebufferHandle::s_ppool_->capacity());
+    }
+
+    inline void invalidate_texture_cache()
+    {
+        std::fill(last_texture_index, last_texture_index + k_max_texture_slots, k_invalid_index);
+    }
+
+    inline void invalidate_cubemap_cache()
+    {
+        std::fill(last_cubemap_index, last_cubemap_index + k_max_cubemap_slots, k_invalid_index);
+    }
+
+    inline void record(bool draw, uint16_t type, uint16_t handle, uint64_t state = 0)
+    {
+        if(recording)
+            records.push_back({draw, type, handle, state});
+    }
+
+    FramebufferHandle default_framebuffer_ = {};
+    uint16_t current_framebuffer_index_ = {};
+    std::map<uint16_t, FramebufferTextureVector> framebuffer_textures_;
+    std::mutex shared_mutex; // Framebuffer texture vectors are also accessed by the main thread
+    HandleArray<NullVertexArrayDependencies> vertex_array_dependencies;
+
+    HandleArray<NullResource> index_buffers;
+    HandleArray<NullResource> vertex_buffers;
+    HandleArray<NullResource> vertex_arrays;
+    HandleArray<NullResource> uniform_buffers;
+    HandleArray<NullResource> shader_storage_buffers;
+    HandleArray<NullResource> shaders;
+    HandleArray<NullResource> textures;
+    HandleArray<NullResource> cubemaps;
+    HandleArray<NullFramebuffer> framebuffers;
+    HandleArray<WRef<BufferLayout>> vertex_buffer_layouts;
+
+    PromiseStorage<PixelData> texture_data_promises_;
+    uint64_t state_cache_;
+    uint32_t reserved_growth_count_ = 0;
+    uint16_t last_shader_index;
+    uint16_t last_VAO_index;
+    uint16_t last_texture_index[k_max_texture_slots];
+    uint16_t last_cubemap_index[k_max_cubemap_slots];
+
+    NullBackend::Statistics stats;
+    // Destroyed resources are released at the end of the frame, like the OpenGL backend does once the GPU is done
+    std::vector<std::function<void()>> deferred_releases;
+    StateCounters counters; // Per-frame
+    bool recording = false;
+    std::vector<NullBackend::Record> records;
+} s_storage;
+
+NullBackend::NullBackend()
+{
+    KLOGN("render") << "[NullBackend] Using headless graphics backend." << std::endl;
+    s_storage.init();
+    s_storage.recording = CFG_.get<bool>("erwin.renderer.null_record"_h, false);
+}
+
+void NullBackend::release()
+{
+    // Commands recorded during the whole session are written on shutdown
+    if(s_storage.recording)
+    {
+        fs::path record_path = CFG_.get<std::string>("erwin.renderer.null_record_path"_h, "null_record.txt");
+        KLOGN("render") << "[NullBackend] Exporting " << s_storage.records.size() << " recorded commands:" << std::endl;
+        KLOGI << kb::KS_PATH_ << record_path << std::endl;
+        export_records(record_path);
+    }
+    s_storage.release();
+}
+
+void NullBackend::set_recording(bool value) { s_storage.recording = value; }
+
+bool NullBackend::is_recording() const { return s_storage.recording; }
+
+const std::vector<NullBackend::Record>& NullBackend::get_records() const { return s_storage.records; }
+
+void NullBackend::clear_records() { s_storage.records.clear(); }
+
+void NullBackend::export_records(const fs::path& filepath) const
+{
+    std::ofstream ofs(filepath);
+    for(const auto& rec : s_storage.records)
+    {
+        ofs << (rec.draw ? 'D' : 'R') << ' ' << rec.type << ' ' << rec.handle;
+        if(rec.draw)
+            ofs << ' ' << std::hex << rec.state << std::dec;
+        ofs << std::endl;
+    }
+}
+
+const NullBackend::Statistics& NullBackend::get_statistics() const { return s_storage.stats; }
+
+void NullBackend::reset_statistics() { s_storage.stats = {}; }
+
+uint32_t NullBackend::get_live_resource_count() const
+{
+    auto count_alive = [](const auto& container) {
+        uint32_t count = 0;
+        container.for_each([&count](const auto& obj) { count += obj.alive ? 1 : 0; });
+        return count;
+    };
+
+    return count_alive(s_storage.index_buffers) + count_alive(s_storage.vertex_buffers) +
+           count_alive(s_storage.vertex_arrays) + count_alive(s_storage.uniform_buffers) +
+           count_alive(s_storage.shader_storage_buffers) + count_alive(s_storage.shaders) +
+           count_alive(s_storage.textures) + count_alive(s_storage.cubemaps) + count_alive(s_storage.framebuffers);
+}
+
+void NullBackend::add_framebuffer_texture_vector(FramebufferHandle handle, const FramebufferTextureVector& ftv)
+{
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+    s_storage.framebuffer_textures_.insert(std::make_pair(handle.index(), ftv));
+}
+
+void NullBackend::bind_default_framebuffer()
+{
+    s_storage.current_framebuffer_index_ = s_storage.default_framebuffer_.index();
+}
+
+void NullBackend::read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels)
+{
+    std::fill(pixels, pixels + 4 * width * height, 0);
+}
+
+std::pair<uint64_t, std::future<PixelData>> NullBackend::future_texture_data()
+{
+    return s_storage.texture_data_promises_.future_operation();
+}
+
+FramebufferHandle NullBackend::default_render_target() { return s_storage.default_framebuffer_; }
+
+TextureHandle NullBackend::get_framebuffer_texture(FramebufferHandle handle, uint32_t index)
+{
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+    K_ASSERT(index < s_storage.framebuffer_textures_[handle.index()].handles.size(),
+             "Invalid framebuffer texture index.");
+    return s_storage.framebuffer_textures_[handle.index()].handles[index];
+}
+
+CubemapHandle NullBackend::get_framebuffer_cubemap(FramebufferHandle handle)
+{
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+    return s_storage.framebuffer_textures_[handle.index()].cubemap;
+}
+
+hash_t NullBackend::get_framebuffer_texture_name(FramebufferHandle handle, uint32_t index)
+{
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+    return s_storage.framebuffer_textures_[handle.index()].debug_names[index];
+}
+
+uint32_t NullBackend::get_framebuffer_texture_count(FramebufferHandle handle)
+{
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+    return uint32_t(s_storage.framebuffer_textures_[handle.index()].handles.size());
+}
+
+void* NullBackend::get_native_texture_handle(TextureHandle) { return nullptr; }
+
+VertexBufferLayoutHandle NullBackend::create_vertex_buffer_layout(const std::vector<BufferLayoutElement>& elements)
+{
+    VertexBufferLayoutHandle handle = VertexBufferLayoutHandle::acquire();
+    K_ASSERT(handle.is_valid(), "No more free handle in handle pool.");
+
+    s_storage.vertex_buffer_layouts.reserve(VertexBufferLayoutHandle::s_ppool_->capacity());
+    s_storage.vertex_buffer_layouts[handle.index()] = make_ref<BufferLayout>(&elements[0], elements.size());
+
+    return handle;
+}
+
+const BufferLayout& NullBackend::get_vertex_buffer_layout(VertexBufferLayoutHandle handle)
+{
+    return *s_storage.vertex_buffer_layouts[handle.index()];
+}
+
+void NullBackend::set_clear_color(float, float, float, float) {}
+
+void NullBackend::clear(int) { ++s_storage.stats.clears; }
+
+void NullBackend::lock_color_buffer() {}
+
+void NullBackend::set_seamless_cubemaps_enabled(bool) {}
+
+void NullBackend::set_depth_lock(bool) {}
+
+void NullBackend::set_stencil_lock(bool) {}
+
+void NullBackend::set_depth_func(DepthFunc) {}
+
+void NullBackend::set_depth_test_enabled(bool) {}
+
+void NullBackend::set_stencil_func(StencilFunc, uint16_t, uint16_t) {}
+
+void NullBackend::set_stencil_operator(StencilOperator) {}
+
+void NullBackend::set_stencil_test_enabled(bool) {}
+
+void NullBackend::set_std_blending() {}
+
+void NullBackend::set_light_blending() {}
+
+void NullBackend::disable_blending() {}
+
+void NullBackend::set_pack_alignment(uint32_t) {}
+
+void NullBackend::set_unpack_alignment(uint32_t) {}
+
+void NullBackend::viewport(float, float, float, float) {}
+
+void NullBackend::set_cull_mode(CullMode) {}
+
+void NullBackend::set_line_width(float) {}
+
+void NullBackend::finish() {}
+
+void NullBackend::flush() {}
+
+void NullBackend::end_frame()
+{
+    ++s_storage.stats.frames;
+    s_storage.stats.state_counters += s_storage.counters;
+    s_storage.flush_deferred_releases();
+    s_storage.counters = {};
+}
+
+const StateCounters& NullBackend::get_state_counters() const { return s_storage.counters; }
+
+static const std::string s_no_error = "No error";
+
+uint32_t NullBackend::get_error() { return 0; }
+
+const std::string& NullBackend::show_error() { return s_no_error; }
+
+void NullBackend::assert_no_error() {}
+
+/*
+          _____  _                 _       _
+         |  __ \(_)               | |     | |
+         | |  | |_ ___ _ __   __ _| |_ ___| |__
+         | |  | | / __| '_ \ / _` | __/ __| '_ \
+         | |__| | \__ \ |_) | (_| | || (__| | | |
+         |_____/|_|___/ .__/ \__,_|\__\___|_| |_|
+                      | |
+                      |_|
+*/
+
+// Command decoding must stay in sync with the OpenGL backend dispatch functions
+namespace null_render_dispatch
+{
+
+template <typename HandleT> static inline HandleT read_handle(memory::LinearBuffer<>& buf, RenderCommand type)
+{
+    HandleT handle;
+    buf.read(&handle);
+    s_storage.record(false, uint16_t(type), handle.index());
+    return handle;
+}
+
+void create_index_buffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t count;
+    DrawPrimitive primitive;
+    UsagePattern mode;
+    uint32_t* auxiliary;
+
+    auto handle = read_handle<IndexBufferHandle>(buf, RenderCommand::CreateIndexBuffer);
+    buf.read(&count);
+    buf.read(&primitive);
+    buf.read(&mode);
+    buf.read(&auxiliary);
+
+    s_storage.index_buffers[handle.index()].init(count);
+}
+
+void create_vertex_buffer(memory::LinearBuffer<>& buf)
+{
+    VertexBufferLayoutHandle layout_hnd;
+    uint32_t count;
+    UsagePattern mode;
+    float* auxiliary;
+
+    auto handle = read_handle<VertexBufferHandle>(buf, RenderCommand::CreateVertexBuffer);
+    buf.read(&layout_hnd);
+    buf.read(&count);
+    buf.read(&mode);
+    buf.read(&auxiliary);
+
+    K_ASSERT(s_storage.vertex_buffer_layouts[layout_hnd.index()] != nullptr, "Invalid vertex buffer layout.");
+    s_storage.vertex_buffers[handle.index()].init(count);
+}
+
+void create_vertex_array(memory::LinearBuffer<>& buf)
+{
+    IndexBufferHandle ib;
+    VertexBufferHandle vb;
+
+    auto handle = read_handle<VertexArrayHandle>(buf, RenderCommand::CreateVertexArray);
+    buf.read(&ib);
+    buf.read(&vb);
+
+    K_ASSERT(s_storage.vertex_buffers[vb.index()].alive, "Vertex array refers to a dead vertex buffer.");
+    s_storage.vertex_arrays[handle.index()].init(1);
+    s_storage.vertex_array_dependencies[handle.index()].vbos.push_back(vb);
+    if(!ib.is_null())
+        s_storage.vertex_array_dependencies[handle.index()].ibo = ib;
+
+    s_storage.last_VAO_index = k_invalid_index;
+}
+
+void create_vertex_array_multiple_VBO(memory::LinearBuffer<>& buf)
+{
+    IndexBufferHandle ib;
+    uint8_t VBO_count;
+
+    auto handle = read_handle<VertexArrayHandle>(buf, RenderCommand::CreateVertexArrayMultipleVBO);
+    buf.read(&ib);
+    buf.read(&VBO_count);
+
+    s_storage.vertex_arrays[handle.index()].init(VBO_count);
+    for(uint8_t ii = 0; ii < VBO_count; ++ii)
+    {
+        VertexBufferHandle vb;
+        buf.read(&vb);
+        s_storage.vertex_array_dependencies[handle.index()].vbos.push_back(vb);
+    }
+    if(!ib.is_null())
+        s_storage.vertex_array_dependencies[handle.index()].ibo = ib;
+
+    s_storage.last_VAO_index = k_invalid_index;
+}
+
+void create_uniform_buffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t size;
+    UsagePattern mode;
+    std::string name;
+    uint8_t* auxiliary;
+
+    auto handle = read_handle<UniformBufferHandle>(buf, RenderCommand::CreateUniformBuffer);
+    buf.read(&size);
+    buf.read(&mode);
+    buf.read_str(name);
+    buf.read(&auxiliary);
+
+    s_storage.uniform_buffers[handle.index()].init(size);
+}
+
+void create_shader_storage_buffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t size;
+    UsagePattern mode;
+    std::string name;
+    uint8_t* auxiliary;
+
+    auto handle = read_handle<ShaderStorageBufferHandle>(buf, RenderCommand::CreateShaderStorageBuffer);
+    buf.read(&size);
+    buf.read(&mode);
+    buf.read_str(name);
+    buf.read(&auxiliary);
+
+    s_storage.shader_storage_buffers[handle.index()].init(size);
+}
+
+void create_shader(memory::LinearBuffer<>& buf)
+{
+    std::string filepath;
+    std::string name;
+
+    auto handle = read_handle<ShaderHandle>(buf, RenderCommand::CreateShader);
+    buf.read_str(filepath);
+    buf.read_str(name);
+
+    s_storage.shaders[handle.index()].init(0);
+    s_storage.last_shader_index = k_invalid_index;
+}
+
+void create_texture_2D(memory::LinearBuffer<>& buf)
+{
+    Texture2DDescriptor descriptor;
+
+    auto handle = read_handle<TextureHandle>(buf, RenderCommand::CreateTexture2D);
+    buf.read(&descriptor);
+
+    s_storage.textures[handle.index()].init(0, descriptor.width, descriptor.height);
+    // Free resources if needed
+    descriptor.release();
+
+    s_storage.invalidate_texture_cache();
+}
+
+void create_cubemap(memory::LinearBuffer<>& buf)
+{
+    CubemapDescriptor descriptor;
+
+    auto handle = read_handle<CubemapHandle>(buf, RenderCommand::CreateCubemap);
+    buf.read(&descriptor);
+
+    s_storage.cubemaps[handle.index()].init(0, descriptor.width, descriptor.height);
+    // Free resources if needed
+    descriptor.release();
+
+    s_storage.invalidate_cubemap_cache();
+}
+
+void create_framebuffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t count;
+    uint8_t flags;
+    FramebufferLayoutElement* auxiliary;
+
+    auto handle = read_handle<FramebufferHandle>(buf, RenderCommand::CreateFramebuffer);
+    buf.read(&width);
+    buf.read(&height);
+    buf.read(&flags);
+    buf.read(&count);
+    buf.read(&auxiliary);
+
+    auto& fb = s_storage.framebuffers[handle.index()];
+    fb = {true, width, height, flags};
+
+    // Attachments are created alongside the framebuffer
+    auto texture_vector = s_storage.get_texture_vector(handle.index());
+    if(fb.has_cubemap())
+        s_storage.cubemaps[texture_vector.cubemap.index()].init(0, width, height);
+    else
+        for(TextureHandle tex : texture_vector.handles)
+            s_storage.textures[tex.index()].init(0, width, height);
+}
+
+void update_index_buffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t count;
+    uint32_t* auxiliary;
+
+    uint32_t offset;
+
+    auto handle = read_handle<IndexBufferHandle>(buf, RenderCommand::UpdateIndexBuffer);
+    buf.read(&count);
+    buf.read(&auxiliary);
+    buf.read(&offset);
+
+    K_ASSERT(s_storage.index_buffers[handle.index()].alive, "Updating a dead index buffer.");
+}
+
+void update_vertex_buffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t size;
+    uint8_t* auxiliary;
+
+    uint32_t offset;
+
+    auto handle = read_handle<VertexBufferHandle>(buf, RenderCommand::UpdateVertexBuffer);
+    buf.read(&size);
+    buf.read(&auxiliary);
+    buf.read(&offset);
+
+    K_ASSERT(s_storage.vertex_buffers[handle.index()].alive, "Updating a dead vertex buffer.");
+}
+
+void update_uniform_buffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t size;
+    uint8_t* auxiliary;
+
+    auto handle = read_handle<UniformBufferHandle>(buf, RenderCommand::UpdateUniformBuffer);
+    buf.read(&size);
+    buf.read(&auxiliary);
+
+    K_ASSERT(s_storage.uniform_buffers[handle.index()].alive, "Updating a dead uniform buffer.");
+}
+
+void update_shader_storage_buffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t size;
+    uint8_t* auxiliary;
+
+    auto handle = read_handle<ShaderStorageBufferHandle>(buf, RenderCommand::UpdateShaderStorageBuffer);
+    buf.read(&size);
+    buf.read(&auxiliary);
+
+    K_ASSERT(s_storage.shader_storage_buffers[handle.index()].alive, "Updating a dead shader storage buffer.");
+}
+
+void shader_attach_uniform_buffer(memory::LinearBuffer<>& buf)
+{
+    UniformBufferHandle ubo_handle;
+
+    auto shader_handle = read_handle<ShaderHandle>(buf, RenderCommand::ShaderAttachUniformBuffer);
+    buf.read(&ubo_handle);
+
+    K_ASSERT(s_storage.shaders[shader_handle.index()].alive, "Attaching a UBO to a dead shader.");
+}
+
+void shader_attach_storage_buffer(memory::LinearBuffer<>& buf)
+{
+    ShaderStorageBufferHandle ssbo_handle;
+
+    auto shader_handle = read_handle<ShaderHandle>(buf, RenderCommand::ShaderAttachStorageBuffer);
+    buf.read(&ssbo_handle);
+
+    K_ASSERT(s_storage.shaders[shader_handle.index()].alive, "Attaching an SSBO to a dead shader.");
+}
+
+void update_framebuffer(memory::LinearBuffer<>& buf)
+{
+    uint32_t width;
+    uint32_t height;
+
+    auto fb_handle = read_handle<FramebufferHandle>(buf, RenderCommand::UpdateFramebuffer);
+    buf.read(&width);
+    buf.read(&height);
+
+    auto& fb = s_storage.framebuffers[fb_handle.index()];
+    fb.width = width;
+    fb.height = height;
+}
+
+void clear_framebuffers(memory::LinearBuffer<>&) { K_ASSERT(false, "Clear framebuffers not implemented."); }
+
+void set_host_window_size(memory::LinearBuffer<>& buf)
+{
+    uint32_t width;
+    uint32_t height;
+    buf.read(&width);
+    buf.read(&height);
+    s_storage.record(false, uint16_t(RenderCommand::SetHostWindowSize), k_invalid_index);
+}
+
+void nop(memory::LinearBuffer<>&) {}
+
+void get_pixel_data(memory::LinearBuffer<>& buf)
+{
+    size_t promise_token;
+
+    auto handle = read_handle<TextureHandle>(buf, RenderCommand::GetPixelData);
+    buf.read(&promise_token);
+
+    const auto& texture = s_storage.textures[handle.index()];
+    size_t size = 4 * texture.width * texture.height;
+    s_storage.texture_data_promises_.fulfill(promise_token, PixelData{new uint8_t[size](), size});
+}
+
+void get_cubemap_pixel_data(memory::LinearBuffer<>& buf)
+{
+    size_t promise_token;
+
+    read_handle<CubemapHandle>(buf, RenderCommand::GetCubemapPixelData);
+    buf.read(&promise_token);
+
+    // Mip levels are not tracked, there is no pixel data to hand out
+    s_storage.texture_data_promises_.fulfill(promise_token, PixelData{nullptr, 0});
+}
+
+void generate_cubemap_mipmaps(memory::LinearBuffer<>& buf)
+{
+    read_handle<CubemapHandle>(buf, RenderCommand::GenerateCubemapMipmaps);
+}
+
+void framebuffer_screenshot(memory::LinearBuffer<>& buf)
+{
+    std::string filepath;
+
+    read_handle<FramebufferHandle>(buf, RenderCommand::FramebufferScreenshot);
+    buf.read_str(filepath);
+}
+
+void destroy_index_buffer(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<IndexBufferHandle>(buf, RenderCommand::DestroyIndexBuffer);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.index_buffers[handle.index()].release();
+    });
+}
+
+void destroy_vertex_buffer_layout(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<VertexBufferLayoutHandle>(buf, RenderCommand::DestroyVertexBufferLayout);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.vertex_buffer_layouts[handle.index()] = nullptr;
+    });
+}
+
+void destroy_vertex_buffer(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<VertexBufferHandle>(buf, RenderCommand::DestroyVertexBuffer);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.vertex_buffers[handle.index()].release();
+    });
+}
+
+void destroy_vertex_array(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<VertexArrayHandle>(buf, RenderCommand::DestroyVertexArray);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.vertex_arrays[handle.index()].release();
+        // VBOs and IBO are owned by the vertex array, like in the OpenGL backend
+        auto& dependencies = s_storage.vertex_array_dependencies[handle.index()];
+        for(VertexBufferHandle vbo : dependencies.vbos)
+            s_storage.vertex_buffers[vbo.index()].release();
+        if(!dependencies.ibo.is_null())
+            s_storage.index_buffers[dependencies.ibo.index()].release();
+        dependencies.clear();
+    });
+}
+
+void destroy_uniform_buffer(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<UniformBufferHandle>(buf, RenderCommand::DestroyUniformBuffer);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.uniform_buffers[handle.index()].release();
+    });
+}
+
+void destroy_shader_storage_buffer(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<ShaderStorageBufferHandle>(buf, RenderCommand::DestroyShaderStorageBuffer);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.shader_storage_buffers[handle.index()].release();
+    });
+}
+
+void destroy_shader(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<ShaderHandle>(buf, RenderCommand::DestroyShader);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.shaders[handle.index()].release();
+    });
+}
+
+void destroy_texture_2D(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<TextureHandle>(buf, RenderCommand::DestroyTexture2D);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.textures[handle.index()].release();
+    });
+}
+
+void destroy_cubemap(memory::LinearBuffer<>& buf)
+{
+    auto handle = read_handle<CubemapHandle>(buf, RenderCommand::DestroyCubemap);
+    s_storage.deferred_releases.push_back([handle]() {
+        s_storage.cubemaps[handle.index()].release();
+    });
+}
+
+void destroy_framebuffer(memory::LinearBuffer<>& buf)
+{
+    bool detach_textures;
+
+    auto handle = read_handle<FramebufferHandle>(buf, RenderCommand::DestroyFramebuffer);
+    buf.read(&detach_textures);
+    s_storage.deferred_releases.push_back([handle, detach_textures]() {
+        auto& fb = s_storage.framebuffers[handle.index()];
+        fb.alive = false;
+
+        // Delete framebuffer textures if they are not detached, their handles were released by the renderer
+        std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+        if(!detach_textures)
+        {
+            const auto& texture_vector = s_storage.framebuffer_textures_[handle.index()];
+            if(!fb.has_cubemap())
+            {
+                for(auto texture : texture_vector.handles)
+                    s_storage.textures[texture.index()].release();
+            }
+            else
+                s_storage.cubemaps[texture_vector.cubemap.index()].release();
+        }
+
+        s_storage.framebuffer_textures_.erase(handle.index());
+    });
+}
+
+} // namespace null_render_dispatch
+
+// Same logic as the OpenGL backend state cache, device calls are replaced by counters
+static void handle_state(uint64_t state_flags)
+{
+    auto& counters = s_storage.counters;
+    if(state_flags == s_storage.state_cache_)
+    {
+        ++counters.state_hits;
+        return;
+    }
+
+    auto has_mutated = [state_flags](uint64_t mask) {
+        return !k_enable_state_cache || ((state_flags ^ s_storage.state_cache_) & mask) > 0;
+    };
+
+    RenderState state;
+    state.decode(state_flags);
+    auto& stats = s_storage.stats;
+    ++counters.state_changes;
+
+    if(has_mutated(k_framebuffer_mask) || has_mutated(k_target_mips_mask))
+    {
+        K_ASSERT(state.render_target == s_storage.default_framebuffer_.index() ||
+                     s_storage.framebuffers[state.render_target].alive,
+                 "Render target is a dead framebuffer.");
+        s_storage.current_framebuffer_index_ = state.render_target;
+        ++counters.render_target_switches;
+        if(state.rasterizer_state.clear_flags != ClearFlags::CLEAR_NONE)
+            ++stats.clears;
+    }
+
+    if(has_mutated(k_cull_mode_mask))
+        ++counters.cull_mode_changes;
+
+    if(has_mutated(k_transp_mask))
+        ++counters.blend_changes;
+
+    if(has_mutated(k_stencil_test_mask | k_depth_test_mask | k_depth_lock_mask | k_stencil_lock_mask))
+        ++counters.depth_stencil_changes;
+
+    s_storage.state_cache_ = state_flags;
+}
+
+namespace null_draw_dispatch
+{
+
+void draw(memory::LinearBuffer<>& buf)
+{
+    DrawCall::DrawCallType type;
+    DrawCall::Data data;
+    buf.read(&type);
+    buf.read(&data);
+    s_storage.record(true, uint16_t(DrawCommand::Draw), data.shader.index(), data.state_flags);
+
+    handle_state(data.state_flags);
+
+    auto& stats = s_storage.stats;
+    auto& counters = s_storage.counters;
+    K_ASSERT(s_storage.shaders[data.shader.index()].alive, "Draw call uses a dead shader.");
+    if(!k_enable_state_cache || data.shader.index() != s_storage.last_shader_index)
+    {
+        ++counters.shader_binds;
+        s_storage.last_shader_index = data.shader.index();
+        s_storage.invalidate_texture_cache();
+        s_storage.invalidate_cubemap_cache();
+    }
+    else
+        ++counters.shader_hits;
+
+    uint8_t texture_count;
+    buf.read(&texture_count);
+    for(uint8_t ii = 0; ii < texture_count; ++ii)
+    {
+        TextureHandle hnd;
+        buf.read(&hnd);
+        if(hnd.is_null())
+            continue;
+
+        if(!k_enable_state_cache || hnd.index() != s_storage.last_texture_index[ii])
+        {
+            ++counters.texture_binds;
+            s_storage.last_texture_index[ii] = hnd.index();
+        }
+        else
+            ++counters.texture_hits;
+    }
+
+    uint8_t cubemap_count;
+    buf.read(&cubemap_count);
+    for(uint8_t ii = 0; ii < cubemap_count; ++ii)
+    {
+        CubemapHandle hnd;
+        buf.read(&hnd);
+
+        if(!k_enable_state_cache || hnd.index() != s_storage.last_cubemap_index[ii])
+        {
+            ++counters.cubemap_binds;
+            s_storage.last_cubemap_index[ii] = hnd.index();
+        }
+        else
+            ++counters.cubemap_hits;
+    }
+
+    K_ASSERT(s_storage.vertex_arrays[data.VAO.index()].alive, "Draw call uses a dead vertex array.");
+    if(!k_enable_state_cache || data.VAO.index() != s_storage.last_VAO_index)
+    {
+        ++counters.VAO_binds;
+        s_storage.last_VAO_index = data.VAO.index();
+    }
+    else
+        ++counters.VAO_hits;
+
+    ++stats.draw_calls;
+    if(type == DrawCall::IndexedInstanced)
+    {
+        uint32_t instance_count;
+        buf.read(&instance_count);
+        stats.instances += instance_count;
+    }
+    else if(type == DrawCall::MultiIndirect)
+    {
+        // Instance counts live in the indirect buffer, count one instance per draw
+        ShaderStorageBufferHandle indirect_buffer;
+        uint32_t draw_count;
+        buf.read(&indirect_buffer);
+        buf.read(&draw_count);
+        K_ASSERT(s_storage.shader_storage_buffers[indirect_buffer.index()].alive,
+                 "Draw call uses a dead indirect buffer.");
+        stats.instances += draw_count;
+    }
+    else
+        ++stats.instances;
+}
+
+void clear(memory::LinearBuffer<>& buf)
+{
+    uint32_t flags;
+    kb::math::argb32_t clear_color;
+
+    FramebufferHandle target;
+    buf.read(&target);
+    buf.read(&flags);
+    buf.read(&clear_color);
+    s_storage.record(true, uint16_t(DrawCommand::Clear), target.index());
+
+    ++s_storage.stats.clears;
+}
+
+void blit_depth(memory::LinearBuffer<>& buf)
+{
+    FramebufferHandle source;
+    FramebufferHandle target;
+    buf.read(&source);
+    buf.read(&target);
+    s_storage.record(true, uint16_t(DrawCommand::BlitDepth), target.index());
+
+    K_ASSERT(s_storage.framebuffers[source.index()].alive && s_storage.framebuffers[target.index()].alive,
+             "Depth blit between dead framebuffers.");
+}
+
+void update_shader_storage_buffer(memory::LinearBuffer<>& buf)
+{
+    ShaderStorageBufferHandle ssbo_handle;
+    uint32_t size;
+    void* data;
+
+    buf.read(&ssbo_handle);
+    buf.read(&size);
+    buf.read(&data);
+    s_storage.record(true, uint16_t(DrawCommand::UpdateShaderStorageBuffer), ssbo_handle.index());
+
+    K_ASSERT(s_storage.shader_storage_buffers[ssbo_handle.index()].alive, "Streaming to a dead shader storage buffer.");
+}
+
+void update_uniform_buffer(memory::LinearBuffer<>& buf)
+{
+    UniformBufferHandle ubo_handle;
+    uint32_t size;
+    void* data;
+
+    buf.read(&ubo_handle);
+    buf.read(&size);
+    buf.read(&data);
+    s_storage.record(true, uint16_t(DrawCommand::UpdateUniformBuffer), ubo_handle.index());
+
+    K_ASSERT(s_storage.uniform_buffers[ubo_handle.index()].alive, "Streaming to a dead uniform buffer.");
+}
+
+} // namespace null_draw_dispatch
+
+typedef void (*backend_dispatch_func_t)(memory::LinearBuffer<>&);
+static backend_dispatch_func_t render_backend_dispatch[std::size_t(RenderCommand::Count)] = {
+    &null_render_dispatch::create_index_buffer,
+    &null_render_dispatch::create_vertex_buffer,
+    &null_render_dispatch::create_vertex_array,
+    &null_render_dispatch::create_vertex_array_multiple_VBO,
+    &null_render_dispatch::create_uniform_buffer,
+    &null_render_dispatch::create_shader_storage_buffer,
+    &null_render_dispatch::create_shader,
+    &null_render_dispatch::create_texture_2D,
+    &null_render_dispatch::create_cubemap,
+    &null_render_dispatch::create_framebuffer,
+    &null_render_dispatch::update_index_buffer,
+    &null_render_dispatch::update_vertex_buffer,
+    &null_render_dispatch::update_uniform_buffer,
+    &null_render_dispatch::update_shader_storage_buffer,
+    &null_render_dispatch::shader_attach_uniform_buffer,
+    &null_render_dispatch::shader_attach_storage_buffer,
+    &null_render_dispatch::update_framebuffer,
+    &null_render_dispatch::clear_framebuffers,
+    &null_render_dispatch::set_host_window_size,
+
+    &null_render_dispatch::nop,
+
+    &null_render_dispatch::get_pixel_data,
+    &null_render_dispatch::get_cubemap_pixel_data,
+    &null_render_dispatch::generate_cubemap_mipmaps,
+    &null_render_dispatch::framebuffer_screenshot,
+    &null_render_dispatch::destroy_index_buffer,
+    &null_render_dispatch::destroy_vertex_buffer_layout,
+    &null_render_dispatch::destroy_vertex_buffer,
+    &null_render_dispatch::destroy_vertex_array,
+    &null_render_dispatch::destroy_uniform_buffer,
+    &null_render_dispatch::destroy_shader_storage_buffer,
+    &null_render_dispatch::destroy_shader,
+    &null_render_dispatch::destroy_texture_2D,
+    &null_render_dispatch::destroy_cubemap,
+    &null_render_dispatch::destroy_framebuffer,
+};
+
+static backend_dispatch_func_t draw_backend_dispatch[std::size_t(DrawCommand::Count)] = {
+    &null_draw_dispatch::draw,
+    &null_draw_dispatch::clear,
+    &null_draw_dispatch::blit_depth,
+    &null_draw_dispatch::update_shader_storage_buffer,
+    &null_draw_dispatch::update_uniform_buffer,
+};
+
+void NullBackend::dispatch_command(uint16_t type, memory::LinearBuffer<>& buf)
+{
+    ++s_storage.stats.render_commands[type];
+    // Render commands may reference handles acquired since last dispatch
+    s_storage.reserve_handles();
+    (*render_backend_dispatch[type])(buf);
+}
+
+void NullBackend::dispatch_draw(uint16_t type, memory::LinearBuffer<>& buf)
+{
+    ++s_storage.stats.draw_commands[type];
+    (*draw_backend_dispatch[type])(buf);
+}
+
+} // namespace erwin
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "render/backend.h"
+#include "render/commands.h"
+
+namespace fs = std::filesystem;
+
+namespace erwin
+{
+
+// Graphics backend that needs no GPU. Every command is fully decoded from the command buffers,
+// resource handles are tracked exactly like a real device would, and the render state cache is
+// emulated so that state changes can be counted. The decoded stream can optionally be recorded.
+// This allows to run and measure the CPU side of the renderer (submission, sort, flush) headless.
+class NullBackend : public Backend
+{
+public:
+    // Cumulative counters, reset with reset_statistics()
+    struct Statistics
+    {
+        uint32_t render_commands[std::size_t(RenderCommand::Count)] = {0};
+        uint32_t draw_commands[std::size_t(DrawCommand::Count)] = {0};
+        uint32_t draw_calls = 0;
+        uint32_t instances = 0;
+        uint32_t clears = 0;
+        uint32_t frames = 0;
+        StateCounters state_counters; // Sum of the per-frame state counters, accumulated at the end of each frame
+    };
+
+    // A decoded command, as recorded when recording is enabled
+    struct Record
+    {
+        bool draw;       // DrawCommand if true, RenderCommand otherwise
+        uint16_t type;   // Command type
+        uint16_t handle; // Index of the main resource the command operates on (shader for draw calls)
+        uint64_t state;  // Render state flags (draw calls only)
+    };
+
+    NullBackend();
+    virtual void release() override;
+
+    // * Null backend specifics
+    // Start / stop recording decoded commands
+    void set_recording(bool value);
+    bool is_recording() const;
+    const std::vector<Record>& get_records() const;
+    void clear_records();
+    // Write recorded commands to a text file, one command per line
+    void export_records(const fs::path& filepath) const;
+    const Statistics& get_statistics() const;
+    void reset_statistics();
+    // Get the number of live resources
+    uint32_t get_live_resource_count() const;
+
+    // * Framebuffer
+    // Add framebuffer texture description
+    virtual void add_framebuffer_texture_vector(FramebufferHandle handle, const FramebufferTextureVector& ftv) override;
+    // Bind the default framebuffer
+    virtual void bind_default_framebuffer() override;
+    // Read framebuffer content to an array
+    virtual void read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels) override;
+
+    // * Immediate
+    // Promise texture data
+    virtual std::pair<uint64_t, std::future<PixelData>> future_texture_data() override;
+    // Get handle of default render target
+    virtual FramebufferHandle default_render_target() override;
+    // Get handle of a specified texture slot inside a framebuffer
+    virtual TextureHandle get_framebuffer_texture(FramebufferHandle handle, uint32_t index) override;
+    // Get handle of a cubemap inside a framebuffer
+    virtual CubemapHandle get_framebuffer_cubemap(FramebufferHandle handle) override;
+    // Get name of a specified texture slot inside a framebuffer
+    virtual hash_t get_framebuffer_texture_name(FramebufferHandle handle, uint32_t index) override;
+    // Get texture count inside a framebuffer
+    virtual uint32_t get_framebuffer_texture_count(FramebufferHandle handle) override;
+    // Get opaque implementation specific handle of a texture (for ImGui and debug purposes)
+    virtual void* get_native_texture_handle(TextureHandle handle) override;
+    // Create a vertex buffer layout description
+    virtual VertexBufferLayoutHandle create_vertex_buffer_layout(const std::vector<BufferLayoutElement>& elements) override;
+    // Retrieve a layout description
+    virtual const BufferLayout& get_vertex_buffer_layout(VertexBufferLayoutHandle handle) override;
+
+    // * Command dispatch
+    virtual void dispatch_command(uint16_t type, memory::LinearBuffer<>& buf) override;
+    virtual void dispatch_draw(uint16_t type, memory::LinearBuffer<>& buf) override;
+
+    // Set the color used to clear any framebuffer
+    virtual void set_clear_color(float r, float g, float b, float a) override;
+    // Clear currently bound framebuffer
+    virtual void clear(int flags) override;
+    // Prevent from drawing in current framebuffer's color attachment(s)
+    virtual void lock_color_buffer() override;
+
+    // * Global state
+    virtual void set_seamless_cubemaps_enabled(bool value) override;
+
+    // * Depth-stencil state
+    // Lock/Unlock writing to the current framebuffer's depth buffer
+    virtual void set_depth_lock(bool value) override;
+    // Lock/Unlock writing to the current framebuffer's stencil
+    virtual void set_stencil_lock(bool value) override;
+    // Set function used as a depth test
+    virtual void set_depth_func(DepthFunc value) override;
+    // Enable/Disable depth test
+    virtual void set_depth_test_enabled(bool value) override;
+    // Set function used as a stencil test, with a reference value and a mask
+    virtual void set_stencil_func(StencilFunc value, uint16_t a = 0, uint16_t b = 0) override;
+    // Specify front/back stencil test action
+    virtual void set_stencil_operator(StencilOperator value) override;
+    // Enable/Disable stencil test
+    virtual void set_stencil_test_enabled(bool value) override;
+
+    // * Blending
+    // Enable blending with blending equation dst.rgb = src.a*src.rgb + (1-src.a)*dst.rgb
+    virtual void set_std_blending() override;
+    // Enable blending with blending equation dst.rgb = src.rgb + dst.rgb
+    virtual void set_light_blending() override;
+    // Disable blending
+    virtual void disable_blending() override;
+
+    // * Byte-alignment
+    // Specify alignment constraint on pixel rows when data is fed to client (value must be in {1,2,4,8})
+    virtual void set_pack_alignment(uint32_t value) override;
+    // Specify alignment constraint on pixel rows when data is read from client (value must be in {1,2,4,8})
+    virtual void set_unpack_alignment(uint32_t value) override;
+
+    // * Raster state
+    // Set the position and size of area to draw to
+    virtual void viewport(float xx, float yy, float width, float height) override;
+    // Set which faces to cull out (front/back/none)
+    virtual void set_cull_mode(CullMode value) override;
+    // Set the line width for next line primitive draw calls
+    virtual void set_line_width(float value) override;
+
+    // * Sync
+    // Wait till all graphics commands have been processed by device
+    virtual void finish() override;
+    // Force issued commands to yield in a finite time
+    virtual void flush() override;
+    // Signal that a frame has been submitted, frame-scoped resources can be recycled
+    virtual void end_frame() override;
+
+    // * Statistics
+    // Get the state cache counters of the frame being submitted, they are reset by end_frame()
+    virtual const StateCounters& get_state_counters() const override;
+
+    // * Debug
+    // Get current error from graphics device
+    virtual uint32_t get_error() override;
+    virtual const std::string& show_error() override;
+    // Fail on graphics device error
+    virtual void assert_no_error() override;
+};
+
+} // namespace erwin
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "render/query_timer.h"
+
+namespace erwin
+{
+
+// There is no GPU work to time with the headless backend
+class NullQueryTimer : public QueryTimer
+{
+public:
+    virtual ~NullQueryTimer() = default;
+
+    // Start query timer
+    virtual void start(bool) override {}
+    // Stop timer and get elapsed GPU time
+    virtual std::chrono::nanoseconds stop() override { return std::chrono::nanoseconds(0); }
+};
+
+class NullPassQueryTimer : public PassQueryTimer
+{
+public:
+    virtual ~NullPassQueryTimer() = default;
+
+    virtual void begin_frame() override {}
+    virtual void begin_pass(uint8_t) override {}
+    virtual void end_frame() override {}
+    virtual bool collect(std::vector<PassTime>&) override { return false; }
+};
+
+} // namespace erwin
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core/window.h"
+
+namespace erwin
+{
+
+// There is no graphics context to speak of with the headless backend
+class NullContext : public GFXContext
+{
+public:
+    virtual ~NullContext() = default;
+
+    virtual void init() override {}
+    virtual void swap_buffers() const override {}
+    virtual void make_current() const override {}
+    virtual void release_current() const override {}
+};
+
+// Window that is never shown, used with the headless backend. No windowing system is initialized,
+// the size stays the one requested at creation.
+class NullWindow : public Window
+{
+public:
+    explicit NullWindow(const WindowProps& props) : width_(props.width), height_(props.height), vsync_(props.vsync)
+    {
+        context_ = new NullContext();
+    }
+    virtual ~NullWindow() = default;
+
+    virtual void update() override {}
+    virtual uint32_t get_width() const override { return width_; }
+    virtual uint32_t get_height() const override { return height_; }
+    virtual void set_vsync(bool value) override { vsync_ = value; }
+    virtual bool is_vsync() override { return vsync_; }
+    virtual void* get_native() const override { return nullptr; }
+
+private:
+    uint32_t width_;
+    uint32_t height_;
+    bool vsync_;
+};
+
+} // namespace erwin
@@ -64,8 +64,6 @@ void APIENTRY glDebugOutput(GLenum source,
 */
 static uint8_t s_glfw_num_windows = 0;
 
-WScope<Window> Window::create(EventBus& event_bus, const WindowProps& props) { return make_scope<GLFWWindow>(props, event_bus); }
-
 static void GLFW_error_callback(int error, const char* description)
 {
     KLOGE("core") << "GLFW Error (" << error << "): " << description << std::endl;
@@ -306,7 +304,7 @@ void GLFWWindow::update()
 {
     W_PROFILE_FUNCTION()
 
-    context_->swap_buffers();
+    // Buffer swapping is handled by Renderer::present(), it may happen on the render thread
     glfwPollEvents();
 }
 
@@ -1,16 +1,26 @@
+#include <algorithm>
+#include <cstring>
+#include <future>
 #include <iostream>
 #include <map>
+#include <mutex>
 
+#include "core/application.h"
 #include "core/core.h"
 #include "glad/glad.h"
 #include "platform/OGL/ogl_backend.h"
 #include "platform/OGL/ogl_buffer.h"
+#include "platform/OGL/ogl_deferred_release.h"
 #include "platform/OGL/ogl_framebuffer.h"
+#include "platform/OGL/ogl_pixel_readback.h"
+#include "platform/OGL/ogl_program_cache.h"
 #include "platform/OGL/ogl_shader.h"
 #include "platform/OGL/ogl_texture.h"
+#include "platform/OGL/ogl_uniform_ring.h"
 #include "platform/OGL/ogl_debug.h"
 #include "render/commands.h"
 #include "render/renderer_config.h"
+#include "stb/stb_image_write.h"
 #include "utils/promise_storage.hpp"
 #include <kibble/math/color.h>
 
@@ -26,26 +36,14 @@ inline bool is_power_of_2(int value) { return bool((value) && ((value & (value -
 
 inline bool is_power_of_2(uint32_t value) { return is_power_of_2(int(value)); }
 
-struct VertexArrayDependencies
-{
-    std::vector<VertexBufferHandle> vbos;
-    IndexBufferHandle ibo = {};
-
-    inline void release()
-    {
-        for(VertexBufferHandle vbo: vbos)
-            vbo.release();
-        if(!ibo.is_null())
-            ibo.release();
-        vbos.clear();
-    }
-};
-
 static struct RenderDeviceStorage
 {
     void init()
     {
         state_cache_ = RenderState().encode();
+        reserved_growth_count_ = ~HandlePool::get_growth_count(); // Force a reservation
+        reserve_handles();
+        vertex_buffer_layouts.reserve(VertexBufferLayoutHandle::s_ppool_->capacity());
         clear_resources();
 
         default_framebuffer_ = FramebufferHandle::acquire();
@@ -56,26 +54,86 @@ static struct RenderDeviceStorage
         invalidate_cubemap_cache();
         invalidate_VAO_cache();
         invalidate_shader_cache();
+
+        uniform_ring.init(k_uniform_ring_segment_size);
+        ring_UBOs.clear();
+        pending_UBOs.clear();
+        storage_ring.init(k_storage_ring_segment_size, OGLUniformRing::Storage);
+        ring_SSBOs.clear();
+        pending_SSBOs.clear();
+    }
+
+    // Wait for screenshots to be written, forget those already written
+    inline void join_screenshot_tasks(bool wait)
+    {
+        for(auto it = screenshot_tasks.begin(); it != screenshot_tasks.end();)
+        {
+            if(wait || it->wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                it->get();
+                it = screenshot_tasks.erase(it);
+            }
+            else
+                ++it;
+        }
     }
 
     void release()
     {
+        pixel_readback.release();
+        join_screenshot_tasks(true);
+        deferred_release.flush();
         default_framebuffer_.release();
         clear_resources();
+        OGLStorageCache::clear();
+        uniform_ring.release();
+        storage_ring.release();
     }
 
     inline void clear_resources()
     {
-        for(auto&& obj: index_buffers) obj.release();
-        for(auto&& obj: vertex_buffers) obj.release();
-        for(auto&& obj: vertex_arrays) obj.release();
-        for(auto&& obj: uniform_buffers) obj.release();
-        for(auto&& obj: shader_storage_buffers) obj.release();
-        for(auto&& obj: textures) obj.release();
-        for(auto&& obj: cubemaps) obj.release();
-        std::fill(std::begin(vertex_buffer_layouts), std::end(vertex_buffer_layouts), nullptr);
-        std::fill(std::begin(shaders), std::end(shaders), nullptr);
-        std::fill(std::begin(framebuffers), std::end(framebuffers), nullptr);
+        index_buffers.for_each([](auto& obj) { obj.release(); });
+        vertex_buffers.for_each([](auto& obj) { obj.release(); });
+        vertex_arrays.for_each([](auto& obj) { obj.release(); });
+        uniform_buffers.for_each([](auto& obj) { obj.release(); });
+        shader_storage_buffers.for_each([](auto& obj) { obj.release(); });
+        cubemaps.for_each([](auto& obj) { obj.release(); });
+        vertex_buffer_layouts.for_each([](auto& obj) { obj = nullptr; });
+        shaders.for_each([](auto& obj) { obj = nullptr; });
+        framebuffers.for_each([](auto& obj) { obj = nullptr; });
+
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        textures.for_each([](auto& obj) { obj.release(); });
+        framebuffer_textures_.clear();
+    }
+
+    inline FramebufferTextureVector get_texture_vector(uint16_t framebuffer_index)
+    {
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        return framebuffer_textures_[framebuffer_index];
+    }
+
+    // Handle pools grow on demand, make sure every handle acquired so far has its storage. Pools grow on the
+    // main thread before the commands using the new handles are submitted, so this is only needed after a growth.
+    // Vertex buffer layouts are created on the main thread and reserved there.
+    inline void reserve_handles()
+    {
+        uint32_t growth_count = HandlePool::get_growth_count();
+        if(growth_count == reserved_growth_count_)
+            return;
+        reserved_growth_count_ = growth_count;
+
+        index_buffers.reserve(IndexBufferHandle::s_ppool_->capacity());
+        vertex_buffers.reserve(VertexBufferHandle::s_ppool_->capacity());
+        vertex_arrays.reserve(VertexArrayHandle::s_ppool_->capacity());
+        uniform_buffers.reserve(UniformBufferHandle::s_ppool_->capacity());
+        uniform_ranges.reserve(UniformBufferHandle::s_ppool_->capacity());
+        shader_storage_buffers.reserve(ShaderStorageBufferHandle::s_ppool_->capacity());
+        storage_ranges.reserve(ShaderStorageBufferHandle::s_ppool_->capacity());
+        textures.reserve(TextureHandle::s_ppool_->capacity());
+        cubemaps.reserve(CubemapHandle::s_ppool_->capacity());
+        shaders.reserve(ShaderHandle::s_ppool_->capacity());
+        framebuffers.reserve(FramebufferHandle::s_ppool_->capacity());
     }
 
     inline void invalidate_texture_cache()
@@ -98,37 +156,98 @@ static struct RenderDeviceStorage
         last_shader_index = k_invalid_index;
     }
 
+    // Stop sourcing a uniform buffer from the uniform ring. Its binding point will be reset to the
+    // buffer itself the next time a shader is bound.
+    inline void detach_from_ring(uint16_t UBO_index)
+    {
+        auto it = std::find(ring_UBOs.begin(), ring_UBOs.end(), UBO_index);
+        if(it == ring_UBOs.end())
+            return;
+        ring_UBOs.erase(it);
+        pending_UBOs.erase(std::remove(pending_UBOs.begin(), pending_UBOs.end(), UBO_index), pending_UBOs.end());
+        invalidate_shader_cache();
+    }
+
+    // Same for a shader storage buffer and the storage ring
+    inline void detach_from_storage_ring(uint16_t SSBO_index)
+    {
+        auto it = std::find(ring_SSBOs.begin(), ring_SSBOs.end(), SSBO_index);
+        if(it == ring_SSBOs.end())
+            return;
+        ring_SSBOs.erase(it);
+        pending_SSBOs.erase(std::remove(pending_SSBOs.begin(), pending_SSBOs.end(), SSBO_index), pending_SSBOs.end());
+        invalidate_shader_cache();
+    }
+
     FramebufferHandle default_framebuffer_ = {};
     uint16_t current_framebuffer_index_ = {};
     glm::vec2 host_window_size_;
     std::map<uint16_t, FramebufferTextureVector> framebuffer_textures_;
-    std::array<VertexArrayDependencies, k_max_handles<VertexArrayHandle>> vertex_array_dependencies;
-
-    std::array<OGLIndexBuffer, k_max_handles<IndexBufferHandle>> index_buffers;
-    std::array<OGLVertexBuffer, k_max_handles<VertexBufferHandle>> vertex_buffers;
-    std::array<OGLVertexArray, k_max_handles<VertexArrayHandle>> vertex_arrays;
-    std::array<OGLUniformBuffer, k_max_handles<UniformBufferHandle>> uniform_buffers;
-    std::array<OGLShaderStorageBuffer, k_max_handles<ShaderStorageBufferHandle>> shader_storage_buffers;
-    std::array<OGLTexture2D, k_max_handles<OGLTexture2D>> textures;
-    std::array<OGLCubemap, k_max_handles<OGLCubemap>> cubemaps;
-
-    WRef<BufferLayout> vertex_buffer_layouts[k_max_handles<VertexBufferLayoutHandle>];
-    WRef<OGLShader> shaders[k_max_handles<ShaderHandle>];
-    WRef<OGLFramebuffer> framebuffers[k_max_handles<FramebufferHandle>];
+    // Framebuffer texture vectors and texture storage are also accessed by the main thread, see
+    // Renderer::create_framebuffer() and Renderer::get_native_texture_handle()
+    std::mutex shared_mutex;
+
+    HandleArray<OGLIndexBuffer> index_buffers;
+    HandleArray<OGLVertexBuffer> vertex_buffers;
+    HandleArray<OGLVertexArray> vertex_arrays;
+    HandleArray<OGLUniformBuffer> uniform_buffers;
+    HandleArray<OGLShaderStorageBuffer> shader_storage_buffers;
+    HandleArray<OGLTexture2D> textures;
+    HandleArray<OGLCubemap> cubemaps;
+
+    HandleArray<WRef<BufferLayout>> vertex_buffer_layouts;
+    HandleArray<WRef<OGLShader>> shaders;
+    HandleArray<WRef<OGLFramebuffer>> framebuffers;
 
-    // ShaderCompatibility shader_compat[k_max_handles<ShaderHandle>];
     PromiseStorage<PixelData> texture_data_promises_;
+    OGLPixelReadback pixel_readback;
+    std::vector<std::future<void>> screenshot_tasks; // Image encoding, runs on worker threads
     uint64_t state_cache_;
+    uint32_t reserved_growth_count_ = 0;
     uint16_t last_shader_index;
     uint16_t last_VAO_index;
     uint16_t last_texture_index[k_max_texture_slots];
     uint16_t last_cubemap_index[k_max_cubemap_slots];
+    StateCounters counters;
+    // Destroyed resources are released once the GPU is done with them
+    OGLDeferredRelease deferred_release;
+
+    // Uniform data of draw call dependencies is sub-allocated in the uniform ring, and uniform buffers
+    // are bound as ranges of the ring instead of being streamed to, see draw_dispatch::update_uniform_buffer()
+    struct RingRange
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+    OGLUniformRing uniform_ring;
+    HandleArray<RingRange> uniform_ranges;
+    std::vector<uint16_t> ring_UBOs;    // Uniform buffers currently sourced from the ring
+    std::vector<uint16_t> pending_UBOs; // Uniform buffers whose range must be bound before the next draw call
+    // Likewise for shader storage data of draw call dependencies, so that each multi-draw indirect batch of
+    // a frame gets its own instance data and draw commands, see draw_dispatch::update_shader_storage_buffer()
+    OGLUniformRing storage_ring;
+    HandleArray<RingRange> storage_ranges;
+    std::vector<uint16_t> ring_SSBOs;    // Shader storage buffers currently sourced from the ring
+    std::vector<uint16_t> pending_SSBOs; // Shader storage buffers whose range must be bound before the next draw call
 } s_storage;
 
 OGLBackend::OGLBackend()
 {
     // Init storage
     s_storage.init();
+
+    // Let the driver compile shaders on its own threads, shader programs are polled before use
+    if(GLAD_GL_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xffffffff);
+        KLOG("render", 1) << "Parallel shader compilation enabled." << std::endl;
+    }
+
+    if(CFG_.get<bool>("erwin.renderer.shader_cache"_h, true))
+        OGLProgramCache::init(WFS_.get_aliased_directory("usr"_h) / "shader_cache");
+
+    // Budget in MB
+    OGLStorageCache::init(CFG_.get<size_t>("erwin.renderer.storage_cache_budget"_h, 64) * 1024 * 1024);
 }
 
 void OGLBackend::release() { s_storage.release(); }
@@ -136,6 +255,8 @@ void OGLBackend::release() { s_storage.release(); }
 // ------------------- PRIVATE API -------------------
 const OGLTexture2D& OGLBackend::create_texture_inplace(TextureHandle handle, const Texture2DDescriptor& desc)
 {
+    s_storage.reserve_handles();
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
     auto& ret = s_storage.textures[handle.index()];
     ret.release();
     ret.init(desc);
@@ -144,29 +265,24 @@ const OGLTexture2D& OGLBackend::create_texture_inplace(TextureHandle handle, con
 
 const OGLCubemap& OGLBackend::create_cubemap_inplace(CubemapHandle handle, const CubemapDescriptor& desc)
 {
+    s_storage.reserve_handles();
     auto& ret = s_storage.cubemaps[handle.index()];
     ret.release();
     ret.init(desc);
     return ret;
 }
 
-const OGLTexture2D& OGLBackend::get_texture(TextureHandle handle)
-{
-    K_ASSERT(handle.is_valid(), "Invalid TextureHandle.");
-    return s_storage.textures[handle.index()];
-}
+// Render thread only, the handle may already be released by the main thread
+const OGLTexture2D& OGLBackend::get_texture(TextureHandle handle) { return s_storage.textures[handle.index()]; }
 
-const OGLCubemap& OGLBackend::get_cubemap(CubemapHandle handle)
-{
-    K_ASSERT(handle.is_valid(), "Invalid CubemapHandle.");
-    return s_storage.cubemaps[handle.index()];
-}
+const OGLCubemap& OGLBackend::get_cubemap(CubemapHandle handle) { return s_storage.cubemaps[handle.index()]; }
 // ------------------- PRIVATE API -------------------
 
 void OGLBackend::viewport(float xx, float yy, float width, float height) { glViewport(xx, yy, width, height); }
 
 void OGLBackend::add_framebuffer_texture_vector(FramebufferHandle handle, const FramebufferTextureVector& ftv)
 {
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
     s_storage.framebuffer_textures_.insert(std::make_pair(handle.index(), ftv));
 }
 
@@ -192,7 +308,7 @@ FramebufferHandle OGLBackend::default_render_target() { return s_storage.default
 
 TextureHandle OGLBackend::get_framebuffer_texture(FramebufferHandle handle, uint32_t index)
 {
-    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
     K_ASSERT(index < s_storage.framebuffer_textures_[handle.index()].handles.size(),
              "Invalid framebuffer texture index.");
     return s_storage.framebuffer_textures_[handle.index()].handles[index];
@@ -200,26 +316,27 @@ TextureHandle OGLBackend::get_framebuffer_texture(FramebufferHandle handle, uint
 
 CubemapHandle OGLBackend::get_framebuffer_cubemap(FramebufferHandle handle)
 {
-    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
     return s_storage.framebuffer_textures_[handle.index()].cubemap;
 }
 
 hash_t OGLBackend::get_framebuffer_texture_name(FramebufferHandle handle, uint32_t index)
 {
-    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
     return s_storage.framebuffer_textures_[handle.index()].debug_names[index];
 }
 
 uint32_t OGLBackend::get_framebuffer_texture_count(FramebufferHandle handle)
 {
-    K_ASSERT(handle.is_valid(), "Invalid FramebufferHandle.");
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
     return uint32_t(s_storage.framebuffer_textures_[handle.index()].handles.size());
 }
 
 void* OGLBackend::get_native_texture_handle(TextureHandle handle)
 {
-    K_ASSERT(handle.is_valid(), "Invalid TextureHandle.");
-    if(!s_storage.textures[handle.index()].is_initialized())
+    // The render thread may not have created the texture yet
+    std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+    if(handle.index() >= s_storage.textures.capacity() || !s_storage.textures[handle.index()].is_initialized())
         return nullptr;
     return s_storage.textures[handle.index()].get_native_handle();
 }
@@ -229,6 +346,7 @@ VertexBufferLayoutHandle OGLBackend::create_vertex_buffer_layout(const std::vect
     VertexBufferLayoutHandle handle = VertexBufferLayoutHandle::acquire();
     K_ASSERT(handle.is_valid(), "No more free handle in handle pool.");
 
+    s_storage.vertex_buffer_layouts.reserve(VertexBufferLayoutHandle::s_ppool_->capacity());
     s_storage.vertex_buffer_layouts[handle.index()] = make_ref<BufferLayout>(&elements[0], elements.size());
 
     return handle;
@@ -236,8 +354,6 @@ VertexBufferLayoutHandle OGLBackend::create_vertex_buffer_layout(const std::vect
 
 const BufferLayout& OGLBackend::get_vertex_buffer_layout(VertexBufferLayoutHandle handle)
 {
-    K_ASSERT(handle.is_valid(), "Invalid VertexBufferLayoutHandle!");
-
     return *s_storage.vertex_buffer_layouts[handle.index()];
 }
 
@@ -367,6 +483,47 @@ void OGLBackend::finish() { glFinish(); }
 
 void OGLBackend::flush() { glFlush(); }
 
+void OGLBackend::end_frame()
+{
+    // Uniform buffers sourced from the ring get their last value back, so that they stay valid
+    // once the ring segment is recycled
+    for(uint16_t index : s_storage.ring_UBOs)
+    {
+        const auto& range = s_storage.uniform_ranges[index];
+        const auto& UBO = s_storage.uniform_buffers[index];
+        glBindBuffer(GL_COPY_READ_BUFFER, s_storage.uniform_ring.get_handle());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, UBO.get_handle());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.offset, 0, range.size);
+    }
+    for(uint16_t index : s_storage.ring_SSBOs)
+    {
+        const auto& range = s_storage.storage_ranges[index];
+        const auto& SSBO = s_storage.shader_storage_buffers[index];
+        glBindBuffer(GL_COPY_READ_BUFFER, s_storage.storage_ring.get_handle());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, SSBO.get_handle());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.offset, 0, range.size);
+    }
+    if(!s_storage.ring_UBOs.empty() || !s_storage.ring_SSBOs.empty())
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        s_storage.ring_UBOs.clear();
+        s_storage.pending_UBOs.clear();
+        s_storage.ring_SSBOs.clear();
+        s_storage.pending_SSBOs.clear();
+        s_storage.invalidate_shader_cache();
+    }
+    s_storage.uniform_ring.next_frame();
+    s_storage.storage_ring.next_frame();
+    s_storage.pixel_readback.next_frame();
+    s_storage.join_screenshot_tasks(false);
+    s_storage.deferred_release.next_frame();
+    OGLStorageCache::next_frame();
+    s_storage.counters = {};
+}
+
+const StateCounters& OGLBackend::get_state_counters() const { return s_storage.counters; }
+
 static const std::map<GLenum, std::string> s_gl_errors = {{GL_NO_ERROR, "No error"},
                                                           {GL_INVALID_OPERATION, "Invalid operation"},
                                                           {GL_INVALID_ENUM, "Invalid enum"},
@@ -492,13 +649,8 @@ void create_vertex_array(memory::LinearBuffer<>& buf)
 
     s_storage.vertex_arrays[handle.index()].init();
     s_storage.vertex_arrays[handle.index()].set_vertex_buffer(s_storage.vertex_buffers[vb.index()]);
-    s_storage.vertex_array_dependencies[handle.index()].vbos.push_back(vb);
     if(!ib.is_null())
-    {
         s_storage.vertex_arrays[handle.index()].set_index_buffer(s_storage.index_buffers[ib.index()]);
-        s_storage.vertex_array_dependencies[handle.index()].ibo = ib;
-    }
-
 
     // VAO binding state has changed, invalidate last bound VAO
     s_storage.invalidate_VAO_cache();
@@ -525,14 +677,10 @@ void create_vertex_array_multiple_VBO(memory::LinearBuffer<>& buf)
         VertexBufferHandle vb;
         buf.read(&vb);
         s_storage.vertex_arrays[handle.index()].add_vertex_buffer(s_storage.vertex_buffers[vb.index()]);
-        s_storage.vertex_array_dependencies[handle.index()].vbos.push_back(vb);
     }
 
     if(!ib.is_null())
-    {
         s_storage.vertex_arrays[handle.index()].set_index_buffer(s_storage.index_buffers[ib.index()]);
-        s_storage.vertex_array_dependencies[handle.index()].ibo = ib;
-    }
 
     // VAO binding state has changed, invalidate last bound VAO
     s_storage.invalidate_VAO_cache();
@@ -592,8 +740,9 @@ void create_shader(memory::LinearBuffer<>& buf)
     buf.read_str(filepath);
     buf.read_str(name);
 
+    // The program is built while the next commands execute, draw calls that use it are skipped until it is ready
     auto ref = make_ref<OGLShader>();
-    ref->init(name, std::string(filepath));
+    ref->init_async(name, std::string(filepath));
     s_storage.shaders[handle.index()] = ref;
     // s_storage.shader_compat[handle.index].set_layout(s_storage.shaders[handle.index]->get_attribute_layout());
 
@@ -613,7 +762,10 @@ void create_texture_2D(memory::LinearBuffer<>& buf)
     buf.read(&handle);
     buf.read(&descriptor);
 
-    s_storage.textures[handle.index()].init(descriptor);
+    {
+        std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+        s_storage.textures[handle.index()].init(descriptor);
+    }
     // Free resources if needed
     descriptor.release();
 
@@ -634,6 +786,8 @@ void create_cubemap(memory::LinearBuffer<>& buf)
     buf.read(&descriptor);
 
     s_storage.cubemaps[handle.index()].init(descriptor);
+    // Free resources if needed
+    descriptor.release();
 
     // Cubemap state has changed, invalidate last bound cubemaps
     s_storage.invalidate_cubemap_cache();
@@ -660,7 +814,7 @@ void create_framebuffer(memory::LinearBuffer<>& buf)
     buf.read(&auxiliary);
 
     FramebufferLayout layout(auxiliary, count);
-    const auto& texture_vector = s_storage.framebuffer_textures_[handle.index()];
+    auto texture_vector = s_storage.get_texture_vector(handle.index());
     s_storage.framebuffers[handle.index()] = make_scope<OGLFramebuffer>(width, height, flags, layout, texture_vector);
     GL_END_DBG()
 }
@@ -673,11 +827,22 @@ void update_index_buffer(memory::LinearBuffer<>& buf)
     IndexBufferHandle handle;
     uint32_t count;
     uint32_t* auxiliary;
+    uint32_t offset;
     buf.read(&handle);
     buf.read(&count);
     buf.read(&auxiliary);
+    buf.read(&offset);
+
+    // Unbind currently bound VAO, binding the IBO would change its element buffer
+    GLint current_vao;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &current_vao);
+    glBindVertexArray(0);
+
+    // Buffers are updated in place, mapping them entirely would wait for the draw calls using other ranges
+    s_storage.index_buffers[handle.index()].stream(auxiliary, count * sizeof(uint32_t), offset * sizeof(uint32_t));
 
-    s_storage.index_buffers[handle.index()].map(auxiliary, count * sizeof(uint32_t));
+    // Restore VAO
+    glBindVertexArray(current_vao);
     GL_END_DBG()
 }
 
@@ -689,11 +854,13 @@ void update_vertex_buffer(memory::LinearBuffer<>& buf)
     VertexBufferHandle handle;
     uint32_t size;
     uint8_t* auxiliary;
+    uint32_t offset;
     buf.read(&handle);
     buf.read(&size);
     buf.read(&auxiliary);
+    buf.read(&offset);
 
-    s_storage.vertex_buffers[handle.index()].map(auxiliary, size);
+    s_storage.vertex_buffers[handle.index()].stream(auxiliary, size, offset);
     GL_END_DBG()
 }
 
@@ -709,6 +876,8 @@ void update_uniform_buffer(memory::LinearBuffer<>& buf)
     buf.read(&size);
     buf.read(&auxiliary);
 
+    // Updated in place, ranges of the uniform ring previously bound for this buffer are now stale
+    s_storage.detach_from_ring(handle.index());
     auto& UBO = s_storage.uniform_buffers[handle.index()];
     UBO.map(auxiliary, size ? size : UBO.get_size());
     GL_END_DBG()
@@ -726,6 +895,8 @@ void update_shader_storage_buffer(memory::LinearBuffer<>& buf)
     buf.read(&size);
     buf.read(&auxiliary);
 
+    // Updated in place, ranges of the storage ring previously bound for this buffer are now stale
+    s_storage.detach_from_storage_ring(handle.index());
     s_storage.shader_storage_buffers[handle.index()].map(auxiliary, size);
     GL_END_DBG()
 }
@@ -775,7 +946,7 @@ void update_framebuffer(memory::LinearBuffer<>& buf)
 
     uint8_t flags = s_storage.framebuffers[fb_handle.index()]->get_flags();
     auto layout = s_storage.framebuffers[fb_handle.index()]->get_layout();
-    auto& texture_vector = s_storage.framebuffer_textures_[fb_handle.index()];
+    auto texture_vector = s_storage.get_texture_vector(fb_handle.index());
     s_storage.framebuffers[fb_handle.index()] = make_scope<OGLFramebuffer>(width, height, flags, layout, texture_vector);
     GL_END_DBG()
 }
@@ -811,8 +982,38 @@ void get_pixel_data(memory::LinearBuffer<>& buf)
     buf.read(&handle);
     buf.read(&promise_token);
 
-    auto&& [data, size] = s_storage.textures[handle.index()].read_pixels();
-    s_storage.texture_data_promises_.fulfill(promise_token, PixelData{data, size});
+    // The promise is fulfilled once the pixels are read back, a frame or two later
+    const auto& texture = s_storage.textures[handle.index()];
+    s_storage.pixel_readback.read_texture(texture.get_handle(), texture.get_width(), texture.get_height(),
+                                          [promise_token](const uint8_t* data, uint32_t size) {
+                                              uint8_t* pixels = new uint8_t[size];
+                                              memcpy(pixels, data, size);
+                                              s_storage.texture_data_promises_.fulfill(promise_token,
+                                                                                       PixelData{pixels, size});
+                                          });
+    GL_END_DBG()
+}
+
+void get_cubemap_pixel_data(memory::LinearBuffer<>& buf)
+{
+    GL_BEGIN_DBG()
+    CubemapHandle handle;
+    size_t promise_token;
+
+    buf.read(&handle);
+    buf.read(&promise_token);
+
+    const auto& cubemap = s_storage.cubemaps[handle.index()];
+    K_ASSERT(cubemap.get_format() == ImageFormat::RGB16F || cubemap.get_format() == ImageFormat::RGBA16F,
+             "Cubemap readback is only supported for half float formats.");
+    uint32_t channels = (cubemap.get_format() == ImageFormat::RGBA16F) ? 4 : 3;
+    s_storage.pixel_readback.read_cubemap(cubemap.get_handle(), cubemap.get_width(), cubemap.get_mips(), channels,
+                                          [promise_token](const uint8_t* data, uint32_t size) {
+                                              uint8_t* pixels = new uint8_t[size];
+                                              memcpy(pixels, data, size);
+                                              s_storage.texture_data_promises_.fulfill(promise_token,
+                                                                                       PixelData{pixels, size});
+                                          });
     GL_END_DBG()
 }
 
@@ -836,7 +1037,20 @@ void framebuffer_screenshot(memory::LinearBuffer<>& buf)
     buf.read(&handle);
     buf.read_str(filepath);
 
-    s_storage.framebuffers[handle.index()]->screenshot(filepath);
+    // Pixels are read back asynchronously, then the image is encoded on a worker thread
+    const auto& fb = *s_storage.framebuffers[handle.index()];
+    uint32_t width = fb.get_width();
+    uint32_t height = fb.get_height();
+    s_storage.pixel_readback.read_framebuffer(
+        fb.get_handle(), width, height, [filepath, width, height](const uint8_t* data, uint32_t size) {
+            std::vector<uint8_t> pixels(data, data + size);
+            s_storage.screenshot_tasks.push_back(
+                std::async(std::launch::async, [filepath, width, height, pixels = std::move(pixels)]() {
+                    stbi_write_png(filepath.c_str(), int(width), int(height), 4, pixels.data(), int(width) * 4);
+                    KLOGN("render") << "[Framebuffer] Saved screenshot:" << std::endl;
+                    KLOGI << kb::KS_PATH_ << filepath << std::endl;
+                }));
+        });
     GL_END_DBG()
 }
 
@@ -847,8 +1061,9 @@ void destroy_index_buffer(memory::LinearBuffer<>& buf)
 
     IndexBufferHandle handle;
     buf.read(&handle);
-    s_storage.index_buffers[handle.index()].release();
-    handle.release();
+    s_storage.deferred_release.push([handle]() {
+        s_storage.index_buffers[handle.index()].recycle();
+    });
     GL_END_DBG()
 }
 
@@ -859,8 +1074,9 @@ void destroy_vertex_buffer_layout(memory::LinearBuffer<>& buf)
 
     VertexBufferLayoutHandle handle;
     buf.read(&handle);
-    s_storage.vertex_buffer_layouts[handle.index()] = nullptr;
-    handle.release();
+    s_storage.deferred_release.push([handle]() {
+        s_storage.vertex_buffer_layouts[handle.index()] = nullptr;
+    });
     GL_END_DBG()
 }
 
@@ -871,8 +1087,9 @@ void destroy_vertex_buffer(memory::LinearBuffer<>& buf)
 
     VertexBufferHandle handle;
     buf.read(&handle);
-    s_storage.vertex_buffers[handle.index()].release();
-    handle.release();
+    s_storage.deferred_release.push([handle]() {
+        s_storage.vertex_buffers[handle.index()].recycle();
+    });
     GL_END_DBG()
 }
 
@@ -883,9 +1100,10 @@ void destroy_vertex_array(memory::LinearBuffer<>& buf)
 
     VertexArrayHandle handle;
     buf.read(&handle);
-    s_storage.vertex_arrays[handle.index()].release();
-    s_storage.vertex_array_dependencies[handle.index()].release(); // Release VBOs/IBO handles
-    handle.release();
+    s_storage.deferred_release.push([handle]() {
+        s_storage.vertex_arrays[handle.index()].release(true); // Also recycles its VBOs and IBO
+        s_storage.invalidate_VAO_cache();
+    });
     GL_END_DBG()
 }
 
@@ -896,8 +1114,10 @@ void destroy_uniform_buffer(memory::LinearBuffer<>& buf)
 
     UniformBufferHandle handle;
     buf.read(&handle);
-    s_storage.uniform_buffers[handle.index()].release();
-    handle.release();
+    s_storage.detach_from_ring(handle.index());
+    s_storage.deferred_release.push([handle]() {
+        s_storage.uniform_buffers[handle.index()].recycle();
+    });
     GL_END_DBG()
 }
 
@@ -908,8 +1128,10 @@ void destroy_shader_storage_buffer(memory::LinearBuffer<>& buf)
 
     ShaderStorageBufferHandle handle;
     buf.read(&handle);
-    s_storage.shader_storage_buffers[handle.index()].release();
-    handle.release();
+    s_storage.detach_from_storage_ring(handle.index());
+    s_storage.deferred_release.push([handle]() {
+        s_storage.shader_storage_buffers[handle.index()].recycle();
+    });
     GL_END_DBG()
 }
 
@@ -920,9 +1142,11 @@ void destroy_shader(memory::LinearBuffer<>& buf)
 
     ShaderHandle handle;
     buf.read(&handle);
-    s_storage.shaders[handle.index()] = nullptr;
-    // s_storage.shader_compat[handle.index].clear();
-    handle.release();
+    s_storage.deferred_release.push([handle]() {
+        s_storage.shaders[handle.index()] = nullptr;
+        // s_storage.shader_compat[handle.index].clear();
+        s_storage.invalidate_shader_cache();
+    });
     GL_END_DBG()
 }
 
@@ -933,8 +1157,13 @@ void destroy_texture_2D(memory::LinearBuffer<>& buf)
 
     TextureHandle handle;
     buf.read(&handle);
-    s_storage.textures[handle.index()].release();
-    handle.release();
+    s_storage.deferred_release.push([handle]() {
+        {
+            std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+            s_storage.textures[handle.index()].recycle();
+        }
+        s_storage.invalidate_texture_cache();
+    });
     GL_END_DBG()
 }
 
@@ -945,8 +1174,10 @@ void destroy_cubemap(memory::LinearBuffer<>& buf)
 
     CubemapHandle handle;
     buf.read(&handle);
-    s_storage.cubemaps[handle.index()].release();
-    handle.release();
+    s_storage.deferred_release.push([handle]() {
+        s_storage.cubemaps[handle.index()].release();
+        s_storage.invalidate_cubemap_cache();
+    });
     GL_END_DBG()
 }
 
@@ -960,32 +1191,30 @@ void destroy_framebuffer(memory::LinearBuffer<>& buf)
     buf.read(&handle);
     buf.read(&detach_textures);
 
-    bool has_cubemap = s_storage.framebuffers[handle.index()]->has_cubemap();
-    s_storage.framebuffers[handle.index()] = nullptr;
+    s_storage.deferred_release.push([handle, detach_textures]() {
+        bool has_cubemap = s_storage.framebuffers[handle.index()]->has_cubemap();
+        s_storage.framebuffers[handle.index()] = nullptr;
 
-    // Delete framebuffer textures if they are not detached
-    if(!detach_textures)
-    {
-        auto& texture_vector = s_storage.framebuffer_textures_[handle.index()];
-        if(!has_cubemap)
+        // Delete framebuffer textures if they are not detached, their handles were released by the renderer
+        std::lock_guard<std::mutex> lock(s_storage.shared_mutex);
+        if(!detach_textures)
         {
-            for(uint32_t ii = 0; ii < texture_vector.handles.size(); ++ii)
+            const auto& texture_vector = s_storage.framebuffer_textures_[handle.index()];
+            if(!has_cubemap)
             {
-                uint16_t tex_index = texture_vector.handles[ii].index();
-                s_storage.textures[tex_index].release();
-                texture_vector.handles[ii].release();
+                for(auto texture : texture_vector.handles)
+                    s_storage.textures[texture.index()].recycle();
+                s_storage.invalidate_texture_cache();
+            }
+            else
+            {
+                s_storage.cubemaps[texture_vector.cubemap.index()].release();
+                s_storage.invalidate_cubemap_cache();
             }
         }
-        else
-        {
-            uint16_t cm_index = texture_vector.cubemap.index();
-            s_storage.cubemaps[cm_index].release();
-            texture_vector.cubemap.release();
-        }
-    }
 
-    s_storage.framebuffer_textures_.erase(handle.index());
-    handle.release();
+        s_storage.framebuffer_textures_.erase(handle.index());
+    });
     GL_END_DBG()
 }
 
@@ -1007,11 +1236,13 @@ static inline bool has_mutated(uint64_t state, uint64_t old_state, uint64_t mask
 
 static void handle_state(uint64_t state_flags)
 {
+    auto& counters = s_storage.counters;
     // * If pass state has changed, decode it, find which parts have changed and update device state
     if(state_flags != s_storage.state_cache_)
     {
         RenderState state;
         state.decode(state_flags);
+        ++counters.state_changes;
 
         if(has_mutated(state_flags, s_storage.state_cache_, k_framebuffer_mask) ||
            has_mutated(state_flags, s_storage.state_cache_, k_target_mips_mask))
@@ -1025,6 +1256,7 @@ static void handle_state(uint64_t state_flags)
                 s_storage.framebuffers[state.render_target]->bind(state.target_mip_level);
 
             s_storage.current_framebuffer_index_ = state.render_target;
+            ++counters.render_target_switches;
 
             // Only clear on render target switch, if clear flags are set
             if(state.rasterizer_state.clear_flags != ClearFlags::CLEAR_NONE)
@@ -1032,10 +1264,14 @@ static void handle_state(uint64_t state_flags)
         }
 
         if(has_mutated(state_flags, s_storage.state_cache_, k_cull_mode_mask))
+        {
             gfx::backend->set_cull_mode(state.rasterizer_state.cull_mode);
+            ++counters.cull_mode_changes;
+        }
 
         if(has_mutated(state_flags, s_storage.state_cache_, k_transp_mask))
         {
+            ++counters.blend_changes;
             switch(state.blend_state)
             {
             case BlendState::Alpha:
@@ -1050,6 +1286,10 @@ static void handle_state(uint64_t state_flags)
             }
         }
 
+        if(has_mutated(state_flags, s_storage.state_cache_,
+                       k_stencil_test_mask | k_depth_test_mask | k_depth_lock_mask | k_stencil_lock_mask))
+            ++counters.depth_stencil_changes;
+
         if(has_mutated(state_flags, s_storage.state_cache_, k_stencil_test_mask))
         {
             gfx::backend->set_stencil_test_enabled(state.depth_stencil_state.stencil_test_enabled);
@@ -1075,6 +1315,8 @@ static void handle_state(uint64_t state_flags)
 
         s_storage.state_cache_ = state_flags;
     }
+    else
+        ++counters.state_hits;
 }
 
 namespace draw_dispatch
@@ -1090,11 +1332,21 @@ void draw(memory::LinearBuffer<>& buf)
     buf.read(&type);
     buf.read(&data);
 
+    auto& counters = s_storage.counters;
+    auto& shader = *s_storage.shaders[data.shader.index()];
+    if(data.flags & DrawCall::Blocking)
+        shader.wait_ready();
+    else if(!shader.is_ready())
+    {
+        ++counters.pending_shader_draws;
+        return;
+    }
+
     handle_state(data.state_flags);
 
     // * Detect if a new shader needs to be used, update and bind shader resources
-    auto& shader = *s_storage.shaders[data.shader.index()];
 
+    bool shader_bound = true;
     if constexpr (k_enable_state_cache)
     {
         if(data.shader.index() != s_storage.last_shader_index)
@@ -1104,9 +1356,34 @@ void draw(memory::LinearBuffer<>& buf)
             s_storage.invalidate_texture_cache();
             s_storage.invalidate_cubemap_cache();
         }
+        else
+            shader_bound = false;
     }
     else
         shader.bind();
+    if(shader_bound)
+        ++counters.shader_binds;
+    else
+        ++counters.shader_hits;
+
+    // Binding a shader resets the binding points of its uniform buffers, ranges of the uniform ring
+    // must be bound again. Otherwise, only the ranges updated since last draw call need binding.
+    const auto& ring_UBOs = shader_bound ? s_storage.ring_UBOs : s_storage.pending_UBOs;
+    for(uint16_t index : ring_UBOs)
+    {
+        const auto& range = s_storage.uniform_ranges[index];
+        shader.bind_uniform_range(s_storage.uniform_buffers[index], s_storage.uniform_ring.get_handle(), range.size,
+                                  range.offset);
+    }
+    s_storage.pending_UBOs.clear();
+    const auto& ring_SSBOs = shader_bound ? s_storage.ring_SSBOs : s_storage.pending_SSBOs;
+    for(uint16_t index : ring_SSBOs)
+    {
+        const auto& range = s_storage.storage_ranges[index];
+        shader.bind_storage_range(s_storage.shader_storage_buffers[index], s_storage.storage_ring.get_handle(),
+                                  range.size, range.offset);
+    }
+    s_storage.pending_SSBOs.clear();
 
     uint8_t texture_count;
     buf.read(&texture_count);
@@ -1121,17 +1398,21 @@ void draw(memory::LinearBuffer<>& buf)
         // Avoid texture switching if not necessary
         if constexpr (k_enable_state_cache)
         {
-            if(hnd.data != s_storage.last_texture_index[ii])
+            if(hnd.index() != s_storage.last_texture_index[ii])
             {
                 const auto& texture = s_storage.textures[hnd.index()];
                 shader.attach_texture_2D(texture, ii);
                 s_storage.last_texture_index[ii] = hnd.index();
+                ++counters.texture_binds;
             }
+            else
+                ++counters.texture_hits;
         }
         else
         {
             const auto& texture = s_storage.textures[hnd.index()];
             shader.attach_texture_2D(texture, ii);
+            ++counters.texture_binds;
         }
     }
 
@@ -1150,12 +1431,16 @@ void draw(memory::LinearBuffer<>& buf)
                 const auto& cubemap = s_storage.cubemaps[hnd.index()];
                 shader.attach_cubemap(cubemap, ii + texture_count); // Cubemap samplers after 2d samplers (this is awkward)
                 s_storage.last_cubemap_index[ii] = hnd.index();
+                ++counters.cubemap_binds;
             }
+            else
+                ++counters.cubemap_hits;
         }
         else
         {
             const auto& cubemap = s_storage.cubemaps[hnd.index()];
             shader.attach_cubemap(cubemap, ii + texture_count); // Cubemap samplers after 2d samplers (this is awkward)
+            ++counters.cubemap_binds;
         }
     }
 
@@ -1164,14 +1449,20 @@ void draw(memory::LinearBuffer<>& buf)
     // Avoid switching vertex array when possible
     if constexpr (k_enable_state_cache)
     {
-        if(data.VAO.data != s_storage.last_VAO_index)
+        if(data.VAO.index() != s_storage.last_VAO_index)
         {
             va.bind();
             s_storage.last_VAO_index = data.VAO.index();
+            ++counters.VAO_binds;
         }
+        else
+            ++counters.VAO_hits;
     }
     else
+    {
         va.bind();
+        ++counters.VAO_binds;
+    }
 
     switch(type)
     {
@@ -1194,6 +1485,24 @@ void draw(memory::LinearBuffer<>& buf)
                                 reinterpret_cast<void*>(data.offset * sizeof(GLuint)), instance_count);
         break;
     }
+    case DrawCall::MultiIndirect: {
+        // Read the buffer holding the draw parameters, and the number of draws
+        ShaderStorageBufferHandle indirect_buffer;
+        uint32_t draw_count;
+        buf.read(&indirect_buffer);
+        buf.read(&draw_count);
+        // Commands uploaded by a dependency of this draw call live in the storage ring
+        uint16_t index = indirect_buffer.index();
+        bool from_ring = std::find(s_storage.ring_SSBOs.begin(), s_storage.ring_SSBOs.end(), index) !=
+                         s_storage.ring_SSBOs.end();
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, from_ring ? s_storage.storage_ring.get_handle()
+                                                        : s_storage.shader_storage_buffers[index].get_handle());
+        size_t offset = from_ring ? s_storage.storage_ranges[index].offset : 0;
+        glMultiDrawElementsIndirect(OGLPrimitive.at(va.get_index_buffer().get_primitive()), GL_UNSIGNED_INT,
+                                    reinterpret_cast<void*>(offset), GLsizei(draw_count), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        break;
+    }
     default:
         K_ASSERT(false, "Specified draw call type is unsupported at the moment.");
         break;
@@ -1277,14 +1586,27 @@ void update_shader_storage_buffer(memory::LinearBuffer<>& buf)
     buf.read(&size);
     buf.read(&data);
 
-    s_storage.shader_storage_buffers[ssbo_handle.index()].stream(data, size, 0);
-    /*
-        auto& ssbo = *s_storage.shader_storage_buffers[ssbo_handle.index];
-        if(!ssbo.has_persistent_mapping())
-            ssbo.stream(data, size, 0);
-        else
-            ssbo.map_persistent(data, size, 0);
-    */
+    // Copy data to the storage ring, the range is bound by the draw call that depends on it. Buffers updated
+    // by several draw calls of a frame, like multi-draw indirect batches, then no longer share their storage.
+    auto& ssbo = s_storage.shader_storage_buffers[ssbo_handle.index()];
+    uint32_t offset;
+    size = size ? size : ssbo.get_size();
+    if(!s_storage.storage_ring.push(data, size, offset))
+    {
+        // Ring segment is full for this frame, fall back to streaming
+        s_storage.detach_from_storage_ring(ssbo_handle.index());
+        ssbo.stream(data, size, 0);
+        GL_END_DBG()
+        return;
+    }
+
+    uint16_t index = ssbo_handle.index();
+    s_storage.storage_ranges[index] = {offset, size};
+    if(std::find(s_storage.ring_SSBOs.begin(), s_storage.ring_SSBOs.end(), index) == s_storage.ring_SSBOs.end())
+        s_storage.ring_SSBOs.push_back(index);
+    auto& pending_SSBOs = s_storage.pending_SSBOs;
+    if(std::find(pending_SSBOs.begin(), pending_SSBOs.end(), index) == pending_SSBOs.end())
+        pending_SSBOs.push_back(index);
     GL_END_DBG()
 }
 
@@ -1301,8 +1623,25 @@ void update_uniform_buffer(memory::LinearBuffer<>& buf)
     buf.read(&size);
     buf.read(&data);
 
+    // Copy data to the uniform ring, the range is bound by the draw call that depends on it
     auto& ubo = s_storage.uniform_buffers[ubo_handle.index()];
-    ubo.stream(data, size ? size : ubo.get_size(), 0);
+    uint32_t offset;
+    size = size ? size : ubo.get_size();
+    if(!s_storage.uniform_ring.push(data, size, offset))
+    {
+        // Ring segment is full for this frame, fall back to streaming
+        s_storage.detach_from_ring(ubo_handle.index());
+        ubo.stream(data, size, 0);
+        GL_END_DBG()
+        return;
+    }
+
+    uint16_t index = ubo_handle.index();
+    s_storage.uniform_ranges[index] = {offset, size};
+    if(std::find(s_storage.ring_UBOs.begin(), s_storage.ring_UBOs.end(), index) == s_storage.ring_UBOs.end())
+        s_storage.ring_UBOs.push_back(index);
+    if(std::find(s_storage.pending_UBOs.begin(), s_storage.pending_UBOs.end(), index) == s_storage.pending_UBOs.end())
+        s_storage.pending_UBOs.push_back(index);
     GL_END_DBG()
 }
 
@@ -1333,6 +1672,7 @@ static backend_dispatch_func_t render_backend_dispatch[std::size_t(RenderCommand
     &render_dispatch::nop,
 
     &render_dispatch::get_pixel_data,
+    &render_dispatch::get_cubemap_pixel_data,
     &render_dispatch::generate_cubemap_mipmaps,
     &render_dispatch::framebuffer_screenshot,
     &render_dispatch::destroy_index_buffer,
@@ -1355,7 +1695,12 @@ static backend_dispatch_func_t draw_backend_dispatch[std::size_t(RenderCommand::
     &draw_dispatch::update_uniform_buffer,
 };
 
-void OGLBackend::dispatch_command(uint16_t type, memory::LinearBuffer<>& buf) { (*render_backend_dispatch[type])(buf); }
+void OGLBackend::dispatch_command(uint16_t type, memory::LinearBuffer<>& buf)
+{
+    // Render commands may reference handles acquired since last dispatch
+    s_storage.reserve_handles();
+    (*render_backend_dispatch[type])(buf);
+}
 
 void OGLBackend::dispatch_draw(uint16_t type, memory::LinearBuffer<>& buf) { (*draw_backend_dispatch[type])(buf); }
 
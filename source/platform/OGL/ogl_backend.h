@@ -98,6 +98,12 @@ public:
     virtual void finish() override;
     // Force issued commands to yield in a finite time
     virtual void flush() override;
+    // Signal that a frame has been submitted, frame-scoped resources can be recycled
+    virtual void end_frame() override;
+
+    // * Statistics
+    // Get the state cache counters of the frame being submitted, they are reset by end_frame()
+    virtual const StateCounters& get_state_counters() const override;
 
     // * Debug
     // Get current error from graphics device
@@ -3,6 +3,7 @@
 
 #include "core/core.h"
 #include "platform/OGL/ogl_buffer.h"
+#include "platform/OGL/ogl_deferred_release.h"
 #include <kibble/logger/logger.h>
 
 #include "glad/glad.h"
@@ -142,6 +143,24 @@ void OGLBuffer::init_base(uint32_t target, void* data, uint32_t size, UsagePatte
 {
     unique_id_ = id::unique_id();
     target_ = target;
+    storage_size_ = size;
+    usage_ = mode;
+
+    // Reuse the storage of a released buffer of the same size if possible, only data needs uploading
+    if(OGLStorageCache::acquire_buffer(size, mode, rd_handle_, persistent_map_))
+    {
+        glBindBuffer(target_, rd_handle_);
+        if(mode != UsagePattern::PersistentMapping)
+        {
+            if(data)
+                glBufferSubData(target_, 0, size, data);
+        }
+        else
+            has_persistent_mapping_ = true;
+
+        initialized_ = true;
+        return;
+    }
 
     GLenum gl_usage_pattern = to_ogl_usage_pattern(mode);
 
@@ -173,6 +192,20 @@ void OGLBuffer::release_base()
     }
 }
 
+void OGLBuffer::recycle()
+{
+    if(initialized_)
+    {
+        KLOG("render", 1) << "Recycling OpenGL " << kb::KS_INST_ << "Buffer " << kb::KC_ << " id=" << rd_handle_
+                          << std::endl;
+        glBindBuffer(target_, 0);
+        OGLStorageCache::recycle_buffer(rd_handle_, storage_size_, usage_, persistent_map_);
+        persistent_map_ = nullptr;
+        has_persistent_mapping_ = false;
+        initialized_ = false;
+    }
+}
+
 OGLVertexBuffer::OGLVertexBuffer(float* vertex_data, uint32_t count, const BufferLayout& layout, UsagePattern mode)
 {
     init(vertex_data, count, layout, mode);
@@ -281,7 +314,7 @@ void OGLVertexArray::init()
     }
 }
 
-void OGLVertexArray::release()
+void OGLVertexArray::release(bool recycle_buffers)
 {
     if(initialized_)
     {
@@ -290,9 +323,19 @@ void OGLVertexArray::release()
         glDeleteVertexArrays(1, &rd_handle_);
         // release VBO/IBO
         if(has_index_buffer())
-            index_buffer_->get().release();
+        {
+            if(recycle_buffers)
+                index_buffer_->get().recycle();
+            else
+                index_buffer_->get().release();
+        }
         for(auto&& vb : vertex_buffers_)
-            vb.get().release();
+        {
+            if(recycle_buffers)
+                vb.get().recycle();
+            else
+                vb.get().release();
+        }
         KLOGI << "done" << std::endl;
         initialized_ = false;
     }
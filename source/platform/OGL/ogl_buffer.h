@@ -13,6 +13,8 @@ public:
 
     void init_base(uint32_t target, void* data, uint32_t size, UsagePattern mode);
     void release_base();
+    // Give the storage to the storage cache instead of deleting it, the GPU must be done with it
+    void recycle();
     void bind() const;
     void unbind() const;
     void stream(void* data, uint32_t size, uint32_t offset=0);
@@ -31,6 +33,8 @@ protected:
     bool initialized_ = false;
     uint32_t target_ = 0;
     uint32_t rd_handle_ = 0;
+    uint32_t storage_size_ = 0;
+    UsagePattern usage_ = UsagePattern::Static;
 };
 
 class OGLVertexBuffer: public OGLBuffer
@@ -121,7 +125,8 @@ public:
     ~OGLVertexArray();
 
     void init();
-    void release();
+    // Buffers are released along with the vertex array, their storage is recycled if required
+    void release(bool recycle_buffers = false);
 
     void bind() const;
     void unbind() const;
@@ -82,4 +82,10 @@ void OGLContext::make_current() const
         glfwMakeContextCurrent(window_context);
 }
 
+void OGLContext::release_current() const
+{
+    if(glfwGetCurrentContext() == static_cast<GLFWwindow*>(window_handle_))
+        glfwMakeContextCurrent(nullptr);
+}
+
 } // namespace erwin
\ No newline at end of file
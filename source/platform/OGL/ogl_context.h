@@ -14,6 +14,7 @@ public:
 	virtual void init() override;
 	virtual void swap_buffers() const override;
 	virtual void make_current() const override;
+	virtual void release_current() const override;
 
 private:
 	void* window_handle_;
@@ -0,0 +1,212 @@
+#include "platform/OGL/ogl_deferred_release.h"
+#include "core/core.h"
+#include "render/renderer_config.h"
+#include <kibble/logger/logger.h>
+
+#include "glad/glad.h"
+
+#include <algorithm>
+
+namespace erwin
+{
+
+OGLDeferredRelease::~OGLDeferredRelease()
+{
+    K_ASSERT(pending_.empty() && batches_.empty(), "Deferred releases were not flushed.");
+}
+
+void OGLDeferredRelease::next_frame()
+{
+    if(!pending_.empty())
+    {
+        batches_.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), 0, std::move(pending_)});
+        pending_.clear();
+    }
+
+    // Batches are fenced in submission order, stop at the first one the GPU may still be using
+    while(!batches_.empty())
+    {
+        auto& batch = batches_.front();
+        GLsync fence = static_cast<GLsync>(batch.fence);
+        GLuint64 timeout = (batch.age >= k_max_destruction_latency) ? 1000000000 : 0;
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if(status == GL_TIMEOUT_EXPIRED && timeout == 0)
+            break;
+        if(status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            KLOGW("render") << "Deferred release wait failed." << std::endl;
+
+        glDeleteSync(fence);
+        for(auto& release : batch.releases)
+            release();
+        batches_.pop_front();
+    }
+
+    for(auto& batch : batches_)
+        ++batch.age;
+}
+
+void OGLDeferredRelease::flush()
+{
+    glFinish();
+    for(auto& batch : batches_)
+    {
+        glDeleteSync(static_cast<GLsync>(batch.fence));
+        for(auto& release : batch.releases)
+            release();
+    }
+    batches_.clear();
+    for(auto& release : pending_)
+        release();
+    pending_.clear();
+}
+
+struct CachedBuffer
+{
+    uint32_t rd_handle;
+    uint32_t size;
+    UsagePattern mode;
+    void* persistent_map;
+    uint32_t frame;
+};
+
+struct CachedTexture
+{
+    uint32_t rd_handle;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint32_t internal_format;
+    size_t size;
+    uint32_t frame;
+};
+
+// Entries are kept in recycling order, the front entries are the least recently recycled
+struct StorageCacheStorage
+{
+    std::vector<CachedBuffer> buffers;
+    std::vector<CachedTexture> textures;
+    size_t size = 0;
+    size_t budget = 0;
+    uint32_t frame = 0;
+};
+static StorageCacheStorage s_storage;
+
+// Delete the least recently recycled storage until the cache fits in its budget
+static void evict()
+{
+    size_t buffer_count = 0;
+    size_t texture_count = 0;
+    while(s_storage.size > s_storage.budget)
+    {
+        bool has_buffer = buffer_count < s_storage.buffers.size();
+        bool has_texture = texture_count < s_storage.textures.size();
+        if(has_buffer && (!has_texture || s_storage.buffers[buffer_count].frame <=
+                                              s_storage.textures[texture_count].frame))
+        {
+            const auto& entry = s_storage.buffers[buffer_count++];
+            glDeleteBuffers(1, &entry.rd_handle);
+            s_storage.size -= entry.size;
+        }
+        else
+        {
+            const auto& entry = s_storage.textures[texture_count++];
+            glDeleteTextures(1, &entry.rd_handle);
+            s_storage.size -= entry.size;
+        }
+    }
+    s_storage.buffers.erase(s_storage.buffers.begin(), s_storage.buffers.begin() + long(buffer_count));
+    s_storage.textures.erase(s_storage.textures.begin(), s_storage.textures.begin() + long(texture_count));
+}
+
+void OGLStorageCache::init(size_t budget)
+{
+    s_storage.budget = budget;
+    evict();
+}
+
+bool OGLStorageCache::acquire_buffer(uint32_t size, UsagePattern mode, uint32_t& rd_handle, void*& persistent_map)
+{
+    auto it = std::find_if(s_storage.buffers.begin(), s_storage.buffers.end(),
+                           [size, mode](const auto& entry) { return entry.size == size && entry.mode == mode; });
+    if(it == s_storage.buffers.end())
+        return false;
+
+    rd_handle = it->rd_handle;
+    persistent_map = it->persistent_map;
+    s_storage.size -= it->size;
+    s_storage.buffers.erase(it);
+    return true;
+}
+
+void OGLStorageCache::recycle_buffer(uint32_t rd_handle, uint32_t size, UsagePattern mode, void* persistent_map)
+{
+    s_storage.buffers.push_back({rd_handle, size, mode, persistent_map, s_storage.frame});
+    s_storage.size += size;
+    evict();
+}
+
+uint32_t OGLStorageCache::acquire_texture(uint32_t width, uint32_t height, uint32_t levels, uint32_t internal_format)
+{
+    auto it = std::find_if(s_storage.textures.begin(), s_storage.textures.end(), [&](const auto& entry) {
+        return entry.width == width && entry.height == height && entry.levels == levels &&
+               entry.internal_format == internal_format;
+    });
+    if(it == s_storage.textures.end())
+        return 0;
+
+    uint32_t rd_handle = it->rd_handle;
+    s_storage.size -= it->size;
+    s_storage.textures.erase(it);
+    return rd_handle;
+}
+
+void OGLStorageCache::recycle_texture(uint32_t rd_handle, uint32_t width, uint32_t height, uint32_t levels,
+                                      uint32_t internal_format, size_t size)
+{
+    s_storage.textures.push_back({rd_handle, width, height, levels, internal_format, size, s_storage.frame});
+    s_storage.size += size;
+    evict();
+}
+
+void OGLStorageCache::next_frame()
+{
+    ++s_storage.frame;
+    auto expired = [](const auto& entry) { return s_storage.frame - entry.frame > k_storage_cache_frames; };
+
+    for(const auto& entry : s_storage.buffers)
+    {
+        if(expired(entry))
+        {
+            glDeleteBuffers(1, &entry.rd_handle);
+            s_storage.size -= entry.size;
+        }
+    }
+    s_storage.buffers.erase(std::remove_if(s_storage.buffers.begin(), s_storage.buffers.end(), expired),
+                            s_storage.buffers.end());
+
+    for(const auto& entry : s_storage.textures)
+    {
+        if(expired(entry))
+        {
+            glDeleteTextures(1, &entry.rd_handle);
+            s_storage.size -= entry.size;
+        }
+    }
+    s_storage.textures.erase(std::remove_if(s_storage.textures.begin(), s_storage.textures.end(), expired),
+                             s_storage.textures.end());
+}
+
+void OGLStorageCache::clear()
+{
+    for(const auto& entry : s_storage.buffers)
+        glDeleteBuffers(1, &entry.rd_handle);
+    for(const auto& entry : s_storage.textures)
+        glDeleteTextures(1, &entry.rd_handle);
+    s_storage.buffers.clear();
+    s_storage.textures.clear();
+    s_storage.size = 0;
+}
+
+size_t OGLStorageCache::get_size() { return s_storage.size; }
+
+} // namespace erwin
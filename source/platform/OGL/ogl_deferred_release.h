@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "render/buffer_layout.h"
+
+namespace erwin
+{
+
+// Destroyed resources may still be used by frames in flight. Releases scheduled during a frame are
+// fenced at the end of the frame, and executed once the GPU is done with it. A batch still in use after
+// k_max_destruction_latency frames is waited for.
+class OGLDeferredRelease
+{
+public:
+    using ReleaseFunc = std::function<void()>;
+
+    OGLDeferredRelease() = default;
+    ~OGLDeferredRelease();
+
+    // Schedule a release, executed once the GPU is done with the current frame
+    inline void push(ReleaseFunc&& func) { pending_.push_back(std::move(func)); }
+    // Fence the releases scheduled during this frame, execute those the GPU is done with
+    void next_frame();
+    // Wait for the GPU and execute all scheduled releases
+    void flush();
+
+private:
+    struct Batch
+    {
+        void* fence = nullptr; // GLsync object
+        uint32_t age = 0;
+        std::vector<ReleaseFunc> releases;
+    };
+
+    std::vector<ReleaseFunc> pending_;
+    std::deque<Batch> batches_;
+};
+
+// Storage of released buffers and textures, kept for a few frames so that allocations of the same size
+// and format can reuse it instead of allocating new storage. Only storage the GPU is done with must be
+// given to the cache, see OGLDeferredRelease. The cache holds at most a byte budget, the least recently
+// recycled storage is deleted first when it is exceeded.
+class OGLStorageCache
+{
+public:
+    // Set the maximum amount of bytes the cache can hold
+    static void init(size_t budget);
+    // Get the name of a cached buffer of the same size and usage. Returns false if there is none.
+    static bool acquire_buffer(uint32_t size, UsagePattern mode, uint32_t& rd_handle, void*& persistent_map);
+    static void recycle_buffer(uint32_t rd_handle, uint32_t size, UsagePattern mode, void* persistent_map);
+    // Get the name of a cached 2D texture with the same immutable storage, or 0 if there is none
+    static uint32_t acquire_texture(uint32_t width, uint32_t height, uint32_t levels, uint32_t internal_format);
+    static void recycle_texture(uint32_t rd_handle, uint32_t width, uint32_t height, uint32_t levels,
+                                uint32_t internal_format, size_t size);
+    // Delete storage that was not reused for k_storage_cache_frames
+    static void next_frame();
+    // Delete all cached storage
+    static void clear();
+    // Get the amount of bytes held by the cache
+    static size_t get_size();
+};
+
+} // namespace erwin
@@ -3,7 +3,6 @@
 #include "platform/OGL/ogl_backend.h"
 #include <kibble/logger/logger.h>
 
-#include "stb/stb_image_write.h"
 
 #include "glad/glad.h"
 
@@ -151,30 +150,6 @@ void OGLFramebuffer::bind(uint32_t mip_level)
 
 void OGLFramebuffer::unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
 
-void OGLFramebuffer::screenshot(const std::string& filepath)
-{
-    KLOGN("render") << "[Framebuffer] Saving screenshot:" << std::endl;
-
-    // Allocate buffer for image data
-    unsigned char* pixels = new unsigned char[width_ * height_ * 4];
-
-    // Retrieve pixel data
-    glFinish();
-    glBindFramebuffer(GL_FRAMEBUFFER, rd_handle_);
-    glPixelStorei(GL_PACK_ALIGNMENT, 1); // Change alignment to 1 to avoid out of bounds writes,
-    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, pixels);
-    glPixelStorei(GL_PACK_ALIGNMENT, 4);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Write to png file
-    stbi_write_png(filepath.c_str(), int(width_), int(height_), 4, pixels, int(width_) * 4);
-
-    // Cleanup
-    delete[] pixels;
-
-    KLOGI << kb::KS_PATH_ << filepath << std::endl;
-}
-
 void OGLFramebuffer::blit_depth(const OGLFramebuffer& source)
 {
     // Push state
@@ -18,12 +18,12 @@ public:
 
 	void bind(uint32_t mip_level=0);
 	void unbind();
-	void screenshot(const std::string& filepath);
 	void blit_depth(const OGLFramebuffer& source);
 
 	inline uint32_t get_width() const  { return width_; }
 	inline uint32_t get_height() const { return height_; }
 	inline uint8_t get_flags() const   { return flags_; }
+	inline uint32_t get_handle() const { return rd_handle_; }
 	inline bool has_depth() const      { return bool(flags_ & FBFlag::FB_DEPTH_ATTACHMENT); }
 	inline bool has_stencil() const    { return bool(flags_ & FBFlag::FB_STENCIL_ATTACHMENT); }
 	inline bool has_cubemap() const    { return bool(flags_ & FBFlag::FB_CUBEMAP_ATTACHMENT); }
@@ -0,0 +1,163 @@
+#include "platform/OGL/ogl_pixel_readback.h"
+#include "core/core.h"
+#include "render/renderer_config.h"
+#include <kibble/logger/logger.h>
+
+#include "glad/glad.h"
+
+#include <algorithm>
+
+namespace erwin
+{
+
+OGLPixelReadback::~OGLPixelReadback()
+{
+    K_ASSERT(pending_.empty() && free_buffers_.empty(), "Pixel readback was not released.");
+}
+
+OGLPixelReadback::PackBuffer OGLPixelReadback::acquire_buffer(uint32_t size)
+{
+    // Smallest free buffer that can hold the pixels
+    auto best = free_buffers_.end();
+    for(auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it)
+        if(it->capacity >= size && (best == free_buffers_.end() || it->capacity < best->capacity))
+            best = it;
+
+    if(best != free_buffers_.end())
+    {
+        PackBuffer buffer = *best;
+        free_buffers_.erase(best);
+        return buffer;
+    }
+
+    PackBuffer buffer;
+    buffer.capacity = size;
+    glCreateBuffers(1, &buffer.rd_handle);
+    glNamedBufferData(buffer.rd_handle, GLsizeiptr(size), nullptr, GL_STREAM_READ);
+    KLOG("render", 0) << "OpenGL " << kb::KS_INST_ << "Pixel Pack Buffer" << kb::KC_
+                      << " created. id=" << buffer.rd_handle << " size=" << size << "B" << std::endl;
+    return buffer;
+}
+
+void OGLPixelReadback::submit(PackBuffer buffer, uint32_t size, Callback&& on_ready)
+{
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending_.push_back({buffer, size, fence, 0, std::move(on_ready)});
+}
+
+void OGLPixelReadback::read_framebuffer(uint32_t framebuffer, uint32_t width, uint32_t height, Callback&& on_ready)
+{
+    uint32_t size = width * height * 4;
+    PackBuffer buffer = acquire_buffer(size);
+
+    // Push state
+    GLint read_fbo = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fbo);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.rd_handle);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); // Change alignment to 1 to avoid out of bounds writes
+    glReadPixels(0, 0, GLsizei(width), GLsizei(height), GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Pop state
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(read_fbo));
+
+    submit(buffer, size, std::move(on_ready));
+}
+
+void OGLPixelReadback::read_texture(uint32_t texture, uint32_t width, uint32_t height, Callback&& on_ready)
+{
+    uint32_t size = width * height * 4;
+    PackBuffer buffer = acquire_buffer(size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.rd_handle);
+    glGetTextureImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, GLsizei(size), nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    submit(buffer, size, std::move(on_ready));
+}
+
+void OGLPixelReadback::read_cubemap(uint32_t texture, uint32_t width, uint32_t mips, uint32_t channels,
+                                    Callback&& on_ready)
+{
+    uint32_t texel_size = channels * 2;
+    uint32_t size = 0;
+    for(uint32_t level = 0; level <= mips; ++level)
+    {
+        uint32_t level_width = std::max(1u, width >> level);
+        size += 6 * level_width * level_width * texel_size;
+    }
+    PackBuffer buffer = acquire_buffer(size);
+
+    // Each level is packed with its six faces, right after the previous level
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.rd_handle);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    uint32_t offset = 0;
+    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
+    for(uint32_t level = 0; level <= mips; ++level)
+    {
+        uint32_t level_width = std::max(1u, width >> level);
+        uint32_t level_size = 6 * level_width * level_width * texel_size;
+        glGetTextureImage(texture, GLint(level), format, GL_HALF_FLOAT, GLsizei(level_size),
+                          reinterpret_cast<void*>(uintptr_t(offset)));
+        offset += level_size;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    submit(buffer, size, std::move(on_ready));
+}
+
+void OGLPixelReadback::complete(Request& request)
+{
+    glDeleteSync(static_cast<GLsync>(request.fence));
+    const auto* data = static_cast<const uint8_t*>(
+        glMapNamedBufferRange(request.buffer.rd_handle, 0, GLsizeiptr(request.size), GL_MAP_READ_BIT));
+    request.on_ready(data, request.size);
+    glUnmapNamedBuffer(request.buffer.rd_handle);
+    free_buffers_.push_back(request.buffer);
+}
+
+void OGLPixelReadback::next_frame()
+{
+    // Fences signal in submission order, stop at the first readback the GPU is not done with
+    while(!pending_.empty())
+    {
+        auto& request = pending_.front();
+        GLuint64 timeout = (request.age >= k_max_readback_latency) ? 1000000000 : 0;
+        GLenum status = glClientWaitSync(static_cast<GLsync>(request.fence), GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if(status == GL_TIMEOUT_EXPIRED && timeout == 0)
+            break;
+        if(status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            KLOGW("render") << "Pixel readback wait failed." << std::endl;
+
+        complete(request);
+        pending_.pop_front();
+    }
+
+    for(auto& request : pending_)
+        ++request.age;
+}
+
+void OGLPixelReadback::flush()
+{
+    if(pending_.empty())
+        return;
+
+    glFinish();
+    for(auto& request : pending_)
+        complete(request);
+    pending_.clear();
+}
+
+void OGLPixelReadback::release()
+{
+    flush();
+    for(const auto& buffer : free_buffers_)
+        glDeleteBuffers(1, &buffer.rd_handle);
+    free_buffers_.clear();
+}
+
+} // namespace erwin
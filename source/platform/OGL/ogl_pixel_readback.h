@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace erwin
+{
+
+// Asynchronous pixel readback. Pixels are packed to a pixel buffer object instead of client memory, and
+// the buffer is fenced. Once the GPU is done, the buffer is mapped and the pixels are handed to a callback,
+// usually a frame or two later. A readback still pending after k_max_readback_latency frames is waited for.
+// Pixel buffers are recycled between readbacks.
+class OGLPixelReadback
+{
+public:
+    // Pixel data is only valid during the call
+    using Callback = std::function<void(const uint8_t* data, uint32_t size)>;
+
+    OGLPixelReadback() = default;
+    ~OGLPixelReadback();
+
+    // Read the RGBA8 pixels of a framebuffer read buffer
+    void read_framebuffer(uint32_t framebuffer, uint32_t width, uint32_t height, Callback&& on_ready);
+    // Read the RGBA8 pixels of the base level of a 2D texture
+    void read_texture(uint32_t texture, uint32_t width, uint32_t height, Callback&& on_ready);
+    // Read the half float pixels of all faces and mip levels of a cubemap, see cubemap_mip_chain_size()
+    void read_cubemap(uint32_t texture, uint32_t width, uint32_t mips, uint32_t channels, Callback&& on_ready);
+    // Complete the readbacks the GPU is done with, should be called once per frame
+    void next_frame();
+    // Wait for the GPU and complete all pending readbacks
+    void flush();
+    // Complete pending readbacks and delete pixel buffers
+    void release();
+
+private:
+    struct PackBuffer
+    {
+        uint32_t rd_handle = 0;
+        uint32_t capacity = 0;
+    };
+
+    struct Request
+    {
+        PackBuffer buffer;
+        uint32_t size = 0;
+        void* fence = nullptr; // GLsync object
+        uint32_t age = 0;
+        Callback on_ready;
+    };
+
+    PackBuffer acquire_buffer(uint32_t size);
+    void submit(PackBuffer buffer, uint32_t size, Callback&& on_ready);
+    void complete(Request& request);
+
+private:
+    std::vector<PackBuffer> free_buffers_;
+    std::deque<Request> pending_;
+};
+
+} // namespace erwin
@@ -0,0 +1,282 @@
+#include "platform/OGL/ogl_program_cache.h"
+#include "core/core.h"
+#include "filesystem/atomic_write.h"
+#include "utils/fnv1a.hpp"
+#include <kibble/logger/logger.h>
+
+#include "glad/glad.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace erwin
+{
+
+// Helpers for stream read/write pointer cast
+// Only well defined for PODs
+template <typename T, typename = std::enable_if_t<std::is_standard_layout_v<T> && std::is_trivial_v<T>>>
+static inline char* opaque_cast(T* in)
+{
+    return reinterpret_cast<char*>(in);
+}
+
+template <typename T, typename = std::enable_if_t<std::is_standard_layout_v<T> && std::is_trivial_v<T>>>
+static inline const char* opaque_cast(const T* in)
+{
+    return reinterpret_cast<const char*>(in);
+}
+
+struct ProgramCacheHeader
+{
+    uint32_t magic;           // Magic number to check file format validity
+    uint32_t version;         // Format version
+    uint64_t key;             // Program key, guards against hash collisions in file names
+    uint32_t binary_format;   // Driver specific binary format
+    uint32_t binary_size;     // Size of the program binary in bytes
+    uint32_t attribute_count; // Number of vertex attributes
+    uint32_t uniform_count;   // Number of non-block uniforms
+    uint32_t slot_count;      // Number of texture slots
+    uint32_t binding_count;   // Number of block binding points
+};
+
+#define PBC_MAGIC 0x43425045 // ASCII(EPBC)
+#define PBC_VERSION 1
+
+// Upper bounds on the sizes read from an entry, anything larger is a corrupted file
+static constexpr uint32_t k_max_binary_size = 64 * 1024 * 1024;
+static constexpr uint32_t k_max_interface_entries = 4096;
+
+// Size of a well-formed entry described by a header
+static inline uint64_t entry_size(const ProgramCacheHeader& header)
+{
+    constexpr uint64_t k_attribute_size = sizeof(hash_t) + sizeof(ShaderDataType);
+    constexpr uint64_t k_binding_size = sizeof(hash_t) + sizeof(uint32_t);
+    return sizeof(ProgramCacheHeader) + uint64_t(header.binary_size) + header.attribute_count * k_attribute_size +
+           (uint64_t(header.uniform_count) + header.slot_count + header.binding_count) * k_binding_size;
+}
+
+static inline bool is_sane(const ProgramCacheHeader& header)
+{
+    return header.binary_size > 0 && header.binary_size <= k_max_binary_size &&
+           header.attribute_count <= k_max_interface_entries && header.uniform_count <= k_max_interface_entries &&
+           header.slot_count <= k_max_interface_entries && header.binding_count <= k_max_interface_entries;
+}
+
+// Remove an entry that cannot be read, so that it is written again
+static void discard_entry(std::ifstream& ifs, const fs::path& path)
+{
+    KLOGW("shader") << "Invalid or outdated program cache entry, removed:" << std::endl;
+    KLOGI << kb::KS_PATH_ << path << std::endl;
+    ifs.close();
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+struct ProgramCacheStorage
+{
+    fs::path directory;
+    uint64_t driver_hash = 0;
+    bool enabled = false;
+};
+static ProgramCacheStorage s_storage;
+
+static fs::path entry_path(uint64_t key)
+{
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return s_storage.directory / ss.str();
+}
+
+void OGLProgramCache::init(const fs::path& directory)
+{
+    s_storage.enabled = false;
+
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if(format_count == 0)
+    {
+        KLOGW("shader") << "Driver does not support program binaries, program cache disabled." << std::endl;
+        return;
+    }
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if(ec)
+    {
+        KLOGW("shader") << "Cannot create program cache directory, program cache disabled:" << std::endl;
+        KLOGI << kb::KS_PATH_ << directory << std::endl;
+        return;
+    }
+
+    // Driver signature
+    uint64_t hash = k_fnv1a_seed;
+    for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        const char* str = reinterpret_cast<const char*>(glGetString(name));
+        if(str)
+            hash = fnv1a(str, std::strlen(str), hash);
+    }
+
+    s_storage.directory = directory;
+    s_storage.driver_hash = hash;
+    s_storage.enabled = true;
+
+    KLOG("shader", 1) << "Program cache: " << kb::KS_PATH_ << directory << std::endl;
+}
+
+bool OGLProgramCache::is_enabled() { return s_storage.enabled; }
+
+uint64_t OGLProgramCache::make_key(const std::vector<std::pair<slang::ExecutionModel, std::string>>& sources)
+{
+    uint64_t key = s_storage.driver_hash;
+    for(auto&& [type, source] : sources)
+    {
+        key = fnv1a(&type, sizeof(type), key);
+        key = fnv1a(source.data(), source.size(), key);
+    }
+    return key;
+}
+
+uint32_t OGLProgramCache::load(uint64_t key, ProgramInterface& iface)
+{
+    W_PROFILE_FUNCTION()
+
+    fs::path path = entry_path(key);
+    std::ifstream ifs(path, std::ios::binary);
+    if(!ifs.is_open())
+        return 0;
+
+    // Sizes are checked against the file before anything is allocated
+    std::error_code ec;
+    uint64_t file_size = uint64_t(fs::file_size(path, ec));
+    ProgramCacheHeader header;
+    ifs.read(opaque_cast(&header), sizeof(ProgramCacheHeader));
+    if(ec || !ifs || header.magic != PBC_MAGIC || header.version != PBC_VERSION || !is_sane(header) ||
+       entry_size(header) != file_size)
+    {
+        discard_entry(ifs, path);
+        return 0;
+    }
+    // Hash collision in the file name
+    if(header.key != key)
+        return 0;
+
+    std::vector<char> binary(header.binary_size);
+    ifs.read(binary.data(), long(header.binary_size));
+
+    iface.attributes.resize(header.attribute_count);
+    for(auto& attribute : iface.attributes)
+    {
+        hash_t name;
+        ShaderDataType type;
+        ifs.read(opaque_cast(&name), sizeof(hash_t));
+        ifs.read(opaque_cast(&type), sizeof(ShaderDataType));
+        attribute = BufferLayoutElement(name, type);
+    }
+    for(uint32_t ii = 0; ii < header.uniform_count; ++ii)
+    {
+        hash_t name;
+        int32_t location;
+        ifs.read(opaque_cast(&name), sizeof(hash_t));
+        ifs.read(opaque_cast(&location), sizeof(int32_t));
+        iface.uniform_locations.insert(std::make_pair(name, location));
+    }
+    for(uint32_t ii = 0; ii < header.slot_count; ++ii)
+    {
+        hash_t name;
+        uint32_t slot;
+        ifs.read(opaque_cast(&name), sizeof(hash_t));
+        ifs.read(opaque_cast(&slot), sizeof(uint32_t));
+        iface.texture_slots.insert(std::make_pair(name, slot));
+    }
+    for(uint32_t ii = 0; ii < header.binding_count; ++ii)
+    {
+        hash_t name;
+        uint32_t binding;
+        ifs.read(opaque_cast(&name), sizeof(hash_t));
+        ifs.read(opaque_cast(&binding), sizeof(uint32_t));
+        iface.block_bindings.insert(std::make_pair(name, binding));
+    }
+
+    if(!ifs)
+    {
+        discard_entry(ifs, path);
+        iface = ProgramInterface();
+        return 0;
+    }
+
+    // The driver may reject a binary it produced, for example after a driver update with the same version string
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, GLenum(header.binary_format), binary.data(), GLsizei(header.binary_size));
+    GLint is_linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+    if(is_linked == GL_FALSE)
+    {
+        KLOG("shader", 1) << "Cached program binary was rejected by the driver." << std::endl;
+        glDeleteProgram(program);
+        iface = ProgramInterface();
+        return 0;
+    }
+
+    return program;
+}
+
+void OGLProgramCache::save(uint64_t key, uint32_t program, const ProgramInterface& iface)
+{
+    W_PROFILE_FUNCTION()
+
+    GLint binary_size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_size);
+    if(binary_size == 0)
+        return;
+
+    std::vector<char> binary(size_t(binary_size));
+    GLenum binary_format = 0;
+    glGetProgramBinary(program, binary_size, &binary_size, &binary_format, binary.data());
+
+    ProgramCacheHeader header;
+    header.magic = PBC_MAGIC;
+    header.version = PBC_VERSION;
+    header.key = key;
+    header.binary_format = binary_format;
+    header.binary_size = uint32_t(binary_size);
+    header.attribute_count = uint32_t(iface.attributes.size());
+    header.uniform_count = uint32_t(iface.uniform_locations.size());
+    header.slot_count = uint32_t(iface.texture_slots.size());
+    header.binding_count = uint32_t(iface.block_bindings.size());
+
+    fs::path path = entry_path(key);
+    bool written = write_file_atomic(path, [&header, &binary, &iface](std::ostream& os) {
+        os.write(opaque_cast(&header), sizeof(ProgramCacheHeader));
+        os.write(binary.data(), long(header.binary_size));
+        for(const auto& attribute : iface.attributes)
+        {
+            os.write(opaque_cast(&attribute.name), sizeof(hash_t));
+            os.write(opaque_cast(&attribute.type), sizeof(ShaderDataType));
+        }
+        for(auto&& [name, location] : iface.uniform_locations)
+        {
+            os.write(opaque_cast(&name), sizeof(hash_t));
+            os.write(opaque_cast(&location), sizeof(int32_t));
+        }
+        for(auto&& [name, slot] : iface.texture_slots)
+        {
+            os.write(opaque_cast(&name), sizeof(hash_t));
+            os.write(opaque_cast(&slot), sizeof(uint32_t));
+        }
+        for(auto&& [name, binding] : iface.block_bindings)
+        {
+            os.write(opaque_cast(&name), sizeof(hash_t));
+            os.write(opaque_cast(&binding), sizeof(uint32_t));
+        }
+    });
+    if(!written)
+    {
+        KLOGW("shader") << "Cannot write program cache entry:" << std::endl;
+        KLOGI << kb::KS_PATH_ << path << std::endl;
+    }
+}
+
+} // namespace erwin
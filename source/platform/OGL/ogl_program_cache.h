@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "core/core.h"
+#include "render/buffer_layout.h"
+#include "render/shader_lang.h"
+
+namespace fs = std::filesystem;
+
+namespace erwin
+{
+
+// Introspection results of a linked program, stored alongside its binary so that a cached program
+// does not need to be introspected again
+struct ProgramInterface
+{
+    std::vector<BufferLayoutElement> attributes;  // In location order
+    std::map<hash_t, int32_t> uniform_locations;  // [uniform hname, location]
+    std::map<hash_t, uint32_t> texture_slots;     // [uniform hname, slot]
+    std::map<hash_t, uint32_t> block_bindings;    // [block hname, binding point]
+};
+
+// On-disk cache of linked program binaries, see glProgramBinary(). Entries are keyed by a hash of the
+// pre-processed program sources and of the driver vendor, renderer and version strings, so a shader edit
+// or a driver update invalidates them. A binary rejected by the driver is simply rebuilt from source.
+class OGLProgramCache
+{
+public:
+    // Enable the cache and create its directory, needs a current context to query the driver
+    static void init(const fs::path& directory);
+    static bool is_enabled();
+    // Compute the cache key of a program
+    static uint64_t make_key(const std::vector<std::pair<slang::ExecutionModel, std::string>>& sources);
+    // Create a program from a cached binary. Returns 0 on a cache miss, or if the driver rejected the binary.
+    static uint32_t load(uint64_t key, ProgramInterface& iface);
+    // Save the binary of a linked program, which must have been linked retrievable
+    static void save(uint64_t key, uint32_t program, const ProgramInterface& iface);
+};
+
+} // namespace erwin
@@ -56,4 +56,77 @@ std::chrono::nanoseconds OGLQueryTimer::stop()
 #endif
 }
 
+OGLPassQueryTimer::OGLPassQueryTimer()
+{
+    for(auto& frame: frames_)
+        glGenQueries(k_max_passes + 1, &frame.query_IDs[0]);
+}
+
+OGLPassQueryTimer::~OGLPassQueryTimer()
+{
+    for(auto& frame: frames_)
+        glDeleteQueries(k_max_passes + 1, &frame.query_IDs[0]);
+}
+
+void OGLPassQueryTimer::begin_frame()
+{
+    // Results of a frame that are still not available after k_frame_count frames are dropped
+    current_ = (current_ + 1) % k_frame_count;
+    frames_[current_].pass_count = 0;
+    frames_[current_].pending = false;
+}
+
+void OGLPassQueryTimer::begin_pass(uint8_t layer_id)
+{
+    auto& frame = frames_[current_];
+    if(frame.pass_count == k_max_passes)
+        return;
+    frame.layer_ids[frame.pass_count] = layer_id;
+    glQueryCounter(frame.query_IDs[frame.pass_count], GL_TIMESTAMP);
+    ++frame.pass_count;
+}
+
+void OGLPassQueryTimer::end_frame()
+{
+    auto& frame = frames_[current_];
+    if(frame.pass_count == 0)
+        return;
+    glQueryCounter(frame.query_IDs[frame.pass_count], GL_TIMESTAMP);
+    frame.pending = true;
+}
+
+bool OGLPassQueryTimer::collect(std::vector<PassTime>& results)
+{
+    // Visit frames from the most recent one, the first available is kept and older ones are dropped
+    bool found = false;
+    for(uint32_t ii = 0; ii < k_frame_count; ++ii)
+    {
+        auto& frame = frames_[(current_ + k_frame_count - ii) % k_frame_count];
+        if(!frame.pending)
+            continue;
+        if(found)
+        {
+            frame.pending = false;
+            continue;
+        }
+
+        // The end timestamp is the last one to complete
+        GLint available = 0;
+        glGetQueryObjectiv(frame.query_IDs[frame.pass_count], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            continue;
+
+        GLuint64 timestamps[k_max_passes + 1];
+        for(uint32_t jj = 0; jj <= frame.pass_count; ++jj)
+            glGetQueryObjectui64v(frame.query_IDs[jj], GL_QUERY_RESULT, &timestamps[jj]);
+
+        results.clear();
+        for(uint32_t jj = 0; jj < frame.pass_count; ++jj)
+            results.push_back({frame.layer_ids[jj], std::chrono::nanoseconds(timestamps[jj + 1] - timestamps[jj])});
+        frame.pending = false;
+        found = true;
+    }
+    return found;
+}
+
 } // namespace erwin
\ No newline at end of file
@@ -29,5 +29,33 @@ private:
 #endif
 };
 
+// Timestamp queries are kept for a few frames, so that results can be read back once available
+class OGLPassQueryTimer: public PassQueryTimer
+{
+public:
+    OGLPassQueryTimer();
+    ~OGLPassQueryTimer();
+
+    virtual void begin_frame() override;
+    virtual void begin_pass(uint8_t layer_id) override;
+    virtual void end_frame() override;
+    virtual bool collect(std::vector<PassTime>& results) override;
+
+private:
+    static constexpr uint32_t k_frame_count = 3;
+    static constexpr uint32_t k_max_passes = 256;
+
+    struct FrameQueries
+    {
+        uint32_t query_IDs[k_max_passes + 1]; // One timestamp per pass start, plus the end timestamp
+        uint8_t layer_ids[k_max_passes];
+        uint32_t pass_count = 0;
+        bool pending = false;
+    };
+
+    FrameQueries frames_[k_frame_count];
+    uint32_t current_ = 0;
+};
+
 
 } // namespace erwin
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "core/application.h"
 #include "filesystem/spv_file.h"
 #include "platform/OGL/ogl_buffer.h"
+#include "platform/OGL/ogl_program_cache.h"
 #include "platform/OGL/ogl_shader.h"
 #include <kibble/string/string.h>
 #include <kibble/logger/logger.h>
@@ -342,22 +343,100 @@ bool OGLShader::init_glsl(const std::string& name, const std::string& glsl_file)
 {
     W_PROFILE_FUNCTION()
 
+    start_glsl(name, glsl_file);
+    return ready_ ? true : finish_glsl();
+}
+
+void OGLShader::init_async(const std::string& name, const std::string& filepath)
+{
+    if(WFS_.check_extension(filepath, ".glsl"))
+        start_glsl(name, filepath);
+    else
+        init(name, filepath);
+}
+
+bool OGLShader::is_ready()
+{
+    if(ready_)
+        return true;
+
+    if(GLAD_GL_KHR_parallel_shader_compile)
+    {
+        GLint is_complete = GL_FALSE;
+        glGetProgramiv(rd_handle_, GL_COMPLETION_STATUS_KHR, &is_complete);
+        if(is_complete == GL_FALSE)
+            return false;
+    }
+
+    finish_glsl();
+    return true;
+}
+
+void OGLShader::wait_ready()
+{
+    if(!ready_)
+        finish_glsl();
+}
+
+void OGLShader::start_glsl(const std::string& name, const std::string& glsl_file)
+{
+    W_PROFILE_FUNCTION()
+
     name_ = name;
     filepath_ = glsl_file;
 
-    std::vector<std::pair<slang::ExecutionModel, std::string>> sources;
-    slang::pre_process_GLSL(glsl_file, sources);
-    bool success = build(sources);
+    pending_sources_.clear();
+    slang::pre_process_GLSL(glsl_file, pending_sources_);
+
+    // Try the program cache first
+    if(OGLProgramCache::is_enabled())
+    {
+        cache_key_ = OGLProgramCache::make_key(pending_sources_);
+        ProgramInterface iface;
+        rd_handle_ = OGLProgramCache::load(cache_key_, iface);
+        if(rd_handle_)
+        {
+            KLOGN("shader") << "Loaded cached OpenGL Shader program: \"" << name_ << "\" [" << rd_handle_ << "]"
+                            << std::endl;
+            import_interface(std::move(iface));
+            pending_sources_.clear();
+            ready_ = true;
+            return;
+        }
+    }
+
+    submit_build();
+    ready_ = false;
+}
+
+bool OGLShader::finish_glsl()
+{
+    W_PROFILE_FUNCTION()
+
+    bool success = finish_build();
     if(success)
+    {
         introspect();
+        if(OGLProgramCache::is_enabled())
+            OGLProgramCache::save(cache_key_, rd_handle_, export_interface());
+    }
     else
     {
         // Load default shader
         KLOGW("shader") << "Loading default red shader as a fallback." << std::endl;
-        sources.clear();
-        slang::pre_process_GLSL("sysres://shaders/red_shader.glsl", sources);
-        introspect();
+        pending_sources_.clear();
+        slang::pre_process_GLSL("sysres://shaders/red_shader.glsl", pending_sources_);
+        submit_build();
+        if(finish_build())
+            introspect();
     }
+    pending_sources_.clear();
+    ready_ = true;
+
+    for(const auto& attachment : pending_attachments_)
+        attach_buffer(attachment.name, attachment.unique_id, attachment.render_handle, attachment.target);
+    pending_attachments_.clear();
+
     return success;
 }
 // Initialize shader from SPIR-V file
@@ -407,32 +486,33 @@ void OGLShader::attach_cubemap(const OGLCubemap& cubemap, uint32_t slot) const
 
 void OGLShader::attach_shader_storage(const OGLShaderStorageBuffer& buffer)
 {
-    hash_t hname = H_(buffer.get_name().c_str());
-    auto it = block_bindings_.find(hname);
-    if(it == block_bindings_.end())
-    {
-        KLOGW("shader") << "Unknown binding name: " << buffer.get_name() << std::endl;
-        return;
-    }
-    GLint binding_point = GLint(it->second);
-    uint32_t render_handle = buffer.get_handle();
-    bound_buffers_.insert(std::make_pair(buffer.get_unique_id(),
-                                         ResourceBinding{binding_point, render_handle, GL_SHADER_STORAGE_BUFFER}));
+    if(ready_)
+        attach_buffer(buffer.get_name(), buffer.get_unique_id(), buffer.get_handle(), GL_SHADER_STORAGE_BUFFER);
+    else
+        pending_attachments_.push_back(
+            {buffer.get_name(), buffer.get_unique_id(), buffer.get_handle(), GL_SHADER_STORAGE_BUFFER});
 }
 
 void OGLShader::attach_uniform_buffer(const OGLUniformBuffer& buffer)
 {
-    hash_t hname = H_(buffer.get_name().c_str());
+    if(ready_)
+        attach_buffer(buffer.get_name(), buffer.get_unique_id(), buffer.get_handle(), GL_UNIFORM_BUFFER);
+    else
+        pending_attachments_.push_back(
+            {buffer.get_name(), buffer.get_unique_id(), buffer.get_handle(), GL_UNIFORM_BUFFER});
+}
+
+void OGLShader::attach_buffer(const std::string& name, W_ID unique_id, uint32_t render_handle, uint32_t target)
+{
+    hash_t hname = H_(name.c_str());
     auto it = block_bindings_.find(hname);
     if(it == block_bindings_.end())
     {
-        KLOGW("shader") << "Unknown binding name: " << buffer.get_name() << std::endl;
+        KLOGW("shader") << "Unknown binding name: " << name << std::endl;
         return;
     }
     GLint binding_point = GLint(it->second);
-    uint32_t render_handle = buffer.get_handle();
-    bound_buffers_.insert(
-        std::make_pair(buffer.get_unique_id(), ResourceBinding{binding_point, render_handle, GL_UNIFORM_BUFFER}));
+    bound_buffers_.insert(std::make_pair(unique_id, ResourceBinding{binding_point, render_handle, target}));
 }
 
 void OGLShader::bind_shader_storage(const OGLShaderStorageBuffer& buffer, uint32_t size, uint32_t base_offset) const
@@ -455,20 +535,35 @@ void OGLShader::bind_uniform_buffer(const OGLUniformBuffer& buffer, uint32_t siz
         glBindBufferBase(GL_UNIFORM_BUFFER, binding_point, buffer.get_handle());
 }
 
+void OGLShader::bind_uniform_range(const OGLUniformBuffer& buffer, uint32_t render_handle, uint32_t size,
+                                   uint32_t offset) const
+{
+    auto it = block_bindings_.find(H_(buffer.get_name().c_str()));
+    if(it != block_bindings_.end())
+        glBindBufferRange(GL_UNIFORM_BUFFER, GLint(it->second), render_handle, offset, size);
+}
+
+void OGLShader::bind_storage_range(const OGLShaderStorageBuffer& buffer, uint32_t render_handle, uint32_t size,
+                                   uint32_t offset) const
+{
+    auto it = block_bindings_.find(H_(buffer.get_name().c_str()));
+    if(it != block_bindings_.end())
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, GLint(it->second), render_handle, offset, size);
+}
+
 const BufferLayout& OGLShader::get_attribute_layout() const { return attribute_layout_; }
 
-bool OGLShader::build(const std::vector<std::pair<slang::ExecutionModel, std::string>>& sources)
+void OGLShader::submit_build()
 {
     W_PROFILE_FUNCTION()
 
     KLOGN("shader") << "Building OpenGL Shader program: \"" << name_ << "\" " << std::endl;
 
-    std::vector<uint32_t> shader_ids;
-
-    // * Compile each shader
-    for(auto&& [type, source] : sources)
+    // * Issue compilation of each shader, status is only queried once the program is linked, so
+    //   that the driver can compile them in parallel
+    pending_shaders_.clear();
+    for(auto&& [type, source] : pending_sources_)
     {
-        // Compile shader from source
         GLuint shader_id = glCreateShader(to_gl_shader_type(type));
 
         KLOGI << "Compiling " << to_string(type) << " [" << shader_id << "]" << std::endl;
@@ -476,33 +571,66 @@ bool OGLShader::build(const std::vector<std::pair<slang::ExecutionModel, std::st
         const char* char_src = source.c_str();
         glShaderSource(shader_id, 1, &char_src, nullptr);
         glCompileShader(shader_id);
+        pending_shaders_.push_back(shader_id);
+    }
 
-        // Check compilation status
-        GLint is_compiled = 0;
-        glGetShaderiv(shader_id, GL_COMPILE_STATUS, &is_compiled);
+    // * Link program
+    rd_handle_ = glCreateProgram();
+    KLOGI << "Linking program [" << rd_handle_ << "]" << std::endl;
+    if(OGLProgramCache::is_enabled())
+        glProgramParameteri(rd_handle_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    for(auto&& shader_id : pending_shaders_)
+        glAttachShader(rd_handle_, shader_id);
+    glLinkProgram(rd_handle_);
+}
 
-        if(is_compiled == GL_FALSE)
+bool OGLShader::finish_build()
+{
+    W_PROFILE_FUNCTION()
+
+    // * Check compilation status
+    bool is_compiled = true;
+    for(size_t ii = 0; ii < pending_shaders_.size(); ++ii)
+    {
+        GLint status = 0;
+        glGetShaderiv(pending_shaders_[ii], GL_COMPILE_STATUS, &status);
+        if(status == GL_FALSE)
         {
             KLOGE("shader") << "Shader \"" << name_ << "\" will not compile" << std::endl;
-            shader_error_report(shader_id, 0, source);
+            shader_error_report(pending_shaders_[ii], 0, pending_sources_[ii].second);
+            is_compiled = false;
+        }
+    }
 
-            // We don't need the shader anymore.
-            glDeleteShader(shader_id);
-            return false;
+    // * Check linking status
+    GLint is_linked = 0;
+    if(is_compiled)
+    {
+        glGetProgramiv(rd_handle_, GL_LINK_STATUS, &is_linked);
+        if(is_linked == GL_FALSE)
+        {
+            KLOGE("render") << "Unable to link shaders." << std::endl;
+            program_error_report(rd_handle_);
         }
+    }
 
-        // Save shader id for later linking
-        shader_ids.push_back(shader_id);
+    // * Shader objects are not needed once the program is linked
+    for(auto&& shader_id : pending_shaders_)
+    {
+        glDetachShader(rd_handle_, shader_id);
+        glDeleteShader(shader_id);
     }
+    pending_shaders_.clear();
 
-    // Link program
-    if(link(shader_ids))
+    if(is_linked == GL_FALSE)
     {
-        KLOGI << "Program \"" << name_ << "\" is ready." << std::endl;
-        return true;
+        glDeleteProgram(rd_handle_);
+        rd_handle_ = 0;
+        return false;
     }
 
-    return false;
+    KLOGI << "Program \"" << name_ << "\" is ready." << std::endl;
+    return true;
 }
 
 bool OGLShader::build_spirv(const std::string& filepath)
@@ -742,6 +870,25 @@ void OGLShader::introspect()
     KLOG("shader", 1) << "--------" << std::endl;
 }
 
+ProgramInterface OGLShader::export_interface() const
+{
+    ProgramInterface iface;
+    iface.attributes.assign(attribute_layout_.begin(), attribute_layout_.end());
+    iface.uniform_locations = uniform_locations_;
+    iface.texture_slots = texture_slots_;
+    iface.block_bindings = block_bindings_;
+    return iface;
+}
+
+void OGLShader::import_interface(ProgramInterface&& iface)
+{
+    attribute_layout_.init(iface.attributes.data(), uint32_t(iface.attributes.size()));
+    uniform_locations_ = std::move(iface.uniform_locations);
+    texture_slots_ = std::move(iface.texture_slots);
+    block_bindings_ = std::move(iface.block_bindings);
+    current_slot_ = uint32_t(texture_slots_.size());
+}
+
 #ifdef W_DEBUG
 static inline void warn_unknown_uniform(const std::string& shader_name, hash_t u_name)
 {
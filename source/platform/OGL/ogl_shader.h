@@ -6,6 +6,7 @@
 #include "core/core.h"
 #include "render/shader_lang.h"
 #include "platform/OGL/ogl_buffer.h"
+#include "platform/OGL/ogl_program_cache.h"
 #include "platform/OGL/ogl_texture.h"
 
 
@@ -25,6 +26,14 @@ public:
 	bool init_glsl(const std::string& name, const std::string& glsl_file);
 	// Initialize shader from SPIR-V file
 	bool init_spirv(const std::string& name, const std::string& spv_file);
+	// Start building a GLSL shader without waiting for the driver, see is_ready().
+	// SPIR-V shaders are built synchronously.
+	void init_async(const std::string& name, const std::string& filepath);
+	// Check whether the program can be used, finish the build if the driver is done compiling it.
+	// Without GL_KHR_parallel_shader_compile, this waits for the driver.
+	bool is_ready();
+	// Wait for the driver to finish building the program
+	void wait_ready();
 
 	void bind() const;
 	void unbind() const;
@@ -38,6 +47,10 @@ public:
 
 	void bind_shader_storage(const OGLShaderStorageBuffer& buffer, uint32_t size=0, uint32_t base_offset=0) const;
 	void bind_uniform_buffer(const OGLUniformBuffer& buffer, uint32_t size=0, uint32_t offset=0) const;
+	// Bind a range of another buffer to the binding point of a uniform buffer, if this shader uses it
+	void bind_uniform_range(const OGLUniformBuffer& buffer, uint32_t render_handle, uint32_t size, uint32_t offset) const;
+	// Same for a shader storage buffer
+	void bind_storage_range(const OGLShaderStorageBuffer& buffer, uint32_t render_handle, uint32_t size, uint32_t offset) const;
 
     const BufferLayout& get_attribute_layout() const;
 
@@ -53,14 +66,26 @@ public:
     }
 
 private:
-	// Build the shader program from sources
-	bool build(const std::vector<std::pair<slang::ExecutionModel, std::string>>& sources);
+	// Pre-process GLSL source and start building it, unless the program is cached
+	void start_glsl(const std::string& name, const std::string& glsl_file);
+	// Wait for the build started by start_glsl(), fall back to the default shader on failure
+	bool finish_glsl();
+	// Issue compilation and linking of the pending sources, without checking their status
+	void submit_build();
+	// Check the status of a build started by submit_build() and release its shader objects
+	bool finish_build();
 	// Build the shader program from SPIR-V binary
 	bool build_spirv(const std::string& filepath);
 	// Link the program
 	bool link(const std::vector<uint32_t>& shader_ids);
 	// Helper function to construct the uniform location, texture slot and binding point registries
 	void introspect();
+	// Copy the registries built by introspect(), to be stored in the program cache
+	ProgramInterface export_interface() const;
+	// Restore registries loaded from the program cache
+	void import_interface(ProgramInterface&& iface);
+	// Register a buffer to the binding point of the block of the same name
+	void attach_buffer(const std::string& name, W_ID unique_id, uint32_t render_handle, uint32_t target);
 
 private:
 	struct ResourceBinding
@@ -69,6 +94,13 @@ private:
 		uint32_t render_handle;
 		uint32_t target;
 	};
+	struct PendingAttachment
+	{
+		std::string name;
+		W_ID unique_id;
+		uint32_t render_handle;
+		uint32_t target;
+	};
 	std::string name_;
 
     uint32_t rd_handle_ = 0;
@@ -79,6 +111,13 @@ private:
     std::map<hash_t, uint32_t> block_bindings_;   // [block hname, binding point]
     std::map<W_ID, ResourceBinding> bound_buffers_;
     std::string filepath_;
+
+    // Asynchronous build state
+    bool ready_ = true;
+    uint64_t cache_key_ = 0;
+    std::vector<std::pair<slang::ExecutionModel, std::string>> pending_sources_;
+    std::vector<uint32_t> pending_shaders_;
+    std::vector<PendingAttachment> pending_attachments_; // Buffers attached before the program was introspected
 };
 
 template <> bool OGLShader::send_uniform<bool>(hash_t name, const bool& value) const;
@@ -1,9 +1,11 @@
 #include "platform/OGL/ogl_texture.h"
+#include "platform/OGL/ogl_deferred_release.h"
 #include "core/core.h"
 #include <kibble/logger/logger.h>
 
 #include "glad/glad.h"
 #include "glm/glm.hpp"
+#include <algorithm>
 #include <iostream>
 #include <map>
 
@@ -218,13 +220,23 @@ void OGLTexture2D::init(const Texture2DDescriptor& descriptor)
 
         KLOGN("texture") << "Creating texture from descriptor: " << std::endl;
 
-        glCreateTextures(GL_TEXTURE_2D, 1, &rd_handle_);
-        KLOGI << "handle: " << rd_handle_ << std::endl;
+        // Reuse the immutable storage of a released texture if possible
+        const FormatDescriptor& fd = s_format_descriptor.at(descriptor.image_format);
+        rd_handle_ = OGLStorageCache::acquire_texture(width_, height_, mips_ + 1, fd.internal_format);
+        bool recycled = (rd_handle_ != 0);
+        if(!recycled)
+        {
+            glCreateTextures(GL_TEXTURE_2D, 1, &rd_handle_);
+            glTextureStorage2D(rd_handle_, mips_ + 1, fd.internal_format, width_, height_);
+        }
+        else
+        {
+            // Sampling parameters are set below, except anisotropy which is only set with mipmaps
+            glTextureParameterf(rd_handle_, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.0f);
+        }
+        KLOGI << "handle: " << rd_handle_ << (recycled ? " (recycled)" : "") << std::endl;
         KLOGI << "width:  " << width_ << std::endl;
         KLOGI << "height: " << height_ << std::endl;
-
-        const FormatDescriptor& fd = s_format_descriptor.at(descriptor.image_format);
-        glTextureStorage2D(rd_handle_, mips_ + 1, fd.internal_format, width_, height_);
         KLOGI << "format: " << format_to_string(fd.format) << std::endl;
 
         if(descriptor.data)
@@ -271,6 +283,18 @@ void OGLTexture2D::release()
     }
 }
 
+void OGLTexture2D::recycle()
+{
+    if(initialized_)
+    {
+        const FormatDescriptor& fd = s_format_descriptor.at(format_);
+        OGLStorageCache::recycle_texture(rd_handle_, width_, height_, mips_ + 1, fd.internal_format,
+                                         texture_storage_size(width_, height_, mips_, format_));
+        KLOG("texture", 1) << "Recycled texture [" << rd_handle_ << "]" << std::endl;
+        initialized_ = false;
+    }
+}
+
 void OGLTexture2D::generate_mipmaps() const { do_generate_mipmaps(rd_handle_, 0, mips_); }
 
 std::pair<uint8_t*, size_t> OGLTexture2D::read_pixels() const
@@ -315,7 +339,25 @@ void OGLCubemap::init(const CubemapDescriptor& descriptor)
         for(size_t face = 0; face < 6; ++face)
             has_data &= (descriptor.face_data[face] != nullptr);
 
-        if(has_data)
+        if(descriptor.mip_data)
+        {
+            // Complete mip chain, all faces of a level are uploaded at once
+            K_ASSERT(format_ == ImageFormat::RGB16F || format_ == ImageFormat::RGBA16F,
+                     "Cubemap mip chains are only supported for half float formats.");
+            const auto* texels = static_cast<const uint8_t*>(descriptor.mip_data);
+            GLint alignment = 4;
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for(uint32_t level = 0; level <= mips_; ++level)
+            {
+                uint32_t level_width = std::max(1u, width_ >> level);
+                glTextureSubImage3D(rd_handle_, int(level), 0, 0, 0, int(level_width), int(level_width), 6, fd.format,
+                                    GL_HALF_FLOAT, texels);
+                texels += cubemap_mip_chain_size(level_width, 0, format_);
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        }
+        else if(has_data)
         {
             for(size_t face = 0; face < 6; ++face)
             {
@@ -341,7 +383,12 @@ void OGLCubemap::init(const CubemapDescriptor& descriptor)
         handle_address_UV_3D(rd_handle_, descriptor.wrap);
 
         // Handle mipmap if specified
-        if(has_mipmap && !descriptor.lazy_mipmap && mips_ > 0)
+        if(has_mipmap && descriptor.mip_data)
+        {
+            glTextureParameteri(rd_handle_, GL_TEXTURE_BASE_LEVEL, 0);
+            glTextureParameteri(rd_handle_, GL_TEXTURE_MAX_LEVEL, GLint(mips_));
+        }
+        else if(has_mipmap && !descriptor.lazy_mipmap && mips_ > 0)
             do_generate_mipmaps(rd_handle_, 0, mips_);
         else
         {
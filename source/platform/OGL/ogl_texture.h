@@ -49,6 +49,8 @@ public:
 
 	void init(const Texture2DDescriptor& descriptor);
 	void release();
+	// Give the storage to the storage cache instead of deleting it, the GPU must be done with it
+	void recycle();
 	inline bool is_initialized() const { return initialized_; }
 
 	virtual void bind(uint32_t slot = 0) const override;
@@ -0,0 +1,94 @@
+#include "platform/OGL/ogl_uniform_ring.h"
+#include "core/core.h"
+#include <kibble/logger/logger.h>
+
+#include "glad/glad.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace erwin
+{
+
+OGLUniformRing::~OGLUniformRing() { release(); }
+
+void OGLUniformRing::init(uint32_t segment_size, Usage usage)
+{
+    if(initialized_)
+        return;
+
+    // Ranges bound to a block binding point must start on a multiple of this.
+    // Indirect draw commands must also be aligned on 4 bytes.
+    GLint alignment;
+    glGetIntegerv(usage == Uniform ? GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT : GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT,
+                  &alignment);
+    alignment_ = std::max(uint32_t(alignment), 4u);
+    segment_size_ = (segment_size + alignment_ - 1) / alignment_ * alignment_;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &rd_handle_);
+    glBindBuffer(GL_UNIFORM_BUFFER, rd_handle_);
+    glBufferStorage(GL_UNIFORM_BUFFER, GLsizeiptr(segment_size_) * k_frame_count, nullptr, flags);
+    map_ = static_cast<uint8_t*>(
+        glMapBufferRange(GL_UNIFORM_BUFFER, 0, GLsizeiptr(segment_size_) * k_frame_count, flags));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    frame_ = 0;
+    head_ = 0;
+    initialized_ = true;
+
+    KLOG("render", 1) << "OpenGL " << kb::KS_INST_ << (usage == Uniform ? "Uniform Ring" : "Storage Ring") << kb::KC_
+                      << " created. id=" << rd_handle_ << std::endl;
+    KLOGI << "Segment size: " << segment_size_ << "B x" << k_frame_count << std::endl;
+    KLOGI << "Alignment:    " << alignment_ << "B" << std::endl;
+}
+
+void OGLUniformRing::release()
+{
+    if(!initialized_)
+        return;
+
+    for(auto& fence : fences_)
+    {
+        if(fence)
+            glDeleteSync(static_cast<GLsync>(fence));
+        fence = nullptr;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, rd_handle_);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glDeleteBuffers(1, &rd_handle_);
+    map_ = nullptr;
+    initialized_ = false;
+}
+
+bool OGLUniformRing::push(const void* data, uint32_t size, uint32_t& offset)
+{
+    if(head_ + size > segment_size_)
+        return false;
+
+    offset = frame_ * segment_size_ + head_;
+    memcpy(map_ + offset, data, size);
+    head_ += (size + alignment_ - 1) / alignment_ * alignment_;
+    return true;
+}
+
+void OGLUniformRing::next_frame()
+{
+    fences_[frame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame_ = (frame_ + 1) % k_frame_count;
+    head_ = 0;
+
+    // The GPU may still be reading the segment we are about to write to
+    if(fences_[frame_])
+    {
+        GLsync fence = static_cast<GLsync>(fences_[frame_]);
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        if(status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            KLOGW("render") << "Uniform ring segment wait failed." << std::endl;
+        glDeleteSync(fence);
+        fences_[frame_] = nullptr;
+    }
+}
+
+} // namespace erwin
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+namespace erwin
+{
+
+// Frame-scoped allocator for uniform data. A single persistently mapped buffer is split into
+// one segment per frame in flight, uniform data is copied to the segment of the current frame
+// and bound as a range, instead of being streamed to each uniform buffer.
+// A segment is fenced at the end of its frame, and only written to again once the GPU is done with it.
+// Shader storage data and indirect draw commands can be sub-allocated the same way, with the Storage usage.
+class OGLUniformRing
+{
+public:
+    enum Usage: uint8_t
+    {
+        Uniform, // Ranges are bound to uniform block binding points
+        Storage  // Ranges are bound to shader storage block binding points, or as indirect draw buffers
+    };
+
+    OGLUniformRing() = default;
+    ~OGLUniformRing();
+
+    void init(uint32_t segment_size, Usage usage = Uniform);
+    void release();
+
+    // Copy data to the current segment. Returns false if the segment is full.
+    bool push(const void* data, uint32_t size, uint32_t& offset);
+    // Fence the current segment and move on to the next one, waiting for the GPU if needed
+    void next_frame();
+
+    inline uint32_t get_handle() const { return rd_handle_; }
+    inline bool is_initialized() const { return initialized_; }
+
+private:
+    static constexpr uint32_t k_frame_count = 3;
+
+    uint8_t* map_ = nullptr;
+    void* fences_[k_frame_count] = {nullptr}; // GLsync objects
+    uint32_t rd_handle_ = 0;
+    uint32_t segment_size_ = 0;
+    uint32_t alignment_ = 256;
+    uint32_t frame_ = 0;
+    uint32_t head_ = 0;
+    bool initialized_ = false;
+};
+
+} // namespace erwin
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "core/clock.hpp"
+#include "render/handles.h"
+#include "render/render_state.h"
+#include "render/sort_key.h"
+#include "utils/radix_sort.hpp"
+
+using namespace erwin;
+
+using Entry = std::pair<uint64_t, void*>;
+
+// Generate keys that look like a busy frame: a handful of views and shaders, random depths,
+// some sequential passes, and dependency entries with the skip key
+static std::vector<Entry> generate_entries(std::size_t count, std::mt19937& gen)
+{
+    std::uniform_int_distribution<uint32_t> view_dist(0, 5);
+    std::uniform_int_distribution<uint32_t> shader_dist(0, 15);
+    std::uniform_int_distribution<uint32_t> kind_dist(0, 9);
+    std::uniform_real_distribution<float> depth_dist(0.f, 1.f);
+
+    RenderState opaque;
+    opaque.render_target = 0;
+    RenderState transparent;
+    transparent.render_target = 0;
+    transparent.blend_state = BlendState::Alpha;
+    uint64_t opaque_flags = opaque.encode();
+    uint64_t transparent_flags = transparent.encode();
+
+    std::vector<Entry> entries(count);
+    uint32_t sequence = 0;
+    for(std::size_t ii = 0; ii < count; ++ii)
+    {
+        SortKey key;
+        ShaderHandle shader{shader_dist(gen)};
+        uint8_t view = uint8_t(view_dist(gen));
+        uint32_t kind = kind_dist(gen);
+        if(kind < 3)
+            entries[ii].first = SortKey::k_skip;
+        else if(kind < 5)
+        {
+            key.set_sequence(sequence++, view, shader);
+            entries[ii].first = key.encode();
+        }
+        else
+        {
+            key.set_depth(depth_dist(gen), view, (kind < 8) ? opaque_flags : transparent_flags, shader);
+            entries[ii].first = key.encode();
+        }
+        entries[ii].second = reinterpret_cast<void*>(ii);
+    }
+    return entries;
+}
+
+template <typename SortFunc>
+static float time_sort(const std::vector<Entry>& reference, std::size_t iterations, SortFunc&& sort_func)
+{
+    std::vector<Entry> work(reference.size());
+    kb::nanoClock clock;
+    std::chrono::nanoseconds total(0);
+    for(std::size_t ii = 0; ii < iterations; ++ii)
+    {
+        std::copy(reference.begin(), reference.end(), work.begin());
+        clock.restart();
+        sort_func(work);
+        total += clock.get_elapsed_time();
+    }
+    return float(std::chrono::duration_cast<std::chrono::nanoseconds>(total).count()) / float(iterations) / 1000.f;
+}
+
+static constexpr std::size_t k_max_count = 8192;
+
+int main(int argc, char** argv)
+{
+    std::size_t iterations = (argc > 1) ? std::size_t(std::stoul(argv[1])) : 500;
+    std::mt19937 gen(42);
+    std::vector<Entry> scratch(k_max_count);
+
+    std::cout << std::setw(8) << "count" << std::setw(16) << "std::sort (us)" << std::setw(16) << "radix (us)"
+              << std::setw(10) << "speedup" << std::endl;
+
+    for(std::size_t count : {64ul, 256ul, 1024ul, 2048ul, 4096ul, k_max_count})
+    {
+        auto reference = generate_entries(count, gen);
+
+        // Sanity check: both paths must agree on the key ordering
+        auto expected = reference;
+        auto result = reference;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [](const Entry& item1, const Entry& item2) { return item1.first < item2.first; });
+        radix_sort(result.data(), scratch.data(), result.size());
+        if(expected != result)
+        {
+            std::cerr << "Radix sort result differs from std::stable_sort for count=" << count << std::endl;
+            return 1;
+        }
+
+        float std_us = time_sort(reference, iterations, [](std::vector<Entry>& work) {
+            std::sort(work.begin(), work.end(),
+                      [](const Entry& item1, const Entry& item2) { return item1.first < item2.first; });
+        });
+        float radix_us = time_sort(reference, iterations, [&scratch](std::vector<Entry>& work) {
+            radix_sort(work.data(), scratch.data(), work.size());
+        });
+
+        std::cout << std::setw(8) << count << std::setw(16) << std::fixed << std::setprecision(2) << std_us
+                  << std::setw(16) << radix_us << std::setw(10) << std_us / radix_us << std::endl;
+    }
+
+    return 0;
+}
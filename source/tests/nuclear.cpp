@@ -58,6 +58,8 @@ template <>
 void erwin::inspector_GUI<ComponentDirectionalLightMaterial>(ComponentDirectionalLightMaterial&, EntityID, Scene&)
 {}
 template <> void erwin::inspector_GUI<ComponentDirectionalLight>(ComponentDirectionalLight&, EntityID, Scene&) {}
+template <> void erwin::inspector_GUI<ComponentPointLight>(ComponentPointLight&, EntityID, Scene&) {}
+template <> void erwin::inspector_GUI<ComponentSpotLight>(ComponentSpotLight&, EntityID, Scene&) {}
 template <> void erwin::inspector_GUI<ComponentScript>(ComponentScript&, EntityID, Scene&) {}
 
 void init_logger()
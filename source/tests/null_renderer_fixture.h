@@ -0,0 +1,130 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+
+#include "core/application.h"
+#include "core/core.h"
+#include "core/window.h"
+#include "platform/Null/null_backend.h"
+#include "render/renderer.h"
+#include <kibble/memory/heap_area.h>
+
+namespace fs = std::filesystem;
+
+namespace erwin
+{
+
+// Application that is never initialized, it only holds the configuration and filesystem the renderer reads,
+// and a headless window so that the render thread can be spawned
+class NullRendererApplication : public Application
+{
+public:
+    NullRendererApplication() : Application({"erwin", "test"})
+    {
+        // Settings are keyed by file stem, so the configuration must be named like the engine's
+        fs::path directory = fs::temp_directory_path() / "erwin_test";
+        fs::create_directories(directory);
+        {
+            std::ofstream ofs(directory / "erwin.toml");
+            ofs << "[renderer]" << std::endl;
+            ofs << "backend = \"null\"" << std::endl;
+            ofs << "render_thread = false" << std::endl;
+            ofs << "null_record = true" << std::endl;
+            ofs << "null_record_path = \"" << (directory / "null_record.txt").string() << "\"" << std::endl;
+        }
+        get_settings().load_toml(directory / "erwin.toml");
+
+        WindowProps props;
+        props.headless = true;
+        window_ = Window::create(get_event_bus(), props);
+    }
+
+    static inline fs::path get_record_path() { return fs::temp_directory_path() / "erwin_test" / "null_record.txt"; }
+};
+
+// Renderer running on the null backend, initialized for each test case
+class NullRendererFixture
+{
+public:
+    NullRendererFixture()
+    {
+        // There can only be one application
+        static NullRendererApplication app;
+        area_.init(20_MB);
+        Renderer::init(area_);
+    }
+
+    ~NullRendererFixture()
+    {
+        if(!shut_down_)
+            Renderer::shutdown();
+    }
+
+    // Shut the renderer down before the end of the test case, to check what happens on shutdown
+    inline void shutdown()
+    {
+        Renderer::shutdown();
+        shut_down_ = true;
+    }
+
+    static inline NullBackend& get_backend() { return static_cast<NullBackend&>(*gfx::backend); }
+
+    // Submit the frame and hand it over to the render thread if there is one
+    static inline void next_frame()
+    {
+        Renderer::flush();
+        Renderer::present();
+    }
+
+    // A triangle, with everything a draw call needs
+    struct Drawable
+    {
+        VertexBufferLayoutHandle layout;
+        IndexBufferHandle IBO;
+        VertexBufferHandle VBO;
+        VertexArrayHandle VAO;
+        ShaderHandle shader;
+    };
+
+    static Drawable create_drawable()
+    {
+        static const float vertex_data[] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+        static const uint32_t index_data[] = {0, 1, 2};
+
+        Drawable drawable;
+        drawable.layout = Renderer::create_vertex_buffer_layout({{"a_position"_h, ShaderDataType::Vec3}});
+        drawable.IBO = Renderer::create_index_buffer(index_data, 3, DrawPrimitive::Triangles);
+        drawable.VBO = Renderer::create_vertex_buffer(drawable.layout, vertex_data, 9);
+        drawable.VAO = Renderer::create_vertex_array(drawable.VBO, drawable.IBO);
+        drawable.shader = Renderer::create_shader("test.glsl", "test");
+        return drawable;
+    }
+
+    static void destroy_drawable(Drawable& drawable)
+    {
+        Renderer::destroy(drawable.shader);
+        // The vertex array owns its VBO and IBO
+        Renderer::destroy(drawable.VAO);
+        Renderer::destroy(drawable.layout);
+    }
+
+    // Submit a draw call of a drawable to the default framebuffer
+    static void submit(const Drawable& drawable, uint8_t layer_id, float depth = 0.5f)
+    {
+        RenderState state;
+        state.render_target = Renderer::default_render_target().index();
+        uint64_t state_flags = state.encode();
+
+        SortKey key;
+        key.set_depth(depth, layer_id, state_flags, drawable.shader);
+        DrawCall dc(DrawCall::Indexed, state_flags, drawable.shader, drawable.VAO);
+        Renderer::submit(key.encode(), dc);
+    }
+
+protected:
+    kb::memory::HeapArea area_;
+    bool shut_down_ = false;
+};
+
+} // namespace erwin
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/application.h"
+#include "core/clock.hpp"
+#include "platform/Null/null_backend.h"
+#include "render/backend.h"
+#include "render/frame_capture.h"
+#include "render/renderer.h"
+#include <kibble/logger/dispatcher.h>
+
+using namespace erwin;
+
+/*
+    Feeds a frame capture to the backend selected in the configuration (erwin.renderer.backend),
+    at full speed, and reports submission times. Captures are produced by Renderer::capture_frames(),
+    or from startup by setting erwin.renderer.capture_frames. Only captures that start with the
+    application hold all the resources their draw commands reference, commands that reference
+    unknown resources are skipped.
+
+    Usage: replay <capture_file> [repeat]
+    The draw commands of the last frame are replayed again [repeat] times, to measure steady state.
+*/
+class ReplayApp : public Application
+{
+public:
+    ReplayApp() : Application({"erwin", "replay"}) {}
+};
+
+struct Timings
+{
+    void add(std::chrono::nanoseconds duration)
+    {
+        samples.push_back(float(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000.f);
+    }
+
+    void print(const std::string& name) const
+    {
+        if(samples.empty())
+            return;
+        float total = 0.f;
+        for(float sample : samples)
+            total += sample;
+        auto [min, max] = std::minmax_element(samples.begin(), samples.end());
+        std::cout << std::setw(12) << name << std::setw(8) << samples.size() << std::fixed << std::setprecision(2)
+                  << std::setw(14) << total / float(samples.size()) << std::setw(14) << *min << std::setw(14) << *max
+                  << std::endl;
+    }
+
+    std::vector<float> samples;
+};
+
+static void print_null_statistics()
+{
+    const auto& stats = static_cast<NullBackend&>(*gfx::backend).get_statistics();
+    uint32_t draw_commands = 0;
+    for(uint32_t count : stats.draw_commands)
+        draw_commands += count;
+    std::cout << "draw commands:          " << draw_commands << std::endl;
+    std::cout << "draw calls / instances: " << stats.draw_calls << " / " << stats.instances << std::endl;
+    const auto& counters = stats.state_counters;
+    std::cout << "state changes:          " << counters.state_changes << std::endl;
+    std::cout << "render target switches: " << counters.render_target_switches << std::endl;
+    std::cout << "shader binds:           " << counters.shader_binds << std::endl;
+    std::cout << "VAO binds:              " << counters.VAO_binds << std::endl;
+    std::cout << "texture binds:          " << counters.texture_binds << std::endl;
+    std::cout << "cubemap binds:          " << counters.cubemap_binds << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: replay <capture_file> [repeat]" << std::endl;
+        return 1;
+    }
+    fs::path capture_path = fs::absolute(argv[1]);
+    uint32_t repeat = (argc > 2) ? uint32_t(std::stoul(argv[2])) : 0;
+
+    KLOGGER_START();
+
+    ReplayApp app;
+    if(!app.init())
+        return -1;
+
+    // Frames are replayed on this thread, so that submission time is measured synchronously
+    Renderer::kill_render_thread();
+#ifdef W_DEBUG
+    Renderer::set_profiling_enabled(true);
+#endif
+    // Submit the commands recorded during engine startup
+    Renderer::flush();
+
+    std::vector<CapturedFrame> frames;
+    FramebufferHandle captured_default_target;
+    if(!FrameCapture::load(capture_path, frames, captured_default_target) || frames.empty())
+    {
+        app.shutdown();
+        return -1;
+    }
+
+    if(gfx::get_backend() == GfxAPI::None)
+        static_cast<NullBackend&>(*gfx::backend).reset_statistics();
+
+    Timings capture_timings;
+    Timings steady_timings;
+    {
+        FrameReplayer replayer(captured_default_target);
+        kb::nanoClock clock;
+        for(const auto& frame : frames)
+        {
+            Renderer::replay(frame, replayer);
+            clock.restart();
+            Renderer::flush();
+            capture_timings.add(clock.get_elapsed_time());
+            replayer.end_frame();
+        }
+        for(uint32_t ii = 0; ii < repeat; ++ii)
+        {
+            Renderer::replay(frames.back(), replayer, true);
+            clock.restart();
+            Renderer::flush();
+            steady_timings.add(clock.get_elapsed_time());
+            replayer.end_frame();
+        }
+
+        std::cout << "Replayed " << frames.size() << " frame(s), " << replayer.get_skipped_count()
+                  << " command(s) skipped." << std::endl;
+    }
+
+    std::cout << std::setw(12) << "pass" << std::setw(8) << "frames" << std::setw(14) << "avg (us)" << std::setw(14)
+              << "min (us)" << std::setw(14) << "max (us)" << std::endl;
+    capture_timings.print("capture");
+    steady_timings.print("last frame");
+
+#ifdef W_DEBUG
+    const auto& stats = Renderer::get_stats();
+    std::cout << "last frame draw calls:  " << stats.draw_call_count << std::endl;
+    std::cout << "last frame merged:      " << stats.merged_draw_call_count << std::endl;
+    std::cout << "last frame uploads:     " << stats.dependency_upload_misses << " (" << stats.dependency_upload_hits
+              << " skipped)" << std::endl;
+    std::cout << "last frame GPU time:    " << stats.GPU_render_time << "us" << std::endl;
+    std::cout << "last frame sort time:   " << stats.CPU_sort_time << "us" << std::endl;
+    const auto& counters = stats.state_counters;
+    std::cout << "last frame states:      " << counters.state_changes << " (" << counters.state_hits << " cached)"
+              << std::endl;
+    std::cout << "last frame shaders:     " << counters.shader_binds << " (" << counters.shader_hits << " cached)"
+              << std::endl;
+    std::cout << "last frame textures:    " << counters.texture_binds << " (" << counters.texture_hits << " cached)"
+              << std::endl;
+    std::cout << "last frame cubemaps:    " << counters.cubemap_binds << " (" << counters.cubemap_hits << " cached)"
+              << std::endl;
+    std::cout << "last frame VAOs:        " << counters.VAO_binds << " (" << counters.VAO_hits << " cached)"
+              << std::endl;
+    std::cout << std::setw(12) << "layer" << std::setw(8) << "draws" << std::setw(14) << "sort (us)" << std::setw(14)
+              << "CPU (us)" << std::setw(14) << "deps (us)" << std::setw(14) << "GPU (us)" << std::endl;
+    for(const auto& pass : stats.passes)
+        std::cout << std::setw(12) << int(pass.layer_id) << std::setw(8) << pass.draw_call_count << std::setw(14)
+                  << pass.CPU_sort_time << std::setw(14) << pass.CPU_dispatch_time << std::setw(14)
+                  << pass.CPU_dependency_time << std::setw(14) << pass.GPU_time << std::endl;
+#endif
+    if(gfx::get_backend() == GfxAPI::None)
+        print_null_statistics();
+
+    app.shutdown();
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <random>
+
+#include "catch2/catch.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "render/culling.h"
+
+using namespace erwin;
+
+// Camera at the origin, looking towards negative z
+static ComponentCamera3D make_camera()
+{
+    ComponentCamera3D camera;
+    camera.set_projection({-1.f, 1.f, -1.f, 1.f, 1.f, 100.f});
+    camera.update_transform(glm::mat4(1.f));
+    return camera;
+}
+
+static const Extent k_unit_cube(-0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f);
+
+TEST_CASE("Frustum culling: boxes inside, outside and straddling", "[culling]")
+{
+    auto camera = make_camera();
+    FrustumCuller culler;
+    culler.set_planes(camera.planes);
+
+    culler.push(k_unit_cube, glm::translate(glm::mat4(1.f), {0.f, 0.f, -10.f}));  // In front
+    culler.push(k_unit_cube, glm::translate(glm::mat4(1.f), {0.f, 0.f, 10.f}));   // Behind
+    culler.push(k_unit_cube, glm::translate(glm::mat4(1.f), {50.f, 0.f, -10.f})); // Right of frustum
+    culler.push(k_unit_cube, glm::translate(glm::mat4(1.f), {0.f, 0.f, -200.f})); // Past far plane
+    culler.push(k_unit_cube, glm::translate(glm::mat4(1.f), {10.2f, 0.f, -10.f})); // Straddles right plane
+
+    REQUIRE(culler.cull() == 2);
+    REQUIRE(culler.is_visible(0));
+    REQUIRE(!culler.is_visible(1));
+    REQUIRE(!culler.is_visible(2));
+    REQUIRE(!culler.is_visible(3));
+    REQUIRE(culler.is_visible(4));
+}
+
+TEST_CASE("Frustum culling: batches agree with the single instance test", "[culling]")
+{
+    auto camera = make_camera();
+    FrustumCuller culler;
+    culler.set_planes(camera.planes);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> position(-60.f, 60.f);
+    std::uniform_real_distribution<float> angle(0.f, 6.28f);
+    std::vector<glm::mat4> models(1001);
+    for(auto& model : models)
+    {
+        model = glm::translate(glm::mat4(1.f), {position(gen), position(gen), position(gen)});
+        model = glm::rotate(model, angle(gen), glm::normalize(glm::vec3(1.f, 2.f, 3.f)));
+        culler.push(k_unit_cube, model);
+    }
+    culler.cull();
+
+    bool agree = true;
+    for(uint32_t ii = 0; ii < models.size(); ++ii)
+        agree &= (culler.is_visible(ii) == FrustumCuller::is_visible(k_unit_cube, models[ii], camera.planes));
+    REQUIRE(agree);
+}
+
+TEST_CASE("Frustum culling: nothing is culled without planes", "[culling]")
+{
+    FrustumCuller culler;
+    culler.push(k_unit_cube, glm::translate(glm::mat4(1.f), {0.f, 0.f, 1000.f}));
+    REQUIRE(culler.cull() == 1);
+}
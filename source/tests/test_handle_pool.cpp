@@ -0,0 +1,106 @@
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "memory/handle_pool.h"
+
+using namespace erwin;
+
+TEST_CASE("Handle pool: acquired handles are valid and unique", "[handle]")
+{
+    HandlePool pool(8);
+    std::set<uint32_t> indices;
+    for(uint32_t ii = 0; ii < 8; ++ii)
+    {
+        uint32_t handle = pool.acquire();
+        REQUIRE(pool.is_valid(handle));
+        indices.insert(handle & HandlePool::k_handle_mask);
+    }
+    REQUIRE(indices.size() == 8);
+    REQUIRE(pool.size() == 8);
+    // Lower indices are acquired first
+    REQUIRE(*indices.begin() == 0);
+    REQUIRE(*indices.rbegin() == 7);
+}
+
+TEST_CASE("Handle pool: released handles are invalidated by their guard", "[handle]")
+{
+    HandlePool pool(4);
+    uint32_t handle = pool.acquire();
+    pool.release(handle);
+    REQUIRE_FALSE(pool.is_valid(handle));
+    REQUIRE(pool.size() == 0);
+
+    // The index is reused with another guard, the dangling copy stays invalid
+    uint32_t reused = pool.acquire();
+    REQUIRE((reused & HandlePool::k_handle_mask) == (handle & HandlePool::k_handle_mask));
+    REQUIRE((reused >> HandlePool::k_guard_shift) == (handle >> HandlePool::k_guard_shift) + 1);
+    REQUIRE(pool.is_valid(reused));
+    REQUIRE_FALSE(pool.is_valid(handle));
+}
+
+TEST_CASE("Handle pool: out of range and null handles are invalid", "[handle]")
+{
+    HandlePool pool(4);
+    REQUIRE_FALSE(pool.is_valid(0xffffffff));
+    REQUIRE_FALSE(pool.is_valid(3)); // Never acquired
+    REQUIRE_FALSE(pool.is_valid(1000));
+}
+
+TEST_CASE("Handle pool: grows on demand", "[handle]")
+{
+    HandlePool pool(2);
+    uint32_t growth_count = HandlePool::get_growth_count();
+    std::vector<uint32_t> handles;
+    for(uint32_t ii = 0; ii < 5; ++ii)
+        handles.push_back(pool.acquire());
+
+    REQUIRE(pool.capacity() == 8);
+    REQUIRE(HandlePool::get_growth_count() == growth_count + 2);
+    for(uint32_t handle : handles)
+        REQUIRE(pool.is_valid(handle));
+}
+
+TEST_CASE("Handle pool: released indices are retired for the reuse latency", "[handle]")
+{
+    constexpr uint32_t k_latency = 3;
+    HandlePool pool(4, k_latency);
+    uint32_t handle = pool.acquire();
+    uint32_t index = handle & HandlePool::k_handle_mask;
+    pool.release(handle);
+    REQUIRE_FALSE(pool.is_valid(handle));
+
+    for(uint32_t ii = 0; ii < k_latency; ++ii)
+    {
+        uint32_t other = pool.acquire();
+        REQUIRE((other & HandlePool::k_handle_mask) != index);
+        pool.next_frame();
+    }
+
+    // Retired index is free again, it sits on top of the free list
+    REQUIRE((pool.acquire() & HandlePool::k_handle_mask) == index);
+}
+
+TEST_CASE("Handle pool: handles can be validated while another thread acquires and releases", "[handle]")
+{
+    HandlePool pool(16, 2);
+    uint32_t stable = pool.acquire();
+
+    // Assertions are not thread safe, failures are counted instead
+    std::atomic<uint32_t> failures{0};
+    std::thread reader([&pool, &failures, stable]() {
+        for(uint32_t ii = 0; ii < 100000; ++ii)
+            if(!pool.is_valid(stable))
+                failures.fetch_add(1, std::memory_order_relaxed);
+    });
+    for(uint32_t ii = 0; ii < 10000; ++ii)
+    {
+        uint32_t handle = pool.acquire();
+        pool.release(handle);
+        pool.next_frame();
+    }
+    reader.join();
+    REQUIRE(failures == 0);
+}
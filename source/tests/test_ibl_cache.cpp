@@ -0,0 +1,83 @@
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "asset/ibl_cache.h"
+#include "catch2/catch.hpp"
+#include "null_renderer_fixture.h"
+
+using namespace erwin;
+
+static constexpr uint32_t k_environment_size = 16;
+
+static void fill(IBLMaps& maps, bool empty)
+{
+    for(auto* descriptor : {&maps.environment_map, &maps.diffuse_irradiance_map, &maps.prefiltered_map})
+    {
+        size_t size = cubemap_mip_chain_size(descriptor->width, descriptor->mips, descriptor->image_format);
+        auto* texels = new uint8_t[size]();
+        if(!empty)
+            for(size_t ii = 0; ii < size; ++ii)
+                texels[ii] = uint8_t(ii * 7 + descriptor->width);
+        descriptor->mip_data = texels;
+        descriptor->must_free = true;
+    }
+}
+
+static void release(IBLMaps& maps)
+{
+    maps.environment_map.release();
+    maps.diffuse_irradiance_map.release();
+    maps.prefiltered_map.release();
+}
+
+static void remove_entry(uint64_t key)
+{
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    std::error_code ec;
+    fs::remove(WFS_.get_aliased_directory("usr"_h) / "ibl_cache" / ss.str(), ec);
+}
+
+static bool same_data(const CubemapDescriptor& a, const CubemapDescriptor& b)
+{
+    size_t size = cubemap_mip_chain_size(a.width, a.mips, a.image_format);
+    return a.width == b.width && a.mips == b.mips && a.image_format == b.image_format && a.mip_data && b.mip_data &&
+           std::memcmp(a.mip_data, b.mip_data, size) == 0;
+}
+
+TEST_CASE_METHOD(NullRendererFixture, "IBL cache: a written entry is loaded back", "[ibl]")
+{
+    const uint64_t key = 0x1b1cac4e00000001ull;
+    IBLMaps maps = IBLCache::describe(k_environment_size);
+    fill(maps, false);
+    REQUIRE(IBLCache::write(key, maps));
+
+    IBLMaps loaded;
+    REQUIRE(IBLCache::load(key, loaded));
+    REQUIRE(same_data(maps.environment_map, loaded.environment_map));
+    REQUIRE(same_data(maps.diffuse_irradiance_map, loaded.diffuse_irradiance_map));
+    REQUIRE(same_data(maps.prefiltered_map, loaded.prefiltered_map));
+    REQUIRE(loaded.environment_map.must_free);
+
+    // Other keys miss
+    IBLMaps missed;
+    REQUIRE_FALSE(IBLCache::load(key + 1, missed));
+
+    release(maps);
+    release(loaded);
+    remove_entry(key);
+}
+
+TEST_CASE_METHOD(NullRendererFixture, "IBL cache: cubemaps that were never drawn to are not saved", "[ibl]")
+{
+    const uint64_t key = 0x1b1cac4e00000002ull;
+    remove_entry(key);
+    IBLMaps maps = IBLCache::describe(k_environment_size);
+    fill(maps, true);
+    REQUIRE_FALSE(IBLCache::write(key, maps));
+
+    IBLMaps loaded;
+    REQUIRE_FALSE(IBLCache::load(key, loaded));
+    release(maps);
+}
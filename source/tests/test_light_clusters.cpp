@@ -0,0 +1,161 @@
+#include <random>
+
+#include "catch2/catch.hpp"
+#include "entity/component/camera.h"
+#include "render/light_clusters.h"
+#include "render/render_workers.h"
+
+using namespace erwin;
+
+static constexpr uint32_t k_tiles_x = 16;
+static constexpr uint32_t k_tiles_y = 9;
+static constexpr uint32_t k_slices = 24;
+
+// Camera at the origin, looking towards negative z, 90 degrees field of view
+static ComponentCamera3D make_camera()
+{
+    ComponentCamera3D camera;
+    camera.set_projection({-1.f, 1.f, -1.f, 1.f, 1.f, 100.f});
+    camera.update_transform(glm::mat4(1.f));
+    return camera;
+}
+
+static void build(LightClusters& clusters, const ComponentCamera3D& camera, RenderWorkers* workers = nullptr)
+{
+    clusters.build(camera.view_matrix, camera.projection_parameters, camera.frustum.near, camera.frustum.far, workers);
+}
+
+static bool cluster_has_light(const LightClusters& clusters, uint32_t cluster, uint32_t light)
+{
+    const auto& range = clusters.get_grid()[cluster];
+    for(uint32_t ii = 0; ii < range.count; ++ii)
+        if(clusters.get_indices()[range.offset + ii] == light)
+            return true;
+    return false;
+}
+
+TEST_CASE("Light clusters: exponential depth slices", "[lights]")
+{
+    auto camera = make_camera();
+    LightClusters clusters;
+    clusters.init(k_tiles_x, k_tiles_y, k_slices, 16, 1024);
+    build(clusters, camera);
+
+    REQUIRE(clusters.get_slice(0.5f) == 0);
+    REQUIRE(clusters.get_slice(1.01f) == 0);
+    REQUIRE(clusters.get_slice(10.5f) == k_slices / 2);
+    REQUIRE(clusters.get_slice(99.f) == k_slices - 1);
+    REQUIRE(clusters.get_slice(1000.f) == k_slices - 1);
+    REQUIRE(clusters.get_index_count() == 0);
+}
+
+TEST_CASE("Light clusters: point lights are assigned to the clusters they overlap", "[lights]")
+{
+    auto camera = make_camera();
+    LightClusters clusters;
+    clusters.init(k_tiles_x, k_tiles_y, k_slices, 16, 1024);
+    clusters.add_point_light({0.f, 0.f, -10.f}, 1.f, {1.f, 1.f, 1.f});  // Straight ahead
+    clusters.add_point_light({0.f, 0.f, 10.f}, 1.f, {1.f, 1.f, 1.f});   // Behind the camera
+    clusters.add_point_light({0.f, 0.f, -500.f}, 1.f, {1.f, 1.f, 1.f}); // Past the far plane
+    build(clusters, camera);
+
+    REQUIRE(clusters.get_index_count() > 0);
+    REQUIRE(cluster_has_light(clusters, clusters.get_cluster(8, 4, k_slices / 2), 0));
+    REQUIRE(!cluster_has_light(clusters, clusters.get_cluster(0, 0, k_slices / 2), 0));
+    REQUIRE(!cluster_has_light(clusters, clusters.get_cluster(8, 4, 0), 0));
+    REQUIRE(!cluster_has_light(clusters, clusters.get_cluster(8, 4, k_slices - 1), 0));
+
+    // Only the first light is referenced
+    bool only_first = true;
+    for(uint32_t ii = 0; ii < clusters.get_index_count(); ++ii)
+        only_first &= (clusters.get_indices()[ii] == 0);
+    REQUIRE(only_first);
+
+    // Lights are transformed to view space, the view is the identity here
+    REQUIRE(clusters.get_lights()[0].position_radius.z == Approx(-10.f));
+}
+
+TEST_CASE("Light clusters: spot light bounding spheres enclose their cone", "[lights]")
+{
+    glm::vec3 position(1.f, 2.f, 3.f);
+    glm::vec3 direction = glm::normalize(glm::vec3(1.f, -1.f, 0.5f));
+    glm::vec3 side = glm::normalize(glm::cross(direction, glm::vec3(0.f, 0.f, 1.f)));
+    float radius = 5.f;
+
+    for(float angle : {0.1f, 0.5f, 0.785f, 1.f, 1.5f})
+    {
+        glm::vec4 sphere = LightClusters::spot_bounding_sphere(position, direction, radius, std::cos(angle));
+        glm::vec3 center(sphere);
+        float tolerance = 1e-4f;
+        // Apex, tip of the cap and a point of the rim
+        glm::vec3 rim = position + radius * (std::cos(angle) * direction + std::sin(angle) * side);
+        REQUIRE(glm::distance(center, position) <= sphere.w + tolerance);
+        REQUIRE(glm::distance(center, position + radius * direction) <= sphere.w + tolerance);
+        REQUIRE(glm::distance(center, rim) <= sphere.w + tolerance);
+        // Never looser than the sphere of a point light of the same radius
+        REQUIRE(sphere.w <= radius + tolerance);
+    }
+}
+
+TEST_CASE("Light clusters: parallel build matches the serial one", "[lights]")
+{
+    auto camera = make_camera();
+    LightClusters serial;
+    LightClusters parallel;
+    serial.init(k_tiles_x, k_tiles_y, k_slices, 512, 1 << 16);
+    parallel.init(k_tiles_x, k_tiles_y, k_slices, 512, 1 << 16);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> coord(-40.f, 40.f);
+    std::uniform_real_distribution<float> depth(-110.f, 5.f);
+    std::uniform_real_distribution<float> radius(0.5f, 8.f);
+    for(uint32_t ii = 0; ii < 500; ++ii)
+    {
+        glm::vec3 position(coord(gen), coord(gen), depth(gen));
+        float r = radius(gen);
+        if(ii % 2)
+        {
+            serial.add_point_light(position, r, {1.f, 1.f, 1.f});
+            parallel.add_point_light(position, r, {1.f, 1.f, 1.f});
+        }
+        else
+        {
+            glm::vec3 direction(coord(gen), coord(gen), coord(gen));
+            serial.add_spot_light(position, direction, r, 0.3f, 0.6f, {1.f, 1.f, 1.f});
+            parallel.add_spot_light(position, direction, r, 0.3f, 0.6f, {1.f, 1.f, 1.f});
+        }
+    }
+
+    RenderWorkers workers;
+    workers.spawn(3);
+    build(serial, camera);
+    build(parallel, camera, &workers);
+    workers.kill();
+
+    REQUIRE(serial.get_index_count() == parallel.get_index_count());
+    bool same = true;
+    for(uint32_t ii = 0; ii < serial.get_cluster_count(); ++ii)
+        same &= (serial.get_grid()[ii].offset == parallel.get_grid()[ii].offset &&
+                 serial.get_grid()[ii].count == parallel.get_grid()[ii].count);
+    for(uint32_t ii = 0; ii < serial.get_index_count(); ++ii)
+        same &= (serial.get_indices()[ii] == parallel.get_indices()[ii]);
+    REQUIRE(same);
+}
+
+TEST_CASE("Light clusters: index list overflow", "[lights]")
+{
+    auto camera = make_camera();
+    LightClusters clusters;
+    clusters.init(k_tiles_x, k_tiles_y, k_slices, 4, 64);
+    for(uint32_t ii = 0; ii < 4; ++ii)
+        REQUIRE(clusters.add_point_light({0.f, 0.f, -20.f}, 15.f, {1.f, 1.f, 1.f}));
+    REQUIRE(!clusters.add_point_light({0.f, 0.f, -20.f}, 15.f, {1.f, 1.f, 1.f}));
+    build(clusters, camera);
+
+    REQUIRE(clusters.is_saturated());
+    REQUIRE(clusters.get_index_count() == 64);
+    bool in_bounds = true;
+    for(uint32_t ii = 0; ii < clusters.get_cluster_count(); ++ii)
+        in_bounds &= (clusters.get_grid()[ii].offset + clusters.get_grid()[ii].count <= 64);
+    REQUIRE(in_bounds);
+}
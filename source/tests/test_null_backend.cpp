@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#include "catch2/catch.hpp"
+#include "null_renderer_fixture.h"
+
+using namespace erwin;
+
+TEST_CASE_METHOD(NullRendererFixture, "Null backend: a frame is decoded and recorded", "[null]")
+{
+    auto drawable = create_drawable();
+    Renderer::flush();
+    get_backend().clear_records();
+    get_backend().reset_statistics();
+
+    uint8_t layer_id = Renderer::next_layer_id();
+    submit(drawable, layer_id, 0.8f);
+    submit(drawable, layer_id, 0.2f);
+    Renderer::flush();
+
+    const auto& stats = get_backend().get_statistics();
+    REQUIRE(stats.frames == 1);
+    REQUIRE(stats.draw_calls == 2);
+    // Both draw calls share their shader and vertex array, the state cache absorbs the second binds
+    REQUIRE(stats.state_counters.shader_binds == 1);
+    REQUIRE(stats.state_counters.shader_hits == 1);
+    REQUIRE(stats.state_counters.VAO_binds == 1);
+    REQUIRE(stats.state_counters.VAO_hits == 1);
+
+    const auto& records = get_backend().get_records();
+    auto draw_count = std::count_if(records.begin(), records.end(), [&drawable](const auto& rec) {
+        return rec.draw && rec.type == uint16_t(DrawCommand::Draw) && rec.handle == drawable.shader.index();
+    });
+    REQUIRE(draw_count == 2);
+
+    destroy_drawable(drawable);
+}
+
+TEST_CASE_METHOD(NullRendererFixture, "Null backend: destroyed resources are released at the end of the frame",
+                 "[null]")
+{
+    uint32_t live_count = get_backend().get_live_resource_count();
+    auto drawable = create_drawable();
+    Renderer::flush();
+    // Index buffer, vertex buffer, vertex array and shader. Layouts are not device resources.
+    REQUIRE(get_backend().get_live_resource_count() == live_count + 4);
+
+    destroy_drawable(drawable);
+    Renderer::flush();
+    REQUIRE(get_backend().get_live_resource_count() == live_count);
+}
+
+TEST_CASE_METHOD(NullRendererFixture, "Null backend: recorded commands are exported on shutdown", "[null]")
+{
+    auto drawable = create_drawable();
+    submit(drawable, Renderer::next_layer_id());
+    Renderer::flush();
+    destroy_drawable(drawable);
+
+    fs::path record_path = NullRendererApplication::get_record_path();
+    fs::remove(record_path);
+    shutdown();
+
+    REQUIRE(fs::exists(record_path));
+    std::ifstream ifs(record_path);
+    std::string line;
+    bool has_draw = false;
+    size_t line_count = 0;
+    while(std::getline(ifs, line))
+    {
+        ++line_count;
+        has_draw |= (line.rfind("D " + std::to_string(uint16_t(DrawCommand::Draw)) + " ", 0) == 0);
+    }
+    REQUIRE(line_count == get_backend().get_records().size());
+    REQUIRE(has_draw);
+}
+
+#ifdef W_DEBUG
+TEST_CASE_METHOD(NullRendererFixture, "Null backend: passes are profiled in dispatch order", "[null]")
+{
+    auto drawable = create_drawable();
+    // Profiling is sampled when a frame starts being recorded
+    Renderer::set_profiling_enabled(true);
+    Renderer::flush();
+
+    uint8_t first = Renderer::next_layer_id("first"_h);
+    uint8_t empty = Renderer::next_layer_id("empty"_h);
+    uint8_t second = Renderer::next_layer_id();
+    // Submitted out of order, passes are reported by layer id
+    submit(drawable, second, 0.5f);
+    submit(drawable, first, 0.2f);
+    submit(drawable, first, 0.8f);
+    Renderer::flush();
+
+    const auto& stats = Renderer::get_stats();
+    // Layers without draw commands are not dispatched
+    REQUIRE(stats.passes.size() == 2);
+    REQUIRE(stats.passes[0].layer_id == first);
+    REQUIRE(stats.passes[0].name == "first"_h);
+    REQUIRE(stats.passes[0].draw_call_count == 2);
+    REQUIRE(stats.passes[1].layer_id == second);
+    REQUIRE(stats.passes[1].name == 0);
+    REQUIRE(stats.passes[1].draw_call_count == 1);
+    for(const auto& pass : stats.passes)
+    {
+        REQUIRE(pass.layer_id != empty);
+        REQUIRE(pass.CPU_sort_time >= 0.f);
+        REQUIRE(pass.CPU_dispatch_time >= pass.CPU_dependency_time);
+    }
+
+    // Passes are rebuilt on each frame, statistics are double buffered
+    submit(drawable, Renderer::next_layer_id(), 0.5f);
+    Renderer::flush();
+    const auto& next_stats = Renderer::get_stats();
+    REQUIRE(next_stats.passes.size() == 1);
+    REQUIRE(next_stats.passes[0].draw_call_count == 1);
+
+    // A toggle does not affect the frame being recorded
+    Renderer::set_profiling_enabled(false);
+    submit(drawable, Renderer::next_layer_id(), 0.5f);
+    submit(drawable, Renderer::next_layer_id(), 0.5f);
+    Renderer::flush();
+    REQUIRE(Renderer::get_stats().passes.size() == 2);
+
+    destroy_drawable(drawable);
+}
+#endif
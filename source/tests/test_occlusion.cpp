@@ -0,0 +1,101 @@
+#include "catch2/catch.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "render/occlusion.h"
+#include "render/render_workers.h"
+
+using namespace erwin;
+
+static const Extent k_unit_cube(-0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f);
+
+static glm::mat4 box(const glm::vec3& position, const glm::vec3& scale = glm::vec3(1.f))
+{
+    return glm::scale(glm::translate(glm::mat4(1.f), position), scale);
+}
+
+// Camera at the origin looking towards negative z, with a 10x10 wall 5 units away
+class OcclusionFixture
+{
+public:
+    OcclusionFixture()
+    {
+        buffer.init(256, 128, 8);
+        buffer.set_view_projection(glm::perspective(glm::radians(90.f), 2.f, 0.1f, 100.f) *
+                                   glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f)));
+        buffer.add_occluder(k_unit_cube, wall);
+    }
+
+protected:
+    OcclusionBuffer buffer;
+    glm::mat4 wall = box({0.f, 0.f, -5.f}, {10.f, 10.f, 0.2f});
+};
+
+TEST_CASE_METHOD(OcclusionFixture, "Occlusion: boxes behind, in front and beside an occluder", "[occlusion]")
+{
+    buffer.rasterize();
+
+    REQUIRE(!buffer.is_visible(k_unit_cube, box({0.f, 0.f, -20.f})));
+    REQUIRE(!buffer.is_visible(k_unit_cube, box({2.f, 1.f, -10.f})));
+    REQUIRE(buffer.is_visible(k_unit_cube, box({0.f, 0.f, -2.f})));
+    REQUIRE(buffer.is_visible(k_unit_cube, box({30.f, 0.f, -20.f})));
+    // Partially hidden
+    REQUIRE(buffer.is_visible(k_unit_cube, box({20.f, 0.f, -20.f}, {4.f, 4.f, 4.f})));
+    // Crossing the near plane
+    REQUIRE(buffer.is_visible(k_unit_cube, box({0.f, 0.f, 0.f})));
+}
+
+TEST_CASE_METHOD(OcclusionFixture, "Occlusion: an occluder does not hide itself", "[occlusion]")
+{
+    buffer.rasterize();
+    REQUIRE(buffer.is_visible(k_unit_cube, wall));
+}
+
+TEST_CASE_METHOD(OcclusionFixture, "Occlusion: parallel rasterization matches serial rasterization", "[occlusion]")
+{
+    buffer.add_occluder(k_unit_cube, box({3.f, -2.f, -8.f}, {2.f, 6.f, 1.f}));
+    buffer.rasterize();
+    std::vector<float> serial(buffer.get_depth(), buffer.get_depth() + buffer.get_width() * buffer.get_height());
+
+    RenderWorkers workers;
+    workers.spawn(3);
+    buffer.rasterize(&workers);
+    workers.kill();
+    std::vector<float> parallel(buffer.get_depth(), buffer.get_depth() + buffer.get_width() * buffer.get_height());
+
+    REQUIRE(serial == parallel);
+}
+
+TEST_CASE("Occlusion: nothing is hidden without occluders", "[occlusion]")
+{
+    OcclusionBuffer buffer;
+    buffer.init(64, 32, 8);
+    buffer.set_view_projection(glm::perspective(glm::radians(90.f), 2.f, 0.1f, 100.f));
+    buffer.rasterize();
+    REQUIRE(buffer.is_visible(k_unit_cube, box({0.f, 0.f, -20.f})));
+}
+
+TEST_CASE("Occlusion: triangle occluders only hide what is behind their surface", "[occlusion]")
+{
+    OcclusionBuffer buffer;
+    buffer.init(256, 128, 8);
+    buffer.set_view_projection(glm::perspective(glm::radians(90.f), 2.f, 0.1f, 100.f) *
+                               glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f)));
+
+    // A 10x10 frame with a 4x4 hole, 5 units away. Its bounding box would hide the hole as well.
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    // Quads as (xmin, xmax, ymin, ymax)
+    const glm::vec4 quads[] = {
+        {-5.f, 5.f, 2.f, 5.f}, {-5.f, 5.f, -5.f, -2.f}, {-5.f, -2.f, -2.f, 2.f}, {2.f, 5.f, -2.f, 2.f}};
+    for(const auto& quad : quads)
+    {
+        uint32_t base = uint32_t(vertices.size());
+        vertices.insert(vertices.end(), {{quad.x, quad.z, -5.f}, {quad.y, quad.z, -5.f}, {quad.y, quad.w, -5.f},
+                                         {quad.x, quad.w, -5.f}});
+        indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+    buffer.add_occluder(vertices.data(), indices.data(), uint32_t(indices.size()), glm::mat4(1.f));
+    buffer.rasterize();
+
+    REQUIRE(buffer.is_visible(k_unit_cube, box({0.f, 0.f, -20.f})));
+    REQUIRE(!buffer.is_visible(k_unit_cube, box({14.f, 0.f, -20.f})));
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "utils/radix_sort.hpp"
+
+using namespace erwin;
+
+using Entry = std::pair<uint64_t, uint32_t>;
+
+static bool key_less(const Entry& item1, const Entry& item2) { return item1.first < item2.first; }
+
+TEST_CASE("Radix sort: random keys", "[sort]")
+{
+    std::mt19937_64 gen(12345);
+    std::vector<Entry> entries(4096);
+    for(uint32_t ii = 0; ii < entries.size(); ++ii)
+        entries[ii] = {gen(), ii};
+
+    auto expected = entries;
+    std::stable_sort(expected.begin(), expected.end(), key_less);
+
+    std::vector<Entry> scratch(entries.size());
+    radix_sort(entries.data(), scratch.data(), entries.size());
+
+    REQUIRE(entries == expected);
+}
+
+TEST_CASE("Radix sort: stability with duplicate keys and constant bytes", "[sort]")
+{
+    // Only the two top bytes vary, so six passes must be skipped
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> dist(0, 15);
+    std::vector<Entry> entries(1000);
+    for(uint32_t ii = 0; ii < entries.size(); ++ii)
+        entries[ii] = {(uint64_t(dist(gen)) << 56) | (uint64_t(dist(gen)) << 48) | 0x0000abcdef012345, ii};
+
+    auto expected = entries;
+    std::stable_sort(expected.begin(), expected.end(), key_less);
+
+    std::vector<Entry> scratch(entries.size());
+    radix_sort(entries.data(), scratch.data(), entries.size());
+
+    REQUIRE(entries == expected);
+}
+
+TEST_CASE("Radix sort: degenerate inputs", "[sort]")
+{
+    std::vector<Entry> scratch(8);
+
+    std::vector<Entry> empty;
+    radix_sort(empty.data(), scratch.data(), 0);
+    REQUIRE(empty.empty());
+
+    std::vector<Entry> single = {{7, 0}};
+    radix_sort(single.data(), scratch.data(), single.size());
+    REQUIRE(single[0] == Entry{7, 0});
+
+    std::vector<Entry> sorted = {{1, 0}, {2, 1}, {2, 2}, {9, 3}};
+    auto expected = sorted;
+    radix_sort(sorted.data(), scratch.data(), sorted.size());
+    REQUIRE(sorted == expected);
+
+    std::vector<Entry> reversed = {{0xffffffffffffffff, 0}, {0x100, 1}, {0xff, 2}, {0, 3}};
+    radix_sort(reversed.data(), scratch.data(), reversed.size());
+    REQUIRE(reversed == std::vector<Entry>{{0, 3}, {0xff, 2}, {0x100, 1}, {0xffffffffffffffff, 0}});
+}
@@ -0,0 +1,126 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "memory/range_allocator.h"
+
+using namespace erwin;
+
+TEST_CASE("Range allocator: ranges are allocated contiguously", "[range]")
+{
+    RangeAllocator allocator(100);
+    uint32_t a, b, c;
+    REQUIRE(allocator.allocate(10, a));
+    REQUIRE(allocator.allocate(20, b));
+    REQUIRE(allocator.allocate(30, c));
+    REQUIRE(a == 0);
+    REQUIRE(b == 10);
+    REQUIRE(c == 30);
+    REQUIRE(allocator.get_free_size() == 40);
+    REQUIRE(allocator.get_free_range_count() == 1);
+}
+
+TEST_CASE("Range allocator: the first free range large enough is reused", "[range]")
+{
+    RangeAllocator allocator(100);
+    uint32_t a, b, c, d;
+    allocator.allocate(10, a);
+    allocator.allocate(30, b);
+    allocator.allocate(10, c);
+    allocator.allocate(10, d);
+    // A hole of 30 elements, then a free range made of d and the tail
+    allocator.release(b, 30);
+    allocator.release(d, 10);
+    REQUIRE(allocator.get_free_range_count() == 2);
+
+    // The hole left by b comes first and is large enough
+    uint32_t offset;
+    REQUIRE(allocator.allocate(20, offset));
+    REQUIRE(offset == b);
+    // The remainder of the hole is too small, the next range is used
+    REQUIRE(allocator.allocate(15, offset));
+    REQUIRE(offset == d);
+}
+
+TEST_CASE("Range allocator: released ranges are merged with their neighbours", "[range]")
+{
+    RangeAllocator allocator(40);
+    uint32_t a, b, c, d;
+    allocator.allocate(10, a);
+    allocator.allocate(10, b);
+    allocator.allocate(10, c);
+    allocator.allocate(10, d);
+    REQUIRE(allocator.get_free_range_count() == 0);
+
+    allocator.release(a, 10);
+    allocator.release(c, 10);
+    REQUIRE(allocator.get_free_range_count() == 2);
+    // Merged with the previous range
+    allocator.release(d, 10);
+    REQUIRE(allocator.get_free_range_count() == 2);
+    // Merged with both sides
+    allocator.release(b, 10);
+    REQUIRE(allocator.get_free_range_count() == 1);
+
+    uint32_t offset;
+    REQUIRE(allocator.allocate(40, offset));
+    REQUIRE(offset == 0);
+}
+
+TEST_CASE("Range allocator: a released range is merged with the next one", "[range]")
+{
+    RangeAllocator allocator(30);
+    uint32_t a, b, c;
+    allocator.allocate(10, a);
+    allocator.allocate(10, b);
+    allocator.allocate(10, c);
+    allocator.release(c, 10);
+    allocator.release(b, 10);
+    REQUIRE(allocator.get_free_range_count() == 1);
+    REQUIRE(allocator.get_free_size() == 20);
+
+    uint32_t offset;
+    REQUIRE(allocator.allocate(20, offset));
+    REQUIRE(offset == b);
+}
+
+TEST_CASE("Range allocator: allocation fails when no range is large enough", "[range]")
+{
+    RangeAllocator allocator(30);
+    uint32_t a, b, c;
+    REQUIRE(allocator.allocate(10, a));
+    REQUIRE(allocator.allocate(10, b));
+    REQUIRE(allocator.allocate(10, c));
+
+    uint32_t offset;
+    REQUIRE_FALSE(allocator.allocate(1, offset));
+
+    // Free space is fragmented, no single range can hold the request
+    allocator.release(a, 10);
+    allocator.release(c, 10);
+    REQUIRE(allocator.get_free_size() == 20);
+    REQUIRE_FALSE(allocator.allocate(15, offset));
+    REQUIRE(allocator.allocate(10, offset));
+}
+
+TEST_CASE("Range allocator: released ranges are retired for the reuse latency", "[range]")
+{
+    constexpr uint32_t k_latency = 3;
+    RangeAllocator allocator(20, k_latency);
+    uint32_t a, b;
+    allocator.allocate(10, a);
+    allocator.allocate(10, b);
+    allocator.release(a, 10);
+
+    uint32_t offset;
+    for(uint32_t ii = 0; ii < k_latency; ++ii)
+    {
+        REQUIRE_FALSE(allocator.allocate(10, offset));
+        allocator.next_frame();
+    }
+    REQUIRE(allocator.allocate(10, offset));
+    REQUIRE(offset == a);
+
+    // Ranges that were never used can be given back right away
+    allocator.cancel(offset, 10);
+    REQUIRE(allocator.allocate(10, offset));
+}
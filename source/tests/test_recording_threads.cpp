@@ -0,0 +1,96 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "null_renderer_fixture.h"
+
+using namespace erwin;
+
+// Wait until a number of threads reached the same point
+static void wait_for(const std::atomic<uint32_t>& counter, uint32_t count)
+{
+    while(counter.load() < count)
+        std::this_thread::yield();
+}
+
+TEST_CASE_METHOD(NullRendererFixture, "Recording threads: draws of bound threads are merged by key on flush",
+                 "[recording]")
+{
+    auto drawable_a = create_drawable();
+    auto drawable_b = create_drawable();
+    REQUIRE(drawable_a.shader != drawable_b.shader);
+    Renderer::flush();
+    get_backend().clear_records();
+
+    // Both threads are bound at the same time, so they record to different command buffers.
+    // Assertions are not thread safe, bind results are checked after the join.
+    uint8_t layer_id = Renderer::next_layer_id();
+    std::atomic<uint32_t> bound{0};
+    std::atomic<uint32_t> failures{0};
+    auto record = [&](const Drawable& drawable, float depth_0, float depth_1) {
+        if(!Renderer::bind_recording_thread())
+            failures.fetch_add(1);
+        bound.fetch_add(1);
+        wait_for(bound, 2);
+        submit(drawable, layer_id, depth_0);
+        submit(drawable, layer_id, depth_1);
+        Renderer::unbind_recording_thread();
+    };
+    std::thread thread_a(record, std::cref(drawable_a), 0.1f, 0.5f);
+    std::thread thread_b(record, std::cref(drawable_b), 0.3f, 0.7f);
+    thread_a.join();
+    thread_b.join();
+    REQUIRE(failures == 0);
+    Renderer::flush();
+
+    // Opaque draw calls are sorted front to back, whatever thread recorded them
+    std::vector<uint16_t> shaders;
+    for(const auto& rec : get_backend().get_records())
+        if(rec.draw && rec.type == uint16_t(DrawCommand::Draw))
+            shaders.push_back(rec.handle);
+    std::vector<uint16_t> expected = {drawable_a.shader.index(), drawable_b.shader.index(), drawable_a.shader.index(),
+                                      drawable_b.shader.index()};
+    REQUIRE(shaders == expected);
+
+    destroy_drawable(drawable_a);
+    destroy_drawable(drawable_b);
+}
+
+TEST_CASE_METHOD(NullRendererFixture, "Recording threads: binding fails when all command buffers are taken",
+                 "[recording]")
+{
+    // The main thread owns one of the command buffers
+    const uint32_t slot_count = CFG_.get<uint32_t>("erwin.renderer.max_recording_threads"_h, 4) - 1;
+    const uint32_t thread_count = slot_count + 1;
+
+    std::atomic<uint32_t> attempts{0};
+    std::atomic<uint32_t> successes{0};
+    std::vector<std::thread> threads;
+    for(uint32_t ii = 0; ii < thread_count; ++ii)
+    {
+        threads.emplace_back([&]() {
+            bool bound = Renderer::bind_recording_thread();
+            if(bound)
+                successes.fetch_add(1);
+            // Slots are held until every thread tried to bind
+            attempts.fetch_add(1);
+            wait_for(attempts, thread_count);
+            if(bound)
+                Renderer::unbind_recording_thread();
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    REQUIRE(successes == slot_count);
+
+    // Unbound slots are free again
+    bool rebound = false;
+    std::thread thread([&rebound]() {
+        rebound = Renderer::bind_recording_thread();
+        if(rebound)
+            Renderer::unbind_recording_thread();
+    });
+    thread.join();
+    REQUIRE(rebound);
+}
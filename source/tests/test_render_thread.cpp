@@ -1,78 +1,82 @@
-#include <iostream>
-#include <iomanip>
-#include <chrono>
-#include <thread>
+#include <vector>
 
-#include "level/chunk.h"
-
-#include "render_thread.h"
-#include "clock.hpp"
-
-#include "debug/logger.h"
+#include "catch2/catch.hpp"
+#include "null_renderer_fixture.h"
+#include "render/renderer_config.h"
 
 using namespace erwin;
 
-std::vector<RenderKey> keys = { 1, 5000, 498, 632, 0, 455, 456, 798, 222, 101};
-std::vector<QueueItem> items = { {0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}};
-void fill_items(std::reference_wrapper<RenderThread> rthread)
+// Resources are created and destroyed on the main thread while the render thread submits the previous frames
+class RenderThreadFixture : public NullRendererFixture
 {
-    std::vector<QueueItem> cmds(items);
-    rthread.get().enqueue(keys, std::move(cmds));
-}
+public:
+    RenderThreadFixture() { Renderer::spawn_render_thread(); }
+};
 
-int main()
+TEST_CASE_METHOD(RenderThreadFixture, "Render thread: handles are released when their destruction is recorded",
+                 "[render_thread]")
 {
-    RenderThread rthread;
-
-    rthread.spawn();
-
-    nanoClock frame_clock;
-    nanoClock main_clock;
-    frame_clock.restart();
-    main_clock.restart();
-
-    float target_fps = 60.f;
-    const std::chrono::nanoseconds frame_duration_ns_(uint32_t(1e9*1.0f/target_fps));
+    auto drawable = create_drawable();
+    next_frame();
+
+    destroy_drawable(drawable);
+    // The vertex array owns its buffers, their handles go with it
+    REQUIRE_FALSE(drawable.VAO.is_valid());
+    REQUIRE_FALSE(drawable.VBO.is_valid());
+    REQUIRE_FALSE(drawable.IBO.is_valid());
+    REQUIRE_FALSE(drawable.shader.is_valid());
+    next_frame();
+
+    Renderer::kill_render_thread();
+    REQUIRE_FALSE(drawable.VAO.is_valid());
+}
 
-    bool running = true;
-    while(running)
+TEST_CASE_METHOD(RenderThreadFixture, "Render thread: released indices are not reused while the backend may use them",
+                 "[render_thread]")
+{
+    static const uint32_t index_data[] = {0, 1, 2};
+    auto released = Renderer::create_index_buffer(index_data, 3, DrawPrimitive::Triangles);
+    uint16_t released_index = released.index();
+    next_frame();
+    Renderer::destroy(released);
+
+    std::vector<IndexBufferHandle> handles;
+    for(uint32_t ii = 0; ii < k_handle_reuse_latency; ++ii)
     {
-        auto run_d = main_clock.get_elapsed_time();
-        float t_tot = std::chrono::duration_cast<std::chrono::duration<float>>(run_d).count();
-        if(t_tot>2.f)
-            running = false;
-
-        // Feed the render thread with draw items
-        fill_items(rthread);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        fill_items(rthread);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-        auto frame_d = frame_clock.restart();
-        auto sleep_duration = frame_duration_ns_ - frame_d;
-        std::this_thread::sleep_for(sleep_duration);
-
-        // Kick off sorted draw-call submissions
-        rthread.flush();
+        auto handle = Renderer::create_index_buffer(index_data, 3, DrawPrimitive::Triangles);
+        REQUIRE(handle.index() != released_index);
+        handles.push_back(handle);
+        next_frame();
     }
 
-    rthread.kill();
-
-
-    Cell* data = nullptr;
-    TerrainChunk chunk(8,16,data);
-
-    for(int ii=0; ii<8; ++ii)
-        for(int jj=0; jj<16; ++jj)
-            chunk.set_cell(ii,jj,make_cell(1,CELL_FLOOR,CELL_FLAG_NONE));
+    // Lower indices are acquired first, the retired index is the next one
+    auto reused = Renderer::create_index_buffer(index_data, 3, DrawPrimitive::Triangles);
+    REQUIRE(reused.index() == released_index);
+    REQUIRE(reused.guard() != released.guard());
+    handles.push_back(reused);
 
-    chunk.set_cell(0,0,make_cell(1,CellWall(CELL_FLOOR|CELL_WALL_NE),CELL_FLAG_NONE));
-    chunk.set_cell(1,5,make_cell(1,CellWall(CELL_FLOOR|CELL_WALL_SW|CELL_WALL_NE),CELL_FLAG_NONE));
+    for(auto handle : handles)
+        Renderer::destroy(handle);
+    next_frame();
+}
 
-    chunk.dbg_display();
+TEST_CASE_METHOD(RenderThreadFixture, "Render thread: framebuffer attachments can be queried during submission",
+                 "[render_thread]")
+{
+    FramebufferLayout layout{{"albedo"_h, ImageFormat::RGBA8, MIN_NEAREST | MAG_NEAREST, TextureWrap::CLAMP_TO_EDGE}};
+    auto fb = Renderer::create_framebuffer(64, 64, FB_DEPTH_ATTACHMENT, layout);
 
-    chunk.write_stream(std::cout);
+    for(uint32_t ii = 0; ii < 4; ++ii)
+    {
+        REQUIRE(Renderer::get_framebuffer_texture_count(fb) == 2);
+        REQUIRE(Renderer::get_framebuffer_texture_name(fb, 1) == "depth"_h);
+        REQUIRE(Renderer::get_framebuffer_texture(fb, 0).is_valid());
+        Renderer::update_framebuffer(fb, 128, 128);
+        next_frame();
+    }
 
-    EventBus::Kill();
-    return 0;
+    auto texture = Renderer::get_framebuffer_texture(fb, 0);
+    Renderer::destroy(fb);
+    REQUIRE_FALSE(texture.is_valid());
+    next_frame();
 }
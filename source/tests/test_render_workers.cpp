@@ -0,0 +1,46 @@
+#include "catch2/catch.hpp"
+#include "render/render_workers.h"
+#include <atomic>
+#include <vector>
+
+using namespace erwin;
+
+class RenderWorkersFixture
+{
+public:
+    RenderWorkersFixture() { workers.spawn(3); }
+    ~RenderWorkersFixture() { workers.kill(); }
+
+protected:
+    RenderWorkers workers;
+};
+
+TEST_CASE_METHOD(RenderWorkersFixture, "Every index is processed exactly once", "[workers]")
+{
+    std::vector<std::atomic<uint32_t>> visits(1000);
+    workers.parallel_for(uint32_t(visits.size()), [&visits](uint32_t ii) { ++visits[ii]; });
+
+    bool once = true;
+    for(const auto& count : visits)
+        once &= (count.load() == 1);
+    REQUIRE(once);
+}
+
+TEST_CASE_METHOD(RenderWorkersFixture, "Consecutive loops do not overlap", "[workers]")
+{
+    std::atomic<uint32_t> total{0};
+    for(uint32_t loop = 0; loop < 100; ++loop)
+    {
+        workers.parallel_for(16, [&total](uint32_t) { ++total; });
+        REQUIRE(total.load() == 16 * (loop + 1));
+    }
+}
+
+TEST_CASE("Loops run on the calling thread without workers", "[workers]")
+{
+    RenderWorkers workers;
+    workers.spawn(0);
+    uint32_t sum = 0;
+    workers.parallel_for(10, [&sum](uint32_t ii) { sum += ii; });
+    REQUIRE(sum == 45);
+}
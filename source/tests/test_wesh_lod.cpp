@@ -0,0 +1,85 @@
+#include <sstream>
+
+#include "asset/mesh.h"
+#include "catch2/catch.hpp"
+#include "filesystem/wesh_file.h"
+
+using namespace erwin;
+
+// A quad and a single triangle coarser level, 3 floats per vertex
+static wesh::WeshDescriptor make_descriptor()
+{
+    wesh::WeshDescriptor descriptor;
+    descriptor.extent = Extent(-1.f, 1.f, -1.f, 1.f, 0.f, 0.f);
+    descriptor.vertex_size = 3;
+    descriptor.vertex_data = {-1.f, -1.f, 0.f, 1.f, -1.f, 0.f, 1.f, 1.f, 0.f, -1.f, 1.f, 0.f};
+    descriptor.index_data = {0, 1, 2, 0, 2, 3, 0, 1, 2};
+    descriptor.lods = {{0, 6, 1.f}, {6, 3, 0.2f}};
+    return descriptor;
+}
+
+TEST_CASE("WESH: levels of detail survive a write/read round trip", "[wesh]")
+{
+    auto descriptor = make_descriptor();
+    std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+    wesh::write(stream, descriptor);
+    auto read_back = wesh::read(stream);
+
+    REQUIRE(read_back.vertex_size == 3);
+    REQUIRE(read_back.vertex_data == descriptor.vertex_data);
+    REQUIRE(read_back.index_data == descriptor.index_data);
+    REQUIRE(read_back.lods.size() == 2);
+    REQUIRE(read_back.lods[1].first_index == 6);
+    REQUIRE(read_back.lods[1].index_count == 3);
+    REQUIRE(read_back.lods[1].screen_size == Approx(0.2f));
+    REQUIRE(read_back.extent.xmax() == Approx(1.f));
+}
+
+TEST_CASE("WESH: version 0.3 files are read as a single level of detail", "[wesh]")
+{
+    // Header as written by the 0.3 exporter: magic, version, vertex size, vertex count, index count
+    std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+    uint32_t magic = 0x48534557;
+    uint16_t version[2] = {0, 3};
+    uint32_t counts[3] = {3, 4, 6};
+    float extent[6] = {-1.f, 1.f, -1.f, 1.f, 0.f, 0.f};
+    auto descriptor = make_descriptor();
+    stream.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    stream.write(reinterpret_cast<const char*>(version), sizeof(version));
+    stream.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+    stream.write(reinterpret_cast<const char*>(extent), sizeof(extent));
+    stream.write(reinterpret_cast<const char*>(descriptor.vertex_data.data()), long(12 * sizeof(float)));
+    stream.write(reinterpret_cast<const char*>(descriptor.index_data.data()), long(6 * sizeof(uint32_t)));
+
+    auto read_back = wesh::read(stream);
+    REQUIRE(read_back.index_data.size() == 6);
+    REQUIRE(read_back.lods.size() == 1);
+    REQUIRE(read_back.lods[0].first_index == 0);
+    REQUIRE(read_back.lods[0].index_count == 6);
+}
+
+TEST_CASE("Mesh: LOD selection with hysteresis", "[mesh]")
+{
+    Mesh mesh;
+    mesh.first_index = 100;
+    mesh.index_count = 600;
+    mesh.lod_count = 3;
+    mesh.lods[0] = {700, 300, 0.2f};
+    mesh.lods[1] = {1000, 100, 0.05f};
+
+    // Without hysteresis, thresholds are sharp
+    REQUIRE(mesh.select_lod(0.5f, 0, 0.f) == 0);
+    REQUIRE(mesh.select_lod(0.19f, 0, 0.f) == 1);
+    REQUIRE(mesh.select_lod(0.01f, 0, 0.f) == 2);
+    REQUIRE(mesh.get_first_index(0) == 100);
+    REQUIRE(mesh.get_index_count(1) == 300);
+    REQUIRE(mesh.get_first_index(2) == 1000);
+
+    // Slightly past a threshold, the current level is kept
+    REQUIRE(mesh.select_lod(0.19f, 0, 0.1f) == 0);
+    REQUIRE(mesh.select_lod(0.21f, 1, 0.1f) == 1);
+    REQUIRE(mesh.select_lod(0.051f, 2, 0.1f) == 2);
+    // Well past it, the level switches
+    REQUIRE(mesh.select_lod(0.17f, 0, 0.1f) == 1);
+    REQUIRE(mesh.select_lod(0.23f, 1, 0.1f) == 0);
+}